@@ -2,11 +2,14 @@
 // Created by Jozef Jelšík on 27/12/2025.
 //
 
+#define _POSIX_C_SOURCE 200809L /* pipe(), fcntl() */
+
 #include "client_dispatcher.h"
 
 #include "../common/util.h"
 #include "snapshot_reciever.h"
 
+#include <fcntl.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
@@ -30,6 +33,7 @@ typedef struct {
     pthread_mutex_t mtx;
     pthread_cond_t cv;
 
+    int started;     /**< 1 from dispatcher_start() until the thread is joined. */
     int running;     /**< 1 while reader thread is alive. */
     int stop;        /**< Request reader thread to stop. */
 
@@ -43,6 +47,9 @@ typedef struct {
     void *resp_payload;    /**< malloc()'d payload for buffered response. */
 
     int last_err; /**< errno-like error code set by reader thread. */
+
+    dispatcher_events_t events; /**< Latest async notifications. */
+    int event_pipe[2];          /**< Non-blocking; one byte per event (coalesced when full). */
 } dispatcher_state_t;
 
 static dispatcher_state_t g_d;
@@ -62,10 +69,14 @@ static dispatcher_state_t g_d;
  *   via `dispatcher_send_and_wait()`
  *
  * ## What the reader thread does
- * The reader thread reads (hdr + payload) and then routes the message:
- * - Async notifications are consumed and dropped:
+ * The reader thread reads framed messages through a @ref rw_rx_buf_t (one large
+ * read() usually yields several messages) and then routes each message:
+ * - Async notifications are consumed without printing:
  *   - `RW_MSG_PROGRESS`, `RW_MSG_END`, `RW_MSG_GLOBAL_MODE_CHANGED`
  *   (The interactive menu must not be spammed or the prompt would get corrupted.)
+ *   The latest PROGRESS / END is kept (`dispatcher_get_events()`) and each one
+ *   (and each completed snapshot) writes a byte into the event pipe, so a UI can
+ *   poll() stdin and the dispatcher together.
  * - Snapshot stream is forwarded to `snapshot_reciever.*`:
  *   - `RW_MSG_SNAPSHOT_BEGIN` -> `client_snapshot_begin()`
  *   - `RW_MSG_SNAPSHOT_CHUNK` -> `client_snapshot_chunk()`
@@ -84,9 +95,10 @@ static dispatcher_state_t g_d;
  * - the waiting caller wakes up, takes ownership of the allocated payload, and returns
  *
  * ## Memory ownership
- * - The reader thread malloc()'s `payload` for any message with payload_len > 0.
- * - For async/unhandled messages, *the reader thread frees payload*.
- * - For a sync response delivered to a waiter, ownership transfers:
+ * - Async/unhandled messages are handled straight from the receive buffer
+ *   (the payload view is valid only until the next frame is read).
+ * - For a sync response delivered to a waiter, the reader thread malloc()'s a
+ *   copy of the payload and ownership transfers:
  *   - reader thread stores the pointer in `g_d.resp_payload`
  *   - `dispatcher_send_and_wait()` returns it via `out_payload`
  *   - caller must free() it
@@ -134,6 +146,17 @@ static void set_error_locked(int err) {
     g_d.last_err = err;
 }
 
+/**
+ * @brief Wake a poll() on the event pipe.
+ *
+ * Never blocks: when the pipe is full the pending bytes already wake the reader.
+ */
+static void signal_event(void) {
+    const uint8_t b = 1;
+    ssize_t n = write(g_d.event_pipe[1], &b, 1);
+    (void)n;
+}
+
 /**
  * @brief Reader thread main loop.
  *
@@ -146,6 +169,17 @@ static void set_error_locked(int err) {
 static void *reader_main(void *arg) {
     (void)arg;
 
+    rw_rx_buf_t rx;
+    if (rw_rx_init(&rx, g_d.fd) != 0) {
+        pthread_mutex_lock(&g_d.mtx);
+        set_error_locked(ENOMEM);
+        g_d.stop = 1;
+        g_d.running = 0;
+        pthread_cond_broadcast(&g_d.cv);
+        pthread_mutex_unlock(&g_d.mtx);
+        return NULL;
+    }
+
     while (1) {
         /* Check stop flag (without holding lock too long). */
         pthread_mutex_lock(&g_d.mtx);
@@ -154,7 +188,7 @@ static void *reader_main(void *arg) {
         if (should_stop) break;
 
         rw_msg_hdr_t hdr;
-        if (rw_recv_hdr(g_d.fd, &hdr) != 0) {
+        if (rw_rx_next(&rx, &hdr) != 0) {
             pthread_mutex_lock(&g_d.mtx);
             set_error_locked(EPIPE);
             g_d.stop = 1;
@@ -163,52 +197,32 @@ static void *reader_main(void *arg) {
             break;
         }
 
-        void *payload = NULL;
-        if (hdr.payload_len > 0) {
-            payload = malloc(hdr.payload_len);
-            if (!payload) {
-                /* Drain payload to keep framing, then signal error. */
-                char buf[256];
-                uint32_t left = hdr.payload_len;
-                while (left > 0) {
-                    uint32_t n = left > sizeof(buf) ? (uint32_t)sizeof(buf) : left;
-                    if (rw_recv_payload(g_d.fd, buf, n) != 0) break;
-                    left -= n;
-                }
-
-                pthread_mutex_lock(&g_d.mtx);
-                set_error_locked(ENOMEM);
-                pthread_cond_broadcast(&g_d.cv);
-                pthread_mutex_unlock(&g_d.mtx);
-                continue;
-            }
-            if (rw_recv_payload(g_d.fd, payload, hdr.payload_len) != 0) {
-                free(payload);
-                pthread_mutex_lock(&g_d.mtx);
-                set_error_locked(EPIPE);
-                g_d.stop = 1;
-                pthread_cond_broadcast(&g_d.cv);
-                pthread_mutex_unlock(&g_d.mtx);
-                break;
-            }
-        }
+        /* Async messages are handled from the receive buffer (no copy). */
+        const void *payload = rx.payload;
 
         /* Dispatch */
         if (hdr.type == RW_MSG_PROGRESS && hdr.payload_len == sizeof(rw_progress_t)) {
             /* Don't print progress on client (keeps menu stable). */
-            free(payload);
+            pthread_mutex_lock(&g_d.mtx);
+            memcpy(&g_d.events.progress, payload, sizeof(rw_progress_t));
+            g_d.events.progress_seq++;
+            pthread_mutex_unlock(&g_d.mtx);
+            signal_event();
             continue;
         }
 
         if (hdr.type == RW_MSG_END && hdr.payload_len == sizeof(rw_end_t)) {
             /* Don't print end on client (keeps menu stable). */
-            free(payload);
+            pthread_mutex_lock(&g_d.mtx);
+            memcpy(&g_d.events.end, payload, sizeof(rw_end_t));
+            g_d.events.end_seq++;
+            pthread_mutex_unlock(&g_d.mtx);
+            signal_event();
             continue;
         }
 
         if (hdr.type == RW_MSG_GLOBAL_MODE_CHANGED && hdr.payload_len == sizeof(rw_global_mode_changed_t)) {
             /* Don't print mode changes on client (keeps menu stable). */
-            free(payload);
             continue;
         }
 
@@ -217,7 +231,6 @@ static void *reader_main(void *arg) {
             if (client_snapshot_begin(b) != 0) {
                 log_error("client_snapshot_begin() failed");
             }
-            free(payload);
             continue;
         }
 
@@ -229,7 +242,6 @@ static void *reader_main(void *arg) {
             if (client_snapshot_chunk(&chunk) != 0) {
                 log_error("client_snapshot_chunk() failed");
             }
-            free(payload);
             continue;
         }
 
@@ -237,16 +249,27 @@ static void *reader_main(void *arg) {
             if (client_snapshot_end() != 0) {
                 log_error("client_snapshot_end() failed");
             }
-            free(payload);
+            signal_event();
             continue;
         }
 
-        /* Sync response delivery */
+        /* Sync response delivery: the waiter gets its own copy. */
         pthread_mutex_lock(&g_d.mtx);
         if (g_d.waiting && !g_d.resp_ready && type_expected((rw_msg_type_t)hdr.type)) {
+            void *copy = NULL;
+            if (hdr.payload_len > 0) {
+                copy = malloc(hdr.payload_len);
+                if (!copy) {
+                    set_error_locked(ENOMEM);
+                    pthread_cond_broadcast(&g_d.cv);
+                    pthread_mutex_unlock(&g_d.mtx);
+                    continue;
+                }
+                memcpy(copy, payload, hdr.payload_len);
+            }
             clear_response_slot_locked();
             g_d.resp_hdr = hdr;
-            g_d.resp_payload = payload; /* transfer ownership */
+            g_d.resp_payload = copy; /* transfer ownership */
             g_d.resp_ready = 1;
             pthread_cond_broadcast(&g_d.cv);
             pthread_mutex_unlock(&g_d.mtx);
@@ -254,14 +277,15 @@ static void *reader_main(void *arg) {
         }
         pthread_mutex_unlock(&g_d.mtx);
 
-        /* Unexpected/unhandled: just drop (already consumed). */
-        free(payload);
+        /* Unexpected/unhandled: dropped by the next rw_rx_next(). */
     }
+    rw_rx_free(&rx);
 
     pthread_mutex_lock(&g_d.mtx);
     g_d.running = 0;
     pthread_cond_broadcast(&g_d.cv);
     pthread_mutex_unlock(&g_d.mtx);
+    signal_event(); /* a poller notices the lost connection */
     return NULL;
 }
 
@@ -292,7 +316,7 @@ static void timespec_add_ms(struct timespec *ts, uint32_t ms) {
 int dispatcher_start(int fd) {
     if (fd < 0) return -1;
 
-    if (g_d.running) {
+    if (g_d.started) {
         return 0;
     }
 
@@ -305,21 +329,84 @@ int dispatcher_start(int fd) {
     g_d.resp_payload = NULL;
     g_d.last_err = 0;
 
-    if (pthread_mutex_init(&g_d.mtx, NULL) != 0) {
+    if (pipe(g_d.event_pipe) != 0) {
         return -1;
     }
+    for (int i = 0; i < 2; i++) {
+        int fl = fcntl(g_d.event_pipe[i], F_GETFL);
+        (void)fcntl(g_d.event_pipe[i], F_SETFL, fl | O_NONBLOCK);
+    }
+    if (pthread_mutex_init(&g_d.mtx, NULL) != 0) {
+        goto fail_pipe;
+    }
     if (pthread_cond_init(&g_d.cv, NULL) != 0) {
         pthread_mutex_destroy(&g_d.mtx);
-        return -1;
+        goto fail_pipe;
     }
 
     if (pthread_create(&g_d.thread, NULL, reader_main, NULL) != 0) {
         pthread_cond_destroy(&g_d.cv);
         pthread_mutex_destroy(&g_d.mtx);
-        return -1;
+        goto fail_pipe;
     }
+    g_d.started = 1;
 
     return 0;
+
+fail_pipe:
+    close(g_d.event_pipe[0]);
+    close(g_d.event_pipe[1]);
+    memset(&g_d, 0, sizeof(g_d));
+    return -1;
+}
+
+/**
+ * @brief Read end of the event pipe (-1 when not started).
+ *
+ * Readable after each PROGRESS, END, completed snapshot and after the
+ * connection was lost. Drain it with @ref dispatcher_drain_events().
+ */
+int dispatcher_event_fd(void) {
+    return g_d.started ? g_d.event_pipe[0] : -1;
+}
+
+/**
+ * @brief Discard pending bytes of the event pipe.
+ */
+void dispatcher_drain_events(void) {
+    if (!g_d.started) return;
+    uint8_t buf[64];
+    while (read(g_d.event_pipe[0], buf, sizeof(buf)) > 0) {
+    }
+}
+
+/**
+ * @brief Copy the latest async notifications.
+ *
+ * @param out Output (zeroed when not started).
+ */
+void dispatcher_get_events(dispatcher_events_t *out) {
+    if (!out) return;
+    if (!g_d.started) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    pthread_mutex_lock(&g_d.mtx);
+    *out = g_d.events;
+    pthread_mutex_unlock(&g_d.mtx);
+}
+
+/**
+ * @brief Report whether the reader thread still reads the socket.
+ *
+ * @return 1 while connected, 0 after a read failure or when not started.
+ */
+int dispatcher_connected(void) {
+    if (!g_d.started) return 0;
+    pthread_mutex_lock(&g_d.mtx);
+    int ok = g_d.running && !g_d.stop;
+    pthread_mutex_unlock(&g_d.mtx);
+    return ok;
 }
 
 /**
@@ -328,12 +415,13 @@ int dispatcher_start(int fd) {
  * Safe to call multiple times.
  *
  * Notes:
- * - Signals the reader thread to exit and joins it.
+ * - Signals the reader thread to exit and joins it (also when it already
+ *   exited after a read failure).
  * - Frees any pending response payload.
  * - Destroys mutex/cond-var and clears global state.
  */
 void dispatcher_stop(void) {
-    if (!g_d.running) {
+    if (!g_d.started) {
         return;
     }
 
@@ -351,6 +439,8 @@ void dispatcher_stop(void) {
 
     pthread_cond_destroy(&g_d.cv);
     pthread_mutex_destroy(&g_d.mtx);
+    close(g_d.event_pipe[0]);
+    close(g_d.event_pipe[1]);
 
     memset(&g_d, 0, sizeof(g_d));
 }
@@ -25,6 +25,8 @@
  * - They are always consumed to prevent socket buffer buildup.
  * - They are intentionally NOT printed in the interactive client, because
  *   printing would corrupt the menu prompt.
+ * - The latest PROGRESS and END are kept for dashboard.c, which waits for them
+ *   on the event pipe together with stdin.
  *
  * Snapshot stream (BEGIN/CHUNK/END):
  * - Is fed into snapshot_reciever.* and rendered when SNAPSHOT_END arrives.
@@ -32,12 +34,37 @@
 
 
 
+/**
+ * @brief Latest async notifications (see @ref dispatcher_get_events()).
+ */
+typedef struct {
+    uint64_t progress_seq;   /**< Number of PROGRESS messages received. */
+    rw_progress_t progress;  /**< Latest PROGRESS (valid if progress_seq > 0). */
+    uint64_t end_seq;        /**< Number of END messages received. */
+    rw_end_t end;            /**< Latest END (valid if end_seq > 0). */
+} dispatcher_events_t;
+
 /** Start reader thread for @p fd. Returns 0 on success. */
 int dispatcher_start(int fd);
 
 /** Stop reader thread and join it. Safe to call multiple times. */
 void dispatcher_stop(void);
 
+/** 1 while the reader thread reads the socket, 0 once the connection is lost. */
+int dispatcher_connected(void);
+
+/**
+ * @brief Pollable fd, readable after PROGRESS, END, a completed snapshot or a
+ *        lost connection (-1 when not started).
+ */
+int dispatcher_event_fd(void);
+
+/** Discard the pending bytes of @ref dispatcher_event_fd(). */
+void dispatcher_drain_events(void);
+
+/** Copy the latest PROGRESS / END (zeroed when not started). */
+void dispatcher_get_events(dispatcher_events_t *out);
+
 /**
  * @brief Send a request and wait for a matching response.
  *
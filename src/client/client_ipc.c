@@ -88,11 +88,14 @@ int client_ipc_connect(const char* socket_path) {
  * @brief Send a JOIN request containing the current process ID.
  *
  * @param fd Connected client socket.
+ * @param resume_token Session to resume (0 = new session).
  * @return 0 on success, -1 on failure.
  */
-int client_ipc_send_join(int fd) {
+int client_ipc_send_join(int fd, uint64_t resume_token) {
     rw_join_t join;
-    join.pid = (int32_t)getpid();
+    memset(&join, 0, sizeof(join));
+    join.pid = (uint32_t)getpid();
+    join.resume_token = resume_token;
 
     if (rw_send_msg(fd, RW_MSG_JOIN, &join, sizeof(join)) != 0) {
         log_error("Failed to send JOIN message to server");
@@ -414,12 +417,20 @@ int client_ipc_restart_sim(int fd, uint32_t total_reps) {
  * Snapshot messages themselves (`RW_MSG_SNAPSHOT_BEGIN/CHUNK/END`) are delivered
  * asynchronously and handled by the dispatcher + snapshot receiver.
  *
+ * With @p base_snapshot_id (RAW only) the server may send just the cells
+ * changed since that snapshot, see snapshot_reciever.h.
+ *
  * @param fd Connected client socket.
+ * @param format Snapshot format.
+ * @param base_snapshot_id Last complete snapshot held by the client (0 = full snapshot).
  * @return 0 on success, -1 on failure.
  */
-int client_ipc_request_snapshot(int fd) {
+int client_ipc_request_snapshot(int fd, rw_wire_snapshot_format_t format, uint32_t base_snapshot_id) {
     rw_request_snapshot_t req;
+    memset(&req, 0, sizeof(req));
     req.pid = (uint32_t)getpid();
+    req.format = (uint8_t)format;
+    req.base_snapshot_id = base_snapshot_id;
 
     const rw_msg_type_t expected[] = { RW_MSG_ACK, RW_MSG_ERROR };
     rw_msg_hdr_t rh;
@@ -604,3 +615,421 @@ int client_ipc_stop_sim(int fd) {
     free(resp);
     return ok;
 }
+
+int client_ipc_solve_hit_time(int fd, uint32_t max_iters, double tolerance) {
+    rw_solve_hit_time_t req;
+    memset(&req, 0, sizeof(req));
+    req.max_iters = max_iters;
+    req.tolerance = tolerance;
+
+    const rw_msg_type_t expected[] = { RW_MSG_ACK, RW_MSG_ERROR };
+    rw_msg_hdr_t rh;
+    void *resp = NULL;
+
+    /* No timeout: large worlds can take a while to solve. */
+    if (dispatcher_send_and_wait(fd, RW_MSG_SOLVE_HIT_TIME, &req, sizeof(req),
+                                 expected, 2, 0, &rh, &resp) != 0) {
+        return -1;
+    }
+
+    if (rh.type == RW_MSG_ERROR && rh.payload_len == sizeof(rw_error_t)) {
+        rw_error_t *e = (rw_error_t *)resp;
+        e->error_msg[sizeof(e->error_msg) - 1] = '\0';
+        log_error("Server error (%u): %s", (unsigned)e->error_code, e->error_msg);
+        free(resp);
+        return -1;
+    }
+
+    if (rh.type != RW_MSG_ACK || rh.payload_len != sizeof(rw_ack_t)) {
+        free(resp);
+        return -1;
+    }
+    rw_ack_t *ack = (rw_ack_t *)resp;
+    int ok = (ack->request_type == RW_MSG_SOLVE_HIT_TIME && ack->status == 0) ? 0 : -1;
+    free(resp);
+    return ok;
+}
+
+int client_ipc_set_rng_mode(int fd, int enabled, uint64_t seed) {
+    rw_set_rng_mode_t req;
+    memset(&req, 0, sizeof(req));
+    req.crn_enabled = (uint8_t)(enabled ? 1 : 0);
+    req.seed = seed;
+
+    const rw_msg_type_t expected[] = { RW_MSG_ACK, RW_MSG_ERROR };
+    rw_msg_hdr_t rh;
+    void *resp = NULL;
+
+    if (dispatcher_send_and_wait(fd, RW_MSG_SET_RNG_MODE, &req, sizeof(req),
+                                 expected, 2, 5000, &rh, &resp) != 0) {
+        return -1;
+    }
+
+    if (rh.type == RW_MSG_ERROR && rh.payload_len == sizeof(rw_error_t)) {
+        rw_error_t *e = (rw_error_t *)resp;
+        e->error_msg[sizeof(e->error_msg) - 1] = '\0';
+        log_error("Server error (%u): %s", (unsigned)e->error_code, e->error_msg);
+        free(resp);
+        return -1;
+    }
+
+    if (rh.type != RW_MSG_ACK || rh.payload_len != sizeof(rw_ack_t)) {
+        free(resp);
+        return -1;
+    }
+    rw_ack_t *ack = (rw_ack_t *)resp;
+    int ok = (ack->request_type == RW_MSG_SET_RNG_MODE && ack->status == 0) ? 0 : -1;
+    free(resp);
+    return ok;
+}
+
+int client_ipc_crn_diff(int fd, const rw_crn_diff_t *req) {
+    if (!req) return -1;
+
+    const rw_msg_type_t expected[] = { RW_MSG_ACK, RW_MSG_ERROR };
+    rw_msg_hdr_t rh;
+    void *resp = NULL;
+
+    /* No timeout: the comparison runs 2 * reps walks per cell. */
+    if (dispatcher_send_and_wait(fd, RW_MSG_CRN_DIFF, req, sizeof(*req),
+                                 expected, 2, 0, &rh, &resp) != 0) {
+        return -1;
+    }
+
+    if (rh.type == RW_MSG_ERROR && rh.payload_len == sizeof(rw_error_t)) {
+        rw_error_t *e = (rw_error_t *)resp;
+        e->error_msg[sizeof(e->error_msg) - 1] = '\0';
+        log_error("Server error (%u): %s", (unsigned)e->error_code, e->error_msg);
+        free(resp);
+        return -1;
+    }
+
+    if (rh.type != RW_MSG_ACK || rh.payload_len != sizeof(rw_ack_t)) {
+        free(resp);
+        return -1;
+    }
+    rw_ack_t *ack = (rw_ack_t *)resp;
+    int ok = (ack->request_type == RW_MSG_CRN_DIFF && ack->status == 0) ? 0 : -1;
+    free(resp);
+    return ok;
+}
+
+int client_ipc_edit_obstacles(int fd, const rw_obstacle_edit_t *edits, uint32_t count, int resimulate) {
+    if (!edits || count == 0 || count > RW_OBSTACLE_EDIT_MAX) return -1;
+
+    size_t len = sizeof(rw_obstacle_edit_hdr_t) + (size_t)count * sizeof(rw_obstacle_edit_t);
+    uint8_t *buf = (uint8_t *)malloc(len);
+    if (!buf) return -1;
+
+    rw_obstacle_edit_hdr_t h;
+    memset(&h, 0, sizeof(h));
+    h.count = count;
+    h.resimulate = (uint8_t)(resimulate ? 1 : 0);
+    memcpy(buf, &h, sizeof(h));
+    memcpy(buf + sizeof(h), edits, (size_t)count * sizeof(rw_obstacle_edit_t));
+
+    const rw_msg_type_t expected[] = { RW_MSG_ACK, RW_MSG_ERROR };
+    rw_msg_hdr_t rh;
+    void *resp = NULL;
+
+    int rc = dispatcher_send_and_wait(fd, RW_MSG_EDIT_OBSTACLES, buf, (uint32_t)len,
+                                      expected, 2, 5000, &rh, &resp);
+    free(buf);
+    if (rc != 0) {
+        return -1;
+    }
+
+    if (rh.type == RW_MSG_ERROR && rh.payload_len == sizeof(rw_error_t)) {
+        rw_error_t *e = (rw_error_t *)resp;
+        e->error_msg[sizeof(e->error_msg) - 1] = '\0';
+        log_error("Server error (%u): %s", (unsigned)e->error_code, e->error_msg);
+        free(resp);
+        return -1;
+    }
+
+    if (rh.type != RW_MSG_ACK || rh.payload_len != sizeof(rw_ack_t)) {
+        free(resp);
+        return -1;
+    }
+    rw_ack_t *ack = (rw_ack_t *)resp;
+    int ok = (ack->request_type == RW_MSG_EDIT_OBSTACLES && ack->status == 0) ? 0 : -1;
+    free(resp);
+    return ok;
+}
+
+int client_ipc_cluster_scaling(int fd, uint32_t reps, const char *path) {
+    if (!path) return -1;
+
+    rw_cluster_scaling_t req;
+    memset(&req, 0, sizeof(req));
+    req.reps = reps;
+    snprintf(req.path, sizeof(req.path), "%s", path);
+
+    const rw_msg_type_t expected[] = { RW_MSG_ACK, RW_MSG_ERROR };
+    rw_msg_hdr_t rh;
+    void *resp = NULL;
+
+    /* No timeout: the report runs the workload once per worker count. */
+    if (dispatcher_send_and_wait(fd, RW_MSG_CLUSTER_SCALING, &req, sizeof(req),
+                                 expected, 2, 0, &rh, &resp) != 0) {
+        return -1;
+    }
+
+    if (rh.type == RW_MSG_ERROR && rh.payload_len == sizeof(rw_error_t)) {
+        rw_error_t *e = (rw_error_t *)resp;
+        e->error_msg[sizeof(e->error_msg) - 1] = '\0';
+        log_error("Server error (%u): %s", (unsigned)e->error_code, e->error_msg);
+        free(resp);
+        return -1;
+    }
+
+    if (rh.type != RW_MSG_ACK || rh.payload_len != sizeof(rw_ack_t)) {
+        free(resp);
+        return -1;
+    }
+    rw_ack_t *ack = (rw_ack_t *)resp;
+    int ok = (ack->request_type == RW_MSG_CLUSTER_SCALING && ack->status == 0) ? 0 : -1;
+    free(resp);
+    return ok;
+}
+
+int client_ipc_set_region(int fd, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    rw_set_region_t req;
+    memset(&req, 0, sizeof(req));
+    req.x = x;
+    req.y = y;
+    req.width = width;
+    req.height = height;
+
+    const rw_msg_type_t expected[] = { RW_MSG_ACK, RW_MSG_ERROR };
+    rw_msg_hdr_t rh;
+    void *resp = NULL;
+
+    if (dispatcher_send_and_wait(fd, RW_MSG_SET_REGION, &req, sizeof(req),
+                                 expected, 2, 5000, &rh, &resp) != 0) {
+        return -1;
+    }
+
+    if (rh.type == RW_MSG_ERROR && rh.payload_len == sizeof(rw_error_t)) {
+        rw_error_t *e = (rw_error_t *)resp;
+        e->error_msg[sizeof(e->error_msg) - 1] = '\0';
+        log_error("Server error (%u): %s", (unsigned)e->error_code, e->error_msg);
+        free(resp);
+        return -1;
+    }
+
+    if (rh.type != RW_MSG_ACK || rh.payload_len != sizeof(rw_ack_t)) {
+        free(resp);
+        return -1;
+    }
+    rw_ack_t *ack = (rw_ack_t *)resp;
+    int ok = (ack->request_type == RW_MSG_SET_REGION && ack->status == 0) ? 0 : -1;
+    free(resp);
+    return ok;
+}
+
+int client_ipc_map_world(int fd, const rw_map_world_t *req) {
+    if (!req) return -1;
+
+    const rw_msg_type_t expected[] = { RW_MSG_ACK, RW_MSG_ERROR };
+    rw_msg_hdr_t rh;
+    void *resp = NULL;
+
+    if (dispatcher_send_and_wait(fd, RW_MSG_MAP_WORLD, req, sizeof(*req),
+                                 expected, 2, 0, &rh, &resp) != 0) {
+        return -1;
+    }
+
+    if (rh.type == RW_MSG_ERROR && rh.payload_len == sizeof(rw_error_t)) {
+        rw_error_t *e = (rw_error_t *)resp;
+        e->error_msg[sizeof(e->error_msg) - 1] = '\0';
+        log_error("Server error (%u): %s", (unsigned)e->error_code, e->error_msg);
+        free(resp);
+        return -1;
+    }
+
+    if (rh.type != RW_MSG_ACK || rh.payload_len != sizeof(rw_ack_t)) {
+        free(resp);
+        return -1;
+    }
+    rw_ack_t *ack = (rw_ack_t *)resp;
+    int ok = (ack->request_type == RW_MSG_MAP_WORLD && ack->status == 0) ? 0 : -1;
+    free(resp);
+    return ok;
+}
+
+int client_ipc_import_image(int fd, const rw_import_image_t *req) {
+    if (!req) return -1;
+
+    const rw_msg_type_t expected[] = { RW_MSG_ACK, RW_MSG_ERROR };
+    rw_msg_hdr_t rh;
+    void *resp = NULL;
+
+    if (dispatcher_send_and_wait(fd, RW_MSG_IMPORT_IMAGE, req, sizeof(*req),
+                                 expected, 2, 0, &rh, &resp) != 0) {
+        return -1;
+    }
+
+    if (rh.type == RW_MSG_ERROR && rh.payload_len == sizeof(rw_error_t)) {
+        rw_error_t *e = (rw_error_t *)resp;
+        e->error_msg[sizeof(e->error_msg) - 1] = '\0';
+        log_error("Server error (%u): %s", (unsigned)e->error_code, e->error_msg);
+        free(resp);
+        return -1;
+    }
+
+    if (rh.type != RW_MSG_ACK || rh.payload_len != sizeof(rw_ack_t)) {
+        free(resp);
+        return -1;
+    }
+    rw_ack_t *ack = (rw_ack_t *)resp;
+    int ok = (ack->request_type == RW_MSG_IMPORT_IMAGE && ack->status == 0) ? 0 : -1;
+    free(resp);
+    return ok;
+}
+
+int client_ipc_trace(int fd, uint8_t action, const char *path) {
+    rw_trace_t req;
+    memset(&req, 0, sizeof(req));
+    req.action = action;
+    if (path) {
+        snprintf(req.path, sizeof(req.path), "%s", path);
+    }
+
+    const rw_msg_type_t expected[] = { RW_MSG_ACK, RW_MSG_ERROR };
+    rw_msg_hdr_t rh;
+    void *resp = NULL;
+
+    if (dispatcher_send_and_wait(fd, RW_MSG_TRACE, &req, sizeof(req),
+                                 expected, 2, 0, &rh, &resp) != 0) {
+        return -1;
+    }
+
+    if (rh.type == RW_MSG_ERROR && rh.payload_len == sizeof(rw_error_t)) {
+        rw_error_t *e = (rw_error_t *)resp;
+        e->error_msg[sizeof(e->error_msg) - 1] = '\0';
+        log_error("Server error (%u): %s", (unsigned)e->error_code, e->error_msg);
+        free(resp);
+        return -1;
+    }
+
+    if (rh.type != RW_MSG_ACK || rh.payload_len != sizeof(rw_ack_t)) {
+        free(resp);
+        return -1;
+    }
+    rw_ack_t *ack = (rw_ack_t *)resp;
+    int ok = (ack->request_type == RW_MSG_TRACE && ack->status == 0) ? 0 : -1;
+    free(resp);
+    return ok;
+}
+
+int client_ipc_query_stats(int fd, rw_stats_t *out_stats) {
+    if (!out_stats) return -1;
+
+    rw_query_stats_t q;
+    q.pid = (uint32_t)getpid();
+
+    const rw_msg_type_t expected[] = { RW_MSG_STATS, RW_MSG_ERROR };
+    rw_msg_hdr_t rh;
+    void *resp = NULL;
+
+    if (dispatcher_send_and_wait(fd, RW_MSG_QUERY_STATS, &q, sizeof(q),
+                                 expected, 2, 5000, &rh, &resp) != 0) {
+        return -1;
+    }
+
+    if (rh.type == RW_MSG_ERROR && rh.payload_len == sizeof(rw_error_t)) {
+        rw_error_t *e = (rw_error_t *)resp;
+        e->error_msg[sizeof(e->error_msg) - 1] = '\0';
+        log_error("Server error (%u): %s", (unsigned)e->error_code, e->error_msg);
+        free(resp);
+        return -1;
+    }
+
+    if (rh.type != RW_MSG_STATS || rh.payload_len != sizeof(rw_stats_t)) {
+        free(resp);
+        return -1;
+    }
+
+    memcpy(out_stats, resp, sizeof(*out_stats));
+    free(resp);
+    if (out_stats->count > RW_STATS_MAX_ENTRIES) {
+        out_stats->count = RW_STATS_MAX_ENTRIES;
+    }
+    return 0;
+}
+
+int client_ipc_export_image(int fd, const rw_export_image_t *req) {
+    if (!req) return -1;
+
+    const rw_msg_type_t expected[] = { RW_MSG_ACK, RW_MSG_ERROR };
+    rw_msg_hdr_t rh;
+    void *resp = NULL;
+
+    if (dispatcher_send_and_wait(fd, RW_MSG_EXPORT_IMAGE, req, sizeof(*req),
+                                 expected, 2, 0, &rh, &resp) != 0) {
+        return -1;
+    }
+
+    if (rh.type == RW_MSG_ERROR && rh.payload_len == sizeof(rw_error_t)) {
+        rw_error_t *e = (rw_error_t *)resp;
+        e->error_msg[sizeof(e->error_msg) - 1] = '\0';
+        log_error("Server error (%u): %s", (unsigned)e->error_code, e->error_msg);
+        free(resp);
+        return -1;
+    }
+
+    if (rh.type != RW_MSG_ACK || rh.payload_len != sizeof(rw_ack_t)) {
+        free(resp);
+        return -1;
+    }
+    rw_ack_t *ack = (rw_ack_t *)resp;
+    int ok = (ack->request_type == RW_MSG_EXPORT_IMAGE && ack->status == 0) ? 0 : -1;
+    free(resp);
+    return ok;
+}
+
+int client_ipc_query_regions(int fd, const rw_wire_rect_t *rects, uint32_t count,
+                             rw_region_stat_t *out, uint64_t *out_version) {
+    if (!rects || !out || count == 0 || count > RW_REGION_QUERY_MAX) return -1;
+
+    size_t len = sizeof(rw_query_regions_hdr_t) + (size_t)count * sizeof(rw_wire_rect_t);
+    uint8_t *buf = (uint8_t *)malloc(len);
+    if (!buf) return -1;
+
+    rw_query_regions_hdr_t h;
+    h.pid = (uint32_t)getpid();
+    h.count = count;
+    memcpy(buf, &h, sizeof(h));
+    memcpy(buf + sizeof(h), rects, (size_t)count * sizeof(rw_wire_rect_t));
+
+    const rw_msg_type_t expected[] = { RW_MSG_REGION_STATS, RW_MSG_ERROR };
+    rw_msg_hdr_t rh;
+    void *resp = NULL;
+
+    int rc = dispatcher_send_and_wait(fd, RW_MSG_QUERY_REGIONS, buf, (uint32_t)len,
+                                      expected, 2, 0, &rh, &resp);
+    free(buf);
+    if (rc != 0) {
+        return -1;
+    }
+
+    if (rh.type == RW_MSG_ERROR && rh.payload_len == sizeof(rw_error_t)) {
+        rw_error_t *e = (rw_error_t *)resp;
+        e->error_msg[sizeof(e->error_msg) - 1] = '\0';
+        log_error("Server error (%u): %s", (unsigned)e->error_code, e->error_msg);
+        free(resp);
+        return -1;
+    }
+
+    rw_region_stats_hdr_t sh;
+    if (rh.type != RW_MSG_REGION_STATS || rh.payload_len != sizeof(sh) + (size_t)count * sizeof(rw_region_stat_t)) {
+        free(resp);
+        return -1;
+    }
+    memcpy(&sh, resp, sizeof(sh));
+    memcpy(out, (const uint8_t *)resp + sizeof(sh), (size_t)count * sizeof(rw_region_stat_t));
+    free(resp);
+    if (out_version) *out_version = sh.results_version;
+    return sh.count == count ? 0 : -1;
+}
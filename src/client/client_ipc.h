@@ -33,12 +33,13 @@ int client_ipc_connect(const char *socket_path);
  * @brief Send a JOIN request to the server.
  *
  * The JOIN message contains the current process ID (`getpid()`), allowing the server to
- * identify the client.
+ * identify the client, and optionally the token of a session to resume.
  *
  * @param fd Connected client socket.
+ * @param resume_token session_token of an earlier WELCOME (0 = new session).
  * @return 0 on success, -1 on failure.
  */
-int client_ipc_send_join(int fd);
+int client_ipc_send_join(int fd, uint64_t resume_token);
 
 /**
  * @brief Receive a WELCOME message from the server.
@@ -70,11 +71,153 @@ int client_ipc_create_sim(int fd, const rw_create_sim_t *req);
 int client_ipc_load_world(int fd, const rw_load_world_t *req);
 int client_ipc_start_sim(int fd);
 int client_ipc_restart_sim(int fd, uint32_t total_reps);
-int client_ipc_request_snapshot(int fd);
+int client_ipc_request_snapshot(int fd, rw_wire_snapshot_format_t format, uint32_t base_snapshot_id);
 int client_ipc_save_results(int fd, const char *path);
 int client_ipc_load_results(int fd, const char *path);
 int client_ipc_quit(int fd, int stop_if_owner);
 int client_ipc_stop_sim(int fd);
 
+/**
+ * @brief Ask the server to compute expected hitting times of the origin.
+ *
+ * Waits without a timeout because the solve time grows with the world size.
+ *
+ * @param fd        Connected client socket.
+ * @param max_iters Maximum solver iterations (0 = server default).
+ * @param tolerance Target relative residual (<= 0 = server default).
+ * @return 0 on success (ACK), -1 on error.
+ */
+int client_ipc_solve_hit_time(int fd, uint32_t max_iters, double tolerance);
+
+/**
+ * @brief Enable or disable common random numbers for subsequent simulations.
+ *
+ * @param fd      Connected client socket.
+ * @param enabled Non-zero to enable CRN.
+ * @param seed    Base seed of the common random streams.
+ * @return 0 on success (ACK), -1 on error.
+ */
+int client_ipc_set_rng_mode(int fd, int enabled, uint64_t seed);
+
+/**
+ * @brief Ask the server for a paired CRN comparison report (current config vs. B).
+ *
+ * Waits without a timeout because the comparison runs 2 * reps walks per cell.
+ *
+ * @param fd  Connected client socket.
+ * @param req Configuration B, replications, seed and report path.
+ * @return 0 on success (ACK), -1 on error.
+ */
+int client_ipc_crn_diff(int fd, const rw_crn_diff_t *req);
+
+/**
+ * @brief Change obstacles of the current world.
+ *
+ * The server drops the results of all start cells the edit can influence and,
+ * if requested, re-simulates only those cells.
+ *
+ * @param fd         Connected client socket.
+ * @param edits      Cell edits.
+ * @param count      Number of edits (1..RW_OBSTACLE_EDIT_MAX).
+ * @param resimulate Non-zero to re-simulate affected cells right away.
+ * @return 0 on success (ACK), -1 on error.
+ */
+int client_ipc_edit_obstacles(int fd, const rw_obstacle_edit_t *edits, uint32_t count, int resimulate);
+
+/**
+ * @brief Ask a cluster-mode server for a scaling efficiency report.
+ *
+ * The server runs @p reps replications with 1..N worker processes and writes a
+ * CSV report to @p path. Waits without a timeout.
+ *
+ * @param fd   Connected client socket.
+ * @param reps Replications per measured worker count.
+ * @param path Server-side CSV path.
+ * @return 0 on success (ACK), -1 on error.
+ */
+int client_ipc_cluster_scaling(int fd, uint32_t reps, const char *path);
+
+/**
+ * @brief Restrict simulation and snapshots to a rectangle of the world.
+ *
+ * Needed to work with worlds too large to simulate or view as a whole.
+ * Width or height 0 clears the region.
+ *
+ * @param fd     Connected client socket.
+ * @param x      Left column.
+ * @param y      Top row.
+ * @param width  Region width (0 = whole world).
+ * @param height Region height (0 = whole world).
+ * @return 0 on success (ACK), -1 on error.
+ */
+int client_ipc_set_region(int fd, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
+/**
+ * @brief Replace the server world by a memory-mapped RWTILE file.
+ *
+ * Depending on @ref rw_map_world_t::mode the server maps an existing file,
+ * generates a new one, or converts the current world first. Waits without a
+ * timeout (generating a large world takes a while).
+ *
+ * @param fd  Connected client socket.
+ * @param req Request payload.
+ * @return 0 on success (ACK), -1 on error.
+ */
+int client_ipc_map_world(int fd, const rw_map_world_t *req);
+
+/**
+ * @brief Load the server world from a PBM/PGM image (server-side path).
+ *
+ * Waits without a timeout (large images take a while).
+ *
+ * @param fd  Connected client socket.
+ * @param req Request payload.
+ * @return 0 on success (ACK), -1 on error.
+ */
+int client_ipc_import_image(int fd, const rw_import_image_t *req);
+
+/**
+ * @brief Start/stop server span tracing or dump it as Chrome trace JSON.
+ *
+ * @param fd     Connected client socket.
+ * @param action rw_wire_trace_action_t.
+ * @param path   Output file on the server (DUMP only, may be NULL otherwise).
+ * @return 0 on success (ACK), -1 on error.
+ */
+int client_ipc_trace(int fd, uint8_t action, const char *path);
+
+/**
+ * @brief Query per-message-type service latencies of the server.
+ *
+ * @param fd        Connected client socket.
+ * @param out_stats Output statistics.
+ * @return 0 on success, -1 on error.
+ */
+int client_ipc_query_stats(int fd, rw_stats_t *out_stats);
+
+/**
+ * @brief Render the current results to a PPM/PNG file on the server.
+ *
+ * Waits without a timeout (large worlds take a while).
+ *
+ * @param fd  Connected client socket.
+ * @param req Request payload.
+ * @return 0 on success (ACK), -1 on error.
+ */
+int client_ipc_export_image(int fd, const rw_export_image_t *req);
+
+/**
+ * @brief Pooled statistics of a batch of rectangles (QUERY_REGIONS).
+ *
+ * @param fd          Connected client socket.
+ * @param rects       Rectangles.
+ * @param count       Number of rectangles (1..RW_REGION_QUERY_MAX).
+ * @param out         count results, in request order.
+ * @param out_version Optional: results version of the answers.
+ * @return 0 on success, -1 on error.
+ */
+int client_ipc_query_regions(int fd, const rw_wire_rect_t *rects, uint32_t count,
+                             rw_region_stat_t *out, uint64_t *out_version);
+
 #endif //SEMPRACA_CLIENT_IPC_H
 
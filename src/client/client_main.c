@@ -4,6 +4,7 @@
 
 #include "ui_menu.h"
 
+#include <signal.h>
 #include <stdio.h>
 
 /**
@@ -25,5 +26,8 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    /* A dropped connection must fail the write (and trigger a reconnect), not kill us. */
+    signal(SIGPIPE, SIG_IGN);
+
     return ui_menu_run(argv[1]);
 }
@@ -0,0 +1,323 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#define _POSIX_C_SOURCE 200809L /* clock_gettime(), poll() */
+
+#include "dashboard.h"
+
+#include "client_ipc.h"
+#include "client_dispatcher.h"
+#include "snapshot_reciever.h"
+#include "../common/util.h"
+#include "../common/protocol.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @file dashboard.c
+ * @brief Implementation of the live dashboard.
+ *
+ * The screen is a grid of fixed-width lines. Each frame composes all lines
+ * into `cur`, compares them with `prev` (what the terminal shows) and writes
+ * only the lines that differ.
+ */
+
+#define DASH_HEADER_LINES 6u   /* lines above the heatmap */
+#define DASH_MAX_COLS 400u
+#define DASH_MAX_ROWS 200u
+#define DASH_BAR_WIDTH 30u
+
+typedef struct {
+    uint32_t cols;  /* usable width (terminal width - 1, no wrap in the last column) */
+    uint32_t rows;
+    char *cur;      /* rows lines of cols + 1 bytes */
+    char *prev;
+    int drawn;      /* prev is on the terminal */
+} screen_t;
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static int screen_init(screen_t *s) {
+    struct winsize ws;
+    uint32_t cols = 80, rows = 24;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0 && ws.ws_row > 0) {
+        cols = ws.ws_col;
+        rows = ws.ws_row;
+    }
+    if (cols > DASH_MAX_COLS) cols = DASH_MAX_COLS;
+    if (rows > DASH_MAX_ROWS) rows = DASH_MAX_ROWS;
+    if (cols < 40) cols = 40;
+    if (rows < DASH_HEADER_LINES + 2u) rows = DASH_HEADER_LINES + 2u;
+
+    memset(s, 0, sizeof(*s));
+    s->cols = cols - 1u;
+    s->rows = rows - 1u; /* keep the last line for the cursor */
+    s->cur = (char *)calloc((size_t)s->rows, (size_t)s->cols + 1u);
+    s->prev = (char *)calloc((size_t)s->rows, (size_t)s->cols + 1u);
+    if (!s->cur || !s->prev) {
+        free(s->cur);
+        free(s->prev);
+        return -1;
+    }
+    return 0;
+}
+
+static void screen_free(screen_t *s) {
+    free(s->cur);
+    free(s->prev);
+    memset(s, 0, sizeof(*s));
+}
+
+static char *screen_line(screen_t *s, uint32_t row) {
+    return s->cur + (size_t)row * (s->cols + 1u);
+}
+
+/* Format line @p row, padded with spaces (cut at the screen width). */
+static void screen_printf(screen_t *s, uint32_t row, const char *fmt, ...) {
+    if (row >= s->rows) return;
+    char *line = screen_line(s, row);
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(line, (size_t)s->cols + 1u, fmt, ap);
+    va_end(ap);
+    if (n < 0) n = 0;
+    if ((uint32_t)n > s->cols) n = (int)s->cols;
+    memset(line + n, ' ', (size_t)(s->cols - (uint32_t)n));
+    line[s->cols] = '\0';
+}
+
+/* Write the lines that changed since the last flush. */
+static void screen_flush(screen_t *s) {
+    const size_t stride = (size_t)s->cols + 1u;
+    for (uint32_t r = 0; r < s->rows; ++r) {
+        const char *line = s->cur + (size_t)r * stride;
+        if (s->drawn && memcmp(line, s->prev + (size_t)r * stride, stride) == 0) continue;
+        printf("\x1b[%u;1H%s", r + 1u, line);
+    }
+    memcpy(s->prev, s->cur, (size_t)s->rows * stride);
+    s->drawn = 1;
+    fflush(stdout);
+}
+
+static const char *state_name(rw_wire_sim_state_t st) {
+    if (st == RW_WIRE_SIM_LOBBY) return "LOBBY";
+    if (st == RW_WIRE_SIM_RUNNING) return "RUNNING";
+    if (st == RW_WIRE_SIM_FINISHED) return "FINISHED";
+    return "?";
+}
+
+/**
+ * @brief Dashboard state carried between frames.
+ */
+typedef struct {
+    int fd;
+    uint32_t snapshot_ms;       /* 0 = heatmap off */
+    const char *heat_note;      /* why the heatmap is off, NULL = on */
+
+    uint64_t rate_t0_ms;        /* throughput measured from here */
+    uint32_t rate_rep0;
+    int rate_valid;
+
+    uint64_t last_snapshot_ms;  /* time of the last snapshot request */
+    uint32_t snapshot_rep;      /* current_rep at that request */
+    int have_heat;
+
+    char *heat;                 /* heat_cols * heat_rows characters */
+    uint32_t heat_cols, heat_rows;
+
+    uint64_t end_seq0;          /* END messages seen before the dashboard started */
+} dash_t;
+
+/* Request a (delta) RAW snapshot and downsample it into d->heat. */
+static int refresh_heatmap(dash_t *d, const screen_t *s, const rw_status_t *st, uint64_t now) {
+    d->last_snapshot_ms = now;
+    d->snapshot_rep = st->current_rep;
+    if (client_ipc_request_snapshot(d->fd, RW_SNAP_FORMAT_RAW, client_snapshot_base_id()) != 0) {
+        if (!dispatcher_connected()) return -1;
+        d->heat_note = "off (snapshot request failed, see log)";
+        return 0;
+    }
+
+    /* the stream precedes the ACK: the buffers are complete here */
+    uint32_t cols = s->cols - 1u;
+    uint32_t rows = s->rows - DASH_HEADER_LINES;
+    if (client_snapshot_heatmap(d->heat, &cols, &rows) != 0) {
+        d->heat_note = "off (no snapshot)";
+        return 0;
+    }
+    d->heat_cols = cols;
+    d->heat_rows = rows;
+    d->have_heat = 1;
+    return 0;
+}
+
+/* Query status, refresh the heatmap if due and compose one frame. */
+static int compose_frame(dash_t *d, screen_t *s) {
+    rw_status_t st;
+    if (client_ipc_query_status(d->fd, &st) != 0) return -1;
+    const uint64_t now = now_ms();
+
+    dispatcher_events_t ev;
+    dispatcher_get_events(&ev);
+
+    /* Throughput since the dashboard saw this run; restarts when the counter goes back. */
+    if (st.state != RW_WIRE_SIM_RUNNING) {
+        d->rate_valid = 0;
+    } else if (!d->rate_valid || st.current_rep < d->rate_rep0) {
+        d->rate_valid = 1;
+        d->rate_t0_ms = now;
+        d->rate_rep0 = st.current_rep;
+    }
+
+    if (d->snapshot_ms > 0 && !d->heat_note && now - d->last_snapshot_ms >= d->snapshot_ms &&
+        (!d->have_heat || st.state == RW_WIRE_SIM_RUNNING || st.current_rep != d->snapshot_rep)) {
+        if (refresh_heatmap(d, s, &st, now) != 0) return -1;
+    }
+
+    const uint32_t total = st.total_reps;
+    const uint32_t cur = st.current_rep < total ? st.current_rep : total;
+    const uint32_t filled = total ? (uint32_t)((uint64_t)cur * DASH_BAR_WIDTH / total) : 0u;
+    char bar[DASH_BAR_WIDTH + 1u];
+    memset(bar, '.', DASH_BAR_WIDTH);
+    memset(bar, '#', filled);
+    bar[DASH_BAR_WIDTH] = '\0';
+
+    screen_printf(s, 0, "Random walk dashboard (Enter = back to menu)");
+    screen_printf(s, 1, "state %-8s world %ux%u  K=%u  reps %u/%u [%s] %u%%",
+                  state_name(st.state), st.size.width, st.size.height, st.k_max_steps,
+                  cur, total, bar, total ? (unsigned)((uint64_t)cur * 100u / total) : 0u);
+
+    double secs = (double)(now - d->rate_t0_ms) / 1000.0;
+    if (d->rate_valid && cur > d->rate_rep0 && secs > 0.0) {
+        double rate = (double)(cur - d->rate_rep0) / secs;
+        uint64_t eta = (uint64_t)((double)(total - cur) / rate + 0.5);
+        screen_printf(s, 2, "throughput %.2f reps/s  ETA %02llu:%02llu:%02llu", rate,
+                      (unsigned long long)(eta / 3600u), (unsigned long long)(eta / 60u % 60u),
+                      (unsigned long long)(eta % 60u));
+    } else if (st.state == RW_WIRE_SIM_RUNNING) {
+        screen_printf(s, 2, "throughput measuring...  ETA --:--:--");
+    } else if (ev.end_seq > d->end_seq0) {
+        screen_printf(s, 2, "last run ended: %s", ev.end.reason == 0 ? "all replications done" : "stopped by client");
+    } else {
+        screen_printf(s, 2, "not running");
+    }
+
+    uint32_t sid = 0, base = 0;
+    uint64_t bytes = 0;
+    if (d->heat_note) {
+        screen_printf(s, 3, "heatmap %s", d->heat_note);
+    } else if (d->snapshot_ms == 0) {
+        screen_printf(s, 3, "heatmap off");
+    } else if (d->have_heat && client_snapshot_last_info(&sid, &base, &bytes) == 0) {
+        if (base != 0) {
+            screen_printf(s, 3, "heatmap every %u ms: snapshot #%u, delta of #%u (%llu B)",
+                          d->snapshot_ms, sid, base, (unsigned long long)bytes);
+        } else {
+            screen_printf(s, 3, "heatmap every %u ms: snapshot #%u, full (%llu B)",
+                          d->snapshot_ms, sid, (unsigned long long)bytes);
+        }
+    } else {
+        screen_printf(s, 3, "heatmap every %u ms: waiting for a snapshot", d->snapshot_ms);
+    }
+    screen_printf(s, 4, "p<=K low ' .:-=+*#%%@' high, 'X' obstacles, ' ' no trials");
+    screen_printf(s, 5, "%s", "");
+
+    for (uint32_t r = DASH_HEADER_LINES; r < s->rows; ++r) {
+        uint32_t hr = r - DASH_HEADER_LINES;
+        if (d->have_heat && hr < d->heat_rows) {
+            screen_printf(s, r, " %.*s", (int)d->heat_cols, d->heat + (size_t)hr * d->heat_cols);
+        } else {
+            screen_printf(s, r, "%s", "");
+        }
+    }
+    return 0;
+}
+
+int dashboard_run(int fd, uint32_t fps, uint32_t snapshot_ms) {
+    if (fps < 1u) fps = 1u;
+    if (fps > 30u) fps = 30u;
+
+    screen_t s;
+    if (screen_init(&s) != 0) return -1;
+
+    dash_t d;
+    memset(&d, 0, sizeof(d));
+    d.fd = fd;
+    d.snapshot_ms = snapshot_ms;
+    d.heat = (char *)malloc((size_t)s.cols * s.rows);
+    if (!d.heat) {
+        screen_free(&s);
+        return -1;
+    }
+    dispatcher_events_t ev;
+    dispatcher_get_events(&ev);
+    d.end_seq0 = ev.end_seq;
+
+    client_snapshot_set_quiet(1);
+    printf("\x1b[?25l\x1b[2J"); /* hide cursor, clear */
+
+    const uint64_t frame_ms = 1000u / fps;
+    uint64_t next_frame = now_ms();
+    int rc = 0;
+    while (1) {
+        if (now_ms() >= next_frame) {
+            if (compose_frame(&d, &s) != 0) {
+                rc = -1;
+                break;
+            }
+            screen_flush(&s);
+            next_frame = now_ms() + frame_ms;
+        }
+
+        uint64_t now = now_ms();
+        struct pollfd pfd[2];
+        pfd[0].fd = STDIN_FILENO;
+        pfd[0].events = POLLIN;
+        pfd[0].revents = 0;
+        pfd[1].fd = dispatcher_event_fd();
+        pfd[1].events = POLLIN;
+        pfd[1].revents = 0;
+        int n = poll(pfd, 2, next_frame > now ? (int)(next_frame - now) : 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            rc = -1;
+            break;
+        }
+        if (pfd[0].revents != 0) {
+            /* any line (or EOF) leaves the dashboard */
+            char line[64];
+            if (!fgets(line, sizeof(line), stdin)) {
+                line[0] = '\0';
+            }
+            break;
+        }
+        if (pfd[1].revents != 0) {
+            /* PROGRESS / END / snapshot: picked up by the next frame */
+            dispatcher_drain_events();
+            if (!dispatcher_connected()) {
+                rc = -1;
+                break;
+            }
+        }
+    }
+
+    printf("\x1b[%u;1H\x1b[?25h\n", s.rows + 1u); /* below the dashboard, cursor back */
+    fflush(stdout);
+    client_snapshot_set_quiet(0);
+    free(d.heat);
+    screen_free(&s);
+    return rc;
+}
@@ -0,0 +1,39 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_DASHBOARD_H
+#define SEMPRACA_DASHBOARD_H
+
+/**
+ * @file dashboard.h
+ * @brief Live console view of the simulation (menu item 20).
+ *
+ * The dashboard redraws a fixed screen at a configurable frame rate:
+ * - state, progress bar, throughput (replications/s) and ETA from STATUS,
+ *   and the reason of the last END,
+ * - a heatmap of p<=K from periodically requested RAW snapshots; after the
+ *   first one each request is a delta (see snapshot_reciever.h), so refreshing
+ *   a large world costs only the changed cells.
+ *
+ * It waits in poll() on stdin and on the dispatcher event pipe, so a key press
+ * (Enter) leaves at once and a lost connection is noticed without waiting for
+ * the next frame. Only screen lines that changed since the last frame are
+ * rewritten (ANSI cursor positioning).
+ */
+
+#include <stdint.h>
+
+/**
+ * @brief Run the dashboard until a line is entered on stdin.
+ *
+ * The dispatcher must be running on @p fd.
+ *
+ * @param fd          Connected socket.
+ * @param fps         Frames per second (clamped to 1..30).
+ * @param snapshot_ms Heatmap refresh interval in ms, 0 = no heatmap.
+ * @return 0 when left by the user (or stdin ended), -1 if the connection failed.
+ */
+int dashboard_run(int fd, uint32_t fps, uint32_t snapshot_ms);
+
+#endif //SEMPRACA_DASHBOARD_H
@@ -0,0 +1,190 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#define _POSIX_C_SOURCE 200809L /* posix_fallocate(), fcntl locks */
+
+#include "snapshot_cache.h"
+
+#include "../common/util.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @file snapshot_cache.c
+ * @brief Implementation of the snapshot cache file.
+ */
+
+#define CACHE_MAGIC "RWSNAPC1"
+
+typedef struct {
+    char magic[8];
+    uint32_t header_size;
+    uint32_t reserved;
+    uint64_t data_len;
+    snapshot_cache_info_t info;
+} cache_header_t;
+
+_Static_assert(sizeof(cache_header_t) <= SNAPSHOT_CACHE_HEADER_SIZE, "cache header too large");
+
+/* The one mapped cache file (the receiver holds a single snapshot). */
+static int g_fd = -1;
+static uint8_t *g_map = NULL;
+static size_t g_map_len = 0;
+
+/* Exclusive lock for the lifetime of the mapping; another client's truncate would SIGBUS us. */
+static int lock_file(int fd) {
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = F_WRLCK;
+    fl.l_whence = SEEK_SET;
+    return fcntl(fd, F_SETLK, &fl);
+}
+
+int snapshot_cache_default_path(const char *socket_path, char *out, size_t cap) {
+    if (!socket_path || !out || cap == 0) return -1;
+    const char *env = getenv("RW_SNAPSHOT_CACHE");
+    if (env) {
+        if (env[0] == '\0' || strlen(env) >= cap) return -1;
+        memcpy(out, env, strlen(env) + 1u);
+        return 0;
+    }
+    /* FNV-1a of the socket path: one cache per server socket */
+    uint64_t h = 1469598103934665603ull;
+    for (const char *p = socket_path; *p; ++p) {
+        h = (h ^ (uint8_t)*p) * 1099511628211ull;
+    }
+
+    /* a directory only we can write to, so nobody can plant a file or symlink at the name */
+    char dir[256];
+    const char *runtime = getenv("XDG_RUNTIME_DIR");
+    int n;
+    if (runtime && runtime[0] == '/') {
+        n = snprintf(dir, sizeof(dir), "%s", runtime);
+    } else {
+        n = snprintf(dir, sizeof(dir), "/tmp/rwclient-%lu", (unsigned long)getuid());
+        if (n > 0 && (size_t)n < sizeof(dir) && mkdir(dir, 0700) != 0 && errno != EEXIST) {
+            log_error("Snapshot cache directory %s: %s", dir, strerror(errno));
+            return -1;
+        }
+    }
+    if (n <= 0 || (size_t)n >= sizeof(dir)) return -1;
+    struct stat sb;
+    if (lstat(dir, &sb) != 0 || !S_ISDIR(sb.st_mode) || sb.st_uid != getuid() || (sb.st_mode & 077) != 0) {
+        log_info("Snapshot cache directory %s is not private to this user; not caching", dir);
+        return -1;
+    }
+
+    n = snprintf(out, cap, "%s/rwclient-%016llx.snap", dir, (unsigned long long)h);
+    return (n > 0 && (size_t)n < cap) ? 0 : -1;
+}
+
+/* Open without following a symlink; only a regular file of ours is accepted. */
+static int open_cache_file(const char *path, int flags) {
+    int fd = open(path, flags | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        if (errno != ENOENT) log_error("Snapshot cache %s: %s", path, strerror(errno));
+        return -1;
+    }
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode) || sb.st_uid != getuid()) {
+        log_error("Snapshot cache %s is not a regular file owned by this user", path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int map_fd(int fd, size_t len) {
+    void *m = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (m == MAP_FAILED) return -1;
+    g_fd = fd;
+    g_map = (uint8_t *)m;
+    g_map_len = len;
+    return 0;
+}
+
+int snapshot_cache_open(const char *path, snapshot_cache_info_t *out_info, void **out_data, uint64_t *out_len) {
+    if (!path || !out_info || !out_data || !out_len) return -1;
+    snapshot_cache_close();
+
+    int fd = open_cache_file(path, O_RDWR);
+    if (fd < 0) return -1;
+    struct stat sb;
+    cache_header_t hdr;
+    if (lock_file(fd) != 0 || fstat(fd, &sb) != 0 || sb.st_size < (off_t)SNAPSHOT_CACHE_HEADER_SIZE ||
+        pread(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr)) {
+        close(fd);
+        return -1;
+    }
+    if (memcmp(hdr.magic, CACHE_MAGIC, sizeof(hdr.magic)) != 0 || hdr.header_size != SNAPSHOT_CACHE_HEADER_SIZE ||
+        hdr.info.snapshot_id == 0 || hdr.data_len != (uint64_t)sb.st_size - SNAPSHOT_CACHE_HEADER_SIZE) {
+        log_debug("Snapshot cache %s holds no complete snapshot", path);
+        close(fd);
+        return -1;
+    }
+    if (map_fd(fd, (size_t)sb.st_size) != 0) {
+        close(fd);
+        return -1;
+    }
+    *out_info = hdr.info;
+    *out_data = g_map + SNAPSHOT_CACHE_HEADER_SIZE;
+    *out_len = hdr.data_len;
+    return 0;
+}
+
+int snapshot_cache_create(const char *path, uint64_t data_len, void **out_data) {
+    if (!path || !out_data) return -1;
+    snapshot_cache_close();
+
+    int fd = open_cache_file(path, O_RDWR | O_CREAT);
+    if (fd < 0) return -1;
+    if (lock_file(fd) != 0) {
+        log_info("Snapshot cache %s is used by another client; not caching", path);
+        close(fd);
+        return -1;
+    }
+    const uint64_t len = SNAPSHOT_CACHE_HEADER_SIZE + data_len;
+    /* drop the old contents, then reserve the blocks: a full disk fails here, not as SIGBUS later */
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)len) != 0 ||
+        posix_fallocate(fd, 0, (off_t)len) != 0 || map_fd(fd, (size_t)len) != 0) {
+        log_error("Snapshot cache %s: cannot allocate %llu bytes", path, (unsigned long long)len);
+        close(fd);
+        return -1;
+    }
+
+    cache_header_t *hdr = (cache_header_t *)g_map;
+    memcpy(hdr->magic, CACHE_MAGIC, sizeof(hdr->magic));
+    hdr->header_size = SNAPSHOT_CACHE_HEADER_SIZE;
+    hdr->data_len = data_len;
+    *out_data = g_map + SNAPSHOT_CACHE_HEADER_SIZE;
+    return 0;
+}
+
+void snapshot_cache_commit(const snapshot_cache_info_t *info) {
+    if (!g_map || !info) return;
+    cache_header_t *hdr = (cache_header_t *)g_map;
+    hdr->info = *info;
+    hdr->info.begin.base_snapshot_id = 0;
+    /* start the write-back now; the page cache keeps it if we crash before */
+    (void)msync(g_map, g_map_len, MS_ASYNC);
+}
+
+void snapshot_cache_close(void) {
+    if (g_map) {
+        munmap(g_map, g_map_len);
+    }
+    if (g_fd >= 0) {
+        close(g_fd); /* releases the lock */
+    }
+    g_fd = -1;
+    g_map = NULL;
+    g_map_len = 0;
+}
@@ -0,0 +1,88 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_SNAPSHOT_CACHE_H
+#define SEMPRACA_SNAPSHOT_CACHE_H
+
+/**
+ * @file snapshot_cache.h
+ * @brief Memory-mapped on-disk copy of the last RAW snapshot.
+ *
+ * The snapshot receiver places the field buffers of a RAW snapshot directly in
+ * a shared mapping of the cache file, so chunks (full or delta) are written to
+ * the file as they arrive and nothing is copied on exit. The header records
+ * which snapshot the data is: the server run (rw_welcome_t::server_instance),
+ * the snapshot id and its SNAPSHOT_BEGIN (world size and kind, view, fields).
+ * It is committed only when a snapshot completes; an interrupted delta leaves
+ * the old id, which stays a valid delta base (see snapshot_reciever.c).
+ *
+ * On the next start the client maps the file and, if the server run matches,
+ * asks for a delta against the cached id: startup costs the changed cells only.
+ *
+ * File layout: a @ref SNAPSHOT_CACHE_HEADER_SIZE byte header, then the data
+ * (the receiver decides the field offsets). The file is locked (fcntl) while
+ * mapped; a second client on the same cache runs without it.
+ */
+
+#include "../common/protocol.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Bytes before the field data (keeps the data 8-byte aligned). */
+#define SNAPSHOT_CACHE_HEADER_SIZE 256u
+
+/**
+ * @brief Identity of a cached snapshot.
+ */
+typedef struct {
+    uint64_t server_instance;   /**< Server run the snapshot came from. */
+    uint32_t snapshot_id;       /**< Complete snapshot in the file (0 = none). */
+    rw_snapshot_begin_t begin;  /**< Its SNAPSHOT_BEGIN (base_snapshot_id cleared). */
+} snapshot_cache_info_t;
+
+/**
+ * @brief Default cache path for a server socket.
+ *
+ * `$RW_SNAPSHOT_CACHE` if set (empty = no cache), otherwise
+ * `rwclient-<hash of socket_path>.snap` in `$XDG_RUNTIME_DIR`, or in the
+ * per-user directory `/tmp/rwclient-<uid>` (created with mode 0700).
+ * The directory must be owned by the user and closed to others.
+ *
+ * @return 0 on success, -1 if the cache is disabled, the directory is not
+ *         private or @p cap is too small.
+ */
+int snapshot_cache_default_path(const char *socket_path, char *out, size_t cap);
+
+/**
+ * @brief Map an existing cache file.
+ *
+ * @param path     Cache file.
+ * @param out_info Header of the cached snapshot.
+ * @param out_data Field data (valid until @ref snapshot_cache_close()).
+ * @param out_len  Length of the field data.
+ * @return 0 on success, -1 if missing, locked by another client or invalid.
+ */
+int snapshot_cache_open(const char *path, snapshot_cache_info_t *out_info, void **out_data, uint64_t *out_len);
+
+/**
+ * @brief Create (or replace) the cache file with @p data_len zeroed data bytes.
+ *
+ * The header holds no snapshot until @ref snapshot_cache_commit().
+ *
+ * @return 0 on success, -1 on failure (the caller falls back to heap buffers).
+ */
+int snapshot_cache_create(const char *path, uint64_t data_len, void **out_data);
+
+/**
+ * @brief Record that the mapped data is the complete snapshot @p info.
+ */
+void snapshot_cache_commit(const snapshot_cache_info_t *info);
+
+/**
+ * @brief Unmap and unlock the cache file (the file stays). Safe if not open.
+ */
+void snapshot_cache_close(void);
+
+#endif //SEMPRACA_SNAPSHOT_CACHE_H
@@ -1,6 +1,8 @@
 #include "snapshot_reciever.h"
+#include "snapshot_cache.h"
 #include "../common/util.h"
 
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -21,40 +23,93 @@
  * - `client_snapshot_chunk()` performs strict bounds checking before copying
  *   received bytes into the target field buffer.
  * - `client_snapshot_end()` renders the assembled view to stdout.
+ * - A delta snapshot (base_snapshot_id != 0) keeps the buffers of its base and
+ *   only overwrites the received byte ranges. The id of the last completely
+ *   applied RAW snapshot is offered as the base of the next request. An
+ *   interrupted delta leaves that base valid: the cells it overwrote changed
+ *   after the base, so the next delta against it sends them again.
  */
 
 #define SNAP_PALETTE " .:-=+*#%@"
 
 /* Internal snapshot buffers.
  *
- * Buffers are per-field arrays in row-major order (idx = y*width + x).
+ * Buffers are per-field arrays of the view in row-major order
+ * (idx = (y - view.y) * view_size.width + (x - view.x)); coordinates shown to
+ * the user are absolute world coordinates.
  * A NULL pointer means the field was not included in the current snapshot.
  */
 typedef struct {
     uint32_t snapshot_id;
     rw_wire_size_t size;
     rw_wire_world_kinds_t world_kind;
-    uint32_t cell_count;
+    rw_wire_pos_t view;
+    rw_wire_size_t view_size;
+    uint64_t cell_count;      /* view_size.width * view_size.height */
     uint32_t included_fields;
 
     uint8_t *obstacles;      /* cell_count */
     uint32_t *trials;        /* cell_count */
     uint64_t *sum_steps;     /* cell_count */
     uint32_t *succ_leq_k;    /* cell_count */
+    double *hit_time;        /* cell_count (optional) */
+
+    /* Derived formats (quant_bits != 0): bitmaps and quantized codes. */
+    uint8_t quant_bits;
+    double avg_steps_scale;
+    double p_leq_k_scale;
+    uint8_t *valid_mask;     /* (cell_count + 7) / 8 */
+    uint8_t *obstacle_mask;  /* (cell_count + 7) / 8 */
+    void *avg_steps_q;       /* cell_count codes of quant_bits */
+    void *p_leq_k_q;         /* cell_count codes of quant_bits */
+
+    uint32_t base_snapshot_id;  /* delta: snapshot the buffers were updated from */
+    uint64_t bytes_received;    /* chunk bytes of this snapshot */
+    int failed;                 /* a chunk was rejected: contents incomplete */
+
+    rw_snapshot_begin_t begin;  /* BEGIN of the full snapshot (id updated by deltas), for the cache */
+    int mapped;                 /* RAW buffers live in the snapshot cache mapping */
 } snapshot_state_t;
 
 static snapshot_state_t g_snap = {0};
 static uint32_t g_k_max_steps = 0;
+/* Dashboard mode: no rendering on SNAPSHOT_END (the dashboard draws its own view). */
+static int g_quiet = 0;
+/* Last completely applied RAW snapshot the buffers build on (0 = none); read by the menu thread. */
+static _Atomic uint32_t g_applied_id = 0;
+/* Snapshot cache file ("" = RAW buffers on the heap) and the server run it is valid for. */
+static char g_cache_path[RW_PATH_MAX];
+static uint64_t g_server_instance = 0;
 
 static void free_snapshot_buffers(void) {
+    if (g_snap.mapped) {
+        /* RAW fields point into the mapping; the file keeps the snapshot */
+        snapshot_cache_close();
+        g_snap.obstacles = NULL;
+        g_snap.trials = NULL;
+        g_snap.sum_steps = NULL;
+        g_snap.succ_leq_k = NULL;
+        g_snap.hit_time = NULL;
+        g_snap.mapped = 0;
+    }
     free(g_snap.obstacles);
     free(g_snap.trials);
     free(g_snap.sum_steps);
     free(g_snap.succ_leq_k);
+    free(g_snap.hit_time);
+    free(g_snap.valid_mask);
+    free(g_snap.obstacle_mask);
+    free(g_snap.avg_steps_q);
+    free(g_snap.p_leq_k_q);
+    g_snap.valid_mask = NULL;
+    g_snap.obstacle_mask = NULL;
+    g_snap.avg_steps_q = NULL;
+    g_snap.p_leq_k_q = NULL;
     g_snap.obstacles = NULL;
     g_snap.trials = NULL;
     g_snap.sum_steps = NULL;
     g_snap.succ_leq_k = NULL;
+    g_snap.hit_time = NULL;
 }
 
 static int field_included(uint32_t included_fields, rw_snapshot_field_t field) {
@@ -63,8 +118,129 @@ static int field_included(uint32_t included_fields, rw_snapshot_field_t field) {
     return (included_fields & bit) != 0;
 }
 
+/* Index of absolute cell (x,y) in the view buffers. */
+static uint64_t view_idx(uint32_t x, uint32_t y) {
+    return (uint64_t)(y - (uint32_t)g_snap.view.y) * g_snap.view_size.width +
+           (x - (uint32_t)g_snap.view.x);
+}
+
+static int mask_bit(const uint8_t *mask, uint64_t idx) {
+    return (mask[idx >> 3] >> (idx & 7u)) & 1;
+}
+
+static uint32_t code_at(const void *codes, uint64_t idx) {
+    return g_snap.quant_bits == 8 ? ((const uint8_t *)codes)[idx] : ((const uint16_t *)codes)[idx];
+}
+
+/* Per-cell values, from raw counters or from the derived fields. */
+static int cell_obstacle(uint64_t idx) {
+    if (g_snap.obstacles) return g_snap.obstacles[idx] != 0;
+    return g_snap.obstacle_mask ? mask_bit(g_snap.obstacle_mask, idx) : 0;
+}
+
+static int cell_has_trials(uint64_t idx) {
+    if (g_snap.trials) return g_snap.trials[idx] != 0;
+    return g_snap.valid_mask ? mask_bit(g_snap.valid_mask, idx) : 0;
+}
+
+/* p<=K of a cell with trials. */
+static double cell_p_leq_k(uint64_t idx) {
+    if (g_snap.p_leq_k_q) return (double)code_at(g_snap.p_leq_k_q, idx) * g_snap.p_leq_k_scale;
+    uint32_t trials = g_snap.trials ? g_snap.trials[idx] : 0u;
+    uint32_t succ = g_snap.succ_leq_k ? g_snap.succ_leq_k[idx] : 0u;
+    return (succ == 0) ? 0.0 : (double)succ / (double)trials;
+}
+
+/* Average steps of the successful trials of a cell, NAN if there are none. */
+static double cell_avg_steps(uint64_t idx) {
+    if (g_snap.avg_steps_q) {
+        uint32_t code = code_at(g_snap.avg_steps_q, idx);
+        if (code == (1u << g_snap.quant_bits) - 1u) return NAN;
+        return (double)code * g_snap.avg_steps_scale;
+    }
+    uint32_t succ = g_snap.succ_leq_k ? g_snap.succ_leq_k[idx] : 0u;
+    if (!g_snap.sum_steps || succ == 0) return NAN;
+    return (double)g_snap.sum_steps[idx] / (double)succ;
+}
+
+static int view_valid(void) {
+    const uint64_t vw = g_snap.view_size.width;
+    const uint64_t vh = g_snap.view_size.height;
+    return vw > 0 && vh > 0 && g_snap.cell_count == vw * vh &&
+           g_snap.view.x >= 0 && g_snap.view.y >= 0 &&
+           (uint64_t)g_snap.view.x + vw <= g_snap.size.width &&
+           (uint64_t)g_snap.view.y + vh <= g_snap.size.height;
+}
+
+/* Byte offsets of the RAW fields in one block, 8-byte aligned (index = field id); returns the total. */
+static uint64_t raw_layout(uint32_t included_fields, uint64_t cells, uint64_t off[RW_SNAP_FIELD_HIT_TIME + 1]) {
+    static const uint64_t elem[RW_SNAP_FIELD_HIT_TIME + 1] = {
+        0, sizeof(uint8_t), sizeof(uint32_t), sizeof(uint64_t), sizeof(uint32_t), sizeof(double)
+    };
+    uint64_t total = 0;
+    for (int f = RW_SNAP_FIELD_OBSTACLES; f <= RW_SNAP_FIELD_HIT_TIME; ++f) {
+        off[f] = UINT64_MAX;
+        if (!field_included(included_fields, (rw_snapshot_field_t)f)) continue;
+        off[f] = total;
+        total += (cells * elem[f] + 7u) & ~(uint64_t)7u;
+    }
+    return total;
+}
+
+/* Point the RAW field buffers into @p data laid out by raw_layout(). */
+static void raw_assign(uint8_t *data, const uint64_t off[RW_SNAP_FIELD_HIT_TIME + 1]) {
+    if (off[RW_SNAP_FIELD_OBSTACLES] != UINT64_MAX) g_snap.obstacles = data + off[RW_SNAP_FIELD_OBSTACLES];
+    if (off[RW_SNAP_FIELD_TRIALS] != UINT64_MAX) g_snap.trials = (uint32_t *)(data + off[RW_SNAP_FIELD_TRIALS]);
+    if (off[RW_SNAP_FIELD_SUM_STEPS] != UINT64_MAX) g_snap.sum_steps = (uint64_t *)(data + off[RW_SNAP_FIELD_SUM_STEPS]);
+    if (off[RW_SNAP_FIELD_SUCC_LEQ_K] != UINT64_MAX) g_snap.succ_leq_k = (uint32_t *)(data + off[RW_SNAP_FIELD_SUCC_LEQ_K]);
+    if (off[RW_SNAP_FIELD_HIT_TIME] != UINT64_MAX) g_snap.hit_time = (double *)(data + off[RW_SNAP_FIELD_HIT_TIME]);
+}
+
+/* RAW snapshot: place the buffers in a fresh cache file (zeroed). */
+static int map_raw_buffers(const rw_snapshot_begin_t *begin) {
+    if (g_cache_path[0] == '\0' || begin->quant_bits != 0) return -1;
+    uint64_t off[RW_SNAP_FIELD_HIT_TIME + 1];
+    uint64_t total = raw_layout(begin->included_fields, begin->cell_count, off);
+    void *data = NULL;
+    if (snapshot_cache_create(g_cache_path, total, &data) != 0) {
+        g_cache_path[0] = '\0'; /* reported once; heap buffers from now on */
+        return -1;
+    }
+    raw_assign((uint8_t *)data, off);
+    g_snap.mapped = 1;
+    return 0;
+}
+
+/* Delta: keep the buffers of the base snapshot, chunks overwrite changed cells. */
+static int delta_begin(const rw_snapshot_begin_t *begin) {
+    uint32_t applied = atomic_load(&g_applied_id);
+    if (applied == 0 || applied != begin->base_snapshot_id ||
+        g_snap.quant_bits != 0 || begin->quant_bits != 0 ||
+        g_snap.included_fields != begin->included_fields || g_snap.cell_count != begin->cell_count ||
+        memcmp(&g_snap.size, &begin->size, sizeof(begin->size)) != 0 ||
+        memcmp(&g_snap.view, &begin->view, sizeof(begin->view)) != 0 ||
+        memcmp(&g_snap.view_size, &begin->view_size, sizeof(begin->view_size)) != 0) {
+        log_error("Delta snapshot #%u does not match the last snapshot (#%u)",
+                  begin->snapshot_id, begin->base_snapshot_id);
+        atomic_store(&g_applied_id, 0u);
+        free_snapshot_buffers();
+        memset(&g_snap, 0, sizeof(g_snap));
+        return -1;
+    }
+    g_snap.snapshot_id = begin->snapshot_id;
+    g_snap.base_snapshot_id = begin->base_snapshot_id;
+    g_snap.bytes_received = 0;
+    g_snap.failed = 0;
+    g_snap.begin.snapshot_id = begin->snapshot_id;
+    return 0;
+}
+
 int client_snapshot_begin(const rw_snapshot_begin_t *begin) {
     if (!begin) return -1;
+    if (begin->base_snapshot_id != 0) {
+        return delta_begin(begin);
+    }
+    atomic_store(&g_applied_id, 0u);
 
     /* Free previous snapshot. */
     free_snapshot_buffers();
@@ -73,26 +249,68 @@ int client_snapshot_begin(const rw_snapshot_begin_t *begin) {
     g_snap.snapshot_id = begin->snapshot_id;
     g_snap.size = begin->size;
     g_snap.world_kind = begin->world_kind;
+    g_snap.view = begin->view;
+    g_snap.view_size = begin->view_size;
     g_snap.cell_count = begin->cell_count;
+    if (!view_valid() || g_snap.cell_count > RW_SNAPSHOT_MAX_CELLS) {
+        log_error("Invalid snapshot view");
+        memset(&g_snap, 0, sizeof(g_snap));
+        return -1;
+    }
     g_snap.included_fields = begin->included_fields;
+    g_snap.quant_bits = begin->quant_bits;
+    g_snap.avg_steps_scale = begin->avg_steps_scale;
+    g_snap.p_leq_k_scale = begin->p_leq_k_scale;
+    if (g_snap.quant_bits != 0 && g_snap.quant_bits != 8 && g_snap.quant_bits != 16) {
+        log_error("Invalid snapshot quantization");
+        memset(&g_snap, 0, sizeof(g_snap));
+        return -1;
+    }
+    const size_t mask_len = (size_t)((begin->cell_count + 7u) / 8u);
+    const size_t code_size = g_snap.quant_bits == 16 ? sizeof(uint16_t) : sizeof(uint8_t);
+    g_snap.begin = *begin;
+    g_snap.begin.base_snapshot_id = 0;
+    if (map_raw_buffers(begin) == 0) {
+        return 0;
+    }
 
     /* Allocate per-field buffers if included. */
     if (field_included(begin->included_fields, RW_SNAP_FIELD_OBSTACLES)) {
-        g_snap.obstacles = (uint8_t *)calloc(begin->cell_count, sizeof(uint8_t));
+        g_snap.obstacles = (uint8_t *)calloc((size_t)begin->cell_count, sizeof(uint8_t));
         if (!g_snap.obstacles) goto oom;
     }
     if (field_included(begin->included_fields, RW_SNAP_FIELD_TRIALS)) {
-        g_snap.trials = (uint32_t *)calloc(begin->cell_count, sizeof(uint32_t));
+        g_snap.trials = (uint32_t *)calloc((size_t)begin->cell_count, sizeof(uint32_t));
         if (!g_snap.trials) goto oom;
     }
     if (field_included(begin->included_fields, RW_SNAP_FIELD_SUM_STEPS)) {
-        g_snap.sum_steps = (uint64_t *)calloc(begin->cell_count, sizeof(uint64_t));
+        g_snap.sum_steps = (uint64_t *)calloc((size_t)begin->cell_count, sizeof(uint64_t));
         if (!g_snap.sum_steps) goto oom;
     }
     if (field_included(begin->included_fields, RW_SNAP_FIELD_SUCC_LEQ_K)) {
-        g_snap.succ_leq_k = (uint32_t *)calloc(begin->cell_count, sizeof(uint32_t));
+        g_snap.succ_leq_k = (uint32_t *)calloc((size_t)begin->cell_count, sizeof(uint32_t));
         if (!g_snap.succ_leq_k) goto oom;
     }
+    if (field_included(begin->included_fields, RW_SNAP_FIELD_HIT_TIME)) {
+        g_snap.hit_time = (double *)calloc((size_t)begin->cell_count, sizeof(double));
+        if (!g_snap.hit_time) goto oom;
+    }
+    if (field_included(begin->included_fields, RW_SNAP_FIELD_VALID_MASK)) {
+        g_snap.valid_mask = (uint8_t *)calloc(mask_len, sizeof(uint8_t));
+        if (!g_snap.valid_mask) goto oom;
+    }
+    if (field_included(begin->included_fields, RW_SNAP_FIELD_OBSTACLE_MASK)) {
+        g_snap.obstacle_mask = (uint8_t *)calloc(mask_len, sizeof(uint8_t));
+        if (!g_snap.obstacle_mask) goto oom;
+    }
+    if (g_snap.quant_bits && field_included(begin->included_fields, RW_SNAP_FIELD_AVG_STEPS_Q)) {
+        g_snap.avg_steps_q = calloc((size_t)begin->cell_count, code_size);
+        if (!g_snap.avg_steps_q) goto oom;
+    }
+    if (g_snap.quant_bits && field_included(begin->included_fields, RW_SNAP_FIELD_P_LEQ_K_Q)) {
+        g_snap.p_leq_k_q = calloc((size_t)begin->cell_count, code_size);
+        if (!g_snap.p_leq_k_q) goto oom;
+    }
 
     return 0;
 
@@ -107,43 +325,63 @@ oom:
  *
  * Bounds checks are done in bytes because chunks carry byte offsets and lengths.
  */
-int client_snapshot_chunk(const rw_snapshot_chunk_t *chunk) {
-    if (!chunk) return -1;
-    if (chunk->snapshot_id != g_snap.snapshot_id) {
-        /* Ignore stale/unknown snapshot IDs. */
-        return 0;
-    }
+static int apply_chunk(const rw_snapshot_chunk_t *chunk) {
 
-    const uint32_t offset = chunk->offset_bytes;
-    const uint32_t len = chunk->data_len;
+    const uint64_t offset = chunk->offset_bytes;
+    const uint64_t len = chunk->data_len;
 
     switch ((rw_snapshot_field_t)chunk->field) {
         case RW_SNAP_FIELD_OBSTACLES: {
             if (!g_snap.obstacles) return -1;
-            uint32_t total = g_snap.cell_count * (uint32_t)sizeof(uint8_t);
-            if (offset > total || len > total || offset + len > total) return -1;
-            memcpy(((uint8_t *)g_snap.obstacles) + offset, chunk->data, len);
+            uint64_t total = g_snap.cell_count * sizeof(uint8_t);
+            if (offset > total || len > total - offset) return -1;
+            memcpy(((uint8_t *)g_snap.obstacles) + offset, chunk->data, (size_t)len);
             break;
         }
         case RW_SNAP_FIELD_TRIALS: {
             if (!g_snap.trials) return -1;
-            uint32_t total = g_snap.cell_count * (uint32_t)sizeof(uint32_t);
-            if (offset > total || len > total || offset + len > total) return -1;
-            memcpy(((uint8_t *)g_snap.trials) + offset, chunk->data, len);
+            uint64_t total = g_snap.cell_count * sizeof(uint32_t);
+            if (offset > total || len > total - offset) return -1;
+            memcpy(((uint8_t *)g_snap.trials) + offset, chunk->data, (size_t)len);
             break;
         }
         case RW_SNAP_FIELD_SUM_STEPS: {
             if (!g_snap.sum_steps) return -1;
-            uint32_t total = g_snap.cell_count * (uint32_t)sizeof(uint64_t);
-            if (offset > total || len > total || offset + len > total) return -1;
-            memcpy(((uint8_t *)g_snap.sum_steps) + offset, chunk->data, len);
+            uint64_t total = g_snap.cell_count * sizeof(uint64_t);
+            if (offset > total || len > total - offset) return -1;
+            memcpy(((uint8_t *)g_snap.sum_steps) + offset, chunk->data, (size_t)len);
             break;
         }
         case RW_SNAP_FIELD_SUCC_LEQ_K: {
             if (!g_snap.succ_leq_k) return -1;
-            uint32_t total = g_snap.cell_count * (uint32_t)sizeof(uint32_t);
-            if (offset > total || len > total || offset + len > total) return -1;
-            memcpy(((uint8_t *)g_snap.succ_leq_k) + offset, chunk->data, len);
+            uint64_t total = g_snap.cell_count * sizeof(uint32_t);
+            if (offset > total || len > total - offset) return -1;
+            memcpy(((uint8_t *)g_snap.succ_leq_k) + offset, chunk->data, (size_t)len);
+            break;
+        }
+        case RW_SNAP_FIELD_HIT_TIME: {
+            if (!g_snap.hit_time) return -1;
+            uint64_t total = g_snap.cell_count * sizeof(double);
+            if (offset > total || len > total - offset) return -1;
+            memcpy(((uint8_t *)g_snap.hit_time) + offset, chunk->data, (size_t)len);
+            break;
+        }
+        case RW_SNAP_FIELD_VALID_MASK:
+        case RW_SNAP_FIELD_OBSTACLE_MASK: {
+            uint8_t *mask = chunk->field == RW_SNAP_FIELD_VALID_MASK ? g_snap.valid_mask : g_snap.obstacle_mask;
+            if (!mask) return -1;
+            uint64_t total = (g_snap.cell_count + 7u) / 8u;
+            if (offset > total || len > total - offset) return -1;
+            memcpy(mask + offset, chunk->data, (size_t)len);
+            break;
+        }
+        case RW_SNAP_FIELD_AVG_STEPS_Q:
+        case RW_SNAP_FIELD_P_LEQ_K_Q: {
+            void *codes = chunk->field == RW_SNAP_FIELD_AVG_STEPS_Q ? g_snap.avg_steps_q : g_snap.p_leq_k_q;
+            if (!codes) return -1;
+            uint64_t total = g_snap.cell_count * (g_snap.quant_bits / 8u);
+            if (offset > total || len > total - offset) return -1;
+            memcpy(((uint8_t *)codes) + offset, chunk->data, (size_t)len);
             break;
         }
         default:
@@ -153,6 +391,27 @@ int client_snapshot_chunk(const rw_snapshot_chunk_t *chunk) {
     return 0;
 }
 
+int client_snapshot_chunk(const rw_snapshot_chunk_t *chunk) {
+    if (!chunk) return -1;
+    if (chunk->snapshot_id != g_snap.snapshot_id) {
+        /* Ignore stale/unknown snapshot IDs. */
+        return 0;
+    }
+    if (apply_chunk(chunk) != 0) {
+        g_snap.failed = 1;
+        atomic_store(&g_applied_id, 0u);
+        if (g_snap.mapped) {
+            /* the file may now mix two snapshots: drop its id */
+            snapshot_cache_info_t none;
+            memset(&none, 0, sizeof(none));
+            snapshot_cache_commit(&none);
+        }
+        return -1;
+    }
+    g_snap.bytes_received += chunk->data_len;
+    return 0;
+}
+
 static int cell_radius(uint32_t sx, uint32_t sy, uint32_t w, uint32_t h, int wrap) {
     if (wrap) {
         uint32_t dx = sx;
@@ -169,11 +428,12 @@ static int cell_radius(uint32_t sx, uint32_t sy, uint32_t w, uint32_t h, int wra
 static void render_radial_summary(void) {
     uint32_t w = g_snap.size.width;
     uint32_t h = g_snap.size.height;
-    uint32_t cells_total = g_snap.cell_count;
-    if (w == 0 || h == 0 || cells_total != w * h) {
+    if (!view_valid()) {
         log_error("Invalid snapshot dimensions");
         return;
     }
+    const uint32_t x0 = (uint32_t)g_snap.view.x, x1 = x0 + g_snap.view_size.width;
+    const uint32_t y0 = (uint32_t)g_snap.view.y, y1 = y0 + g_snap.view_size.height;
 
     /* Distance is measured from origin (0,0). For WRAP worlds use toroidal
      * Manhattan distance; for obstacle worlds use standard Manhattan.
@@ -200,19 +460,21 @@ static void render_radial_summary(void) {
         return;
     }
 
+    const int have_avg = g_snap.sum_steps || g_snap.avg_steps_q;
+    const int have_p = g_snap.succ_leq_k || g_snap.p_leq_k_q;
     uint32_t non_obstacle_cells = 0;
     uint32_t used_cells = 0;
     double global_max_avg = 0.0;
     int obstacles_present = 0;
 
     /* First pass: aggregate by radius. */
-    for (uint32_t sy = 0; sy < h; ++sy) {
-        for (uint32_t sx = 0; sx < w; ++sx) {
-            uint32_t idx = sy * w + sx;
+    for (uint32_t sy = y0; sy < y1; ++sy) {
+        for (uint32_t sx = x0; sx < x1; ++sx) {
+            uint64_t idx = view_idx(sx, sy);
             int r = cell_radius(sx, sy, w, h, wrap);
             if (r < 0 || r > r_max) continue;
 
-            int obstacle = g_snap.obstacles && g_snap.obstacles[idx];
+            int obstacle = cell_obstacle(idx);
             if (obstacle) {
                 obstacles_present = 1;
             } else {
@@ -222,13 +484,25 @@ static void render_radial_summary(void) {
 
             if (obstacle) continue;
 
-            uint32_t trials = g_snap.trials ? g_snap.trials[idx] : 0u;
-            uint32_t succ = g_snap.succ_leq_k ? g_snap.succ_leq_k[idx] : 0u;
-            uint64_t sum_steps_cell = g_snap.sum_steps ? g_snap.sum_steps[idx] : 0u;
-            if (trials == 0) continue;
+            if (!cell_has_trials(idx)) continue;
             n_used[r]++;
             used_cells++;
 
+            if (!g_snap.trials) {
+                /* Derived snapshot: ring average of the per-cell averages. */
+                double avg_i = cell_avg_steps(idx);
+                if (!isnan(avg_i)) {
+                    sum_avg_steps[r] += avg_i;
+                    succ_count_r[r]++;
+                    if (avg_i > global_max_avg) global_max_avg = avg_i;
+                }
+                if (have_p) sum_p[r] += cell_p_leq_k(idx);
+                continue;
+            }
+
+            uint32_t trials = g_snap.trials[idx];
+            uint32_t succ = g_snap.succ_leq_k ? g_snap.succ_leq_k[idx] : 0u;
+            uint64_t sum_steps_cell = g_snap.sum_steps ? g_snap.sum_steps[idx] : 0u;
             sum_steps_r[r] += sum_steps_cell;
             succ_count_r[r] += succ;
 
@@ -256,10 +530,12 @@ static void render_radial_summary(void) {
     for (int r = 0; r <= r_max; ++r) {
         if (succ_count_r[r] > 0 && g_snap.sum_steps) {
             avg_r[r] = (double)sum_steps_r[r] / (double)succ_count_r[r];
+        } else if (succ_count_r[r] > 0 && g_snap.avg_steps_q) {
+            avg_r[r] = sum_avg_steps[r] / (double)succ_count_r[r];
         } else {
             avg_r[r] = NAN;
         }
-        if (n_used[r] > 0 && g_snap.succ_leq_k) {
+        if (n_used[r] > 0 && have_p) {
             p_r[r] = sum_p[r] / (double)n_used[r];
         } else {
             p_r[r] = NAN;
@@ -269,21 +545,22 @@ static void render_radial_summary(void) {
     /* Second pass: obstacle-induced local increases. */
     double max_increase = -INFINITY;
     int have_increase = 0;
-    if (g_snap.sum_steps) {
-        for (uint32_t sy = 0; sy < h; ++sy) {
-            for (uint32_t sx = 0; sx < w; ++sx) {
-                uint32_t idx = sy * w + sx;
+    if (have_avg) {
+        for (uint32_t sy = y0; sy < y1; ++sy) {
+            for (uint32_t sx = x0; sx < x1; ++sx) {
+                uint64_t idx = view_idx(sx, sy);
                 int r = cell_radius(sx, sy, w, h, wrap);
                 if (r < 0 || r > r_max) continue;
-                if (g_snap.obstacles && g_snap.obstacles[idx]) continue;
-
-                uint32_t trials = g_snap.trials ? g_snap.trials[idx] : 0u;
-                if (trials == 0) continue;
+                if (cell_obstacle(idx)) continue;
+                if (!cell_has_trials(idx)) continue;
 
                 double baseline = avg_r[r];
                 if (isnan(baseline) || baseline == 0.0) continue;
 
-                double avg_i = (double)g_snap.sum_steps[idx] / (double)trials;
+                double avg_i = g_snap.sum_steps
+                                   ? (double)g_snap.sum_steps[idx] / (double)g_snap.trials[idx]
+                                   : cell_avg_steps(idx);
+                if (isnan(avg_i)) continue;
                 double inc = (avg_i - baseline) / baseline;
                 if (inc > max_increase) {
                     max_increase = inc;
@@ -414,46 +691,56 @@ static void print_legend(void) {
 }
 
 static void render_cell_grid_preview(void) {
-    const uint32_t w = g_snap.size.width;
-    const uint32_t h = g_snap.size.height;
-    if (w == 0 || h == 0 || g_snap.cell_count != w * h) {
+    if (!view_valid()) {
         log_error("Invalid snapshot dimensions for grid preview");
         return;
     }
+    const uint32_t w = g_snap.view_size.width;
+    const uint32_t h = g_snap.view_size.height;
+    const uint32_t x0 = (uint32_t)g_snap.view.x;
+    const uint32_t y0 = (uint32_t)g_snap.view.y;
 
     const uint32_t max_rows = 12u; /* keep output compact */
     const uint32_t max_cols = 24u;
     uint32_t rows = h < max_rows ? h : max_rows;
     uint32_t cols = w < max_cols ? w : max_cols;
 
-    printf("GRID PREVIEW (top-left %ux%u of %ux%u)\n", cols, rows, w, h);
-    printf("y/x");
-    for (uint32_t x = 0; x < cols; ++x) {
-        printf(" %2u", x);
+    if (w == g_snap.size.width && h == g_snap.size.height) {
+        printf("GRID PREVIEW (top-left %ux%u of %ux%u)\n", cols, rows, w, h);
+    } else {
+        printf("GRID PREVIEW (top-left %ux%u of region %ux%u at (%u,%u), world %ux%u)\n",
+               cols, rows, w, h, x0, y0, g_snap.size.width, g_snap.size.height);
+    }
+    /* Column/row label widths grow with the coordinates of a region. */
+    int cw = snprintf(NULL, 0, "%u", x0 + cols - 1u);
+    int rw = snprintf(NULL, 0, "%u", y0 + rows - 1u);
+    if (cw < 2) cw = 2;
+    if (rw < 3) rw = 3;
+
+    printf("%-*s", rw, "y/x");
+    for (uint32_t x = x0; x < x0 + cols; ++x) {
+        printf(" %*u", cw, x);
     }
     printf("\n");
 
-    for (uint32_t y = 0; y < rows; ++y) {
-        printf("%3u", y);
-        for (uint32_t x = 0; x < cols; ++x) {
-            uint32_t idx = y * w + x;
-            int obstacle = g_snap.obstacles ? g_snap.obstacles[idx] : 0;
-            if (obstacle) {
-                printf(" ##");
+    for (uint32_t y = y0; y < y0 + rows; ++y) {
+        printf("%*u", rw, y);
+        for (uint32_t x = x0; x < x0 + cols; ++x) {
+            uint64_t idx = view_idx(x, y);
+            if (cell_obstacle(idx)) {
+                printf(" %*s", cw, "##");
                 continue;
             }
-            uint32_t trials = g_snap.trials ? g_snap.trials[idx] : 0u;
-            uint32_t succ = g_snap.succ_leq_k ? g_snap.succ_leq_k[idx] : 0u;
             char c = '.';
-            if (trials == 0) {
+            if (!cell_has_trials(idx)) {
                 c = ' ';
             } else {
-                double p = (succ == 0) ? 0.0 : (double)succ / (double)trials;
+                double p = cell_p_leq_k(idx);
                 size_t palette_idx = (size_t)lrint(p * (double)(strlen(SNAP_PALETTE) - 1));
                 if (palette_idx >= strlen(SNAP_PALETTE)) palette_idx = strlen(SNAP_PALETTE) - 1;
                 c = SNAP_PALETTE[palette_idx];
             }
-            printf("  %c", c);
+            printf(" %*c", cw, c);
         }
         printf("\n");
     }
@@ -461,6 +748,25 @@ static void render_cell_grid_preview(void) {
 }
 
 int client_snapshot_end(void) {
+    if (view_valid() && !g_snap.failed && g_snap.quant_bits == 0) {
+        /* only RAW snapshots can be the base of a delta */
+        atomic_store(&g_applied_id, g_snap.snapshot_id);
+        if (g_snap.mapped) {
+            snapshot_cache_info_t info;
+            memset(&info, 0, sizeof(info));
+            info.server_instance = g_server_instance;
+            info.snapshot_id = g_snap.snapshot_id;
+            info.begin = g_snap.begin;
+            snapshot_cache_commit(&info);
+        }
+    }
+    if (g_quiet) {
+        return 0;
+    }
+    if (g_snap.base_snapshot_id != 0) {
+        printf("Delta snapshot #%u (base #%u): %" PRIu64 " bytes of changed cells received\n",
+               g_snap.snapshot_id, g_snap.base_snapshot_id, g_snap.bytes_received);
+    }
     /* Render assembled snapshot. */
     render_radial_summary();
     print_legend();
@@ -469,7 +775,7 @@ int client_snapshot_end(void) {
 }
 
 int client_snapshot_render_last(void) {
-    if (g_snap.cell_count == 0 || g_snap.size.width == 0 || g_snap.size.height == 0) {
+    if (!view_valid()) {
         log_error("No snapshot available");
         return -1;
     }
@@ -480,18 +786,36 @@ int client_snapshot_render_last(void) {
 }
 
 int client_snapshot_dump_cell(uint32_t x, uint32_t y) {
-    const uint32_t w = g_snap.size.width;
-    const uint32_t h = g_snap.size.height;
-    if (w == 0 || h == 0 || g_snap.cell_count != w * h) {
+    if (!view_valid()) {
         log_error("No snapshot available");
         return -1;
     }
-    if (x >= w || y >= h) {
-        log_error("Cell out of bounds (x=%u y=%u)", (unsigned)x, (unsigned)y);
+    if (x < (uint32_t)g_snap.view.x || y < (uint32_t)g_snap.view.y ||
+        x - (uint32_t)g_snap.view.x >= g_snap.view_size.width ||
+        y - (uint32_t)g_snap.view.y >= g_snap.view_size.height) {
+        log_error("Cell out of snapshot view (x=%u y=%u)", (unsigned)x, (unsigned)y);
         return -1;
     }
 
-    uint32_t idx = y * w + x;
+    uint64_t idx = view_idx(x, y);
+    if (g_snap.quant_bits) {
+        double avg = cell_avg_steps(idx);
+        printf("SNAPSHOT CELL (%u,%u) [derived %u-bit]\n", (unsigned)x, (unsigned)y, (unsigned)g_snap.quant_bits);
+        printf("  obstacle: %s\n", cell_obstacle(idx) ? "yes" : "no");
+        printf("  avg_steps_if_succ: ");
+        if (isnan(avg)) {
+            printf("n/a\n");
+        } else {
+            printf("%.3f (+-%.3f)\n", avg, g_snap.avg_steps_scale / 2.0);
+        }
+        if (cell_has_trials(idx)) {
+            printf("  p<=K   : %.6f (+-%.6f)\n", cell_p_leq_k(idx), g_snap.p_leq_k_scale / 2.0);
+        } else {
+            printf("  p<=K   : n/a (no trials)\n");
+        }
+        printf("\n");
+        return 0;
+    }
     int obstacle = g_snap.obstacles ? g_snap.obstacles[idx] : 0;
     uint32_t trials = g_snap.trials ? g_snap.trials[idx] : 0u;
     uint32_t succ = g_snap.succ_leq_k ? g_snap.succ_leq_k[idx] : 0u;
@@ -514,6 +838,17 @@ int client_snapshot_dump_cell(uint32_t x, uint32_t y) {
     } else {
         printf("  p<=K   : n/a (no trials)\n");
     }
+    if (g_snap.hit_time) {
+        double e = g_snap.hit_time[idx];
+        printf("  E[T]    : ");
+        if (isnan(e)) {
+            printf("n/a (obstacle)\n");
+        } else if (isinf(e)) {
+            printf("infinite (origin not reached almost surely)\n");
+        } else {
+            printf("%.3f\n", e);
+        }
+    }
     printf("\n");
     return 0;
 }
@@ -522,7 +857,123 @@ void client_snapshot_set_k_max(uint32_t k_max_steps) {
     g_k_max_steps = k_max_steps;
 }
 
+void client_snapshot_set_quiet(int quiet) {
+    g_quiet = quiet ? 1 : 0;
+}
+
+int client_snapshot_last_info(uint32_t *snapshot_id, uint32_t *base_snapshot_id, uint64_t *bytes) {
+    if (!view_valid()) return -1;
+    if (snapshot_id) *snapshot_id = g_snap.snapshot_id;
+    if (base_snapshot_id) *base_snapshot_id = g_snap.base_snapshot_id;
+    if (bytes) *bytes = g_snap.bytes_received;
+    return 0;
+}
+
+int client_snapshot_heatmap(char *out, uint32_t *cols, uint32_t *rows) {
+    if (!out || !cols || !rows || *cols == 0 || *rows == 0 || !view_valid()) return -1;
+    const uint32_t w = g_snap.view_size.width;
+    const uint32_t h = g_snap.view_size.height;
+    const uint32_t nc = *cols < w ? *cols : w;
+    const uint32_t nr = *rows < h ? *rows : h;
+    const size_t nb = (size_t)nc * nr;
+
+    /* per block: sum of p<=K and count of cells with trials, obstacle and total cell counts */
+    double *p_sum = (double *)calloc(nb, sizeof(double));
+    uint64_t *n_trials = (uint64_t *)calloc(nb, sizeof(uint64_t));
+    uint64_t *n_obst = (uint64_t *)calloc(nb, sizeof(uint64_t));
+    uint64_t *n_cells = (uint64_t *)calloc(nb, sizeof(uint64_t));
+    if (!p_sum || !n_trials || !n_obst || !n_cells) {
+        free(p_sum);
+        free(n_trials);
+        free(n_obst);
+        free(n_cells);
+        return -1;
+    }
+
+    for (uint32_t y = 0; y < h; ++y) {
+        const size_t row = (size_t)((uint64_t)y * nr / h) * nc;
+        for (uint32_t x = 0; x < w; ++x) {
+            const size_t b = row + (size_t)((uint64_t)x * nc / w);
+            const uint64_t idx = (uint64_t)y * w + x;
+            n_cells[b]++;
+            if (cell_obstacle(idx)) {
+                n_obst[b]++;
+            } else if (cell_has_trials(idx)) {
+                n_trials[b]++;
+                p_sum[b] += cell_p_leq_k(idx);
+            }
+        }
+    }
+
+    const size_t pal = strlen(SNAP_PALETTE);
+    for (size_t b = 0; b < nb; ++b) {
+        char c = ' ';
+        if (n_trials[b] > 0) {
+            size_t pi = (size_t)lrint(p_sum[b] / (double)n_trials[b] * (double)(pal - 1));
+            c = SNAP_PALETTE[pi < pal ? pi : pal - 1];
+        } else if (n_obst[b] * 2 >= n_cells[b]) {
+            c = 'X';
+        }
+        out[b] = c;
+    }
+    free(p_sum);
+    free(n_trials);
+    free(n_obst);
+    free(n_cells);
+
+    *cols = nc;
+    *rows = nr;
+    return 0;
+}
+
+int client_snapshot_cache_attach(const char *path, uint64_t server_instance) {
+    g_server_instance = server_instance;
+    if (!path || strlen(path) >= sizeof(g_cache_path)) {
+        g_cache_path[0] = '\0';
+        return 0;
+    }
+    memcpy(g_cache_path, path, strlen(path) + 1u);
+    if (view_valid()) {
+        return 0; /* keep the snapshot we hold */
+    }
+
+    snapshot_cache_info_t info;
+    void *data = NULL;
+    uint64_t len = 0;
+    if (snapshot_cache_open(g_cache_path, &info, &data, &len) != 0) {
+        return 0;
+    }
+    uint64_t off[RW_SNAP_FIELD_HIT_TIME + 1];
+    const rw_snapshot_begin_t *b = &info.begin;
+    memset(&g_snap, 0, sizeof(g_snap));
+    g_snap.size = b->size;
+    g_snap.world_kind = b->world_kind;
+    g_snap.view = b->view;
+    g_snap.view_size = b->view_size;
+    g_snap.cell_count = b->cell_count;
+    if (info.server_instance != server_instance || b->quant_bits != 0 || !view_valid() ||
+        b->cell_count > RW_SNAPSHOT_MAX_CELLS || raw_layout(b->included_fields, b->cell_count, off) != len) {
+        log_info("Snapshot cache %s is from another server run or invalid; ignoring it", g_cache_path);
+        snapshot_cache_close();
+        memset(&g_snap, 0, sizeof(g_snap));
+        return 0;
+    }
+    g_snap.snapshot_id = info.snapshot_id;
+    g_snap.included_fields = b->included_fields;
+    g_snap.begin = *b;
+    raw_assign((uint8_t *)data, off);
+    g_snap.mapped = 1;
+    atomic_store(&g_applied_id, info.snapshot_id);
+    log_info("Loaded cached snapshot #%u (%" PRIu64 " cells) from %s", info.snapshot_id, b->cell_count, g_cache_path);
+    return 1;
+}
+
+uint32_t client_snapshot_base_id(void) {
+    return atomic_load(&g_applied_id);
+}
+
 void client_snapshot_free(void) {
+    atomic_store(&g_applied_id, 0u);
     free_snapshot_buffers();
     memset(&g_snap, 0, sizeof(g_snap));
 }
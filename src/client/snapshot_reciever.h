@@ -38,7 +38,9 @@
  * @brief Begin assembling a new snapshot.
  *
  * Frees any previously assembled snapshot buffers and allocates buffers for the
- * fields indicated by @p begin->included_fields.
+ * fields indicated by @p begin->included_fields. A delta
+ * (@p begin->base_snapshot_id != 0) instead keeps the buffers of that base
+ * snapshot, which must be the last one received completely.
  *
  * @param begin Snapshot metadata received from the server.
  * @retval 0  Success.
@@ -81,6 +83,8 @@ int client_snapshot_render_last(void);
 
 /**
  * @brief Dump one cell from the last snapshot to stdout.
+ *
+ * @p x and @p y are absolute world coordinates inside the snapshot view.
  */
 int client_snapshot_dump_cell(uint32_t x, uint32_t y);
 
@@ -89,6 +93,58 @@ int client_snapshot_dump_cell(uint32_t x, uint32_t y);
  */
 void client_snapshot_set_k_max(uint32_t k_max_steps);
 
+/**
+ * @brief Suppress (1) or restore (0) rendering when a snapshot completes.
+ *
+ * Used by the dashboard, which draws the snapshot itself.
+ */
+void client_snapshot_set_quiet(int quiet);
+
+/**
+ * @brief Describe the last assembled snapshot.
+ *
+ * @param snapshot_id      Output id (may be NULL).
+ * @param base_snapshot_id Output base of a delta, 0 for a full snapshot (may be NULL).
+ * @param bytes            Output chunk bytes received for it (may be NULL).
+ * @return 0 on success, -1 if no snapshot is available.
+ */
+int client_snapshot_last_info(uint32_t *snapshot_id, uint32_t *base_snapshot_id, uint64_t *bytes);
+
+/**
+ * @brief Downsample the last snapshot to a character heatmap.
+ *
+ * The view is split into @p cols x @p rows blocks (at most one cell each).
+ * A block shows the mean p<=K of its cells with trials on the grid preview
+ * palette, 'X' if at least half of it is obstacles, ' ' otherwise.
+ *
+ * @param out  Output, cols * rows characters row by row (not NUL-terminated).
+ * @param cols In: maximum columns, out: columns used.
+ * @param rows In: maximum rows, out: rows used.
+ * @return 0 on success, -1 if no snapshot is available or allocation failed.
+ */
+int client_snapshot_heatmap(char *out, uint32_t *cols, uint32_t *rows);
+
+/**
+ * @brief Keep RAW snapshots in the cache file @p path (see snapshot_cache.h).
+ *
+ * Call before the dispatcher starts. If no snapshot is held yet, the cached one
+ * is loaded when it comes from @p server_instance; it then is the base of the
+ * next delta request (@ref client_snapshot_base_id()).
+ *
+ * @param path            Cache file, NULL = keep snapshots on the heap.
+ * @param server_instance rw_welcome_t::server_instance of the connection.
+ * @return 1 if a cached snapshot was loaded, 0 otherwise.
+ */
+int client_snapshot_cache_attach(const char *path, uint64_t server_instance);
+
+/**
+ * @brief Id of the last completely received RAW snapshot, to request a delta
+ *        against (0 = none; also 0 while a full snapshot is being received).
+ *
+ * May be called from any thread.
+ */
+uint32_t client_snapshot_base_id(void);
+
 /**
  * @brief Free any allocated snapshot buffers.
  *
@@ -6,11 +6,14 @@
 
 #include "client_ipc.h"
 #include "client_dispatcher.h"
+#include "dashboard.h"
 #include "snapshot_reciever.h"
+#include "snapshot_cache.h"
 #include "../common/util.h"
 #include "../common/protocol.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -27,8 +30,21 @@
  * - Snapshot reception/rendering is asynchronous; the menu triggers snapshot
  *   requests and can re-render or inspect the last received snapshot.
  * - Interactive input is read from stdin and is expected to be used from a TTY.
+ *   stdin is unbuffered, so the dashboard can poll() fd 0 without input
+ *   hiding in the stdio buffer.
+ * - A lost connection is re-established with the session token from WELCOME
+ *   (ownership is kept within the server's grace period); a resumed session
+ *   then fetches only the cells changed since the last complete raw snapshot.
  */
 
+/** Reconnect attempts after a lost connection (1, 2, 4, 8, 8, ... s apart). */
+#define MENU_RECONNECT_ATTEMPTS 8
+
+/** Session token of the current connection (0 before the first WELCOME). */
+static uint64_t g_session_token = 0;
+/* Snapshot cache file of this server socket ("" = disabled), see snapshot_cache.h. */
+static char g_cache_path[RW_PATH_MAX];
+
 /**
  * @brief Print a compact status summary for the user.
  *
@@ -216,6 +232,159 @@ static int menu_new_sim(int fd) {
     return client_ipc_create_sim(fd, &req);
 }
 
+/**
+ * @brief Handle the "Map world file" menu action.
+ *
+ * Maps an RWTILE file as the (read-only) server world, optionally generating
+ * it first or converting the current world into it.
+ *
+ * @param fd Connected server socket.
+ * @return 0 on success, -1 on failure.
+ */
+static int menu_map_world(int fd) {
+    rw_map_world_t req;
+    memset(&req, 0, sizeof(req));
+
+    uint32_t mode = 0;
+    printf("0 = map existing file, 1 = generate new file, 2 = convert current world.\n");
+    if (prompt_u32("Mode", &mode) != 0 || mode > RW_WIRE_MAP_CONVERT) return -1;
+
+    int multi = 0;
+    if (prompt_yes_no("Multi-user mode?", &multi) != 0) return -1;
+
+    if (mode == RW_WIRE_MAP_GENERATE) {
+        uint32_t w = 0, h = 0, percent = 0, seed = 0;
+        int obstacles = 0;
+        if (prompt_u32("World width", &w) != 0) return -1;
+        if (prompt_u32("World height", &h) != 0) return -1;
+        if (prompt_yes_no("World type obstacles? (n=wrap)", &obstacles) != 0) return -1;
+        if (prompt_u32("Obstacle percent", &percent) != 0 || percent > 100) return -1;
+        if (prompt_u32("Seed", &seed) != 0) return -1;
+
+        req.world_kind = obstacles ? RW_WIRE_WORLD_OBSTACLES : RW_WIRE_WORLD_WRAP;
+        req.size.width = w;
+        req.size.height = h;
+        req.obstacle_percent = (uint8_t)percent;
+        req.seed = seed;
+    }
+
+    printf("World file path (RWTILE, on the server): ");
+    fflush(stdout);
+    if (read_line(req.path, sizeof(req.path)) != 0) return -1;
+
+    req.mode = (uint8_t)mode;
+    req.multi_user = (uint8_t)(multi ? 1 : 0);
+    if (mode == RW_WIRE_MAP_GENERATE) {
+        log_info("Generating world file (may take a while)...");
+    }
+    return client_ipc_map_world(fd, &req);
+}
+
+/**
+ * @brief Handle the "Import world image" menu action.
+ *
+ * @param fd Connected server socket.
+ * @return 0 on success, -1 on failure.
+ */
+static int menu_import_image(int fd) {
+    rw_import_image_t req;
+    memset(&req, 0, sizeof(req));
+
+    printf("Image path (binary PBM/PGM, on the server): ");
+    fflush(stdout);
+    if (read_line(req.path, sizeof(req.path)) != 0) return -1;
+
+    int obstacles = 0;
+    if (prompt_yes_no("World type obstacles? (n=wrap)", &obstacles) != 0) return -1;
+
+    uint32_t threshold = 0;
+    printf("PGM pixels darker than the threshold become obstacles (PBM: black).\n");
+    if (prompt_u32("Threshold (0-255)", &threshold) != 0 || threshold > 255u) return -1;
+
+    int multi = 0;
+    if (prompt_yes_no("Multi-user mode?", &multi) != 0) return -1;
+
+    req.world_kind = obstacles ? RW_WIRE_WORLD_OBSTACLES : RW_WIRE_WORLD_WRAP;
+    req.threshold = (uint8_t)threshold;
+    req.multi_user = (uint8_t)(multi ? 1 : 0);
+    return client_ipc_import_image(fd, &req);
+}
+
+/**
+ * @brief Handle the "Export heatmap image" menu action.
+ *
+ * The format follows the file extension (.png, otherwise PPM).
+ *
+ * @param fd Connected server socket.
+ * @return 0 on success, -1 on failure.
+ */
+static int menu_export_image(int fd) {
+    rw_export_image_t req;
+    memset(&req, 0, sizeof(req));
+
+    printf("Image path (.ppm or .png, on the server): ");
+    fflush(stdout);
+    if (read_line(req.path, sizeof(req.path)) != 0) return -1;
+    size_t len = strlen(req.path);
+    req.format = (len >= 4 && strcmp(req.path + len - 4, ".png") == 0) ? RW_WIRE_IMAGE_PNG : RW_WIRE_IMAGE_PPM;
+
+    uint32_t field = 0, cmap = 0, downsample = 0;
+    if (prompt_u32("Field (0=p<=K, 1=avg steps)", &field) != 0 || field > 1u) return -1;
+    if (prompt_u32("Colormap (0=viridis, 1=heat, 2=gray)", &cmap) != 0 || cmap > 2u) return -1;
+    if (prompt_u32("Cells per pixel edge (0=auto)", &downsample) != 0) return -1;
+    if (field == 1u && prompt_double("Avg steps at the top color (0=largest)", &req.max_value) != 0) return -1;
+
+    req.field = (uint8_t)field;
+    req.colormap = (uint8_t)cmap;
+    req.downsample = downsample;
+    log_info("Rendering image on the server...");
+    return client_ipc_export_image(fd, &req);
+}
+
+/**
+ * @brief Handle the "Trace" menu action.
+ *
+ * @param fd Connected server socket.
+ * @return 0 on success, -1 on failure.
+ */
+static int menu_trace(int fd) {
+    uint32_t action = 0;
+    printf("0 = start, 1 = stop, 2 = dump to file\n");
+    if (prompt_u32("Trace action", &action) != 0 || action > RW_WIRE_TRACE_DUMP) return -1;
+
+    char path[RW_PATH_MAX] = {0};
+    if (action == RW_WIRE_TRACE_DUMP) {
+        printf("Trace file path (Chrome JSON, written by server): ");
+        fflush(stdout);
+        if (read_line(path, sizeof(path)) != 0) return -1;
+    }
+    return client_ipc_trace(fd, (uint8_t)action, path);
+}
+
+/**
+ * @brief Handle the "Request latency stats" menu action.
+ *
+ * @param fd Connected server socket.
+ * @return 0 on success, -1 on failure.
+ */
+static int menu_latency_stats(int fd) {
+    rw_stats_t st;
+    if (client_ipc_query_stats(fd, &st) != 0) return -1;
+
+    printf("%-20s %10s %10s %10s %10s %10s\n", "request", "count", "p50 us", "p99 us", "p999 us", "max us");
+    for (uint32_t i = 0; i < st.count; i++) {
+        const rw_stats_entry_t *e = &st.entries[i];
+        printf("%-20s %10llu %10.1f %10.1f %10.1f %10.1f\n",
+               rw_msg_type_name(e->type), (unsigned long long)e->count,
+               (double)e->p50_ns / 1e3, (double)e->p99_ns / 1e3,
+               (double)e->p999_ns / 1e3, (double)e->max_ns / 1e3);
+    }
+    if (st.count == 0) {
+        printf("(no requests recorded)\n");
+    }
+    return 0;
+}
+
 /**
  * @brief Handle the "Restart finished" menu action.
  *
@@ -267,6 +436,228 @@ static int menu_restart_finished(int fd) {
     return 0;
 }
 
+/**
+ * @brief Handle the "CRN diff report" menu action.
+ *
+ * Configuration A is the current server configuration; the user enters
+ * configuration B (probabilities, K), the number of paired replications, the
+ * common seed and the server-side report path.
+ *
+ * @param fd Connected server socket.
+ * @return 0 on success, -1 on failure.
+ */
+static int menu_crn_diff(int fd) {
+    rw_crn_diff_t req;
+    memset(&req, 0, sizeof(req));
+
+    printf("Configuration B (A = current server configuration)\n");
+    if (prompt_double("p_up", &req.probs_b.p_up) != 0) return -1;
+    if (prompt_double("p_down", &req.probs_b.p_down) != 0) return -1;
+    if (prompt_double("p_left", &req.probs_b.p_left) != 0) return -1;
+    if (prompt_double("p_right", &req.probs_b.p_right) != 0) return -1;
+    if (prompt_u32("K (max steps)", &req.k_b) != 0) return -1;
+    if (prompt_u32("Paired replications per cell", &req.reps) != 0) return -1;
+
+    uint32_t seed = 0;
+    if (prompt_u32("Seed", &seed) != 0) return -1;
+    req.seed = seed;
+
+    printf("Report file path (CSV, written by server): ");
+    fflush(stdout);
+    if (read_line(req.path, sizeof(req.path)) != 0) return -1;
+
+    return client_ipc_crn_diff(fd, &req);
+}
+
+/**
+ * @brief Handle the "Edit obstacles" menu action.
+ *
+ * The user enters a list of cell edits (x, y, obstacle yes/no) and chooses
+ * whether the server re-simulates the affected cells right away.
+ *
+ * @param fd Connected server socket.
+ * @return 0 on success, -1 on failure.
+ */
+static int menu_edit_obstacles(int fd) {
+    uint32_t count = 0;
+    if (prompt_u32("Number of edited cells", &count) != 0) return -1;
+    if (count == 0 || count > RW_OBSTACLE_EDIT_MAX) {
+        log_error("Number of edits must be 1..%u", RW_OBSTACLE_EDIT_MAX);
+        return -1;
+    }
+
+    rw_obstacle_edit_t *edits = (rw_obstacle_edit_t *)calloc(count, sizeof(rw_obstacle_edit_t));
+    if (!edits) return -1;
+
+    for (uint32_t i = 0; i < count; i++) {
+        int value = 0;
+        printf("Edit %u/%u\n", i + 1, count);
+        if (prompt_u32("Cell x", &edits[i].x) != 0 ||
+            prompt_u32("Cell y", &edits[i].y) != 0 ||
+            prompt_yes_no("Obstacle?", &value) != 0) {
+            free(edits);
+            return -1;
+        }
+        edits[i].value = (uint8_t)(value ? 1 : 0);
+    }
+
+    int resimulate = 0;
+    if (prompt_yes_no("Re-simulate affected cells now?", &resimulate) != 0) {
+        free(edits);
+        return -1;
+    }
+
+    int rc = client_ipc_edit_obstacles(fd, edits, count, resimulate);
+    free(edits);
+    return rc;
+}
+
+/**
+ * @brief Handle the "Region statistics" menu action.
+ *
+ * 0 rectangles asks for the four quadrants of the world.
+ *
+ * @param fd Connected server socket.
+ * @return 0 on success, -1 on failure.
+ */
+static int menu_region_stats(int fd) {
+    uint32_t count = 0;
+    if (prompt_u32("Number of rectangles (0 = quadrants)", &count) != 0) return -1;
+    if (count > RW_REGION_QUERY_MAX) {
+        log_error("Number of rectangles must be 0..%u", RW_REGION_QUERY_MAX);
+        return -1;
+    }
+
+    const uint32_t n = count ? count : 4u;
+    rw_wire_rect_t *rects = (rw_wire_rect_t *)calloc(n, sizeof(rw_wire_rect_t));
+    rw_region_stat_t *stats = (rw_region_stat_t *)calloc(n, sizeof(rw_region_stat_t));
+    int rc = -1;
+    if (!rects || !stats) goto out;
+
+    if (count == 0) {
+        rw_status_t st;
+        if (client_ipc_query_status(fd, &st) != 0) goto out;
+        const uint32_t hw = st.size.width / 2u, hh = st.size.height / 2u;
+        rects[0] = (rw_wire_rect_t){0, 0, hw, hh};
+        rects[1] = (rw_wire_rect_t){hw, 0, st.size.width - hw, hh};
+        rects[2] = (rw_wire_rect_t){0, hh, hw, st.size.height - hh};
+        rects[3] = (rw_wire_rect_t){hw, hh, st.size.width - hw, st.size.height - hh};
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        printf("Rectangle %u/%u\n", i + 1, count);
+        if (prompt_u32("x", &rects[i].x) != 0 || prompt_u32("y", &rects[i].y) != 0 ||
+            prompt_u32("Width", &rects[i].width) != 0 || prompt_u32("Height", &rects[i].height) != 0) {
+            goto out;
+        }
+    }
+
+    uint64_t version = 0;
+    if (client_ipc_query_regions(fd, rects, n, stats, &version) != 0) goto out;
+
+    printf("%-25s %10s %12s %10s %10s\n", "rectangle (x,y wxh)", "cells", "trials", "p<=K", "avg steps");
+    for (uint32_t i = 0; i < n; i++) {
+        const rw_region_stat_t *s = &stats[i];
+        char name[64];
+        snprintf(name, sizeof(name), "%u,%u %ux%u", rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+        printf("%-25s %10llu %12llu ", name, (unsigned long long)s->cells, (unsigned long long)s->trials);
+        if (s->trials > 0) {
+            printf("%10.4f ", (double)s->successes / (double)s->trials);
+        } else {
+            printf("%10s ", "n/a");
+        }
+        if (s->successes > 0) {
+            printf("%10.2f\n", (double)s->sum_steps / (double)s->successes);
+        } else {
+            printf("%10s\n", "n/a");
+        }
+    }
+    printf("(results version %llu)\n", (unsigned long long)version);
+    rc = 0;
+
+out:
+    free(rects);
+    free(stats);
+    return rc;
+}
+
+/**
+ * @brief Connect, JOIN (resuming @ref g_session_token) and start the dispatcher.
+ *
+ * @param socket_path Path to the AF_UNIX server socket.
+ * @param welcome     Output WELCOME.
+ * @return Connected socket, or -1 on failure.
+ */
+static int session_connect(const char *socket_path, rw_welcome_t *welcome) {
+    int fd = client_ipc_connect(socket_path);
+    if (fd < 0) return -1;
+
+    /* Handshake BEFORE dispatcher: JOIN + blocking WELCOME receive. */
+    if (client_ipc_send_join(fd, g_session_token) != 0 || client_ipc_recv_welcome(fd, welcome) != 0) {
+        close(fd);
+        return -1;
+    }
+    g_session_token = welcome->session_token;
+    client_snapshot_set_k_max(welcome->k_max_steps);
+    (void)client_snapshot_cache_attach(g_cache_path[0] ? g_cache_path : NULL, welcome->server_instance);
+
+    /* Start single-reader dispatcher AFTER handshake. */
+    if (dispatcher_start(fd) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Ask for the cells changed since the held raw snapshot, if there is one.
+ */
+static void request_snapshot_update(int fd) {
+    uint32_t base = client_snapshot_base_id();
+    if (base == 0) return;
+    if (client_ipc_request_snapshot(fd, RW_SNAP_FORMAT_RAW, base) != 0) {
+        log_error("Snapshot request failed");
+    } else {
+        log_info("Requested cells changed since snapshot #%u...", base);
+    }
+}
+
+/**
+ * @brief Replace a lost connection, resuming the session.
+ *
+ * A resumed session asks for the cells changed since the last complete raw
+ * snapshot; a new session (e.g. the server restarted) drops the snapshot,
+ * whose id means nothing to the new server.
+ *
+ * @param socket_path Path to the AF_UNIX server socket.
+ * @param old_fd      Lost connection (closed here).
+ * @return New connected socket, or -1 when all attempts failed.
+ */
+static int session_reconnect(const char *socket_path, int old_fd) {
+    dispatcher_stop();
+    close(old_fd);
+
+    unsigned delay = 1;
+    for (int attempt = 1; attempt <= MENU_RECONNECT_ATTEMPTS; attempt++) {
+        log_info("Connection lost, reconnecting in %u s (attempt %d/%d)...", delay, attempt, MENU_RECONNECT_ATTEMPTS);
+        sleep(delay);
+        if (delay < 8) delay *= 2;
+
+        rw_welcome_t welcome;
+        int fd = session_connect(socket_path, &welcome);
+        if (fd < 0) continue;
+
+        if (!welcome.resumed) {
+            log_info("Reconnected as a new session%s", welcome.is_owner ? " (owner)" : "");
+            client_snapshot_free();
+            return fd;
+        }
+        log_info("Reconnected, session resumed%s", welcome.is_owner ? " (owner)" : "");
+        request_snapshot_update(fd);
+        return fd;
+    }
+    return -1;
+}
+
 /**
  * @brief Run the interactive client menu.
  *
@@ -278,34 +669,33 @@ static int menu_restart_finished(int fd) {
  */
 int ui_menu_run(const char *socket_path) {
     if (!socket_path) return 1;
-
-    int fd = client_ipc_connect(socket_path);
-    if (fd < 0) {
-        die("Failed to connect to server");
-    }
-
-    /* Handshake BEFORE dispatcher: JOIN + blocking WELCOME receive. */
-    if (client_ipc_send_join(fd) != 0) {
-        die("Failed to send JOIN");
+    setvbuf(stdin, NULL, _IONBF, 0);
+    if (snapshot_cache_default_path(socket_path, g_cache_path, sizeof(g_cache_path)) != 0) {
+        g_cache_path[0] = '\0';
     }
 
     rw_welcome_t welcome;
-    if (client_ipc_recv_welcome(fd, &welcome) != 0) {
-        die("Failed to receive WELCOME");
+    int fd = session_connect(socket_path, &welcome);
+    if (fd < 0) {
+        die("Failed to connect to server");
     }
 
-    log_info("Connected. WELCOME: size=%ux%u reps=%u K=%u", welcome.size.width, welcome.size.height, welcome.total_reps, welcome.k_max_steps);
-    client_snapshot_set_k_max(welcome.k_max_steps);
-
-    /* Start single-reader dispatcher AFTER handshake. */
-    if (dispatcher_start(fd) != 0) {
-        die("Failed to start dispatcher");
-    }
+    log_info("Connected. WELCOME: size=%ux%u reps=%u K=%u%s", welcome.size.width, welcome.size.height,
+             welcome.total_reps, welcome.k_max_steps, welcome.is_owner ? " (owner)" : "");
+    /* a snapshot loaded from the cache only needs the cells changed since */
+    request_snapshot_update(fd);
 
     while (1) {
         rw_status_t st;
         if (client_ipc_query_status(fd, &st) != 0) {
-            die("Failed to query status");
+            if (dispatcher_connected()) {
+                die("Failed to query status");
+            }
+            fd = session_reconnect(socket_path, fd);
+            if (fd < 0) {
+                die("Failed to reconnect to server");
+            }
+            continue;
         }
         /* Keep snapshot summaries in sync with the latest server K. */
         client_snapshot_set_k_max(st.k_max_steps);
@@ -321,6 +711,19 @@ int ui_menu_run(const char *socket_path) {
         printf("  7) Stop simulation\n");
         printf("  8) Re-render last snapshot\n");
         printf("  9) Dump cell from last snapshot\n");
+        printf(" 10) Solve expected hitting times\n");
+        printf(" 11) Set RNG mode (common random numbers)\n");
+        printf(" 12) CRN diff report (current config vs. B)\n");
+        printf(" 13) Edit obstacles (incremental re-simulation)\n");
+        printf(" 14) Cluster scaling report\n");
+        printf(" 15) Set region (simulate/view part of the world)\n");
+        printf(" 16) Map world file (out-of-core world)\n");
+        printf(" 17) Import world image (PBM/PGM)\n");
+        printf(" 18) Trace (Chrome JSON timeline)\n");
+        printf(" 19) Request latency stats\n");
+        printf(" 20) Live dashboard\n");
+        printf(" 21) Export heatmap image (PPM/PNG)\n");
+        printf(" 22) Region statistics\n");
         printf("  0) Quit\n");
         printf("Choice: ");
         fflush(stdout);
@@ -343,7 +746,12 @@ int ui_menu_run(const char *socket_path) {
                 log_error("Restart failed");
             }
         } else if (choice == 4) {
-            if (client_ipc_request_snapshot(fd) != 0) {
+            uint32_t format = 0;
+            printf("0 = raw counters, 1 = derived 8-bit, 2 = derived 16-bit\n");
+            if (prompt_u32("Snapshot format", &format) != 0 || format > RW_SNAP_FORMAT_DERIVED16) {
+                log_error("Invalid snapshot format");
+            } else if (client_ipc_request_snapshot(fd, (rw_wire_snapshot_format_t)format,
+                                                   format == RW_SNAP_FORMAT_RAW ? client_snapshot_base_id() : 0) != 0) {
                 log_error("Snapshot request failed");
             } else {
                 log_info("Snapshot requested. Waiting for snapshot stream...");
@@ -376,6 +784,88 @@ int ui_menu_run(const char *socket_path) {
                     log_error("Cell dump failed");
                 }
             }
+        } else if (choice == 10) {
+            log_info("Solving expected hitting times (may take a while)...");
+            if (client_ipc_solve_hit_time(fd, 0, 0.0) != 0) {
+                log_error("Solve failed");
+            } else {
+                log_info("Solved. Request a snapshot and dump a cell to see E[T].");
+            }
+        } else if (choice == 11) {
+            int crn = 0;
+            uint32_t seed = 0;
+            if (prompt_yes_no("Use common random numbers?", &crn) == 0 &&
+                (!crn || prompt_u32("Seed", &seed) == 0)) {
+                if (client_ipc_set_rng_mode(fd, crn, seed) != 0) {
+                    log_error("Set RNG mode failed");
+                }
+            }
+        } else if (choice == 12) {
+            if (menu_crn_diff(fd) != 0) {
+                log_error("CRN diff failed");
+            } else {
+                log_info("CRN diff report written.");
+            }
+        } else if (choice == 13) {
+            if (menu_edit_obstacles(fd) != 0) {
+                log_error("Obstacle edit failed");
+            }
+        } else if (choice == 14) {
+            uint32_t reps = 0;
+            char path[RW_PATH_MAX];
+            if (prompt_u32("Replications per worker count", &reps) == 0) {
+                printf("Report file path (CSV, written by server): ");
+                fflush(stdout);
+                if (read_line(path, sizeof(path)) == 0) {
+                    log_info("Measuring scaling (may take a while)...");
+                    if (client_ipc_cluster_scaling(fd, reps, path) != 0) {
+                        log_error("Scaling report failed");
+                    } else {
+                        log_info("Scaling report written.");
+                    }
+                }
+            }
+        } else if (choice == 15) {
+            uint32_t x = 0, y = 0, w = 0, h = 0;
+            printf("Width or height 0 = whole world.\n");
+            if (prompt_u32("Region x", &x) == 0 && prompt_u32("Region y", &y) == 0 &&
+                prompt_u32("Region width", &w) == 0 && prompt_u32("Region height", &h) == 0) {
+                if (client_ipc_set_region(fd, x, y, w, h) != 0) {
+                    log_error("Set region failed");
+                }
+            }
+        } else if (choice == 16) {
+            if (menu_map_world(fd) != 0) {
+                log_error("Map world failed");
+            }
+        } else if (choice == 17) {
+            if (menu_import_image(fd) != 0) {
+                log_error("Image import failed");
+            }
+        } else if (choice == 18) {
+            if (menu_trace(fd) != 0) {
+                log_error("Trace request failed");
+            }
+        } else if (choice == 19) {
+            if (menu_latency_stats(fd) != 0) {
+                log_error("Stats request failed");
+            }
+        } else if (choice == 20) {
+            uint32_t fps = 0, snapshot_ms = 0;
+            if (prompt_u32("Frames per second (1-30)", &fps) == 0 &&
+                prompt_u32("Heatmap refresh interval (ms, 0 = off)", &snapshot_ms) == 0) {
+                if (dashboard_run(fd, fps, snapshot_ms) != 0) {
+                    log_error("Dashboard stopped: connection failed");
+                }
+            }
+        } else if (choice == 21) {
+            if (menu_export_image(fd) != 0) {
+                log_error("Image export failed");
+            }
+        } else if (choice == 22) {
+            if (menu_region_stats(fd) != 0) {
+                log_error("Region statistics failed");
+            }
         } else if (choice == 0) {
             int stop = 0;
             if (isatty(STDIN_FILENO)) {
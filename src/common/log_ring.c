@@ -0,0 +1,264 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "log_ring.h"
+
+#include "util.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file log_ring.c
+ * @brief Implementation of the asynchronous ring-buffer logger.
+ */
+
+#define LOG_FLUSH_INTERVAL_NS 20000000L
+#define LOG_BATCH_MAX (LOG_RING_SLOTS * 4)
+
+typedef struct {
+    uint64_t seq;     /* global order of the messages */
+    time_t when;
+    int level;
+    char text[LOG_RING_TEXT];
+} log_record_t;
+
+typedef struct {
+    atomic_uint head;     /* next record the owner thread writes */
+    atomic_uint tail;     /* next record the flusher reads */
+    atomic_uint dropped;  /* messages lost because the ring was full */
+    atomic_int alive;     /* cleared when the owner thread exits */
+    int in_use;           /* handed out to a thread (g_reg_mtx) */
+    log_record_t rec[LOG_RING_SLOTS];
+} log_ring_t;
+
+static log_ring_t *g_rings[LOG_RING_MAX];          /* g_reg_mtx */
+static pthread_mutex_t g_reg_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_drain_mtx = PTHREAD_MUTEX_INITIALIZER; /* the single consumer */
+static log_record_t *g_batch;                      /* g_drain_mtx */
+
+static pthread_key_t g_ring_key;
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static _Thread_local log_ring_t *t_ring;
+
+static atomic_int g_active;
+static atomic_int g_stop;
+static atomic_ullong g_seq;
+static pthread_t g_flusher;
+
+static void ring_detach(void *p) {
+    atomic_store_explicit(&((log_ring_t *)p)->alive, 0, memory_order_release);
+}
+
+static void key_init(void) {
+    (void)pthread_key_create(&g_ring_key, ring_detach);
+}
+
+/* Hand a free ring to the calling thread (once per thread). */
+static log_ring_t *ring_attach(void) {
+    pthread_once(&g_key_once, key_init);
+
+    log_ring_t *r = NULL;
+    pthread_mutex_lock(&g_reg_mtx);
+    for (int i = 0; i < LOG_RING_MAX && !r; i++) {
+        if (!g_rings[i]) {
+            g_rings[i] = (log_ring_t *)calloc(1, sizeof(log_ring_t));
+            if (!g_rings[i]) break;
+        }
+        if (!g_rings[i]->in_use) {
+            r = g_rings[i];
+        }
+    }
+    if (r) {
+        r->in_use = 1;
+        atomic_store_explicit(&r->alive, 1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&g_reg_mtx);
+
+    if (r) {
+        t_ring = r;
+        (void)pthread_setspecific(g_ring_key, r);
+    }
+    return r;
+}
+
+static const char *level_name(int level) {
+    switch (level) {
+        case RW_LOG_DEBUG: return "DEBUG";
+        case RW_LOG_ERROR: return "ERROR";
+        default: return "INFO";
+    }
+}
+
+static int by_seq(const void *a, const void *b) {
+    uint64_t x = ((const log_record_t *)a)->seq;
+    uint64_t y = ((const log_record_t *)b)->seq;
+    return (x > y) - (x < y);
+}
+
+static void write_records(const log_record_t *rec, size_t n, unsigned dropped) {
+    time_t cached = (time_t)-1;
+    struct tm tmv;
+    memset(&tmv, 0, sizeof(tmv));
+
+    for (size_t i = 0; i < n; i++) {
+        if (rec[i].when != cached) {
+            cached = rec[i].when;
+            if (localtime_r(&cached, &tmv) == NULL) {
+                memset(&tmv, 0, sizeof(tmv));
+            }
+        }
+        FILE *out = rec[i].level >= RW_LOG_ERROR ? stderr : stdout;
+        fprintf(out, "[%02d:%02d:%02d] [%s] %s\n",
+                tmv.tm_hour, tmv.tm_min, tmv.tm_sec, level_name(rec[i].level), rec[i].text);
+    }
+    if (dropped > 0) {
+        time_t now = time(NULL);
+        if (localtime_r(&now, &tmv) == NULL) {
+            memset(&tmv, 0, sizeof(tmv));
+        }
+        fprintf(stderr, "[%02d:%02d:%02d] [ERROR] logger: %u messages dropped (ring full)\n",
+                tmv.tm_hour, tmv.tm_min, tmv.tm_sec, dropped);
+    }
+    fflush(stdout);
+    fflush(stderr);
+}
+
+/* Move everything queued to the output; caller holds g_drain_mtx. */
+static void drain_locked(void) {
+    log_ring_t *rings[LOG_RING_MAX];
+    int nrings = 0;
+
+    pthread_mutex_lock(&g_reg_mtx);
+    for (int i = 0; i < LOG_RING_MAX; i++) {
+        if (g_rings[i] && g_rings[i]->in_use) {
+            rings[nrings++] = g_rings[i];
+        }
+    }
+    pthread_mutex_unlock(&g_reg_mtx);
+
+    int more = 1;
+    while (more) {
+        size_t count = 0;
+        unsigned dropped = 0;
+        more = 0;
+
+        for (int i = 0; i < nrings; i++) {
+            log_ring_t *r = rings[i];
+            unsigned tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+            unsigned head = atomic_load_explicit(&r->head, memory_order_acquire);
+            unsigned take = head - tail;
+            if (take > LOG_BATCH_MAX - count) {
+                take = (unsigned)(LOG_BATCH_MAX - count);
+                more = 1;
+            }
+            for (unsigned k = 0; k < take; k++) {
+                g_batch[count++] = r->rec[(tail + k) & (LOG_RING_SLOTS - 1u)];
+            }
+            atomic_store_explicit(&r->tail, tail + take, memory_order_release);
+            dropped += atomic_exchange_explicit(&r->dropped, 0u, memory_order_relaxed);
+        }
+
+        if (count > 1) {
+            qsort(g_batch, count, sizeof(g_batch[0]), by_seq);
+        }
+        if (count > 0 || dropped > 0) {
+            write_records(g_batch, count, dropped);
+        }
+    }
+
+    //rings of exited threads are free again once empty
+    pthread_mutex_lock(&g_reg_mtx);
+    for (int i = 0; i < nrings; i++) {
+        log_ring_t *r = rings[i];
+        if (!atomic_load_explicit(&r->alive, memory_order_acquire) &&
+            atomic_load_explicit(&r->head, memory_order_relaxed) ==
+            atomic_load_explicit(&r->tail, memory_order_relaxed)) {
+            r->in_use = 0;
+        }
+    }
+    pthread_mutex_unlock(&g_reg_mtx);
+}
+
+static void *flusher_main(void *arg) {
+    (void)arg;
+    struct timespec ts = {0, LOG_FLUSH_INTERVAL_NS};
+
+    while (!atomic_load_explicit(&g_stop, memory_order_acquire)) {
+        nanosleep(&ts, NULL);
+        log_ring_flush();
+    }
+    return NULL;
+}
+
+int log_ring_push(int level, time_t when, const char *fmt, va_list ap) {
+    if (!atomic_load_explicit(&g_active, memory_order_acquire)) return -1;
+
+    log_ring_t *r = t_ring ? t_ring : ring_attach();
+    if (!r) return -1;
+
+    unsigned head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (head - tail >= LOG_RING_SLOTS) {
+        atomic_fetch_add_explicit(&r->dropped, 1u, memory_order_relaxed);
+        return 0;
+    }
+
+    log_record_t *rec = &r->rec[head & (LOG_RING_SLOTS - 1u)];
+    rec->seq = atomic_fetch_add_explicit(&g_seq, 1u, memory_order_relaxed);
+    rec->when = when;
+    rec->level = level;
+    vsnprintf(rec->text, sizeof(rec->text), fmt, ap);
+
+    atomic_store_explicit(&r->head, head + 1u, memory_order_release);
+    return 0;
+}
+
+void log_ring_flush(void) {
+    pthread_mutex_lock(&g_drain_mtx);
+    if (g_batch) {
+        drain_locked();
+    }
+    pthread_mutex_unlock(&g_drain_mtx);
+}
+
+int log_ring_start(void) {
+    if (atomic_load_explicit(&g_active, memory_order_acquire)) return 0;
+
+    pthread_mutex_lock(&g_drain_mtx);
+    g_batch = (log_record_t *)malloc(sizeof(log_record_t) * LOG_BATCH_MAX);
+    pthread_mutex_unlock(&g_drain_mtx);
+    if (!g_batch) return -1;
+
+    atomic_store_explicit(&g_stop, 0, memory_order_relaxed);
+    if (pthread_create(&g_flusher, NULL, flusher_main, NULL) != 0) {
+        pthread_mutex_lock(&g_drain_mtx);
+        free(g_batch);
+        g_batch = NULL;
+        pthread_mutex_unlock(&g_drain_mtx);
+        return -1;
+    }
+    atomic_store_explicit(&g_active, 1, memory_order_release);
+    return 0;
+}
+
+void log_ring_stop(void) {
+    if (!atomic_load_explicit(&g_active, memory_order_acquire)) return;
+
+    atomic_store_explicit(&g_active, 0, memory_order_release);
+    atomic_store_explicit(&g_stop, 1, memory_order_release);
+    pthread_join(g_flusher, NULL);
+
+    pthread_mutex_lock(&g_drain_mtx);
+    drain_locked();
+    free(g_batch);
+    g_batch = NULL;
+    pthread_mutex_unlock(&g_drain_mtx);
+}
@@ -0,0 +1,76 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_LOG_RING_H
+#define SEMPRACA_LOG_RING_H
+
+/**
+ * @file log_ring.h
+ * @brief Asynchronous logger: per-thread ring buffers drained by a flusher thread.
+ *
+ * Synchronous logging formats the time with localtime, writes through stdio
+ * and flushes every line, which turns the log into a sync point for the
+ * simulation and client threads. While the asynchronous logger runs, @ref
+ * rw_log() only formats the message into a ring owned by the calling thread;
+ * a background thread collects the rings, orders the records and writes them.
+ *
+ * Rings
+ * -----
+ * Each thread gets a single-producer/single-consumer ring of
+ * @ref LOG_RING_SLOTS records on its first message (lock-free after that).
+ * Rings of exited threads are recycled once drained. Records longer than
+ * @ref LOG_RING_TEXT bytes are truncated.
+ *
+ * Drop policy
+ * -----------
+ * A producer never waits: if its ring is full the message is dropped and
+ * counted, and the flusher reports the number of dropped messages. If all
+ * @ref LOG_RING_MAX rings are taken, the thread logs synchronously.
+ *
+ * Processes
+ * ---------
+ * Start the logger after any fork() (children must not inherit the flusher
+ * state) and stop it before exit so that nothing is lost. @ref die() drains
+ * the rings before writing the fatal message.
+ */
+
+#include <stdarg.h>
+#include <time.h>
+
+/** Records per thread ring. */
+#define LOG_RING_SLOTS 256
+/** Maximum number of thread rings. */
+#define LOG_RING_MAX 64
+/** Maximum message length (bytes, incl. NUL) of one record. */
+#define LOG_RING_TEXT 232
+
+/**
+ * @brief Start the flusher thread and route @ref rw_log() through the rings.
+ * @return 0 on success (or already running), -1 on failure.
+ */
+int log_ring_start(void);
+
+/**
+ * @brief Drain all rings, stop the flusher and return to synchronous logging.
+ */
+void log_ring_stop(void);
+
+/**
+ * @brief Write out everything queued so far (from the calling thread).
+ */
+void log_ring_flush(void);
+
+/**
+ * @brief Queue one message (used by @ref rw_log()).
+ *
+ * @param level RW_LOG_* level.
+ * @param when  Time of the message.
+ * @param fmt   printf-style format string.
+ * @param ap    Format arguments.
+ * @retval 0  Queued or dropped by the drop policy.
+ * @retval -1 The logger is not running or no ring is available; log synchronously.
+ */
+int log_ring_push(int level, time_t when, const char *fmt, va_list ap);
+
+#endif //SEMPRACA_LOG_RING_H
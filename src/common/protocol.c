@@ -5,6 +5,8 @@
 #include "protocol.h"
 
 #include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
@@ -106,6 +108,13 @@ int rw_send_msg(int fd, rw_msg_type_t type, const void *payload, uint32_t payloa
     return 0;
 }
 
+int rw_send_frames(int fd, const void *frames, size_t len) {
+    if (len > 0 && frames == NULL) {
+        return -1;
+    }
+    return rw_write_all(fd, frames, len);
+}
+
 /**
  * @brief Receive a message header.
  *
@@ -207,3 +216,196 @@ int rw_send_msg_noblock(int fd, rw_msg_type_t type, const void *payload, uint32_
     }
     return 0;
 }
+
+/**
+ * @brief Initialize a buffered receiver.
+ *
+ * @param rx Receiver.
+ * @param fd Connected socket.
+ * @return 0 on success, -1 on error.
+ */
+int rw_rx_init(rw_rx_buf_t *rx, int fd) {
+    if (!rx) {
+        return -1;
+    }
+    memset(rx, 0, sizeof(*rx));
+    rx->fd = fd;
+    rx->buf = (uint8_t *)malloc(RW_RX_BUF_INIT);
+    if (!rx->buf) {
+        return -1;
+    }
+    rx->cap = RW_RX_BUF_INIT;
+    rx->payload = rx->buf;
+    return 0;
+}
+
+/**
+ * @brief Release a buffered receiver.
+ *
+ * @param rx Receiver (may be NULL).
+ */
+void rw_rx_free(rw_rx_buf_t *rx) {
+    if (!rx) {
+        return;
+    }
+    free(rx->buf);
+    rx->buf = NULL;
+    rx->cap = 0;
+}
+
+/**
+ * @brief Make @p need bytes from rx->head available in the buffer.
+ *
+ * Moves the unparsed bytes to the front or grows the buffer when needed,
+ * then reads as much as the socket has (usually a single read()).
+ *
+ * @return 0 on success, -1 on EOF/error.
+ */
+static int rw_rx_fill(rw_rx_buf_t *rx, size_t need) {
+    //compact when the frame does not fit or little room is left for reads
+    if (rx->head + need > rx->cap || (rx->head > 0 && rx->cap - rx->tail < rx->cap / 4u)) {
+        size_t have = rx->tail - rx->head;
+        if (need > rx->cap) {
+            size_t cap = rx->cap;
+            while (cap < need) cap *= 2u;
+            uint8_t *p = (uint8_t *)malloc(cap);
+            if (!p) {
+                return -1;
+            }
+            memcpy(p, rx->buf + rx->head, have);
+            free(rx->buf);
+            rx->buf = p;
+            rx->cap = cap;
+        } else {
+            memmove(rx->buf, rx->buf + rx->head, have);
+        }
+        rx->head = 0;
+        rx->tail = have;
+    }
+
+    while (rx->tail - rx->head < need) {
+        ssize_t n = read(rx->fd, rx->buf + rx->tail, rx->cap - rx->tail);
+        if (n > 0) {
+            rx->tail += (size_t)n;
+            rx->reads++;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Receive the next complete frame into the buffer.
+ *
+ * @param rx Receiver.
+ * @param out_hdr Output header.
+ * @return 0 on success, -1 on EOF/error.
+ */
+int rw_rx_next(rw_rx_buf_t *rx, rw_msg_hdr_t *out_hdr) {
+    if (!rx || !rx->buf || !out_hdr) {
+        return -1;
+    }
+
+    //drop the previous frame (including unread payload)
+    rx->head = rx->next;
+    if (rx->head == rx->tail) {
+        rx->head = rx->tail = 0;
+    }
+
+    if (rw_rx_fill(rx, sizeof(rw_msg_hdr_t)) != 0) {
+        return -1;
+    }
+    memcpy(&rx->hdr, rx->buf + rx->head, sizeof(rx->hdr));
+    size_t frame = sizeof(rw_msg_hdr_t) + (size_t)rx->hdr.payload_len;
+    if (frame > RW_RX_FRAME_MAX || rw_rx_fill(rx, frame) != 0) {
+        return -1;
+    }
+
+    rx->payload = rx->buf + rx->head + sizeof(rw_msg_hdr_t);
+    rx->consumed = 0;
+    rx->next = rx->head + frame;
+    rx->frames++;
+    *out_hdr = rx->hdr;
+    return 0;
+}
+
+/**
+ * @brief Copy the next @p len payload bytes of the current frame.
+ *
+ * @param rx Receiver.
+ * @param buf Output buffer.
+ * @param len Number of bytes.
+ * @return 0 on success, -1 if fewer bytes are left.
+ */
+int rw_rx_payload(rw_rx_buf_t *rx, void *buf, uint32_t len) {
+    if (!rx || len > rx->hdr.payload_len - rx->consumed) {
+        return -1;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    if (!buf) {
+        return -1;
+    }
+    memcpy(buf, rx->payload + rx->consumed, len);
+    rx->consumed += len;
+    return 0;
+}
+
+/**
+ * @brief Name of a message type without the RW_MSG_ prefix.
+ *
+ * @param type Message type.
+ * @return Static string ("UNKNOWN" for unknown types).
+ */
+const char *rw_msg_type_name(uint16_t type) {
+    switch ((rw_msg_type_t)type) {
+        case RW_MSG_JOIN: return "JOIN";
+        case RW_MSG_WELCOME: return "WELCOME";
+        case RW_MSG_SET_GLOBAL_MODE: return "SET_GLOBAL_MODE";
+        case RW_MSG_GLOBAL_MODE_CHANGED: return "GLOBAL_MODE_CHANGED";
+        case RW_MSG_PROGRESS: return "PROGRESS";
+        case RW_MSG_SNAPSHOT_BEGIN: return "SNAPSHOT_BEGIN";
+        case RW_MSG_SNAPSHOT_CHUNK: return "SNAPSHOT_CHUNK";
+        case RW_MSG_SNAPSHOT_END: return "SNAPSHOT_END";
+        case RW_MSG_STOP_SIM: return "STOP_SIM";
+        case RW_MSG_END: return "END";
+        case RW_MSG_QUERY_STATUS: return "QUERY_STATUS";
+        case RW_MSG_STATUS: return "STATUS";
+        case RW_MSG_CREATE_SIM: return "CREATE_SIM";
+        case RW_MSG_LOAD_WORLD: return "LOAD_WORLD";
+        case RW_MSG_START_SIM: return "START_SIM";
+        case RW_MSG_REQUEST_SNAPSHOT: return "REQUEST_SNAPSHOT";
+        case RW_MSG_RESTART_SIM: return "RESTART_SIM";
+        case RW_MSG_LOAD_RESULTS: return "LOAD_RESULTS";
+        case RW_MSG_SAVE_RESULTS: return "SAVE_RESULTS";
+        case RW_MSG_QUIT: return "QUIT";
+        case RW_MSG_ACK: return "ACK";
+        case RW_MSG_SOLVE_HIT_TIME: return "SOLVE_HIT_TIME";
+        case RW_MSG_SET_RNG_MODE: return "SET_RNG_MODE";
+        case RW_MSG_CRN_DIFF: return "CRN_DIFF";
+        case RW_MSG_EDIT_OBSTACLES: return "EDIT_OBSTACLES";
+        case RW_MSG_CLUSTER_ASSIGN: return "CLUSTER_ASSIGN";
+        case RW_MSG_CLUSTER_WORLD_CHUNK: return "CLUSTER_WORLD_CHUNK";
+        case RW_MSG_CLUSTER_DELTA: return "CLUSTER_DELTA";
+        case RW_MSG_CLUSTER_REP_DONE: return "CLUSTER_REP_DONE";
+        case RW_MSG_CLUSTER_DONE: return "CLUSTER_DONE";
+        case RW_MSG_CLUSTER_SCALING: return "CLUSTER_SCALING";
+        case RW_MSG_SET_REGION: return "SET_REGION";
+        case RW_MSG_MAP_WORLD: return "MAP_WORLD";
+        case RW_MSG_CLUSTER_WORLD_FILE: return "CLUSTER_WORLD_FILE";
+        case RW_MSG_IMPORT_IMAGE: return "IMPORT_IMAGE";
+        case RW_MSG_TRACE: return "TRACE";
+        case RW_MSG_QUERY_STATS: return "QUERY_STATS";
+        case RW_MSG_STATS: return "STATS";
+        case RW_MSG_EXPORT_IMAGE: return "EXPORT_IMAGE";
+        case RW_MSG_QUERY_REGIONS: return "QUERY_REGIONS";
+        case RW_MSG_REGION_STATS: return "REGION_STATS";
+        case RW_MSG_ERROR: return "ERROR";
+    }
+    return "UNKNOWN";
+}
@@ -17,12 +17,24 @@
  * - `rw_msg_hdr_t.payload_len` specifies the payload size in bytes.
  * - The helpers `rw_send_msg()`, `rw_recv_hdr()`, and `rw_recv_payload()` implement
  *   simple blocking I/O that reads/writes exactly the requested number of bytes.
+ * - Long-lived readers (server client threads, client dispatcher) use a
+ *   @ref rw_rx_buf_t instead: it reads large blocks and parses every complete
+ *   frame in them, so a message usually costs one read() or less.
  *
  * Snapshot streaming:
  * - Large snapshot datasets are sent as a sequence of messages:
  *   `RW_MSG_SNAPSHOT_BEGIN`, one or more `RW_MSG_SNAPSHOT_CHUNK`, and
  *   `RW_MSG_SNAPSHOT_END`.
  * - Each chunk carries a slice of one field (obstacles, trials, sum_steps, ...).
+ * - A delta snapshot (@ref rw_snapshot_begin_t::base_snapshot_id) only carries
+ *   the slices that changed since an earlier snapshot.
+ *
+ * Sessions:
+ * - WELCOME carries a session token. A client that lost its connection sends it
+ *   in the next JOIN; an owner resuming within the server's grace period gets
+ *   its ownership back.
+ * - A resumed session talks to the same server instance, so the snapshot it
+ *   received last can be the base of a delta snapshot request.
  */
 
 #include <stdint.h>
@@ -77,6 +89,37 @@ typedef enum {
 
     RW_MSG_ACK = 21,              /**< Server -> Client: generic ACK for a request. */
 
+    RW_MSG_SOLVE_HIT_TIME = 22,   /**< Client -> Server: compute expected hitting times (deterministic). */
+
+    RW_MSG_SET_RNG_MODE = 23,     /**< Client -> Server: enable/disable common random numbers. */
+    RW_MSG_CRN_DIFF = 24,         /**< Client -> Server: paired CRN comparison report. */
+
+    RW_MSG_EDIT_OBSTACLES = 25,   /**< Client -> Server: change obstacles, optionally re-simulate affected cells. */
+
+    /* Cluster mode: coordinator <-> worker process (see cluster.h). */
+    RW_MSG_CLUSTER_ASSIGN = 26,      /**< Coordinator -> Worker: run configuration + start cell band. */
+    RW_MSG_CLUSTER_WORLD_CHUNK = 27, /**< Coordinator -> Worker: slice of the obstacle map. */
+    RW_MSG_CLUSTER_DELTA = 28,       /**< Worker -> Coordinator: per-cell counters of one replication. */
+    RW_MSG_CLUSTER_REP_DONE = 29,    /**< Worker -> Coordinator: replication finished. */
+    RW_MSG_CLUSTER_DONE = 30,        /**< Worker -> Coordinator: run finished. */
+    RW_MSG_CLUSTER_SCALING = 31,     /**< Client -> Server: scaling efficiency report. */
+
+    RW_MSG_SET_REGION = 32,       /**< Client -> Server: restrict simulation and snapshots to a rectangle. */
+
+    RW_MSG_MAP_WORLD = 33,           /**< Client -> Server: use a memory-mapped RWTILE world. */
+    RW_MSG_CLUSTER_WORLD_FILE = 34,  /**< Coordinator -> Worker: path of the mapped world file. */
+
+    RW_MSG_IMPORT_IMAGE = 35,     /**< Client -> Server: load the world from a PBM/PGM image (in lobby). */
+    RW_MSG_TRACE = 36,            /**< Client -> Server: start/stop span tracing or dump it to a file. */
+
+    RW_MSG_QUERY_STATS = 37,      /**< Client -> Server: request service latency statistics. */
+    RW_MSG_STATS = 38,            /**< Server -> Client: latency statistics per message type. */
+
+    RW_MSG_EXPORT_IMAGE = 39,     /**< Client -> Server: render p<=K or avg steps to a PPM/PNG file. */
+
+    RW_MSG_QUERY_REGIONS = 40,    /**< Client -> Server: pooled statistics of a batch of rectangles. */
+    RW_MSG_REGION_STATS = 41,     /**< Server -> Client: answer to QUERY_REGIONS. */
+
     RW_MSG_ERROR = 255    /**< Server -> Client: error message. */
 } rw_msg_type_t;
 
@@ -139,6 +182,9 @@ typedef struct {
 #pragma pack(push, 1)
 typedef struct {
     uint32_t pid; /**< Client process id. */
+    uint32_t reserved;
+    /** Session token from an earlier WELCOME to resume (0 = new session). */
+    uint64_t resume_token;
 } rw_join_t;
 #pragma pack(pop)
 
@@ -157,6 +203,15 @@ typedef struct {
 
     rw_wire_global_mode_t global_mode;
     rw_wire_pos_t origin;
+
+    /** Token identifying this session; send it in JOIN to resume after a reconnect. */
+    uint64_t session_token;
+    uint8_t resumed;      /**< 1 if JOIN resumed the session of @ref rw_join_t::resume_token (same server instance). */
+    uint8_t is_owner;     /**< 1 if this client controls the simulation. */
+    uint8_t reserved8[6];
+
+    /** Random id of this server run; snapshot ids are only valid as delta bases within it. */
+    uint64_t server_instance;
 } rw_welcome_t;
 #pragma pack(pop)
 
@@ -190,15 +245,40 @@ typedef struct {
 /**
  * @brief Snapshot field identifiers for chunked snapshot transfer.
  *
- * The client interprets per-cell arrays; index = y * width + x.
+ * The client interprets per-cell arrays of the snapshot view (see
+ * @ref rw_snapshot_begin_t); index = (y - view.y) * view_size.width + (x - view.x).
  */
 typedef enum {
     RW_SNAP_FIELD_OBSTACLES = 1,   /**< uint8_t[]: 1 if obstacle, 0 otherwise. */
     RW_SNAP_FIELD_TRIALS = 2,      /**< uint32_t[]: number of trials per cell. */
     RW_SNAP_FIELD_SUM_STEPS = 3,   /**< uint64_t[]: sum of steps per cell. */
-    RW_SNAP_FIELD_SUCC_LEQ_K = 4   /**< uint32_t[]: successes within K per cell. */
+    RW_SNAP_FIELD_SUCC_LEQ_K = 4,  /**< uint32_t[]: successes within K per cell. */
+    RW_SNAP_FIELD_HIT_TIME = 5,    /**< double[]: expected hitting time (only if solved). */
+
+    /* Derived formats (see @ref rw_wire_snapshot_format_t). Masks are bitmaps:
+     * cell i is bit (i & 7) of byte i / 8. Codes are uint8_t or uint16_t per
+     * cell, see @ref rw_snapshot_begin_t::quant_bits. */
+    RW_SNAP_FIELD_VALID_MASK = 6,     /**< bitmap: cell has trials (p<=K is defined). */
+    RW_SNAP_FIELD_OBSTACLE_MASK = 7,  /**< bitmap: cell is an obstacle. */
+    RW_SNAP_FIELD_AVG_STEPS_Q = 8,    /**< codes: avg steps = code * avg_steps_scale;
+                                           all ones = n/a (no successful trial). */
+    RW_SNAP_FIELD_P_LEQ_K_Q = 9       /**< codes: p<=K = code * p_leq_k_scale. */
 } rw_snapshot_field_t;
 
+/**
+ * @brief Encodings a client may request in REQUEST_SNAPSHOT.
+ *
+ * RAW sends the counters (16 bytes per cell plus obstacles). The derived formats
+ * send what the client displays, computed by the server: avg steps and p<=K as
+ * 8- or 16-bit codes with a per-snapshot scale, plus valid and obstacle
+ * bitmaps (about 2.25 or 4.25 bytes per cell). Hit times are only sent in RAW.
+ */
+typedef enum {
+    RW_SNAP_FORMAT_RAW = 0,
+    RW_SNAP_FORMAT_DERIVED8 = 1,
+    RW_SNAP_FORMAT_DERIVED16 = 2
+} rw_wire_snapshot_format_t;
+
 /**
  * @brief Payload of a SNAPSHOT_BEGIN message.
  */
@@ -208,8 +288,23 @@ typedef struct {
     rw_wire_size_t size;
     rw_wire_world_kinds_t world_kind;
 
-    uint32_t cell_count;       /**< size.width * size.height */
     uint32_t included_fields;  /**< Bitmask of `rw_snapshot_field_t` values. */
+
+    /** Rectangle of the world covered by the field arrays (the region, or the whole world). */
+    rw_wire_pos_t view;
+    rw_wire_size_t view_size;
+    uint64_t cell_count;       /**< view_size.width * view_size.height */
+
+    /** Derived formats: bits per code (8 or 16); 0 for RAW. */
+    uint8_t quant_bits;
+    uint8_t reserved8[3];
+    /**
+     * Non-zero: delta against this earlier snapshot. Only cells changed since
+     * then are sent; all other bytes of the fields keep their base values.
+     */
+    uint32_t base_snapshot_id;
+    double avg_steps_scale;    /**< Value of one RW_SNAP_FIELD_AVG_STEPS_Q code step. */
+    double p_leq_k_scale;      /**< Value of one RW_SNAP_FIELD_P_LEQ_K_Q code step. */
 } rw_snapshot_begin_t;
 #pragma pack(pop)
 
@@ -221,7 +316,7 @@ typedef struct {
     uint32_t snapshot_id;
     uint16_t field;        /**< `rw_snapshot_field_t` */
     uint16_t reserved;
-    uint32_t offset_bytes; /**< Offset from start of field data. */
+    uint64_t offset_bytes; /**< Offset from start of field data. */
     uint32_t data_len;     /**< Valid data length in @ref data. */
     uint8_t data[RW_SNAPSHOT_CHUNK_MAX];
 } rw_snapshot_chunk_t;
@@ -315,8 +410,373 @@ typedef struct {
  */
 typedef struct {
     uint32_t pid;
+    uint8_t format;        /**< rw_wire_snapshot_format_t */
+    uint8_t reserved8[3];
+    /**
+     * Last snapshot the client has applied completely (0 = none). The server
+     * answers with a delta against it when it still knows that snapshot and
+     * its view and format match; otherwise with a full snapshot.
+     */
+    uint32_t base_snapshot_id;
 } rw_request_snapshot_t;
 
+/**
+ * @brief Payload for SOLVE_HIT_TIME.
+ *
+ * Zero values select the solver defaults.
+ */
+typedef struct {
+    uint32_t max_iters;  /**< Maximum Krylov iterations (0 = default). */
+    uint32_t reserved;
+    double tolerance;    /**< Target relative residual (<= 0 = default). */
+} rw_solve_hit_time_t;
+
+/**
+ * @brief Payload for SET_RNG_MODE.
+ *
+ * With CRN enabled, the walk from cell i in replication r uses a random stream
+ * derived only from (seed, i, r), so runs of different configurations with the
+ * same seed are directly comparable.
+ */
+typedef struct {
+    uint8_t crn_enabled;  /**< 0=independent thread streams, 1=common random numbers */
+    uint8_t reserved8[3];
+    uint32_t reserved;
+    uint64_t seed;        /**< Base seed of the common random streams. */
+} rw_set_rng_mode_t;
+
+/**
+ * @brief Payload for CRN_DIFF.
+ *
+ * Configuration A is the current server configuration; configuration B differs
+ * in @ref probs_b and @ref k_b. The server writes a per-cell CSV report to @ref path.
+ */
+typedef struct {
+    rw_wire_move_probs_t probs_b;
+    uint32_t k_b;
+    uint32_t reps;        /**< Paired replications per cell (>= 2). */
+    uint64_t seed;        /**< Base seed of the common random streams. */
+    char path[RW_PATH_MAX];
+} rw_crn_diff_t;
+
+/** Maximum number of cell edits in one EDIT_OBSTACLES message. */
+#define RW_OBSTACLE_EDIT_MAX 1024u
+
+/**
+ * @brief Header of the EDIT_OBSTACLES payload.
+ *
+ * Followed by @ref count entries of @ref rw_obstacle_edit_t
+ * (payload_len = sizeof(header) + count * sizeof(rw_obstacle_edit_t)).
+ */
+typedef struct {
+    uint32_t count;       /**< Number of edits (1..RW_OBSTACLE_EDIT_MAX). */
+    uint8_t resimulate;   /**< 1 = re-simulate affected cells right away */
+    uint8_t reserved8[3];
+} rw_obstacle_edit_hdr_t;
+
+/**
+ * @brief One cell edit of EDIT_OBSTACLES.
+ */
+typedef struct {
+    uint32_t x;
+    uint32_t y;
+    uint8_t value;        /**< 0=free, 1=obstacle */
+    uint8_t reserved8[3];
+} rw_obstacle_edit_t;
+
+/** Maximum number of cells in one CLUSTER_DELTA message (and bytes in one CLUSTER_WORLD_CHUNK). */
+#define RW_CLUSTER_CHUNK_CELLS 8192u
+
+/**
+ * @brief Payload for CLUSTER_ASSIGN.
+ *
+ * The worker simulates start cells with x in [x0, x0 + width) and y in
+ * [y0, y1) for replications 1..total_reps. The obstacle bitmap (see world.h)
+ * follows as CLUSTER_WORLD_CHUNK messages covering the whole world, or, if
+ * @ref world_mapped is set, as a single CLUSTER_WORLD_FILE message.
+ */
+typedef struct {
+    uint8_t world_kind;   /**< rw_wire_world_kinds_t */
+    uint8_t crn_enabled;
+    uint8_t world_mapped; /**< 1 = workers map the RWTILE file themselves */
+    uint8_t reserved8;
+    uint32_t k_max_steps;
+    rw_wire_size_t size;
+    rw_wire_move_probs_t probs;
+    uint32_t total_reps;
+    uint32_t x0;
+    uint32_t width;
+    uint32_t y0;
+    uint32_t y1;
+    uint32_t reserved;
+    uint64_t crn_seed;
+} rw_cluster_assign_t;
+
+/**
+ * @brief Header of CLUSTER_WORLD_CHUNK, followed by @ref count bitmap bytes.
+ */
+typedef struct {
+    uint64_t offset;      /**< Byte offset into the obstacle bitmap. */
+    uint32_t count;       /**< 1..RW_CLUSTER_CHUNK_CELLS */
+    uint32_t reserved;
+} rw_cluster_world_chunk_t;
+
+/**
+ * @brief Header of CLUSTER_DELTA.
+ *
+ * Followed by three arrays for cells [offset, offset + count):
+ * `uint32_t trials[count]`, `uint32_t success_leq_k[count]`,
+ * `uint64_t sum_steps[count]`.
+ */
+typedef struct {
+    uint32_t rep;
+    uint32_t count;       /**< 1..RW_CLUSTER_CHUNK_CELLS */
+    uint64_t offset;      /**< Linear index of the first cell. */
+} rw_cluster_delta_t;
+
+/**
+ * @brief Payload for CLUSTER_REP_DONE.
+ */
+typedef struct {
+    uint32_t rep;
+    uint32_t walks;       /**< Walks simulated in this replication. */
+    uint64_t busy_ns;     /**< Compute time of this replication. */
+} rw_cluster_rep_done_t;
+
+/**
+ * @brief Payload for CLUSTER_DONE.
+ */
+typedef struct {
+    uint32_t reps_done;
+    uint32_t reserved;
+    uint64_t walks;
+    uint64_t busy_ns;
+} rw_cluster_done_t;
+
+/**
+ * @brief Payload for CLUSTER_SCALING.
+ *
+ * The server runs @ref reps replications of the current configuration with
+ * 1..N worker processes and writes a CSV report to @ref path.
+ */
+typedef struct {
+    uint32_t reps;
+    uint32_t reserved;
+    char path[RW_PATH_MAX];
+} rw_cluster_scaling_t;
+
+/**
+ * @brief Payload for SET_REGION.
+ *
+ * Restricts simulated start cells and snapshots to the given rectangle, which
+ * must lie inside the world. Width or height 0 clears the region (whole world).
+ * Walks started inside the region may still leave it.
+ */
+typedef struct {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+} rw_set_region_t;
+
+/** Largest snapshot view (cells); larger worlds need a region to be viewed. */
+#define RW_SNAPSHOT_MAX_CELLS (1ull << 24)
+
+/**
+ * @brief Modes of MAP_WORLD.
+ */
+typedef enum {
+    RW_WIRE_MAP_OPEN = 0,      /**< Map an existing RWTILE file. */
+    RW_WIRE_MAP_GENERATE = 1,  /**< Generate a random RWTILE file, then map it. */
+    RW_WIRE_MAP_CONVERT = 2    /**< Write the current world as RWTILE, then map it. */
+} rw_wire_map_mode_t;
+
+/**
+ * @brief Payload for MAP_WORLD.
+ *
+ * Replaces the world by a read-only mapping of the RWTILE file @ref path
+ * (see world_tiles.h). @ref world_kind, @ref obstacle_percent, @ref size and
+ * @ref seed are used by @ref RW_WIRE_MAP_GENERATE only. Probabilities and K of
+ * the current configuration are kept; results are cleared.
+ */
+typedef struct {
+    uint8_t mode;             /**< rw_wire_map_mode_t */
+    uint8_t world_kind;       /**< rw_wire_world_kinds_t */
+    uint8_t obstacle_percent; /**< 0..100 */
+    uint8_t multi_user;       /**< 0=single-user, 1=multi-user */
+    rw_wire_size_t size;
+    uint32_t seed;
+    char path[RW_PATH_MAX];
+} rw_map_world_t;
+
+/**
+ * @brief Payload for IMPORT_IMAGE.
+ *
+ * Loads a binary PBM (P4) or PGM (P5) image as the obstacle map (see
+ * world_import.h). Configuration other than the world is kept; results are
+ * cleared.
+ */
+typedef struct {
+    uint8_t world_kind;   /**< rw_wire_world_kinds_t */
+    uint8_t threshold;    /**< PGM: gray levels (0..255) below it are obstacles */
+    uint8_t multi_user;   /**< 0=single-user, 1=multi-user */
+    uint8_t reserved8;
+    char path[RW_PATH_MAX];
+} rw_import_image_t;
+
+/**
+ * @brief Actions of TRACE.
+ */
+typedef enum {
+    RW_WIRE_TRACE_START = 0, /**< Start a new session (discards the previous one). */
+    RW_WIRE_TRACE_STOP = 1,  /**< Stop recording (the session is kept). */
+    RW_WIRE_TRACE_DUMP = 2,  /**< Write the session as Chrome trace JSON to path. */
+} rw_wire_trace_action_t;
+
+/**
+ * @brief Payload for TRACE.
+ *
+ * The trace file is written by the server process, so path is resolved on
+ * the server host. Only spans of the server process are recorded (cluster
+ * worker processes are not traced).
+ */
+typedef struct {
+    uint8_t action;       /**< rw_wire_trace_action_t */
+    uint8_t reserved8[3];
+    char path[RW_PATH_MAX]; /**< DUMP only */
+} rw_trace_t;
+
+/** Maximum number of message types in a STATS reply. */
+#define RW_STATS_MAX_ENTRIES 64u
+
+/**
+ * @brief Payload of a QUERY_STATS request.
+ */
+typedef struct {
+    uint32_t pid;
+} rw_query_stats_t;
+
+/**
+ * @brief Service latency of one request type since server start (nanoseconds).
+ *
+ * Measured from receiving the request header to finishing the reply.
+ * Quantiles are upper bounds of log-scaled buckets (within 12.5 %).
+ */
+typedef struct {
+    uint16_t type;      /**< rw_msg_type_t of the request */
+    uint16_t reserved16;
+    uint32_t reserved32;
+    uint64_t count;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+} rw_stats_entry_t;
+
+/**
+ * @brief Payload of a STATS reply (only the first count entries are valid).
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t reserved32;
+    rw_stats_entry_t entries[RW_STATS_MAX_ENTRIES];
+} rw_stats_t;
+
+/**
+ * @brief Field rendered by EXPORT_IMAGE.
+ */
+typedef enum {
+    RW_WIRE_IMAGE_P_LEQ_K = 0,
+    RW_WIRE_IMAGE_AVG_STEPS = 1,
+} rw_wire_image_field_t;
+
+/**
+ * @brief Colormaps of EXPORT_IMAGE.
+ */
+typedef enum {
+    RW_WIRE_CMAP_VIRIDIS = 0,
+    RW_WIRE_CMAP_HEAT = 1,
+    RW_WIRE_CMAP_GRAY = 2,
+} rw_wire_colormap_t;
+
+/**
+ * @brief File formats of EXPORT_IMAGE.
+ */
+typedef enum {
+    RW_WIRE_IMAGE_PPM = 0,
+    RW_WIRE_IMAGE_PNG = 1,
+} rw_wire_image_format_t;
+
+/**
+ * @brief Payload for EXPORT_IMAGE.
+ *
+ * The server renders the whole world from the current results (see
+ * heatmap_export.h) and writes the file on the server host.
+ */
+typedef struct {
+    uint8_t field;        /**< rw_wire_image_field_t */
+    uint8_t colormap;     /**< rw_wire_colormap_t */
+    uint8_t format;       /**< rw_wire_image_format_t */
+    uint8_t reserved8;
+    uint32_t downsample;  /**< cells per pixel edge, 0 = automatic */
+    double max_value;     /**< avg steps at the top color, 0 = largest value */
+    char path[RW_PATH_MAX];
+} rw_export_image_t;
+
+/** Maximum number of rectangles in one QUERY_REGIONS message. */
+#define RW_REGION_QUERY_MAX 4096u
+
+/**
+ * @brief Header of the QUERY_REGIONS payload.
+ *
+ * Followed by @ref count entries of @ref rw_wire_rect_t
+ * (payload_len = sizeof(header) + count * sizeof(rw_wire_rect_t)).
+ */
+typedef struct {
+    uint32_t pid;
+    uint32_t count;       /**< Number of rectangles (1..RW_REGION_QUERY_MAX). */
+} rw_query_regions_hdr_t;
+
+/**
+ * @brief Rectangle of cells; clipped to the world by the server.
+ */
+typedef struct {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+} rw_wire_rect_t;
+
+/**
+ * @brief Header of the REGION_STATS reply.
+ *
+ * Followed by @ref count entries of @ref rw_region_stat_t, in request order.
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t reserved32;
+    uint64_t results_version; /**< Results the sums were taken from (changes with every update). */
+} rw_region_stats_hdr_t;
+
+/**
+ * @brief Pooled counters of one rectangle.
+ *
+ * p<=K = successes / trials, avg steps = sum_steps / successes.
+ */
+typedef struct {
+    uint64_t cells;       /**< Cells of the clipped rectangle (0 = outside the world). */
+    uint64_t trials;
+    uint64_t successes;
+    uint64_t sum_steps;
+} rw_region_stat_t;
+
+/**
+ * @brief Payload for CLUSTER_WORLD_FILE.
+ */
+typedef struct {
+    char path[RW_PATH_MAX];
+} rw_cluster_world_file_t;
+
 /**
  * @brief Payload for QUIT.
  */
@@ -359,6 +819,76 @@ typedef struct {
 } rw_error_t;
 #pragma pack(pop)
 
+/** Initial size of a @ref rw_rx_buf_t (grows for larger frames). */
+#define RW_RX_BUF_INIT 65536u
+/** Largest frame (header + payload) a @ref rw_rx_buf_t accepts. */
+#define RW_RX_FRAME_MAX (64u << 20)
+
+/**
+ * @brief Buffered framed receiver of one connection.
+ *
+ * @ref rw_rx_next() returns the next complete frame; its payload stays in the
+ * buffer (`payload` is a view, valid until the next @ref rw_rx_next()) and can
+ * be copied out piecewise with @ref rw_rx_payload(). Unread payload bytes are
+ * skipped by the next @ref rw_rx_next(), so unknown messages need no drain.
+ * Payload structs are packed, so the unaligned view may be cast directly.
+ *
+ * Only one thread may use a receiver, and nothing else may read its fd.
+ */
+typedef struct {
+    int fd;
+    uint8_t *buf;
+    size_t cap;
+    size_t head;            /**< Start of the current frame. */
+    size_t tail;            /**< End of the received bytes. */
+    size_t next;            /**< Start of the frame after the current one. */
+    rw_msg_hdr_t hdr;       /**< Header of the current frame. */
+    const uint8_t *payload; /**< Payload of the current frame (view into buf). */
+    uint32_t consumed;      /**< Payload bytes taken by @ref rw_rx_payload(). */
+    uint64_t reads;         /**< read() calls that returned data. */
+    uint64_t frames;        /**< Frames returned. */
+} rw_rx_buf_t;
+
+/**
+ * @brief Initialize a receiver for @p fd.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int rw_rx_init(rw_rx_buf_t *rx, int fd);
+
+/**
+ * @brief Release the buffer (does not close the fd).
+ */
+void rw_rx_free(rw_rx_buf_t *rx);
+
+/**
+ * @brief Receive the next complete frame.
+ *
+ * Blocks until a whole frame is buffered. Frames larger than
+ * @ref RW_RX_FRAME_MAX are treated as a protocol error.
+ *
+ * @param rx      Receiver.
+ * @param out_hdr Output header (also kept in @p rx).
+ * @return 0 on success, -1 on EOF/error.
+ */
+int rw_rx_next(rw_rx_buf_t *rx, rw_msg_hdr_t *out_hdr);
+
+/**
+ * @brief Copy the next @p len payload bytes of the current frame.
+ *
+ * Counterpart of @ref rw_recv_payload() for buffered frames.
+ *
+ * @return 0 on success, -1 if the frame has fewer unread bytes.
+ */
+int rw_rx_payload(rw_rx_buf_t *rx, void *buf, uint32_t len);
+
+/**
+ * @brief Name of a message type without the RW_MSG_ prefix (for logs).
+ *
+ * @param type Message type.
+ * @return Static string ("UNKNOWN" for unknown types).
+ */
+const char *rw_msg_type_name(uint16_t type);
+
 /**
  * @brief Send a message header and optional payload.
  *
@@ -386,6 +916,19 @@ int rw_send_msg(int fd, rw_msg_type_t type, const void *payload, uint32_t payloa
  */
 int rw_send_msg_noblock(int fd, rw_msg_type_t type, const void *payload, uint32_t payload_len);
 
+/**
+ * @brief Send bytes that already contain complete frames (header + payload).
+ *
+ * Blocking write of @p len bytes, used to replay pre-encoded message sequences
+ * (e.g. a cached snapshot) with as few syscalls as possible.
+ *
+ * @param fd Connected socket.
+ * @param frames Encoded frames.
+ * @param len Byte length of @p frames.
+ * @return 0 on success, -1 on error.
+ */
+int rw_send_frames(int fd, const void *frames, size_t len);
+
 /**
  * @brief Receive a message header.
  *
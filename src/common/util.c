@@ -4,7 +4,10 @@
 
 #include "util.h"
 
+#include "log_ring.h"
+
 #include <errno.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -62,29 +65,38 @@ static void vlog(FILE *out, const char *level, const char *fmt, va_list ap) {
     fflush(out);
 }
 
-/**
- * @brief Log an informational message to stdout.
- *
- * @param fmt printf-style format string.
- * @param ... Format arguments.
- */
-void log_info(const char *fmt, ...) {
-    va_list ap;
-    va_start(ap, fmt);
-    vlog(stdout, "INFO", fmt, ap);
-    va_end(ap);
+static atomic_int g_log_level = RW_LOG_INFO;
+
+void rw_log_set_level(int level) {
+    atomic_store_explicit(&g_log_level, level, memory_order_relaxed);
 }
 
 /**
- * @brief Log an error message to stderr.
+ * @brief Log a message at the given level.
+ *
+ * Queued to the asynchronous logger when it runs, written directly otherwise.
  *
+ * @param level RW_LOG_* level.
  * @param fmt printf-style format string.
  * @param ... Format arguments.
  */
-void log_error(const char *fmt, ...) {
+void rw_log(int level, const char *fmt, ...) {
+    if (level < atomic_load_explicit(&g_log_level, memory_order_relaxed)) {
+        return;
+    }
+
     va_list ap;
     va_start(ap, fmt);
-    vlog(stderr, "ERROR", fmt, ap);
+
+    va_list ring_ap;
+    va_copy(ring_ap, ap);
+    int queued = log_ring_push(level, time(NULL), fmt, ring_ap) == 0;
+    va_end(ring_ap);
+
+    if (!queued) {
+        const char *name = level >= RW_LOG_ERROR ? "ERROR" : (level == RW_LOG_DEBUG ? "DEBUG" : "INFO");
+        vlog(level >= RW_LOG_ERROR ? stderr : stdout, name, fmt, ap);
+    }
     va_end(ap);
 }
 
@@ -100,6 +112,9 @@ void log_error(const char *fmt, ...) {
 void die(const char *fmt,...) {
     int saved_errno = errno;
 
+    //earlier messages first
+    log_ring_flush();
+
     va_list ap;
     va_start(ap, fmt);
     vlog(stderr, "FATAL", fmt, ap);
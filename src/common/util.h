@@ -12,7 +12,9 @@
  * @brief Small logging and fatal-error helpers.
  *
  * This module provides simple, thread-safe(ish) logging to stdout/stderr with a time
- * prefix, plus a `die()` helper that logs and terminates the process.
+ * prefix and a level filter, plus a `die()` helper that logs and terminates the
+ * process. Long-running multi-threaded processes can move the actual writing to
+ * a background thread with log_ring.h.
  */
 
 /**
@@ -29,20 +31,54 @@
 void die(const char *fmt, ...);
 
 /**
- * @brief Log an informational message to stdout.
+ * @name Log levels
+ * Messages below @ref RW_LOG_MIN_LEVEL are removed at compile time (the macros
+ * below expand to a constant-false branch); messages below the runtime level
+ * (@ref rw_log_set_level()) are dropped before any formatting.
+ * @{
+ */
+#define RW_LOG_DEBUG 0
+#define RW_LOG_INFO  1
+#define RW_LOG_ERROR 2
+/** @} */
+
+#ifndef RW_LOG_MIN_LEVEL
+/** Lowest level compiled in (override with -DRW_LOG_MIN_LEVEL=...). */
+#define RW_LOG_MIN_LEVEL RW_LOG_DEBUG
+#endif
+
+/**
+ * @brief Log a message at @p level.
+ *
+ * INFO and DEBUG go to stdout, ERROR to stderr, each line prefixed with the
+ * time and level. While the asynchronous logger runs (see log_ring.h) the
+ * message is only formatted into the calling thread's ring buffer; otherwise
+ * it is written and flushed immediately.
  *
+ * @param level One of the RW_LOG_* levels.
  * @param fmt printf-style format string.
  * @param ... Format arguments.
  */
-void log_info(const char *fmt, ...);
+void rw_log(int level, const char *fmt, ...);
 
 /**
- * @brief Log an error message to stderr.
+ * @brief Set the runtime log level (messages below it are dropped).
  *
- * @param fmt printf-style format string.
- * @param ... Format arguments.
+ * @param level One of the RW_LOG_* levels (default @ref RW_LOG_INFO).
  */
-void log_error(const char *fmt, ...);
+void rw_log_set_level(int level);
+
+/** @brief Log a debug message to stdout (off unless enabled at runtime). */
+#define log_debug(...) \
+    do { if (RW_LOG_DEBUG >= RW_LOG_MIN_LEVEL) rw_log(RW_LOG_DEBUG, __VA_ARGS__); } while (0)
+
+/** @brief Log an informational message to stdout. */
+#define log_info(...) \
+    do { if (RW_LOG_INFO >= RW_LOG_MIN_LEVEL) rw_log(RW_LOG_INFO, __VA_ARGS__); } while (0)
+
+/** @brief Log an error message to stderr. */
+#define log_error(...) \
+    do { if (RW_LOG_ERROR >= RW_LOG_MIN_LEVEL) rw_log(RW_LOG_ERROR, __VA_ARGS__); } while (0)
 
 /**
  * @brief Safely copy a Unix-domain socket path into a fixed-size buffer.
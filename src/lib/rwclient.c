@@ -0,0 +1,424 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "rwclient.h"
+
+#include "../common/util.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @file rwclient.c
+ * @brief Implementation of the embeddable client library.
+ *
+ * Each connection keeps a FIFO of submitted requests. The reader thread routes
+ * notifications to the callbacks, stores snapshot frames into the buffers of
+ * the request at the head of the FIFO, and completes that request with the
+ * next reply. The send lock covers "append to FIFO + write", so the FIFO order
+ * always equals the order of requests on the wire.
+ */
+
+#define RWC_HANDSHAKE_TIMEOUT_S 5
+
+typedef struct rwc_pending {
+    rwc_done_fn done;
+    void *user;
+    rwc_snapshot_t *snap;   /* snapshot requests only */
+    uint32_t snapshot_id;
+    int snap_state;         /* 0 = waiting for BEGIN, 1 = receiving, 2 = ended */
+    int truncated;
+    struct rwc_pending *next;
+} rwc_pending_t;
+
+struct rwc_conn {
+    int fd;
+    rw_rx_buf_t rx;
+    rw_welcome_t welcome;
+    rwc_callbacks_t cb;
+
+    pthread_t reader;
+    pthread_mutex_t send_mtx;   /* serializes FIFO append + socket write */
+    pthread_mutex_t mtx;        /* protects the FIFO and closed */
+    rwc_pending_t *head;
+    rwc_pending_t *tail;
+    int closed;                 /* reader thread finished */
+    int closing;                /* rwc_close() in progress */
+};
+
+/* Waiter of rwc_call(); freed by whichever side finishes last. */
+typedef struct {
+    pthread_mutex_t mtx;
+    pthread_cond_t cv;
+    int done;
+    int abandoned;
+    int status;
+    rw_msg_hdr_t hdr;
+    void *out;
+    uint32_t out_cap;
+} rwc_waiter_t;
+
+static int connect_unix(const char *path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (rw_copy_socket_path(addr.sun_path, sizeof(addr.sun_path), path) != 0 ||
+        connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Detach the head request (NULL if none). */
+static rwc_pending_t *pop_head(rwc_conn_t *c) {
+    pthread_mutex_lock(&c->mtx);
+    rwc_pending_t *p = c->head;
+    if (p) {
+        c->head = p->next;
+        if (!c->head) c->tail = NULL;
+    }
+    pthread_mutex_unlock(&c->mtx);
+    return p;
+}
+
+static rwc_pending_t *peek_head(rwc_conn_t *c) {
+    pthread_mutex_lock(&c->mtx);
+    rwc_pending_t *p = c->head;
+    pthread_mutex_unlock(&c->mtx);
+    return p;
+}
+
+static void complete(rwc_conn_t *c, rwc_pending_t *p, int status,
+                     const rw_msg_hdr_t *hdr, const void *payload) {
+    if (p->done) p->done(c, p->user, status, hdr, payload);
+    free(p);
+}
+
+static void snapshot_chunk(rwc_pending_t *p, const rw_msg_hdr_t *hdr, const uint8_t *payload) {
+    const size_t head = offsetof(rw_snapshot_chunk_t, data);
+    if (hdr->payload_len < head) return;
+    rw_snapshot_chunk_t ch;
+    memcpy(&ch, payload, head);
+    if (ch.snapshot_id != p->snapshot_id || ch.data_len > hdr->payload_len - head) return;
+    if (ch.field == 0 || ch.field > RWC_SNAP_FIELD_MAX || !p->snap->field[ch.field]) return;
+
+    uint64_t cap = p->snap->field_cap[ch.field];
+    if (ch.offset_bytes >= cap) {
+        p->truncated = 1;
+        return;
+    }
+    uint64_t n = ch.data_len;
+    if (n > cap - ch.offset_bytes) {
+        //keep the part that fits
+        n = cap - ch.offset_bytes;
+        p->truncated = 1;
+    }
+    memcpy((uint8_t *)p->snap->field[ch.field] + ch.offset_bytes, payload + head, (size_t)n);
+    if (ch.offset_bytes + n > p->snap->field_len[ch.field]) {
+        p->snap->field_len[ch.field] = ch.offset_bytes + n;
+    }
+}
+
+/* Snapshot stream frames belong to the head request if it asked for one. */
+static void snapshot_frame(rwc_conn_t *c, const rw_msg_hdr_t *hdr, const uint8_t *payload) {
+    rwc_pending_t *p = peek_head(c);
+    if (!p || !p->snap) return;
+
+    if (hdr->type == RW_MSG_SNAPSHOT_BEGIN) {
+        if (p->snap_state != 0 || hdr->payload_len != sizeof(rw_snapshot_begin_t)) return;
+        memcpy(&p->snap->begin, payload, sizeof(rw_snapshot_begin_t));
+        if (p->snap->begin.base_snapshot_id == 0) {
+            memset(p->snap->field_len, 0, sizeof(p->snap->field_len));
+        }
+        p->snapshot_id = p->snap->begin.snapshot_id;
+        p->snap_state = 1;
+    } else if (hdr->type == RW_MSG_SNAPSHOT_CHUNK) {
+        if (p->snap_state == 1) snapshot_chunk(p, hdr, payload);
+    } else if (p->snap_state == 1) {
+        p->snap_state = 2;
+    }
+}
+
+static void *reader_main(void *arg) {
+    rwc_conn_t *c = (rwc_conn_t *)arg;
+    rw_msg_hdr_t hdr;
+
+    while (rw_rx_next(&c->rx, &hdr) == 0) {
+        const uint8_t *payload = c->rx.payload;
+        switch (hdr.type) {
+            case RW_MSG_PROGRESS:
+                if (c->cb.on_progress && hdr.payload_len == sizeof(rw_progress_t)) {
+                    rw_progress_t m;
+                    memcpy(&m, payload, sizeof(m));
+                    c->cb.on_progress(c, c->cb.user, &m);
+                }
+                continue;
+            case RW_MSG_END:
+                if (c->cb.on_end && hdr.payload_len == sizeof(rw_end_t)) {
+                    rw_end_t m;
+                    memcpy(&m, payload, sizeof(m));
+                    c->cb.on_end(c, c->cb.user, &m);
+                }
+                continue;
+            case RW_MSG_GLOBAL_MODE_CHANGED:
+                if (c->cb.on_global_mode && hdr.payload_len == sizeof(rw_global_mode_changed_t)) {
+                    rw_global_mode_changed_t m;
+                    memcpy(&m, payload, sizeof(m));
+                    c->cb.on_global_mode(c, c->cb.user, &m);
+                }
+                continue;
+            case RW_MSG_SNAPSHOT_BEGIN:
+            case RW_MSG_SNAPSHOT_CHUNK:
+            case RW_MSG_SNAPSHOT_END:
+                snapshot_frame(c, &hdr, payload);
+                continue;
+            default:
+                break;
+        }
+
+        rwc_pending_t *p = pop_head(c);
+        if (!p) continue; /* reply to nothing: drop */
+        int status = RWC_OK;
+        if (hdr.type == RW_MSG_ERROR) {
+            status = RWC_ERR_SERVER;
+        } else if (p->snap && (p->truncated || p->snap_state != 2)) {
+            status = RWC_ERR_TRUNCATED;
+        }
+        complete(c, p, status, &hdr, payload);
+    }
+
+    //connection gone: fail everything still pending
+    pthread_mutex_lock(&c->mtx);
+    c->closed = 1;
+    int closing = c->closing;
+    pthread_mutex_unlock(&c->mtx);
+    for (rwc_pending_t *p; (p = pop_head(c)) != NULL;) {
+        complete(c, p, RWC_ERR_DISCONNECTED, NULL, NULL);
+    }
+    if (!closing && c->cb.on_disconnect) {
+        c->cb.on_disconnect(c, c->cb.user, EPIPE);
+    }
+    return NULL;
+}
+
+rwc_conn_t *rwc_connect(const char *socket_path, const rwc_callbacks_t *cb) {
+    return rwc_connect_resume(socket_path, 0, cb);
+}
+
+rwc_conn_t *rwc_connect_resume(const char *socket_path, uint64_t resume_token, const rwc_callbacks_t *cb) {
+    if (!socket_path) return NULL;
+
+    rwc_conn_t *c = (rwc_conn_t *)calloc(1, sizeof(*c));
+    if (!c) return NULL;
+    if (cb) c->cb = *cb;
+    c->fd = connect_unix(socket_path);
+    if (c->fd < 0) {
+        free(c);
+        return NULL;
+    }
+    if (rw_rx_init(&c->rx, c->fd) != 0) {
+        close(c->fd);
+        free(c);
+        return NULL;
+    }
+
+    struct timeval tv = {RWC_HANDSHAKE_TIMEOUT_S, 0};
+    (void)setsockopt(c->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    rw_join_t join;
+    memset(&join, 0, sizeof(join));
+    join.pid = (uint32_t)getpid();
+    join.resume_token = resume_token;
+    rw_msg_hdr_t hdr;
+    if (rw_send_msg(c->fd, RW_MSG_JOIN, &join, sizeof(join)) != 0 ||
+        rw_rx_next(&c->rx, &hdr) != 0 || hdr.type != RW_MSG_WELCOME ||
+        hdr.payload_len != sizeof(c->welcome) || rw_rx_payload(&c->rx, &c->welcome, sizeof(c->welcome)) != 0) {
+        log_error("rwclient: handshake with %s failed", socket_path);
+        rw_rx_free(&c->rx);
+        close(c->fd);
+        free(c);
+        return NULL;
+    }
+    tv.tv_sec = 0;
+    (void)setsockopt(c->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    pthread_mutex_init(&c->send_mtx, NULL);
+    pthread_mutex_init(&c->mtx, NULL);
+    if (pthread_create(&c->reader, NULL, reader_main, c) != 0) {
+        pthread_mutex_destroy(&c->send_mtx);
+        pthread_mutex_destroy(&c->mtx);
+        rw_rx_free(&c->rx);
+        close(c->fd);
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+void rwc_close(rwc_conn_t *c) {
+    if (!c) return;
+
+    pthread_mutex_lock(&c->mtx);
+    c->closing = 1;
+    pthread_mutex_unlock(&c->mtx);
+
+    (void)shutdown(c->fd, SHUT_RDWR);
+    pthread_join(c->reader, NULL);
+
+    rw_rx_free(&c->rx);
+    close(c->fd);
+    pthread_mutex_destroy(&c->send_mtx);
+    pthread_mutex_destroy(&c->mtx);
+    free(c);
+}
+
+const rw_welcome_t *rwc_welcome(const rwc_conn_t *c) {
+    return c ? &c->welcome : NULL;
+}
+
+static int submit(rwc_conn_t *c, rw_msg_type_t type, const void *payload, uint32_t payload_len,
+                  rwc_snapshot_t *snap, rwc_done_fn done, void *user) {
+    if (!c) return -1;
+    rwc_pending_t *p = (rwc_pending_t *)calloc(1, sizeof(*p));
+    if (!p) return -1;
+    p->done = done;
+    p->user = user;
+    p->snap = snap;
+
+    pthread_mutex_lock(&c->send_mtx);
+    pthread_mutex_lock(&c->mtx);
+    if (c->closed || c->closing) {
+        pthread_mutex_unlock(&c->mtx);
+        pthread_mutex_unlock(&c->send_mtx);
+        free(p);
+        return -1;
+    }
+    if (c->tail) {
+        c->tail->next = p;
+    } else {
+        c->head = p;
+    }
+    c->tail = p;
+    pthread_mutex_unlock(&c->mtx);
+
+    int rc = rw_send_msg(c->fd, type, payload, payload_len);
+    if (rc != 0) {
+        //not on the wire, so it cannot have been completed: unlink it again
+        pthread_mutex_lock(&c->mtx);
+        rwc_pending_t **pp = &c->head;
+        rwc_pending_t *prev = NULL;
+        while (*pp && *pp != p) {
+            prev = *pp;
+            pp = &(*pp)->next;
+        }
+        if (*pp) {
+            *pp = p->next;
+            if (c->tail == p) c->tail = prev;
+            free(p);
+        }
+        pthread_mutex_unlock(&c->mtx);
+        (void)shutdown(c->fd, SHUT_RDWR);
+    }
+    pthread_mutex_unlock(&c->send_mtx);
+    return rc;
+}
+
+int rwc_submit(rwc_conn_t *c, rw_msg_type_t type, const void *payload, uint32_t payload_len,
+               rwc_done_fn done, void *user) {
+    return submit(c, type, payload, payload_len, NULL, done, user);
+}
+
+int rwc_request_snapshot(rwc_conn_t *c, rw_wire_snapshot_format_t format, uint32_t base_snapshot_id,
+                         rwc_snapshot_t *dst, rwc_done_fn done, void *user) {
+    if (!dst) return -1;
+    rw_request_snapshot_t req;
+    memset(&req, 0, sizeof(req));
+    req.pid = (uint32_t)getpid();
+    req.format = (uint8_t)format;
+    req.base_snapshot_id = base_snapshot_id;
+    return submit(c, RW_MSG_REQUEST_SNAPSHOT, &req, sizeof(req), dst, done, user);
+}
+
+static void waiter_free(rwc_waiter_t *w) {
+    pthread_mutex_destroy(&w->mtx);
+    pthread_cond_destroy(&w->cv);
+    free(w);
+}
+
+static void call_done(rwc_conn_t *c, void *user, int status, const rw_msg_hdr_t *hdr, const void *payload) {
+    (void)c;
+    rwc_waiter_t *w = (rwc_waiter_t *)user;
+    pthread_mutex_lock(&w->mtx);
+    if (w->abandoned) {
+        pthread_mutex_unlock(&w->mtx);
+        waiter_free(w);
+        return;
+    }
+    w->status = status;
+    if (hdr) {
+        w->hdr = *hdr;
+        if (w->out && payload) {
+            memcpy(w->out, payload, hdr->payload_len < w->out_cap ? hdr->payload_len : w->out_cap);
+        }
+    }
+    w->done = 1;
+    pthread_cond_signal(&w->cv);
+    pthread_mutex_unlock(&w->mtx);
+}
+
+int rwc_call(rwc_conn_t *c, rw_msg_type_t type, const void *payload, uint32_t payload_len,
+             rw_msg_hdr_t *out_hdr, void *out, uint32_t out_cap, int timeout_ms) {
+    rwc_waiter_t *w = (rwc_waiter_t *)calloc(1, sizeof(*w));
+    if (!w) return RWC_ERR_DISCONNECTED;
+    pthread_mutex_init(&w->mtx, NULL);
+    pthread_cond_init(&w->cv, NULL);
+    w->out = out;
+    w->out_cap = out ? out_cap : 0;
+
+    if (submit(c, type, payload, payload_len, NULL, call_done, w) != 0) {
+        waiter_free(w);
+        return RWC_ERR_DISCONNECTED;
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&w->mtx);
+    while (!w->done) {
+        if (timeout_ms <= 0) {
+            pthread_cond_wait(&w->cv, &w->mtx);
+        } else if (pthread_cond_timedwait(&w->cv, &w->mtx, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    if (!w->done) {
+        //the reply may still come; the callback frees the waiter then
+        w->abandoned = 1;
+        pthread_mutex_unlock(&w->mtx);
+        return RWC_ERR_TIMEOUT;
+    }
+    int status = w->status;
+    if (out_hdr) *out_hdr = w->hdr;
+    pthread_mutex_unlock(&w->mtx);
+    waiter_free(w);
+    return status;
+}
@@ -0,0 +1,192 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_RWCLIENT_H
+#define SEMPRACA_RWCLIENT_H
+
+/**
+ * @file rwclient.h
+ * @brief Embeddable client library (librwclient.a) for programmatic consumers.
+ *
+ * The interactive client keeps its state in globals (dispatcher, snapshot
+ * receiver) and is driven by the menu. This library offers the same protocol
+ * behind an explicit handle, so one process can hold any number of
+ * connections:
+ *
+ * @code
+ * rwc_conn_t *c = rwc_connect("/tmp/rw_test.sock", &callbacks);
+ * rw_query_status_t q = {getpid()};
+ * rwc_submit(c, RW_MSG_QUERY_STATUS, &q, sizeof(q), on_status, ctx);
+ * ...
+ * rwc_close(c);
+ * @endcode
+ *
+ * Model
+ * -----
+ * - Each connection owns one reader thread. Requests are pipelined: any thread
+ *   may submit at any time without waiting for earlier replies. The server
+ *   answers the requests of one connection in order, so replies are matched to
+ *   requests first-in first-out.
+ * - Completion callbacks and notification callbacks run on the reader thread
+ *   of their connection. They may submit new requests but must not block on
+ *   the same connection (no @ref rwc_call() from a callback).
+ * - Payload pointers passed to callbacks are valid only during the call.
+ * - Snapshot data goes straight into caller-provided field buffers
+ *   (@ref rwc_snapshot_t); the library does not allocate per snapshot.
+ *
+ * Only submit requests that the server answers with exactly one reply
+ * (ACK/ERROR or a typed response); see the protocol section of README.md.
+ */
+
+#include "../common/protocol.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Opaque connection handle. */
+typedef struct rwc_conn rwc_conn_t;
+
+/**
+ * @brief Completion status passed to @ref rwc_done_fn.
+ */
+typedef enum {
+    RWC_OK = 0,              /**< Reply received (hdr/payload valid). */
+    RWC_ERR_SERVER = 1,      /**< Server replied with RW_MSG_ERROR (payload: rw_error_t). */
+    RWC_ERR_TRUNCATED = 2,   /**< Snapshot reply received, but a field did not fit its buffer. */
+    RWC_ERR_DISCONNECTED = -1, /**< Connection lost or closed before the reply (hdr is NULL). */
+    RWC_ERR_TIMEOUT = -2       /**< @ref rwc_call() only: no reply within the timeout. */
+} rwc_status_t;
+
+/**
+ * @brief Completion callback of a submitted request.
+ *
+ * @param c       Connection.
+ * @param user    User pointer given at submission.
+ * @param status  @ref rwc_status_t.
+ * @param hdr     Reply header, NULL on @ref RWC_ERR_DISCONNECTED.
+ * @param payload Reply payload (hdr->payload_len bytes), valid during the call.
+ */
+typedef void (*rwc_done_fn)(rwc_conn_t *c, void *user, int status,
+                            const rw_msg_hdr_t *hdr, const void *payload);
+
+/**
+ * @brief Notification callbacks (each may be NULL).
+ */
+typedef struct {
+    void (*on_progress)(rwc_conn_t *c, void *user, const rw_progress_t *p);
+    void (*on_end)(rwc_conn_t *c, void *user, const rw_end_t *e);
+    void (*on_global_mode)(rwc_conn_t *c, void *user, const rw_global_mode_changed_t *m);
+    /** Connection lost (not called for @ref rwc_close()); @p err is errno-like. */
+    void (*on_disconnect)(rwc_conn_t *c, void *user, int err);
+    void *user;
+} rwc_callbacks_t;
+
+/** Highest snapshot field id (@ref rw_snapshot_field_t) a buffer can be given for. */
+#define RWC_SNAP_FIELD_MAX RW_SNAP_FIELD_P_LEQ_K_Q
+
+/**
+ * @brief Destination of a snapshot request.
+ *
+ * Set field[f] / field_cap[f] for every field you want (index = field id);
+ * fields without a buffer are discarded. On completion @ref begin holds the
+ * snapshot metadata and field_len[f] the number of bytes stored for field f
+ * (a field larger than its buffer is cut and reported as @ref RWC_ERR_TRUNCATED).
+ */
+typedef struct {
+    void *field[RWC_SNAP_FIELD_MAX + 1];
+    uint64_t field_cap[RWC_SNAP_FIELD_MAX + 1];
+    uint64_t field_len[RWC_SNAP_FIELD_MAX + 1];
+    rw_snapshot_begin_t begin;
+} rwc_snapshot_t;
+
+/**
+ * @brief Connect, JOIN and start the reader thread.
+ *
+ * The handshake is synchronous (5 s timeout).
+ *
+ * @param socket_path Server socket.
+ * @param cb          Notification callbacks (copied; NULL = none).
+ * @return Handle, or NULL on failure.
+ */
+rwc_conn_t *rwc_connect(const char *socket_path, const rwc_callbacks_t *cb);
+
+/**
+ * @brief Like @ref rwc_connect(), resuming an earlier session.
+ *
+ * An owner whose connection dropped gets control back when it resumes within
+ * the server's grace period (see rw_welcome_t::resumed / is_owner).
+ *
+ * @param socket_path  Server socket.
+ * @param resume_token session_token of the earlier @ref rwc_welcome() (0 = new session).
+ * @param cb           Notification callbacks (copied; NULL = none).
+ * @return Handle, or NULL on failure.
+ */
+rwc_conn_t *rwc_connect_resume(const char *socket_path, uint64_t resume_token, const rwc_callbacks_t *cb);
+
+/**
+ * @brief Close the connection and free the handle.
+ *
+ * Pending requests complete with @ref RWC_ERR_DISCONNECTED before it returns.
+ * Must not be called from a callback of the same connection.
+ */
+void rwc_close(rwc_conn_t *c);
+
+/**
+ * @brief WELCOME received during @ref rwc_connect().
+ */
+const rw_welcome_t *rwc_welcome(const rwc_conn_t *c);
+
+/**
+ * @brief Submit a request without waiting for its reply.
+ *
+ * @param c           Connection.
+ * @param type        Request type.
+ * @param payload     Request payload (may be NULL if @p payload_len is 0).
+ * @param payload_len Payload length.
+ * @param done        Completion callback (may be NULL).
+ * @param user        Passed to @p done.
+ * @return 0 if sent (@p done will be called exactly once), -1 otherwise
+ *         (@p done is not called).
+ */
+int rwc_submit(rwc_conn_t *c, rw_msg_type_t type, const void *payload, uint32_t payload_len,
+               rwc_done_fn done, void *user);
+
+/**
+ * @brief Request a snapshot into caller buffers.
+ *
+ * @p dst must stay valid until @p done is called. The reply (ACK) completes the
+ * request after the whole snapshot stream has been stored.
+ *
+ * With @p base_snapshot_id (RAW only) @p dst must hold that snapshot completely;
+ * the server may then send only the changed cells, which are written over it
+ * (dst->begin.base_snapshot_id tells whether it did).
+ *
+ * @param c      Connection.
+ * @param format @ref rw_wire_snapshot_format_t.
+ * @param base_snapshot_id Snapshot held in @p dst to update (0 = full snapshot).
+ * @param dst    Field buffers.
+ * @param done   Completion callback (may be NULL).
+ * @param user   Passed to @p done.
+ * @return 0 if sent, -1 otherwise.
+ */
+int rwc_request_snapshot(rwc_conn_t *c, rw_wire_snapshot_format_t format, uint32_t base_snapshot_id,
+                         rwc_snapshot_t *dst, rwc_done_fn done, void *user);
+
+/**
+ * @brief Blocking request/reply convenience on top of @ref rwc_submit().
+ *
+ * @param c           Connection.
+ * @param type        Request type.
+ * @param payload     Request payload.
+ * @param payload_len Payload length.
+ * @param out_hdr     Reply header (may be NULL).
+ * @param out         Buffer for the reply payload (may be NULL).
+ * @param out_cap     Capacity of @p out; longer payloads are cut.
+ * @param timeout_ms  Timeout, 0 = wait forever.
+ * @return @ref rwc_status_t of the reply (@ref RWC_ERR_TIMEOUT on timeout).
+ */
+int rwc_call(rwc_conn_t *c, rw_msg_type_t type, const void *payload, uint32_t payload_len,
+             rw_msg_hdr_t *out_hdr, void *out, uint32_t out_cap, int timeout_ms);
+
+#endif //SEMPRACA_RWCLIENT_H
@@ -0,0 +1,661 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cluster.h"
+#include "trace.h"
+
+#include "scheduler.h"
+#include "worker_pool.h"
+#include "world_tiles.h"
+#include "../common/protocol.h"
+#include "../common/util.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @file cluster.c
+ * @brief Implementation of the cluster coordinator and the worker process loop.
+ */
+
+#define CLUSTER_QUEUE_CAPACITY 8192u
+#define CLUSTER_POLL_MS 100
+/* Start cells submitted between two checks for STOP_SIM. */
+#define CLUSTER_STOP_CHECK_CELLS 4096u
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Read and discard @p len payload bytes. */
+static int drain_payload(int fd, uint32_t len) {
+    char buf[256];
+    while (len > 0) {
+        uint32_t chunk = len > sizeof(buf) ? (uint32_t)sizeof(buf) : len;
+        if (rw_recv_payload(fd, buf, chunk) != 0) return -1;
+        len -= chunk;
+    }
+    return 0;
+}
+
+/*======== worker process ========*/
+
+/* Non-blocking check for STOP_SIM from the coordinator. Returns -1 on EOF. */
+static int worker_poll_stop(int fd, int *stop) {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    while (!*stop && poll(&pfd, 1, 0) > 0) {
+        rw_msg_hdr_t hdr;
+        if (rw_recv_hdr(fd, &hdr) != 0) return -1;
+        if (drain_payload(fd, hdr.payload_len) != 0) return -1;
+        if (hdr.type == RW_MSG_STOP_SIM) {
+            *stop = 1;
+        }
+    }
+    return 0;
+}
+
+/* Stream counters of cells [offset, offset + count) as CLUSTER_DELTA messages. */
+static int worker_send_delta(int fd, const results_t *r, uint32_t rep,
+                             uint64_t offset, uint32_t count, uint8_t *buf) {
+    const uint32_t *trials = results_trials(r);
+    const uint64_t *sum_steps = results_sum_steps(r);
+    const uint32_t *success = results_success_leq_k(r);
+
+    for (uint32_t done = 0; done < count;) {
+        uint32_t n = count - done;
+        if (n > RW_CLUSTER_CHUNK_CELLS) n = RW_CLUSTER_CHUNK_CELLS;
+
+        rw_cluster_delta_t d;
+        memset(&d, 0, sizeof(d));
+        d.rep = rep;
+        d.offset = offset + done;
+        d.count = n;
+
+        uint8_t *p = buf;
+        memcpy(p, &d, sizeof(d));
+        p += sizeof(d);
+        memcpy(p, trials + d.offset, sizeof(uint32_t) * (size_t)n);
+        p += sizeof(uint32_t) * (size_t)n;
+        memcpy(p, success + d.offset, sizeof(uint32_t) * (size_t)n);
+        p += sizeof(uint32_t) * (size_t)n;
+        memcpy(p, sum_steps + d.offset, sizeof(uint64_t) * (size_t)n);
+        p += sizeof(uint64_t) * (size_t)n;
+
+        if (rw_send_msg(fd, RW_MSG_CLUSTER_DELTA, buf, (uint32_t)(p - buf)) != 0) return -1;
+        done += n;
+    }
+    return 0;
+}
+
+/* Receive the obstacle bitmap announced by CLUSTER_ASSIGN. */
+static int worker_recv_world(int fd, world_t *w) {
+    uint64_t n = world_obstacle_bytes(w);
+    uint64_t got = 0;
+
+    while (got < n) {
+        rw_msg_hdr_t hdr;
+        rw_cluster_world_chunk_t ch;
+        if (rw_recv_hdr(fd, &hdr) != 0) return -1;
+        if (hdr.type != RW_MSG_CLUSTER_WORLD_CHUNK || hdr.payload_len < sizeof(ch)) return -1;
+        if (rw_recv_payload(fd, &ch, sizeof(ch)) != 0) return -1;
+        if (ch.offset != got || ch.count > n - got || hdr.payload_len != sizeof(ch) + ch.count) return -1;
+        if (rw_recv_payload(fd, w->obstacle_bits + ch.offset, ch.count) != 0) return -1;
+        got += ch.count;
+    }
+    return 0;
+}
+
+/* Map the RWTILE file announced by CLUSTER_ASSIGN (shared page cache, no copy). */
+static int worker_map_world(int fd, world_t *w, world_kind_t kind, world_size_t size) {
+    rw_msg_hdr_t hdr;
+    rw_cluster_world_file_t wf;
+    if (rw_recv_hdr(fd, &hdr) != 0) return -1;
+    if (hdr.type != RW_MSG_CLUSTER_WORLD_FILE || hdr.payload_len != sizeof(wf)) return -1;
+    if (rw_recv_payload(fd, &wf, sizeof(wf)) != 0) return -1;
+    wf.path[RW_PATH_MAX - 1] = '\0';
+
+    if (world_tiles_map(w, wf.path) != 0) return -1;
+    if (w->kind != kind || w->size.width != size.width || w->size.height != size.height) {
+        log_error("cluster worker: '%s' does not match the assigned world", wf.path);
+        world_destroy(w);
+        return -1;
+    }
+    return 0;
+}
+
+/* Run one assignment; returns -1 if the coordinator went away. */
+static int worker_run(int fd, int nthreads, const rw_cluster_assign_t *a, uint8_t *buf) {
+    world_t w;
+    results_t r;
+    world_size_t size = {(int32_t)a->size.width, (int32_t)a->size.height};
+    world_kind_t kind = (a->world_kind == RW_WIRE_WORLD_OBSTACLES) ? WORLD_OBSTACLES : WORLD_WRAP;
+
+    if (a->world_mapped) {
+        if (worker_map_world(fd, &w, kind, size) != 0) return -1;
+    } else {
+        if (world_init(&w, kind, size) != 0) return -1;
+        if (worker_recv_world(fd, &w) != 0) {
+            world_destroy(&w);
+            return -1;
+        }
+    }
+    if (results_init(&r, size) != 0) {
+        world_destroy(&w);
+        return -1;
+    }
+    if (a->width == 0 || a->x0 > a->size.width || a->width > a->size.width - a->x0 ||
+        a->y0 >= a->y1 || a->y1 > a->size.height) {
+        results_destroy(&r);
+        world_destroy(&w);
+        return -1;
+    }
+
+    move_probs_t probs = {a->probs.p_up, a->probs.p_down, a->probs.p_left, a->probs.p_right};
+    worker_pool_t pool;
+    if (worker_pool_init(&pool, nthreads, CLUSTER_QUEUE_CAPACITY, &w, &r, probs, a->k_max_steps) != 0) {
+        die("cluster worker: worker_pool_init() failed");
+    }
+    worker_pool_set_crn(&pool, a->crn_enabled, a->crn_seed);
+
+    int stop = 0, rc = 0;
+    rw_cluster_done_t done;
+    memset(&done, 0, sizeof(done));
+
+    for (uint32_t rep = 1; rep <= a->total_reps && !stop && rc == 0; rep++) {
+        for (uint32_t y = a->y0; y < a->y1; y++) {
+            results_clear_range(&r, world_index(&w, (int32_t)a->x0, (int32_t)y), a->width);
+        }
+
+        uint64_t t0 = now_ns();
+        uint32_t walks = 0;
+        uint32_t since_check = CLUSTER_STOP_CHECK_CELLS;
+
+        world_region_t band = {(int32_t)a->x0, (int32_t)a->y0,
+                               {(int32_t)a->width, (int32_t)(a->y1 - a->y0)}};
+        world_scan_t scan;
+        pos_t p;
+        world_scan_begin(&scan, &w, &band);
+        while (!stop && world_scan_next(&scan, &p)) {
+            if (++since_check >= CLUSTER_STOP_CHECK_CELLS) {
+                since_check = 0;
+                if (worker_poll_stop(fd, &stop) != 0) {
+                    rc = -1;
+                    break;
+                }
+                if (stop) break;
+            }
+            if (world_is_obstacle_xy(&w, p.x, p.y)) continue;
+
+            rw_job_t job;
+            job.cell_idx = world_index(&w, p.x, p.y);
+            job.start = p;
+            job.rep = rep;
+            worker_pool_submit(&pool, job);
+            walks++;
+        }
+        worker_pool_wait_all(&pool);
+        uint64_t busy = now_ns() - t0;
+        if (rc != 0) break;
+
+        rw_cluster_rep_done_t rd;
+        rd.rep = rep;
+        rd.walks = walks;
+        rd.busy_ns = busy;
+        for (uint32_t y = a->y0; y < a->y1 && rc == 0; y++) {
+            rc = worker_send_delta(fd, &r, rep, world_index(&w, (int32_t)a->x0, (int32_t)y), a->width, buf);
+        }
+        if (rc != 0 || rw_send_msg(fd, RW_MSG_CLUSTER_REP_DONE, &rd, sizeof(rd)) != 0) {
+            rc = -1;
+            break;
+        }
+        done.reps_done = rep;
+        done.walks += walks;
+        done.busy_ns += busy;
+    }
+
+    worker_pool_stop(&pool);
+    worker_pool_destroy(&pool);
+    results_destroy(&r);
+    world_destroy(&w);
+
+    if (rc == 0 && rw_send_msg(fd, RW_MSG_CLUSTER_DONE, &done, sizeof(done)) != 0) {
+        rc = -1;
+    }
+    return rc;
+}
+
+static void worker_process_main(int fd, int nthreads) {
+    size_t buf_len = sizeof(rw_cluster_delta_t) + (size_t)RW_CLUSTER_CHUNK_CELLS * 16u;
+    uint8_t *buf = (uint8_t *)malloc(buf_len);
+    if (!buf) {
+        die("cluster worker: out of memory");
+    }
+
+    if (scheduler_start(nthreads) != 0) {
+        die("cluster worker: scheduler_start failed");
+    }
+    log_info("Cluster worker started (pid=%d, threads=%d)", (int)getpid(), nthreads);
+
+    while (1) {
+        rw_msg_hdr_t hdr;
+        if (rw_recv_hdr(fd, &hdr) != 0) break;
+
+        if (hdr.type == RW_MSG_CLUSTER_ASSIGN && hdr.payload_len == sizeof(rw_cluster_assign_t)) {
+            rw_cluster_assign_t a;
+            if (rw_recv_payload(fd, &a, sizeof(a)) != 0) break;
+            if (worker_run(fd, nthreads, &a, buf) != 0) break;
+            continue;
+        }
+
+        /* Late STOP_SIM after a finished run, or unknown: ignore. */
+        if (drain_payload(fd, hdr.payload_len) != 0) break;
+    }
+
+    scheduler_stop();
+    free(buf);
+}
+
+/*======== coordinator ========*/
+
+int cluster_spawn(cluster_t *c, int nworkers, int threads_per_worker) {
+    if (!c || nworkers <= 0 || threads_per_worker <= 0) return -1;
+
+    memset(c, 0, sizeof(*c));
+    c->workers = (cluster_worker_t *)calloc((size_t)nworkers, sizeof(cluster_worker_t));
+    if (!c->workers) return -1;
+    if (pthread_mutex_init(&c->mtx, NULL) != 0) {
+        free(c->workers);
+        c->workers = NULL;
+        return -1;
+    }
+
+    for (int i = 0; i < nworkers; i++) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+            log_error("cluster: socketpair failed: %s", strerror(errno));
+            cluster_shutdown(c);
+            return -1;
+        }
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            log_error("cluster: fork failed: %s", strerror(errno));
+            close(sv[0]);
+            close(sv[1]);
+            cluster_shutdown(c);
+            return -1;
+        }
+        if (pid == 0) {
+            /* Worker: Ctrl+C is handled by the coordinator, which closes our socket. */
+            signal(SIGINT, SIG_IGN);
+            close(sv[0]);
+            for (int j = 0; j < c->nworkers; j++) {
+                close(c->workers[j].fd);
+            }
+            worker_process_main(sv[1], threads_per_worker);
+            close(sv[1]);
+            _exit(0);
+        }
+
+        close(sv[1]);
+        c->workers[i].pid = pid;
+        c->workers[i].fd = sv[0];
+        c->nworkers = i + 1;
+        c->nlive = i + 1;
+    }
+
+    log_info("Cluster mode: %d worker processes, %d threads each", nworkers, threads_per_worker);
+    return 0;
+}
+
+void cluster_shutdown(cluster_t *c) {
+    if (!c || !c->workers) return;
+
+    for (int i = 0; i < c->nworkers; i++) {
+        if (c->workers[i].fd >= 0) close(c->workers[i].fd);
+    }
+    for (int i = 0; i < c->nworkers; i++) {
+        if (c->workers[i].pid > 0) waitpid(c->workers[i].pid, NULL, 0);
+    }
+
+    pthread_mutex_destroy(&c->mtx);
+    free(c->workers);
+    memset(c, 0, sizeof(*c));
+}
+
+/* Take worker @p i out of service; its stream may be mid-frame, so it is never read again. */
+static void worker_retire_locked(cluster_t *c, int i) {
+    cluster_worker_t *wk = &c->workers[i];
+    if (wk->fd < 0) return;
+
+    close(wk->fd);
+    kill(wk->pid, SIGKILL);
+    waitpid(wk->pid, NULL, 0);
+    log_error("cluster: worker pid=%d retired, %d of %d workers left", (int)wk->pid, c->nlive - 1, c->nworkers);
+    wk->fd = -1;
+    wk->pid = 0;
+    c->nlive--;
+}
+
+static int send_assign(int fd, const cluster_job_t *job, const world_region_t *reg,
+                       uint32_t y0, uint32_t y1) {
+    const world_t *w = job->world;
+
+    rw_cluster_assign_t a;
+    memset(&a, 0, sizeof(a));
+    a.world_kind = (w->kind == WORLD_OBSTACLES) ? RW_WIRE_WORLD_OBSTACLES : RW_WIRE_WORLD_WRAP;
+    a.crn_enabled = (uint8_t)(job->crn ? 1 : 0);
+    a.k_max_steps = job->k_max_steps;
+    a.size.width = (uint32_t)w->size.width;
+    a.size.height = (uint32_t)w->size.height;
+    a.probs.p_up = job->probs.p_up;
+    a.probs.p_down = job->probs.p_down;
+    a.probs.p_left = job->probs.p_left;
+    a.probs.p_right = job->probs.p_right;
+    a.total_reps = job->reps;
+    a.x0 = (uint32_t)reg->x;
+    a.width = (uint32_t)reg->size.width;
+    a.y0 = y0;
+    a.y1 = y1;
+    a.crn_seed = job->crn_seed;
+    a.world_mapped = (uint8_t)((job->world_file && world_is_readonly(w)) ? 1 : 0);
+
+    if (rw_send_msg(fd, RW_MSG_CLUSTER_ASSIGN, &a, sizeof(a)) != 0) return -1;
+
+    if (a.world_mapped) {
+        rw_cluster_world_file_t wf;
+        memset(&wf, 0, sizeof(wf));
+        snprintf(wf.path, sizeof(wf.path), "%s", job->world_file);
+        return rw_send_msg(fd, RW_MSG_CLUSTER_WORLD_FILE, &wf, sizeof(wf));
+    }
+
+    uint8_t buf[sizeof(rw_cluster_world_chunk_t) + RW_CLUSTER_CHUNK_CELLS];
+    uint64_t n = world_obstacle_bytes(w);
+    for (uint64_t off = 0; off < n;) {
+        rw_cluster_world_chunk_t ch;
+        memset(&ch, 0, sizeof(ch));
+        ch.offset = off;
+        ch.count = (n - off > RW_CLUSTER_CHUNK_CELLS) ? RW_CLUSTER_CHUNK_CELLS : (uint32_t)(n - off);
+        memcpy(buf, &ch, sizeof(ch));
+        memcpy(buf + sizeof(ch), w->obstacle_bits + off, ch.count);
+        if (rw_send_msg(fd, RW_MSG_CLUSTER_WORLD_CHUNK, buf, (uint32_t)(sizeof(ch) + ch.count)) != 0) return -1;
+        off += ch.count;
+    }
+    return 0;
+}
+
+static uint64_t free_cells_in_row(const world_t *w, const world_region_t *reg, uint32_t y) {
+    uint64_t free_cells = 0;
+    for (int32_t x = reg->x; x < reg->x + reg->size.width; x++) {
+        if (!world_is_obstacle_xy(w, x, (int32_t)y)) free_cells++;
+    }
+    return free_cells;
+}
+
+/* Split the rows of @p reg into @p n bands with roughly equal free-cell
+ * counts; band i is rows [rows[i], rows[i+1]) (absolute row numbers). */
+static void partition_rows(const world_t *w, const world_region_t *reg, int n, uint32_t *rows) {
+    const uint32_t Y0 = (uint32_t)reg->y;
+    const uint32_t Y1 = Y0 + (uint32_t)reg->size.height;
+
+    uint64_t total = 0;
+    for (uint32_t y = Y0; y < Y1; y++) {
+        total += free_cells_in_row(w, reg, y);
+    }
+
+    uint64_t acc = 0;
+    uint32_t y = Y0;
+    rows[0] = Y0;
+    for (int b = 1; b < n; b++) {
+        uint64_t target = total * (uint64_t)b / (uint64_t)n;
+        /* leave at least one row for each remaining band */
+        while (y < Y1 - (uint32_t)(n - b) && (acc < target || y < rows[b - 1] + 1)) {
+            acc += free_cells_in_row(w, reg, y);
+            y++;
+        }
+        rows[b] = y;
+    }
+    rows[n] = Y1;
+}
+
+typedef struct {
+    uint32_t reps_done;
+    int done;
+} worker_run_state_t;
+
+int cluster_run(cluster_t *c,
+                const cluster_job_t *job,
+                results_t *r,
+                const volatile int *stop,
+                cluster_rep_fn on_rep,
+                void *user,
+                cluster_run_stats_t *out) {
+    if (!c || !c->workers || !job || !job->world || !r || job->reps == 0) return -1;
+
+    const world_t *w = job->world;
+    world_region_t reg;
+    if (world_region_resolve(w, &job->region, &reg) != 0) return -1;
+    if (results_cell_count(r) != world_cell_count(w)) return -1;
+
+    pthread_mutex_lock(&c->mtx);
+
+    if (c->nlive == 0) {
+        pthread_mutex_unlock(&c->mtx);
+        log_error("cluster: no worker left");
+        return -1;
+    }
+    int n = (job->nworkers <= 0 || job->nworkers > c->nlive) ? c->nlive : job->nworkers;
+    if (n > reg.size.height) n = (int)reg.size.height;
+
+    int *ids = (int *)malloc(sizeof(int) * (size_t)n);
+    uint32_t *rows = (uint32_t *)malloc(sizeof(uint32_t) * (size_t)(n + 1));
+    struct pollfd *pfds = (struct pollfd *)malloc(sizeof(struct pollfd) * (size_t)n);
+    worker_run_state_t *st = (worker_run_state_t *)calloc((size_t)n, sizeof(worker_run_state_t));
+    size_t buf_len = sizeof(rw_cluster_delta_t) + (size_t)RW_CLUSTER_CHUNK_CELLS * 16u;
+    uint8_t *buf = (uint8_t *)malloc(buf_len);
+    if (!ids || !rows || !pfds || !st || !buf) {
+        pthread_mutex_unlock(&c->mtx);
+        free(ids);
+        free(rows);
+        free(pfds);
+        free(st);
+        free(buf);
+        return -1;
+    }
+    //band i goes to the i-th worker still in service
+    for (int i = 0, k = 0; k < n; i++) {
+        if (c->workers[i].fd >= 0) ids[k++] = i;
+    }
+
+    cluster_run_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.nworkers = n;
+    uint64_t busy_ns = 0;
+    uint64_t t0 = now_ns();
+    int rc = 0;
+
+    partition_rows(w, &reg, n, rows);
+    for (int i = 0; i < n; i++) {
+        if (send_assign(c->workers[ids[i]].fd, job, &reg, rows[i], rows[i + 1]) != 0) {
+            log_error("cluster: failed to assign work to worker %d", ids[i]);
+            worker_retire_locked(c, ids[i]);
+            st[i].done = 1;
+            rc = -1;
+        }
+    }
+
+    int stop_sent = 0;
+    int remaining = 0;
+    for (int i = 0; i < n; i++) {
+        if (!st[i].done) remaining++;
+    }
+
+    while (remaining > 0) {
+        //a failed run is incomplete anyway: stop the others, they still end with CLUSTER_DONE
+        if (((stop && *stop) || rc != 0) && !stop_sent) {
+            rw_stop_sim_t s;
+            s.pid = (uint32_t)getpid();
+            for (int i = 0; i < n; i++) {
+                if (!st[i].done) (void)rw_send_msg(c->workers[ids[i]].fd, RW_MSG_STOP_SIM, &s, sizeof(s));
+            }
+            stop_sent = 1;
+        }
+
+        for (int i = 0; i < n; i++) {
+            pfds[i].fd = st[i].done ? -1 : c->workers[ids[i]].fd;
+            pfds[i].events = POLLIN;
+            pfds[i].revents = 0;
+        }
+        int pr = poll(pfds, (nfds_t)n, CLUSTER_POLL_MS);
+        if (pr < 0 && errno != EINTR) {
+            //workers still sending would leave stale frames for the next run
+            log_error("cluster: poll failed: %s", strerror(errno));
+            for (int i = 0; i < n; i++) {
+                if (!st[i].done) worker_retire_locked(c, ids[i]);
+            }
+            rc = -1;
+            break;
+        }
+        if (pr <= 0) continue;
+
+        for (int i = 0; i < n; i++) {
+            if (st[i].done || !(pfds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+            int fd = c->workers[ids[i]].fd;
+            rw_msg_hdr_t hdr;
+            int ok = rw_recv_hdr(fd, &hdr) == 0;
+
+            if (ok && hdr.type == RW_MSG_CLUSTER_DELTA &&
+                hdr.payload_len > sizeof(rw_cluster_delta_t) && hdr.payload_len <= buf_len) {
+                rw_cluster_delta_t d;
+                ok = rw_recv_payload(fd, buf, hdr.payload_len) == 0;
+                if (ok) {
+                    memcpy(&d, buf, sizeof(d));
+                    ok = d.count > 0 && hdr.payload_len == sizeof(d) + (size_t)d.count * 16u;
+                }
+                if (ok) {
+                    const uint8_t *p = buf + sizeof(d);
+                    const uint32_t *trials = (const uint32_t *)p;
+                    const uint32_t *success = (const uint32_t *)(p + sizeof(uint32_t) * (size_t)d.count);
+                    const uint64_t *sum_steps = (const uint64_t *)(p + sizeof(uint32_t) * 2u * (size_t)d.count);
+                    trace_span_t span;
+                    trace_begin(&span, "cluster delta merge", "cells", d.count);
+                    ok = results_merge_range(r, d.offset, d.count, trials, sum_steps, success) == 0;
+                    trace_end(&span);
+                }
+            } else if (ok && hdr.type == RW_MSG_CLUSTER_REP_DONE &&
+                       hdr.payload_len == sizeof(rw_cluster_rep_done_t)) {
+                rw_cluster_rep_done_t rd;
+                ok = rw_recv_payload(fd, &rd, sizeof(rd)) == 0;
+                if (ok) {
+                    st[i].reps_done = rd.rep;
+                    stats.walks += rd.walks;
+                    busy_ns += rd.busy_ns;
+
+                    uint32_t min_rep = job->reps;
+                    for (int j = 0; j < n; j++) {
+                        if (st[j].reps_done < min_rep) min_rep = st[j].reps_done;
+                    }
+                    if (min_rep > stats.reps_done) {
+                        stats.reps_done = min_rep;
+                        if (on_rep) on_rep(user, min_rep, job->reps);
+                    }
+                }
+            } else if (ok && hdr.type == RW_MSG_CLUSTER_DONE &&
+                       hdr.payload_len == sizeof(rw_cluster_done_t)) {
+                rw_cluster_done_t dn;
+                ok = rw_recv_payload(fd, &dn, sizeof(dn)) == 0;
+                if (ok) {
+                    st[i].done = 1;
+                    remaining--;
+                }
+            } else {
+                ok = 0;
+            }
+
+            if (!ok) {
+                log_error("cluster: worker %d (pid=%d) failed or sent an invalid message",
+                          ids[i], (int)c->workers[ids[i]].pid);
+                worker_retire_locked(c, ids[i]);
+                st[i].done = 1;
+                remaining--;
+                rc = -1;
+            }
+        }
+    }
+
+    stats.wall_s = (double)(now_ns() - t0) / 1e9;
+    stats.busy_s = (double)busy_ns / 1e9;
+
+    pthread_mutex_unlock(&c->mtx);
+
+    free(ids);
+    free(rows);
+    free(pfds);
+    free(st);
+    free(buf);
+
+    if (out) *out = stats;
+    return rc;
+}
+
+int cluster_scaling_report(cluster_t *c, const cluster_job_t *job, const char *path) {
+    if (!c || !c->workers || !job || !job->world || !path || job->reps == 0) return -1;
+
+    results_t scratch;
+    if (results_init(&scratch, job->world->size) != 0) return -1;
+
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        log_error("cluster: fopen('%s') failed: %s", path, strerror(errno));
+        results_destroy(&scratch);
+        return -1;
+    }
+
+    int ok = fprintf(f, "workers,reps,walks,wall_s,walks_per_s,speedup,efficiency,marginal\n") < 0 ? -1 : 0;
+    double x1 = 0.0, prev = 0.0;
+
+    for (int n = 1; n <= c->nworkers && ok == 0; n++) {
+        cluster_job_t j = *job;
+        j.nworkers = n;
+        cluster_run_stats_t st;
+
+        results_clear(&scratch);
+        if (cluster_run(c, &j, &scratch, NULL, NULL, NULL, &st) != 0) {
+            ok = -1;
+            break;
+        }
+        if (st.nworkers < n) break; /* fewer rows than workers */
+
+        double x = st.wall_s > 0.0 ? (double)st.walks / st.wall_s : 0.0;
+        if (n == 1) x1 = x;
+        double speedup = x1 > 0.0 ? x / x1 : 0.0;
+        double marginal = x1 > 0.0 ? (x - prev) / x1 : 0.0;
+        prev = x;
+
+        log_info("Cluster scaling: %d worker(s) %.0f walks/s, speedup %.2f, efficiency %.1f%%, marginal %+.2f",
+                 n, x, speedup, 100.0 * speedup / (double)n, marginal);
+        if (fprintf(f, "%d,%u,%llu,%.6f,%.1f,%.4f,%.4f,%.4f\n",
+                    n, j.reps, (unsigned long long)st.walks, st.wall_s, x,
+                    speedup, speedup / (double)n, marginal) < 0) {
+            ok = -1;
+        }
+    }
+
+    if (fclose(f) != 0) ok = -1;
+    results_destroy(&scratch);
+    return ok;
+}
@@ -0,0 +1,194 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_CLUSTER_H
+#define SEMPRACA_CLUSTER_H
+
+/**
+ * @file cluster.h
+ * @brief Cluster mode: one coordinator process and several worker processes.
+ *
+ * A single server process is limited by one address space and the memory
+ * bandwidth available to it. In cluster mode the server (coordinator) forks N
+ * worker processes at startup and talks to each one over a socketpair using
+ * the regular message framing (@ref rw_send_msg(), @ref rw_recv_hdr()).
+ *
+ * Work split
+ * ----------
+ * Start cells of the job region are partitioned into contiguous row bands
+ * with roughly equal numbers of free cells, one band per worker. For every run
+ * the coordinator sends each worker:
+ * - `CLUSTER_ASSIGN` (configuration + its band),
+ * - the obstacle bitmap as `CLUSTER_WORLD_CHUNK` messages, or for a mapped
+ *   world (see world_tiles.h) only the file path as `CLUSTER_WORLD_FILE`; the
+ *   worker maps the same file, so all processes share one page cache copy.
+ *
+ * The worker simulates all replications of its band with its own thread pool,
+ * submitting start cells in tile order (see @ref world_scan_next()).
+ * After each replication it streams the per-cell counters of that replication
+ * (row segments of its band) as `CLUSTER_DELTA` messages, followed by
+ * `CLUSTER_REP_DONE`; at the end it
+ * sends `CLUSTER_DONE`. The coordinator merges deltas into the global
+ * @ref results_t (so snapshots are served from it as usual) and reports
+ * replication r as completed once every worker finished r.
+ *
+ * With CRN enabled the walk from cell i in replication r uses the same stream
+ * as in a single-process run, so results do not depend on the worker count.
+ *
+ * Worker failure
+ * --------------
+ * A worker that dies, or sends a malformed or unexpected frame, is retired:
+ * its stream may stop mid-frame and cannot be resynchronized, so the
+ * coordinator closes its socket, kills and reaps it. The run fails; later runs
+ * split the region among the remaining workers and fail once none is left.
+ * Retired workers are not reforked: the coordinator is multithreaded by then.
+ *
+ * Threading
+ * ---------
+ * @ref cluster_spawn() must be called before any thread is created (it uses
+ * fork()). Runs are serialized by an internal mutex.
+ */
+
+#include "world.h"
+#include "results.h"
+#include "../common/types.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/**
+ * @brief Coordinator-side handle of one worker process.
+ */
+typedef struct {
+    pid_t pid;  /**< 0 once retired and reaped. */
+    int fd;     /**< Coordinator end of the socketpair (-1 once retired). */
+} cluster_worker_t;
+
+/**
+ * @brief Set of worker processes.
+ */
+typedef struct {
+    int nworkers;
+    cluster_worker_t *workers;
+
+    /** Workers still in service (see "Worker failure"). */
+    int nlive;
+
+    /** Serializes runs (simulation thread vs. scaling report). */
+    pthread_mutex_t mtx;
+} cluster_t;
+
+/**
+ * @brief Description of one cluster run.
+ */
+typedef struct {
+    const world_t *world;
+
+    /** RWTILE file of a mapped @ref world (NULL = send the bitmap). */
+    const char *world_file;
+
+    /** Start cells (empty = whole world). */
+    world_region_t region;
+
+    move_probs_t probs;
+    uint32_t k_max_steps;
+    uint32_t reps;
+
+    int crn;            /**< Non-zero: common random numbers. */
+    uint64_t crn_seed;
+
+    /** Number of workers to use (<= 0 or more than available = all). */
+    int nworkers;
+} cluster_job_t;
+
+/**
+ * @brief Outcome of a run.
+ */
+typedef struct {
+    /** Replications completed by every worker. */
+    uint32_t reps_done;
+
+    /** Workers actually used. */
+    int nworkers;
+
+    /** Walks simulated by all workers. */
+    uint64_t walks;
+
+    /** Wall-clock time of the run (seconds). */
+    double wall_s;
+
+    /** Sum of worker compute times (seconds). */
+    double busy_s;
+} cluster_run_stats_t;
+
+/**
+ * @brief Called by @ref cluster_run() whenever another replication is completed
+ *        by all workers.
+ */
+typedef void (*cluster_rep_fn)(void *user, uint32_t rep, uint32_t total);
+
+/**
+ * @brief Fork @p nworkers worker processes.
+ *
+ * Each child runs the worker loop until the coordinator closes its socket and
+ * then exits; it never returns from this function.
+ *
+ * @param c                  Cluster to initialize.
+ * @param nworkers           Number of worker processes (>= 1).
+ * @param threads_per_worker Simulation threads inside each worker (>= 1).
+ * @return 0 on success, -1 on failure (already started workers are shut down).
+ */
+int cluster_spawn(cluster_t *c, int nworkers, int threads_per_worker);
+
+/**
+ * @brief Close worker sockets and reap worker processes.
+ * @param c Cluster (may be NULL).
+ */
+void cluster_shutdown(cluster_t *c);
+
+/**
+ * @brief Run replications on the workers and merge results into @p r.
+ *
+ * @p r is not cleared; counters of every replication are added to it.
+ *
+ * @param c      Cluster.
+ * @param job    Run description.
+ * @param r      Results receiving the merged counters (same size as the world).
+ * @param stop   Optional stop flag; when it becomes non-zero the workers are
+ *               asked to stop after their current row.
+ * @param on_rep Optional per-replication callback.
+ * @param user   Callback argument.
+ * @param out    Optional run statistics.
+ *
+ * @retval 0  All workers finished (or stopped) normally.
+ * @retval -1 Invalid arguments, no worker left or a worker failed (it is retired).
+ */
+int cluster_run(cluster_t *c,
+                const cluster_job_t *job,
+                results_t *r,
+                const volatile int *stop,
+                cluster_rep_fn on_rep,
+                void *user,
+                cluster_run_stats_t *out);
+
+/**
+ * @brief Measure scaling efficiency per added worker process.
+ *
+ * Runs @p job with 1, 2, ..., N workers into scratch results (the server
+ * results are not touched) and writes a CSV report:
+ * @code
+ * workers,reps,walks,wall_s,walks_per_s,speedup,efficiency,marginal
+ * @endcode
+ * where speedup = X(n) / X(1), efficiency = speedup / n and marginal is the
+ * throughput gained by the n-th worker relative to X(1) (X = walks per second).
+ *
+ * @param c    Cluster.
+ * @param job  Run description (@ref cluster_job_t::nworkers is ignored).
+ * @param path Output CSV path.
+ * @return 0 on success, -1 on failure.
+ */
+int cluster_scaling_report(cluster_t *c, const cluster_job_t *job, const char *path);
+
+#endif //SEMPRACA_CLUSTER_H
@@ -0,0 +1,210 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#include "crn_diff.h"
+
+#include "random_walk.h"
+#include "scheduler.h"
+#include "../common/util.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file crn_diff.c
+ * @brief Implementation of the paired CRN comparison.
+ *
+ * The grid is split into row bands, run as background tasks of the scheduler
+ * (the caller takes band 0); each band runs all replications of its cells and
+ * stores the per-cell result row. The CSV is written afterwards by the
+ * calling thread, so the output does not depend on the band count.
+ */
+
+/* Per-cell output, in CSV column order after x,y,n. */
+enum {
+    COL_SUCC_A = 0,
+    COL_SUCC_B,
+    COL_D_SUCC,
+    COL_D_SUCC_CI,
+    COL_STEPS_A,
+    COL_STEPS_B,
+    COL_D_STEPS,
+    COL_D_STEPS_CI,
+    COL_COUNT
+};
+
+typedef struct {
+    const world_t *w;
+    crn_config_t a;
+    crn_config_t b;
+    uint32_t reps;
+    uint64_t seed;
+    uint32_t y0;
+    uint32_t y1;
+    double *out; /* cell_count * COL_COUNT */
+    sched_task_t task;
+} crn_task_t;
+
+/* Mean and 95% CI half-width of paired differences from running sums. */
+static void diff_stats(double sum, double sum_sq, uint32_t n, double *mean, double *ci95) {
+    *mean = sum / (double)n;
+    if (n < 2) {
+        *ci95 = NAN;
+        return;
+    }
+    double var = (sum_sq - sum * sum / (double)n) / (double)(n - 1);
+    if (var < 0.0) var = 0.0;
+    *ci95 = 1.96 * sqrt(var / (double)n);
+}
+
+static void crn_band_main(void *arg) {
+    crn_task_t *t = (crn_task_t *)arg;
+    const uint32_t W = (uint32_t)t->w->size.width;
+
+    for (uint32_t y = t->y0; y < t->y1; y++) {
+        for (uint32_t x = 0; x < W; x++) {
+            uint64_t idx = (uint64_t)y * W + x;
+            if (world_is_obstacle_idx(t->w, idx)) continue;
+
+            pos_t start = {(int32_t)x, (int32_t)y};
+            double succ_a = 0.0, succ_b = 0.0, ds = 0.0, ds2 = 0.0;
+            double steps_a = 0.0, steps_b = 0.0, dt = 0.0, dt2 = 0.0;
+
+            for (uint32_t rep = 1; rep <= t->reps; rep++) {
+                rw_rng_t rng;
+                uint32_t sa = 0, sb = 0;
+                int reached = 0, ok_a = 0, ok_b = 0;
+
+                rw_rng_seed_stream(&rng, t->seed, idx, rep);
+                random_walk_run(t->w, start, t->a.probs, t->a.k_max_steps, &rng, &sa, &reached, &ok_a);
+                rw_rng_seed_stream(&rng, t->seed, idx, rep);
+                random_walk_run(t->w, start, t->b.probs, t->b.k_max_steps, &rng, &sb, &reached, &ok_b);
+
+                double d = (double)(ok_b - ok_a);
+                succ_a += (double)ok_a;
+                succ_b += (double)ok_b;
+                ds += d;
+                ds2 += d * d;
+
+                d = (double)sb - (double)sa;
+                steps_a += (double)sa;
+                steps_b += (double)sb;
+                dt += d;
+                dt2 += d * d;
+            }
+
+            double *row = t->out + (size_t)idx * COL_COUNT;
+            row[COL_SUCC_A] = succ_a / (double)t->reps;
+            row[COL_SUCC_B] = succ_b / (double)t->reps;
+            diff_stats(ds, ds2, t->reps, &row[COL_D_SUCC], &row[COL_D_SUCC_CI]);
+            row[COL_STEPS_A] = steps_a / (double)t->reps;
+            row[COL_STEPS_B] = steps_b / (double)t->reps;
+            diff_stats(dt, dt2, t->reps, &row[COL_D_STEPS], &row[COL_D_STEPS_CI]);
+        }
+    }
+}
+
+static int write_report(const char *path, const world_t *w, uint32_t reps,
+                        const double *out, crn_diff_summary_t *sum) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        log_error("crn_diff: fopen('%s') failed: %s", path, strerror(errno));
+        return -1;
+    }
+
+    const uint32_t W = (uint32_t)w->size.width;
+    const uint64_t n = world_cell_count(w);
+    double ci_succ = 0.0, ci_steps = 0.0;
+
+    int ok = fprintf(f, "x,y,n,succ_a,succ_b,d_succ,d_succ_ci95,steps_a,steps_b,d_steps,d_steps_ci95\n") < 0 ? -1 : 0;
+    for (uint64_t idx = 0; idx < n && ok == 0; idx++) {
+        if (world_is_obstacle_idx(w, idx)) continue;
+        const double *row = out + (size_t)idx * COL_COUNT;
+
+        if (fprintf(f, "%llu,%llu,%u,%.6f,%.6f,%.6f,%.6f,%.3f,%.3f,%.3f,%.3f\n",
+                    (unsigned long long)(idx % W), (unsigned long long)(idx / W), reps,
+                    row[COL_SUCC_A], row[COL_SUCC_B], row[COL_D_SUCC], row[COL_D_SUCC_CI],
+                    row[COL_STEPS_A], row[COL_STEPS_B], row[COL_D_STEPS], row[COL_D_STEPS_CI]) < 0) {
+            ok = -1;
+        }
+
+        sum->cells++;
+        if (fabs(row[COL_D_SUCC]) > row[COL_D_SUCC_CI]) sum->succ_significant++;
+        if (fabs(row[COL_D_STEPS]) > row[COL_D_STEPS_CI]) sum->steps_significant++;
+        ci_succ += row[COL_D_SUCC_CI];
+        ci_steps += row[COL_D_STEPS_CI];
+    }
+
+    if (fclose(f) != 0) {
+        ok = -1;
+    }
+    if (ok != 0) {
+        log_error("crn_diff: write failed for '%s'", path);
+        return -1;
+    }
+
+    if (sum->cells > 0) {
+        sum->mean_succ_ci95 = ci_succ / (double)sum->cells;
+        sum->mean_steps_ci95 = ci_steps / (double)sum->cells;
+    }
+    return 0;
+}
+
+int crn_diff_run(const world_t *w,
+                 crn_config_t a,
+                 crn_config_t b,
+                 uint32_t reps,
+                 uint64_t seed,
+                 int nthreads,
+                 const char *path,
+                 crn_diff_summary_t *out_summary) {
+    if (!w || !path || reps == 0) return -1;
+    if (nthreads <= 0) nthreads = 1;
+
+    const uint32_t H = (uint32_t)w->size.height;
+    const uint64_t n = world_cell_count(w);
+    if ((uint32_t)nthreads > H) nthreads = (int)H;
+
+    double *out = (double *)calloc((size_t)n * COL_COUNT, sizeof(double));
+    crn_task_t *tasks = (crn_task_t *)malloc(sizeof(crn_task_t) * (size_t)nthreads);
+    if (!out || !tasks) {
+        free(out);
+        free(tasks);
+        return -1;
+    }
+
+    for (int i = 0; i < nthreads; i++) {
+        tasks[i].w = w;
+        tasks[i].a = a;
+        tasks[i].b = b;
+        tasks[i].reps = reps;
+        tasks[i].seed = seed;
+        tasks[i].y0 = (uint32_t)(((uint64_t)H * (uint64_t)i) / (uint64_t)nthreads);
+        tasks[i].y1 = (uint32_t)(((uint64_t)H * (uint64_t)(i + 1)) / (uint64_t)nthreads);
+        tasks[i].out = out;
+    }
+    sched_group_t group;
+    sched_group_init(&group);
+    for (int i = 1; i < nthreads; i++) {
+        scheduler_submit(SCHED_BACKGROUND, &tasks[i].task, crn_band_main, &tasks[i], &group);
+    }
+    crn_band_main(&tasks[0]);
+    sched_group_wait(&group);
+    sched_group_destroy(&group);
+
+    crn_diff_summary_t sum;
+    memset(&sum, 0, sizeof(sum));
+    int rc = write_report(path, w, reps, out, &sum);
+
+    free(out);
+    free(tasks);
+
+    if (rc == 0 && out_summary) {
+        *out_summary = sum;
+    }
+    return rc;
+}
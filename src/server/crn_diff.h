@@ -0,0 +1,89 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_CRN_DIFF_H
+#define SEMPRACA_CRN_DIFF_H
+
+/**
+ * @file crn_diff.h
+ * @brief Paired comparison of two configurations using common random numbers.
+ *
+ * For every free start cell and every replication r, one walk is simulated
+ * under configuration A and one under configuration B, both driven by the same
+ * random stream (@ref rw_rng_seed_stream() with the same seed, cell and r).
+ * Because the walks are coupled, the per-cell difference B - A has a much
+ * smaller variance than the difference of two independent runs.
+ *
+ * Two metrics are compared per cell:
+ * - success indicator (origin reached within K steps),
+ * - truncated step count min(T, K).
+ *
+ * For each metric the report contains the means under A and B, the mean
+ * paired difference and the half-width of its 95% confidence interval
+ * (1.96 * s / sqrt(n), s = sample standard deviation of the differences).
+ *
+ * Report format (CSV, one row per free cell):
+ * @code
+ * x,y,n,succ_a,succ_b,d_succ,d_succ_ci95,steps_a,steps_b,d_steps,d_steps_ci95
+ * @endcode
+ */
+
+#include "world.h"
+#include "../common/types.h"
+
+#include <stdint.h>
+
+/**
+ * @brief One configuration of a paired comparison.
+ */
+typedef struct {
+    move_probs_t probs;
+    uint32_t k_max_steps;
+} crn_config_t;
+
+/**
+ * @brief Aggregated outcome of a comparison (over all free cells).
+ */
+typedef struct {
+    /** Number of compared cells. */
+    uint32_t cells;
+
+    /** Cells whose success-probability difference CI excludes 0. */
+    uint32_t succ_significant;
+
+    /** Cells whose step-count difference CI excludes 0. */
+    uint32_t steps_significant;
+
+    /** Mean CI half-width of the success-probability difference. */
+    double mean_succ_ci95;
+
+    /** Mean CI half-width of the step-count difference. */
+    double mean_steps_ci95;
+} crn_diff_summary_t;
+
+/**
+ * @brief Run the paired comparison and write the CSV report.
+ *
+ * @param w           World.
+ * @param a           Configuration A.
+ * @param b           Configuration B.
+ * @param reps        Replications per cell (>= 2 for confidence bounds).
+ * @param seed        Base seed of the common random streams.
+ * @param nthreads    Number of row bands run as background tasks (<= 0 = 1).
+ * @param path        Output CSV path.
+ * @param out_summary Optional aggregated outcome.
+ *
+ * @retval 0  Success.
+ * @retval -1 Invalid arguments, allocation failure or write error.
+ */
+int crn_diff_run(const world_t *w,
+                 crn_config_t a,
+                 crn_config_t b,
+                 uint32_t reps,
+                 uint64_t seed,
+                 int nthreads,
+                 const char *path,
+                 crn_diff_summary_t *out_summary);
+
+#endif //SEMPRACA_CRN_DIFF_H
@@ -0,0 +1,481 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#include "heatmap_export.h"
+
+#include "scheduler.h"
+
+#include "../common/util.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file heatmap_export.c
+ * @brief Implementation of the banded, multi-threaded image export.
+ */
+
+/* Pooled counters of one output pixel. */
+typedef struct {
+    uint64_t trials;
+    uint64_t succ;
+    uint64_t steps;
+    uint64_t obstacles;
+} px_acc_t;
+
+typedef struct heatmap_job heatmap_job_t;
+
+typedef struct {
+    heatmap_job_t *job;
+    px_acc_t *acc;        /* out_w accumulators of the current row */
+    double max_avg;       /* pass 1 output */
+    sched_task_t task;
+} heatmap_worker_t;
+
+struct heatmap_job {
+    const heatmap_source_t *src;
+    heatmap_field_t field;
+    uint32_t ds;
+    uint32_t out_w, out_h;
+    size_t pre;           /* bytes before the pixels of a row (PNG filter type) */
+    size_t stride;        /* bytes per row in the band buffer */
+    uint8_t lut[256][3];
+    double max_avg;       /* avg steps at the top color */
+
+    /* current band, set before its tasks are submitted */
+    int pass;             /* 1 = find the largest avg, 2 = render pixels */
+    uint32_t band_y0, band_y1;
+    _Atomic uint32_t next_row;
+    uint8_t *band;
+
+    sched_group_t group;
+};
+
+/* ---- colormaps ---- */
+
+typedef struct {
+    double t;
+    uint8_t rgb[3];
+} cmap_stop_t;
+
+static const cmap_stop_t kViridis[] = {
+    {0.000, {68, 1, 84}},   {0.125, {71, 44, 122}},  {0.250, {59, 81, 139}},
+    {0.375, {44, 113, 142}}, {0.500, {33, 144, 141}}, {0.625, {39, 173, 129}},
+    {0.750, {92, 200, 99}},  {0.875, {170, 220, 50}}, {1.000, {253, 231, 37}},
+};
+static const cmap_stop_t kHeat[] = {
+    {0.00, {64, 0, 0}}, {0.33, {200, 30, 0}}, {0.66, {255, 180, 0}}, {1.00, {255, 255, 160}},
+};
+static const cmap_stop_t kGray[] = {
+    {0.0, {32, 32, 32}}, {1.0, {224, 224, 224}},
+};
+
+static const uint8_t kObstacleRgb[3] = {0, 0, 0};
+static const uint8_t kNoDataRgb[3] = {255, 255, 255};
+
+/* Interpolate the stops into a 256 entry table. */
+static void build_lut(heatmap_colormap_t cmap, uint8_t lut[256][3]) {
+    const cmap_stop_t *stops = kViridis;
+    size_t n = sizeof(kViridis) / sizeof(kViridis[0]);
+    if (cmap == HEATMAP_CMAP_HEAT) {
+        stops = kHeat;
+        n = sizeof(kHeat) / sizeof(kHeat[0]);
+    } else if (cmap == HEATMAP_CMAP_GRAY) {
+        stops = kGray;
+        n = sizeof(kGray) / sizeof(kGray[0]);
+    }
+    for (int i = 0; i < 256; i++) {
+        double t = (double)i / 255.0;
+        size_t k = 1;
+        while (k < n - 1 && stops[k].t < t) k++;
+        double f = (t - stops[k - 1].t) / (stops[k].t - stops[k - 1].t);
+        for (int c = 0; c < 3; c++) {
+            double v = stops[k - 1].rgb[c] + f * (double)(stops[k].rgb[c] - stops[k - 1].rgb[c]);
+            lut[i][c] = (uint8_t)(v + 0.5);
+        }
+    }
+}
+
+int heatmap_colormap_parse(const char *name, heatmap_colormap_t *out) {
+    if (!name || !out) return -1;
+    if (strcmp(name, "viridis") == 0) {
+        *out = HEATMAP_CMAP_VIRIDIS;
+    } else if (strcmp(name, "heat") == 0) {
+        *out = HEATMAP_CMAP_HEAT;
+    } else if (strcmp(name, "gray") == 0) {
+        *out = HEATMAP_CMAP_GRAY;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+void heatmap_source_from_results(heatmap_source_t *src, const world_t *world, const results_t *results) {
+    if (!src) return;
+    memset(src, 0, sizeof(*src));
+    if (!world || !results) return;
+    src->size = world->size;
+    src->world = world;
+    src->trials = results_trials(results);
+    src->sum_steps = results_sum_steps(results);
+    src->success_leq_k = results_success_leq_k(results);
+}
+
+/* ---- rendering ---- */
+
+static uint32_t load_u32(const void *base, uint64_t i) {
+    uint32_t v;
+    memcpy(&v, (const uint8_t *)base + i * sizeof(v), sizeof(v));
+    return v;
+}
+
+static uint64_t load_u64(const void *base, uint64_t i) {
+    uint64_t v;
+    memcpy(&v, (const uint8_t *)base + i * sizeof(v), sizeof(v));
+    return v;
+}
+
+static int is_obstacle(const heatmap_source_t *s, uint64_t i) {
+    if (s->world) return world_is_obstacle_idx(s->world, i);
+    if (s->obstacle_bits) return (s->obstacle_bits[i >> 3] >> (i & 7u)) & 1u;
+    if (s->obstacle_bytes) return s->obstacle_bytes[i] != 0;
+    return 0;
+}
+
+/* Pool the D rows of output row @p oy into w->acc. */
+static void pool_row(const heatmap_job_t *j, heatmap_worker_t *w, uint32_t oy) {
+    const heatmap_source_t *s = j->src;
+    const uint64_t width = (uint64_t)s->size.width;
+    const uint64_t y0 = (uint64_t)oy * j->ds;
+    uint64_t y1 = y0 + j->ds;
+    if (y1 > (uint64_t)s->size.height) y1 = (uint64_t)s->size.height;
+
+    memset(w->acc, 0, sizeof(px_acc_t) * j->out_w);
+    for (uint64_t y = y0; y < y1; y++) {
+        const uint64_t row = y * width;
+        uint64_t x = 0;
+        for (uint32_t ox = 0; ox < j->out_w; ox++) {
+            uint64_t x1 = x + j->ds;
+            if (x1 > width) x1 = width;
+            px_acc_t *a = &w->acc[ox];
+            for (; x < x1; x++) {
+                const uint64_t i = row + x;
+                a->trials += load_u32(s->trials, i);
+                a->succ += load_u32(s->success_leq_k, i);
+                a->steps += load_u64(s->sum_steps, i);
+                a->obstacles += (uint64_t)is_obstacle(s, i);
+            }
+        }
+    }
+}
+
+/* Cells of pixel column @p ox (the last column/row may be narrower). */
+static uint64_t block_cells(const heatmap_job_t *j, uint32_t ox, uint32_t oy) {
+    uint64_t w = j->ds, h = j->ds;
+    uint64_t x0 = (uint64_t)ox * j->ds, y0 = (uint64_t)oy * j->ds;
+    if (x0 + w > (uint64_t)j->src->size.width) w = (uint64_t)j->src->size.width - x0;
+    if (y0 + h > (uint64_t)j->src->size.height) h = (uint64_t)j->src->size.height - y0;
+    return w * h;
+}
+
+static void render_row(heatmap_job_t *j, heatmap_worker_t *w, uint32_t oy) {
+    pool_row(j, w, oy);
+    if (j->pass == 1) {
+        for (uint32_t ox = 0; ox < j->out_w; ox++) {
+            const px_acc_t *a = &w->acc[ox];
+            if (a->succ == 0) continue;
+            double avg = (double)a->steps / (double)a->succ;
+            if (avg > w->max_avg) w->max_avg = avg;
+        }
+        return;
+    }
+
+    uint8_t *out = j->band + (size_t)(oy - j->band_y0) * j->stride;
+    if (j->pre) out[0] = 0; /* PNG filter type None */
+    out += j->pre;
+    for (uint32_t ox = 0; ox < j->out_w; ox++, out += 3) {
+        const px_acc_t *a = &w->acc[ox];
+        const uint8_t *rgb = kNoDataRgb;
+        if (a->obstacles * 2u >= block_cells(j, ox, oy)) {
+            rgb = kObstacleRgb;
+        } else if (j->field == HEATMAP_FIELD_P_LEQ_K ? a->trials > 0 : a->succ > 0) {
+            double v = j->field == HEATMAP_FIELD_P_LEQ_K
+                           ? (double)a->succ / (double)a->trials
+                           : (double)a->steps / (double)a->succ / j->max_avg;
+            if (v > 1.0) v = 1.0;
+            rgb = j->lut[(int)(v * 255.0 + 0.5)];
+        }
+        memcpy(out, rgb, 3);
+    }
+}
+
+/* Take rows of the current band until none is left. */
+static void run_band(void *arg) {
+    heatmap_worker_t *w = (heatmap_worker_t *)arg;
+    heatmap_job_t *j = w->job;
+    uint32_t oy;
+    while ((oy = atomic_fetch_add(&j->next_row, 1u)) < j->band_y1) {
+        render_row(j, w, oy);
+    }
+}
+
+/* Render rows [y0, y1): workers 1.. as background tasks, the caller is worker 0. */
+static void band_step(heatmap_job_t *j, heatmap_worker_t *workers, int nworkers, uint32_t y0, uint32_t y1) {
+    j->band_y0 = y0;
+    j->band_y1 = y1;
+    atomic_store(&j->next_row, y0);
+    for (int i = 1; i < nworkers; i++) {
+        scheduler_submit(SCHED_BACKGROUND, &workers[i].task, run_band, &workers[i], &j->group);
+    }
+    run_band(&workers[0]);
+    sched_group_wait(&j->group);
+}
+
+/* ---- output ---- */
+
+typedef struct {
+    FILE *f;
+    heatmap_format_t format;
+    uint32_t crc;         /* of the open PNG chunk */
+    uint32_t adler_a;     /* Adler-32 of the zlib stream */
+    uint32_t adler_b;
+    int first_idat;
+    int err;
+} img_writer_t;
+
+static uint32_t g_crc_table[256];
+static pthread_once_t g_crc_once = PTHREAD_ONCE_INIT;
+
+static void crc_table_init(void) {
+    for (uint32_t n = 0; n < 256u; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1u) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        g_crc_table[n] = c;
+    }
+}
+
+static void raw_write(img_writer_t *w, const void *p, size_t n) {
+    if (!w->err && n > 0 && fwrite(p, 1, n, w->f) != n) w->err = 1;
+}
+
+/* Write chunk bytes, updating the chunk CRC. */
+static void png_put(img_writer_t *w, const void *p, size_t n) {
+    const uint8_t *b = (const uint8_t *)p;
+    uint32_t c = w->crc;
+    for (size_t i = 0; i < n; i++) c = g_crc_table[(c ^ b[i]) & 0xFFu] ^ (c >> 8);
+    w->crc = c;
+    raw_write(w, p, n);
+}
+
+static void put_be32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static void png_chunk_begin(img_writer_t *w, uint32_t len, const char *type) {
+    uint8_t b[4];
+    put_be32(b, len);
+    raw_write(w, b, 4);
+    w->crc = 0xFFFFFFFFu;
+    png_put(w, type, 4);
+}
+
+static void png_chunk_end(img_writer_t *w) {
+    uint8_t b[4];
+    put_be32(b, w->crc ^ 0xFFFFFFFFu);
+    raw_write(w, b, 4);
+}
+
+static void adler_update(img_writer_t *w, const uint8_t *p, size_t n) {
+    uint32_t a = w->adler_a, b = w->adler_b;
+    while (n > 0) {
+        size_t k = n < 5552u ? n : 5552u; /* largest run without uint32 overflow */
+        n -= k;
+        while (k--) {
+            a += *p++;
+            b += a;
+        }
+        a %= 65521u;
+        b %= 65521u;
+    }
+    w->adler_a = a;
+    w->adler_b = b;
+}
+
+static void img_begin(img_writer_t *w, uint32_t width, uint32_t height) {
+    if (w->format == HEATMAP_FORMAT_PPM) {
+        if (fprintf(w->f, "P6\n%u %u\n255\n", width, height) < 0) w->err = 1;
+        return;
+    }
+    static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    raw_write(w, sig, sizeof(sig));
+    uint8_t ihdr[13];
+    put_be32(ihdr, width);
+    put_be32(ihdr + 4, height);
+    ihdr[8] = 8;  /* bit depth */
+    ihdr[9] = 2;  /* RGB */
+    ihdr[10] = 0; /* deflate */
+    ihdr[11] = 0; /* adaptive filtering (rows use None) */
+    ihdr[12] = 0; /* no interlace */
+    png_chunk_begin(w, sizeof(ihdr), "IHDR");
+    png_put(w, ihdr, sizeof(ihdr));
+    png_chunk_end(w);
+    w->adler_a = 1;
+    w->adler_b = 0;
+    w->first_idat = 1;
+}
+
+/* One band: PPM rows as they are, PNG as an IDAT of stored deflate blocks. */
+static void img_write_band(img_writer_t *w, const uint8_t *data, size_t n) {
+    if (w->format == HEATMAP_FORMAT_PPM) {
+        raw_write(w, data, n);
+        return;
+    }
+    const size_t blocks = (n + 65534u) / 65535u;
+    png_chunk_begin(w, (uint32_t)(n + blocks * 5u + (w->first_idat ? 2u : 0u)), "IDAT");
+    if (w->first_idat) {
+        static const uint8_t zhdr[2] = {0x78, 0x01}; /* deflate, 32K window, no dictionary */
+        png_put(w, zhdr, sizeof(zhdr));
+        w->first_idat = 0;
+    }
+    for (size_t off = 0; off < n; off += 65535u) {
+        const size_t len = n - off < 65535u ? n - off : 65535u;
+        const uint8_t hdr[5] = {0x00, (uint8_t)len, (uint8_t)(len >> 8),
+                                (uint8_t)~len, (uint8_t)(~len >> 8)};
+        png_put(w, hdr, sizeof(hdr));
+        png_put(w, data + off, len);
+        adler_update(w, data + off, len);
+    }
+    png_chunk_end(w);
+}
+
+static void img_end(img_writer_t *w) {
+    if (w->format == HEATMAP_FORMAT_PPM) return;
+    /* empty final stored block + Adler-32 closes the zlib stream */
+    uint8_t tail[9] = {0x01, 0x00, 0x00, 0xFF, 0xFF};
+    put_be32(tail + 5, (w->adler_b << 16) | w->adler_a);
+    png_chunk_begin(w, sizeof(tail), "IDAT");
+    png_put(w, tail, sizeof(tail));
+    png_chunk_end(w);
+    png_chunk_begin(w, 0, "IEND");
+    png_chunk_end(w);
+}
+
+/* ---- export ---- */
+
+int heatmap_export(const char *path,
+                   const heatmap_source_t *src,
+                   const heatmap_options_t *opts,
+                   uint32_t *out_width,
+                   uint32_t *out_height) {
+    if (!path || !src || !opts || !src->trials || !src->sum_steps || !src->success_leq_k) return -1;
+    if (src->size.width <= 0 || src->size.height <= 0) return -1;
+    if (opts->field != HEATMAP_FIELD_P_LEQ_K && opts->field != HEATMAP_FIELD_AVG_STEPS) return -1;
+    if (opts->format != HEATMAP_FORMAT_PPM && opts->format != HEATMAP_FORMAT_PNG) return -1;
+
+    const uint64_t width = (uint64_t)src->size.width, height = (uint64_t)src->size.height;
+    uint64_t ds = opts->downsample;
+    if (ds == 0) {
+        uint64_t longest = width > height ? width : height;
+        ds = (longest + HEATMAP_MAX_DIM - 1u) / HEATMAP_MAX_DIM;
+    }
+    const uint64_t out_w = (width + ds - 1u) / ds, out_h = (height + ds - 1u) / ds;
+    if (ds > UINT32_MAX || out_w > HEATMAP_MAX_DIM || out_h > HEATMAP_MAX_DIM) {
+        log_error("heatmap_export: %" PRIu64 "x%" PRIu64 " pixels exceed %u; use a larger downsample",
+                  out_w, out_h, HEATMAP_MAX_DIM);
+        return -1;
+    }
+
+    int nthreads = opts->nthreads > 0 ? opts->nthreads : 1;
+    if ((uint64_t)nthreads > out_h) nthreads = (int)out_h;
+
+    heatmap_job_t job;
+    memset(&job, 0, sizeof(job));
+    sched_group_init(&job.group);
+    job.src = src;
+    job.field = opts->field;
+    job.ds = (uint32_t)ds;
+    job.out_w = (uint32_t)out_w;
+    job.out_h = (uint32_t)out_h;
+    job.pre = opts->format == HEATMAP_FORMAT_PNG ? 1u : 0u;
+    job.stride = job.pre + 3u * (size_t)out_w;
+    build_lut(opts->colormap, job.lut);
+    uint32_t band_rows = (uint32_t)(HEATMAP_BAND_BYTES / job.stride);
+    if (band_rows == 0) band_rows = 1;
+    if (band_rows > job.out_h) band_rows = job.out_h;
+
+    int rc = -1;
+    FILE *f = NULL;
+    heatmap_worker_t *workers = (heatmap_worker_t *)calloc((size_t)nthreads, sizeof(*workers));
+    job.band = (uint8_t *)malloc((size_t)band_rows * job.stride);
+    if (!workers || !job.band) goto out;
+    for (int i = 0; i < nthreads; i++) {
+        workers[i].job = &job;
+        workers[i].acc = (px_acc_t *)malloc(sizeof(px_acc_t) * (size_t)out_w);
+        if (!workers[i].acc) goto out;
+    }
+
+    /* Pass 1: scale of avg steps (pooled pixel values, so the top color is used). */
+    job.max_avg = opts->max_value;
+    if (job.field == HEATMAP_FIELD_AVG_STEPS && job.max_avg <= 0.0) {
+        job.pass = 1;
+        for (uint32_t y = 0; y < job.out_h; y += band_rows) {
+            band_step(&job, workers, nthreads, y, y + band_rows < job.out_h ? y + band_rows : job.out_h);
+        }
+        job.max_avg = 0.0;
+        for (int i = 0; i < nthreads; i++) {
+            if (workers[i].max_avg > job.max_avg) job.max_avg = workers[i].max_avg;
+        }
+        if (job.max_avg <= 0.0) job.max_avg = 1.0;
+    }
+
+    f = fopen(path, "wb");
+    if (!f) {
+        log_error("heatmap_export: fopen('%s') failed", path);
+        goto out;
+    }
+    pthread_once(&g_crc_once, crc_table_init);
+    img_writer_t w;
+    memset(&w, 0, sizeof(w));
+    w.f = f;
+    w.format = opts->format;
+    img_begin(&w, job.out_w, job.out_h);
+
+    job.pass = 2;
+    for (uint32_t y = 0; y < job.out_h && !w.err; y += band_rows) {
+        uint32_t y1 = y + band_rows < job.out_h ? y + band_rows : job.out_h;
+        band_step(&job, workers, nthreads, y, y1);
+        img_write_band(&w, job.band, (size_t)(y1 - y) * job.stride);
+    }
+    img_end(&w);
+    if (fclose(f) != 0) w.err = 1;
+    f = NULL;
+    if (w.err) {
+        log_error("heatmap_export: write to '%s' failed", path);
+        remove(path);
+        goto out;
+    }
+    if (out_width) *out_width = job.out_w;
+    if (out_height) *out_height = job.out_h;
+    rc = 0;
+
+out:
+    sched_group_destroy(&job.group);
+    if (f) {
+        fclose(f);
+        remove(path);
+    }
+    if (workers) {
+        for (int i = 0; i < nthreads; i++) free(workers[i].acc);
+    }
+    free(workers);
+    free(job.band);
+    return rc;
+}
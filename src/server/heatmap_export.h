@@ -0,0 +1,114 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_HEATMAP_EXPORT_H
+#define SEMPRACA_HEATMAP_EXPORT_H
+
+/**
+ * @file heatmap_export.h
+ * @brief Render p<=K or avg steps of a world as a PPM / PNG image.
+ *
+ * Used by the server (EXPORT_IMAGE, live results) and by the offline tool
+ * rwheatmap (a memory-mapped RWRES file, see @ref persist_map_results()).
+ *
+ * Pixels
+ * ------
+ * With downsampling D one pixel covers a D x D block of cells; its value is
+ * pooled over the block like one big cell:
+ * - p<=K      = sum success_leq_k / sum trials,
+ * - avg steps = sum sum_steps / sum success_leq_k, divided by the colormap
+ *   maximum (given, or the largest pixel value found in a first pass).
+ * Blocks that are at least half obstacles are black, blocks without data
+ * white; the colormaps avoid both colors.
+ *
+ * Bounded memory
+ * --------------
+ * The image is produced in bands of rows (at most @ref HEATMAP_BAND_BYTES of
+ * pixels). The rows of a band are rendered by background tasks of the
+ * scheduler (see scheduler.h; the caller takes part), then the band is
+ * written and the buffer reused, so a gigapixel world needs a few MB besides its data.
+ * PNG output is written by an in-tree encoder that stores the rows in
+ * uncompressed deflate blocks (no zlib dependency), one IDAT chunk per band.
+ */
+
+#include "world.h"
+#include "results.h"
+
+#include <stdint.h>
+
+/** Upper bound of the pixel bytes rendered before they are written. */
+#define HEATMAP_BAND_BYTES (8u * 1024u * 1024u)
+
+/** Largest output width or height (PNG limit is 2^31 - 1). */
+#define HEATMAP_MAX_DIM 1000000u
+
+typedef enum {
+    HEATMAP_FIELD_P_LEQ_K = 0,
+    HEATMAP_FIELD_AVG_STEPS = 1
+} heatmap_field_t;
+
+typedef enum {
+    HEATMAP_CMAP_VIRIDIS = 0, /**< perceptually uniform, dark purple -> yellow */
+    HEATMAP_CMAP_HEAT = 1,    /**< dark red -> yellow -> pale yellow */
+    HEATMAP_CMAP_GRAY = 2     /**< dark gray -> light gray */
+} heatmap_colormap_t;
+
+typedef enum {
+    HEATMAP_FORMAT_PPM = 0,   /**< binary P6 */
+    HEATMAP_FORMAT_PNG = 1    /**< 8-bit RGB, stored deflate */
+} heatmap_format_t;
+
+/**
+ * @brief Counters to render.
+ *
+ * Obstacles come from @ref world if set, otherwise from the linear bitmap
+ * @ref obstacle_bits or one byte per cell @ref obstacle_bytes (none = no
+ * obstacles). The counter arrays may be unaligned (mapped files).
+ */
+typedef struct {
+    world_size_t size;
+    const world_t *world;
+    const uint8_t *obstacle_bits;
+    const uint8_t *obstacle_bytes;
+    const void *trials;          /**< uint32_t[cells] */
+    const void *sum_steps;       /**< uint64_t[cells] */
+    const void *success_leq_k;   /**< uint32_t[cells] */
+} heatmap_source_t;
+
+typedef struct {
+    heatmap_field_t field;
+    heatmap_colormap_t colormap;
+    heatmap_format_t format;
+    uint32_t downsample;  /**< cells per pixel edge, 0 = smallest that fits @ref HEATMAP_MAX_DIM */
+    double max_value;     /**< avg steps at the top color, <= 0 = automatic */
+    int nthreads;         /**< render tasks per band, <= 0 means 1 */
+} heatmap_options_t;
+
+/**
+ * @brief Source over live server results.
+ */
+void heatmap_source_from_results(heatmap_source_t *src, const world_t *world, const results_t *results);
+
+/**
+ * @brief Render @p src to the image file @p path.
+ *
+ * @param out_width  Optional: image width in pixels.
+ * @param out_height Optional: image height in pixels.
+ * @return 0 on success, -1 on invalid arguments, allocation or write failure
+ *         (a partial file is removed).
+ */
+int heatmap_export(const char *path,
+                   const heatmap_source_t *src,
+                   const heatmap_options_t *opts,
+                   uint32_t *out_width,
+                   uint32_t *out_height);
+
+/**
+ * @brief Parse a colormap name ("viridis", "heat", "gray").
+ *
+ * @return 0 on success, -1 for an unknown name.
+ */
+int heatmap_colormap_parse(const char *name, heatmap_colormap_t *out);
+
+#endif //SEMPRACA_HEATMAP_EXPORT_H
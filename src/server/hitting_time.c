@@ -0,0 +1,1064 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+/**
+ * @file hitting_time.c
+ * @brief Multigrid-preconditioned Krylov solver for expected hitting times.
+ *
+ * Design notes
+ * ------------
+ * - Level 0 is the world grid. Each cell stores a one-byte stencil code
+ *   (which moves lead to an active neighbour, which moves are blocked and keep
+ *   the walker in place). Moves into the origin are dropped from the stencil
+ *   because E[origin] = 0.
+ * - Coarse level l+1 aggregates 2x2 blocks of level l. With piecewise-constant
+ *   prolongation the Galerkin operator P^T A P is again a 5-point stencil on the
+ *   coarse grid, stored explicitly (diag + 4 neighbour coefficients).
+ * - The coarsest level (<= HT_COARSEST_CELLS cells) is solved exactly with a
+ *   dense LU factorization.
+ * - Inactive cells (obstacles, origin, cells with infinite hitting time) keep a
+ *   value of 0 in every vector, so all loops run over full rows without masks.
+ * - The calling thread drives the algorithm; every vector or stencil step is a
+ *   phase split into row bands, run as background tasks of the scheduler
+ *   (the caller takes band 0) and joined before the next step. Reductions sum
+ *   per-band partials in a fixed order, so results are deterministic for a
+ *   given band count.
+ */
+
+#include "hitting_time.h"
+
+#include "scheduler.h"
+
+#include "../common/util.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { DIR_UP = 0, DIR_DOWN = 1, DIR_LEFT = 2, DIR_RIGHT = 3 };
+
+/** Stencil code bit: move in direction d leads to an active neighbour. */
+#define HT_ACTIVE_BIT(d) (1u << (d))
+/** Stencil code bit: move in direction d is blocked (walker stays). */
+#define HT_STAY_BIT(d) (1u << (4 + (d)))
+/** Stencil code of cells that are not part of the system. */
+#define HT_CODE_INACTIVE 0xFFu
+
+#define HT_DEFAULT_MAX_ITERS 500u
+#define HT_DEFAULT_TOLERANCE 1e-8
+#define HT_COARSEST_CELLS 256u
+#define HT_MAX_LEVELS 24
+#define HT_SMOOTH_SWEEPS 2
+#define HT_JACOBI_OMEGA 0.7
+/** Over-correction of the coarse-grid update (plain aggregation underestimates it). */
+#define HT_COARSE_SCALE 1.8
+/** Residual growth that is treated as divergence (hopelessly ill-conditioned system). */
+#define HT_DIVERGENCE 1e8
+
+/** Stride between per-band reduction slots (avoids false sharing). */
+#define HT_PAD 8
+
+typedef struct {
+    uint32_t w;
+    uint32_t h;
+    uint32_t n;
+
+    /* Explicit 5-point stencil (levels >= 1): A_ii and A_i,neighbour. */
+    double *diag;
+    double *cu;
+    double *cd;
+    double *cl;
+    double *cr;
+
+    /* Work vectors (levels >= 1; level 0 borrows Krylov vectors). */
+    double *x;
+    double *b;
+    double *r;
+} ht_level_t;
+
+typedef struct ht_solver ht_solver_t;
+
+/** Work of one row band in a phase (see run_phase()). */
+typedef void (*ht_kernel_t)(ht_solver_t *s, int tid, const void *arg);
+
+typedef struct {
+    ht_solver_t *s;
+    int tid;
+    sched_task_t task;
+} ht_part_t;
+
+struct ht_solver {
+    int nthreads;       /* row bands */
+    double *partials;
+
+    /* Current phase, read by the band tasks. */
+    ht_kernel_t kernel;
+    const void *karg;
+    ht_part_t *parts;
+    sched_group_t group;
+
+    /* Fine level description. */
+    uint8_t *code;
+    double p[4];
+    double dcode[256];
+
+    ht_level_t lv[HT_MAX_LEVELS];
+    int nlevels;
+
+    /* Dense LU of the coarsest level. */
+    double *lu;
+    uint32_t *piv;
+    uint32_t lu_n;
+
+    /* Krylov vectors (fine level). */
+    double *x;
+    double *r;
+    double *z;
+    double *pv;
+    double *q;
+    double *r0;
+    double *v;
+    double *t;
+
+    int symmetric;
+    uint32_t max_iters;
+    double tolerance;
+
+    /* Outputs. */
+    uint32_t iterations;
+    double rel_residual;
+    int converged;
+};
+
+/*======== grid helpers ========*/
+
+static uint32_t idx_up(uint32_t i, uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+    (void)x;
+    return (y > 0) ? i - w : i + (h - 1u) * w;
+}
+
+static uint32_t idx_down(uint32_t i, uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+    (void)x;
+    return (y + 1u < h) ? i + w : i - (h - 1u) * w;
+}
+
+static uint32_t idx_left(uint32_t i, uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+    (void)y; (void)h;
+    return (x > 0) ? i - 1u : i + (w - 1u);
+}
+
+static uint32_t idx_right(uint32_t i, uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+    (void)y; (void)h;
+    return (x + 1u < w) ? i + 1u : i - (w - 1u);
+}
+
+/**
+ * @brief Cell reached by moving from (x,y) in direction @p d, following the
+ *        random-walk rules (wrap or stay on border/obstacle).
+ */
+static uint32_t world_next_cell(const world_t *w, uint32_t x, uint32_t y, int d) {
+    pos_t next = {(int32_t)x, (int32_t)y};
+    if (d == DIR_UP) next.y -= 1;
+    else if (d == DIR_DOWN) next.y += 1;
+    else if (d == DIR_LEFT) next.x -= 1;
+    else next.x += 1;
+
+    if (w->kind == WORLD_WRAP) {
+        next = world_wrap_pos(w, next);
+    }
+    if (!world_in_bounds(w, next.x, next.y) || world_is_obstacle_xy(w, next.x, next.y)) {
+        return (uint32_t)world_index(w, (int32_t)x, (int32_t)y);
+    }
+    return (uint32_t)world_index(w, next.x, next.y);
+}
+
+/**
+ * @brief Cell from which a move in direction @p d lands on (x,y), or UINT32_MAX.
+ */
+static uint32_t world_prev_cell(const world_t *w, uint32_t x, uint32_t y, int d) {
+    pos_t prev = {(int32_t)x, (int32_t)y};
+    if (d == DIR_UP) prev.y += 1;
+    else if (d == DIR_DOWN) prev.y -= 1;
+    else if (d == DIR_LEFT) prev.x += 1;
+    else prev.x -= 1;
+
+    if (w->kind == WORLD_WRAP) {
+        prev = world_wrap_pos(w, prev);
+    }
+    if (!world_in_bounds(w, prev.x, prev.y) || world_is_obstacle_xy(w, prev.x, prev.y)) {
+        return UINT32_MAX;
+    }
+    return (uint32_t)world_index(w, prev.x, prev.y);
+}
+
+static void rows_for(uint32_t h, int tid, int nthreads, uint32_t *y0, uint32_t *y1) {
+    *y0 = (uint32_t)(((uint64_t)h * (uint64_t)tid) / (uint64_t)nthreads);
+    *y1 = (uint32_t)(((uint64_t)h * (uint64_t)(tid + 1)) / (uint64_t)nthreads);
+}
+
+/*======== setup: classification of cells ========*/
+
+/**
+ * @brief Mark cells whose expected hitting time is finite and build stencil codes.
+ *
+ * 1) reverse BFS from the origin: cells that can reach the origin at all;
+ * 2) reverse BFS from the remaining free cells: cells that can get trapped;
+ * 3) finite = (1) minus (2), origin excluded.
+ */
+static int classify_cells(const world_t *w, const double p[4], uint8_t *code,
+                          uint32_t *out_finite, uint32_t *out_infinite) {
+    const uint32_t W = (uint32_t)w->size.width;
+    const uint32_t n = (uint32_t)world_cell_count(w); /* checked by the caller */
+
+    enum { ST_OBST = 0, ST_FREE = 1, ST_CAN = 2, ST_DOOMED = 3 };
+    uint8_t *st = (uint8_t *)malloc((size_t)n);
+    uint32_t *queue = (uint32_t *)malloc(sizeof(uint32_t) * (size_t)n);
+    if (!st || !queue) {
+        free(st);
+        free(queue);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        st[i] = world_is_obstacle_idx(w, i) ? ST_OBST : ST_FREE;
+    }
+
+    uint32_t head = 0, tail = 0;
+    if (st[0] != ST_OBST) {
+        st[0] = ST_CAN;
+        queue[tail++] = 0;
+    }
+    while (head < tail) {
+        uint32_t j = queue[head++];
+        uint32_t x = j % W, y = j / W;
+        for (int d = 0; d < 4; d++) {
+            if (p[d] <= 0.0) continue;
+            uint32_t i = world_prev_cell(w, x, y, d);
+            if (i == UINT32_MAX || i == j || i == 0) continue;
+            if (st[i] != ST_FREE) continue;
+            st[i] = ST_CAN;
+            queue[tail++] = i;
+        }
+    }
+
+    head = tail = 0;
+    for (uint32_t i = 1; i < n; i++) {
+        if (st[i] == ST_FREE) {
+            st[i] = ST_DOOMED;
+            queue[tail++] = i;
+        }
+    }
+    while (head < tail) {
+        uint32_t j = queue[head++];
+        uint32_t x = j % W, y = j / W;
+        for (int d = 0; d < 4; d++) {
+            if (p[d] <= 0.0) continue;
+            uint32_t i = world_prev_cell(w, x, y, d);
+            if (i == UINT32_MAX || i == j || i == 0) continue;
+            if (st[i] != ST_CAN) continue;
+            st[i] = ST_DOOMED;
+            queue[tail++] = i;
+        }
+    }
+
+    uint32_t finite = 0, infinite = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        code[i] = HT_CODE_INACTIVE;
+        if (i == 0 || st[i] == ST_OBST) continue;
+        if (st[i] == ST_DOOMED) {
+            infinite++;
+            continue;
+        }
+        uint8_t c = 0;
+        uint32_t x = i % W, y = i / W;
+        for (int d = 0; d < 4; d++) {
+            if (p[d] <= 0.0) continue;
+            uint32_t j = world_next_cell(w, x, y, d);
+            if (j == i) c |= (uint8_t)HT_STAY_BIT(d);
+            else if (j != 0) c |= (uint8_t)HT_ACTIVE_BIT(d);
+        }
+        code[i] = c;
+        finite++;
+    }
+
+    free(queue);
+    free(st);
+    *out_finite = finite;
+    *out_infinite = infinite;
+    return 0;
+}
+
+/*======== stencil access ========*/
+
+/** Stencil of cell @p i on level @p l: diagonal and coefficients {up,down,left,right}. */
+static double level_coef(const ht_solver_t *s, int l, uint32_t i, double a[4]) {
+    if (l > 0) {
+        const ht_level_t *L = &s->lv[l];
+        a[DIR_UP] = L->cu[i];
+        a[DIR_DOWN] = L->cd[i];
+        a[DIR_LEFT] = L->cl[i];
+        a[DIR_RIGHT] = L->cr[i];
+        return L->diag[i];
+    }
+    uint8_t c = s->code[i];
+    if (c == HT_CODE_INACTIVE) {
+        a[0] = a[1] = a[2] = a[3] = 0.0;
+        return 0.0;
+    }
+    for (int d = 0; d < 4; d++) {
+        a[d] = (c & HT_ACTIVE_BIT(d)) ? -s->p[d] : 0.0;
+    }
+    return s->dcode[c];
+}
+
+/** out = A_l * in on rows [y0,y1). */
+static void level_apply(const ht_solver_t *s, int l, const double *in, double *out,
+                        uint32_t y0, uint32_t y1) {
+    const ht_level_t *L = &s->lv[l];
+    const uint32_t W = L->w, H = L->h;
+
+    for (uint32_t y = y0; y < y1; y++) {
+        uint32_t i = y * W;
+        for (uint32_t x = 0; x < W; x++, i++) {
+            if (l == 0) {
+                uint8_t c = s->code[i];
+                if (c == HT_CODE_INACTIVE) {
+                    out[i] = 0.0;
+                    continue;
+                }
+                double acc = s->dcode[c] * in[i];
+                if (c & HT_ACTIVE_BIT(DIR_UP)) acc -= s->p[DIR_UP] * in[idx_up(i, x, y, W, H)];
+                if (c & HT_ACTIVE_BIT(DIR_DOWN)) acc -= s->p[DIR_DOWN] * in[idx_down(i, x, y, W, H)];
+                if (c & HT_ACTIVE_BIT(DIR_LEFT)) acc -= s->p[DIR_LEFT] * in[idx_left(i, x, y, W, H)];
+                if (c & HT_ACTIVE_BIT(DIR_RIGHT)) acc -= s->p[DIR_RIGHT] * in[idx_right(i, x, y, W, H)];
+                out[i] = acc;
+            } else {
+                if (L->diag[i] == 0.0) {
+                    out[i] = 0.0;
+                    continue;
+                }
+                out[i] = L->diag[i] * in[i]
+                       + L->cu[i] * in[idx_up(i, x, y, W, H)]
+                       + L->cd[i] * in[idx_down(i, x, y, W, H)]
+                       + L->cl[i] * in[idx_left(i, x, y, W, H)]
+                       + L->cr[i] * in[idx_right(i, x, y, W, H)];
+            }
+        }
+    }
+}
+
+static double level_diag(const ht_solver_t *s, int l, uint32_t i) {
+    if (l > 0) return s->lv[l].diag[i];
+    uint8_t c = s->code[i];
+    return (c == HT_CODE_INACTIVE) ? 0.0 : s->dcode[c];
+}
+
+/*======== setup: coarse levels ========*/
+
+static void level_free(ht_level_t *L) {
+    free(L->diag); free(L->cu); free(L->cd); free(L->cl); free(L->cr);
+    free(L->x); free(L->b); free(L->r);
+    memset(L, 0, sizeof(*L));
+}
+
+static int level_alloc(ht_level_t *L, uint32_t w, uint32_t h) {
+    memset(L, 0, sizeof(*L));
+    L->w = w;
+    L->h = h;
+    L->n = w * h;
+    size_t bytes = sizeof(double) * (size_t)L->n;
+    L->diag = (double *)calloc(1, bytes);
+    L->cu = (double *)calloc(1, bytes);
+    L->cd = (double *)calloc(1, bytes);
+    L->cl = (double *)calloc(1, bytes);
+    L->cr = (double *)calloc(1, bytes);
+    L->x = (double *)calloc(1, bytes);
+    L->b = (double *)calloc(1, bytes);
+    L->r = (double *)calloc(1, bytes);
+    if (!L->diag || !L->cu || !L->cd || !L->cl || !L->cr || !L->x || !L->b || !L->r) {
+        level_free(L);
+        return -1;
+    }
+    return 0;
+}
+
+/** Galerkin coarse stencil of level @p l+1 from level @p l (coarse rows [Y0,Y1)). */
+static void build_coarse_rows(ht_solver_t *s, int l, uint32_t Y0, uint32_t Y1) {
+    const ht_level_t *F = &s->lv[l];
+    ht_level_t *C = &s->lv[l + 1];
+    const uint32_t W = F->w, H = F->h;
+
+    for (uint32_t Y = Y0; Y < Y1; Y++) {
+        for (uint32_t X = 0; X < C->w; X++) {
+            uint32_t I = Y * C->w + X;
+            double dg = 0.0, c[4] = {0.0, 0.0, 0.0, 0.0};
+
+            for (uint32_t y = 2u * Y; y < 2u * Y + 2u && y < H; y++) {
+                for (uint32_t x = 2u * X; x < 2u * X + 2u && x < W; x++) {
+                    uint32_t i = y * W + x;
+                    double a[4];
+                    double di = level_coef(s, l, i, a);
+                    if (di == 0.0) continue;
+                    dg += di;
+
+                    uint32_t nb[4] = {
+                        idx_up(i, x, y, W, H), idx_down(i, x, y, W, H),
+                        idx_left(i, x, y, W, H), idx_right(i, x, y, W, H)
+                    };
+                    for (int d = 0; d < 4; d++) {
+                        if (a[d] == 0.0) continue;
+                        uint32_t J = (nb[d] / W / 2u) * C->w + (nb[d] % W) / 2u;
+                        if (J == I) dg += a[d];
+                        else c[d] += a[d];
+                    }
+                }
+            }
+            C->diag[I] = dg;
+            C->cu[I] = c[DIR_UP];
+            C->cd[I] = c[DIR_DOWN];
+            C->cl[I] = c[DIR_LEFT];
+            C->cr[I] = c[DIR_RIGHT];
+        }
+    }
+}
+
+/** Dense LU (partial pivoting) of the coarsest level; inactive rows become identity. */
+static int build_coarsest_lu(ht_solver_t *s) {
+    int l = s->nlevels - 1;
+    const ht_level_t *L = &s->lv[l];
+    const uint32_t n = L->n, W = L->w, H = L->h;
+
+    s->lu_n = n;
+    s->lu = (double *)calloc((size_t)n * (size_t)n, sizeof(double));
+    s->piv = (uint32_t *)malloc(sizeof(uint32_t) * (size_t)n);
+    if (!s->lu || !s->piv) return -1;
+
+    double *A = s->lu;
+    for (uint32_t i = 0; i < n; i++) {
+        double a[4];
+        double dg = level_coef(s, l, i, a);
+        if (dg == 0.0) {
+            A[(size_t)i * n + i] = 1.0;
+            continue;
+        }
+        uint32_t x = i % W, y = i / W;
+        uint32_t nb[4] = {
+            idx_up(i, x, y, W, H), idx_down(i, x, y, W, H),
+            idx_left(i, x, y, W, H), idx_right(i, x, y, W, H)
+        };
+        A[(size_t)i * n + i] += dg;
+        for (int d = 0; d < 4; d++) {
+            A[(size_t)i * n + nb[d]] += a[d];
+        }
+    }
+
+    for (uint32_t k = 0; k < n; k++) {
+        uint32_t pr = k;
+        double best = fabs(A[(size_t)k * n + k]);
+        for (uint32_t i = k + 1; i < n; i++) {
+            double v = fabs(A[(size_t)i * n + k]);
+            if (v > best) { best = v; pr = i; }
+        }
+        if (best == 0.0) return -1;
+        s->piv[k] = pr;
+        if (pr != k) {
+            for (uint32_t j = 0; j < n; j++) {
+                double tmp = A[(size_t)k * n + j];
+                A[(size_t)k * n + j] = A[(size_t)pr * n + j];
+                A[(size_t)pr * n + j] = tmp;
+            }
+        }
+        double inv = 1.0 / A[(size_t)k * n + k];
+        for (uint32_t i = k + 1; i < n; i++) {
+            double f = A[(size_t)i * n + k] * inv;
+            if (f == 0.0) continue;
+            A[(size_t)i * n + k] = f;
+            for (uint32_t j = k + 1; j < n; j++) {
+                A[(size_t)i * n + j] -= f * A[(size_t)k * n + j];
+            }
+        }
+    }
+    return 0;
+}
+
+static void coarsest_solve(const ht_solver_t *s, const double *b, double *x) {
+    const uint32_t n = s->lu_n;
+    const double *A = s->lu;
+
+    memcpy(x, b, sizeof(double) * (size_t)n);
+    for (uint32_t k = 0; k < n; k++) {
+        uint32_t pr = s->piv[k];
+        if (pr != k) { double t = x[k]; x[k] = x[pr]; x[pr] = t; }
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        double acc = x[i];
+        for (uint32_t j = 0; j < i; j++) acc -= A[(size_t)i * n + j] * x[j];
+        x[i] = acc;
+    }
+    for (uint32_t i = n; i-- > 0;) {
+        double acc = x[i];
+        for (uint32_t j = i + 1; j < n; j++) acc -= A[(size_t)i * n + j] * x[j];
+        x[i] = acc / A[(size_t)i * n + i];
+    }
+    /* Inactive rows are identity with a zero right-hand side: keep them 0. */
+    for (uint32_t i = 0; i < n; i++) {
+        if (level_diag(s, s->nlevels - 1, i) == 0.0) x[i] = 0.0;
+    }
+}
+
+/*======== parallel phases ========*/
+
+static void part_main(void *arg) {
+    ht_part_t *p = (ht_part_t *)arg;
+    p->s->kernel(p->s, p->tid, p->s->karg);
+}
+
+/** Run @p fn on every row band (bands 1.. as background tasks, band 0 here) and wait. */
+static void run_phase(ht_solver_t *s, ht_kernel_t fn, const void *arg) {
+    s->kernel = fn;
+    s->karg = arg;
+    for (int t = 1; t < s->nthreads; t++) {
+        scheduler_submit(SCHED_BACKGROUND, &s->parts[t].task, part_main, &s->parts[t], &s->group);
+    }
+    fn(s, 0, arg);
+    sched_group_wait(&s->group);
+}
+
+/** Sum of reduction slot @p k over all bands, in band order. */
+static double partial_sum(const ht_solver_t *s, int k) {
+    double sum = 0.0;
+    for (int t = 0; t < s->nthreads; t++) {
+        sum += s->partials[t * HT_PAD + k];
+    }
+    return sum;
+}
+
+static double dot_rows(const double *a, const double *b, uint32_t i0, uint32_t i1) {
+    double acc = 0.0;
+    for (uint32_t i = i0; i < i1; i++) acc += a[i] * b[i];
+    return acc;
+}
+
+/** Fine-level cell range [*i0,*i1) of band @p tid. */
+static void fine_rows(const ht_solver_t *s, int tid, uint32_t *i0, uint32_t *i1) {
+    uint32_t y0, y1;
+    rows_for(s->lv[0].h, tid, s->nthreads, &y0, &y1);
+    *i0 = y0 * s->lv[0].w;
+    *i1 = y1 * s->lv[0].w;
+}
+
+/*======== multigrid kernels ========*/
+
+/** Vectors of one V-cycle level. */
+typedef struct {
+    int l;
+    double *x;
+    const double *b;
+    double *r;
+} ht_level_op_t;
+
+static void k_build_coarse(ht_solver_t *s, int tid, const void *arg) {
+    const int l = *(const int *)arg;
+    uint32_t Y0, Y1;
+    rows_for(s->lv[l + 1].h, tid, s->nthreads, &Y0, &Y1);
+    build_coarse_rows(s, l, Y0, Y1);
+}
+
+/** First Jacobi sweep from x = 0: just x = omega D^-1 b. */
+static void k_smooth_first(ht_solver_t *s, int tid, const void *arg) {
+    const ht_level_op_t *op = (const ht_level_op_t *)arg;
+    const ht_level_t *L = &s->lv[op->l];
+    uint32_t y0, y1;
+    rows_for(L->h, tid, s->nthreads, &y0, &y1);
+    for (uint32_t i = y0 * L->w; i < y1 * L->w; i++) {
+        double dg = level_diag(s, op->l, i);
+        op->x[i] = (dg != 0.0) ? HT_JACOBI_OMEGA * op->b[i] / dg : 0.0;
+    }
+}
+
+/** r = b - A x. */
+static void k_residual(ht_solver_t *s, int tid, const void *arg) {
+    const ht_level_op_t *op = (const ht_level_op_t *)arg;
+    const ht_level_t *L = &s->lv[op->l];
+    uint32_t y0, y1;
+    rows_for(L->h, tid, s->nthreads, &y0, &y1);
+    level_apply(s, op->l, op->x, op->r, y0, y1);
+    for (uint32_t i = y0 * L->w; i < y1 * L->w; i++) op->r[i] = op->b[i] - op->r[i];
+}
+
+/** Damped Jacobi update from the residual. */
+static void k_jacobi(ht_solver_t *s, int tid, const void *arg) {
+    const ht_level_op_t *op = (const ht_level_op_t *)arg;
+    const ht_level_t *L = &s->lv[op->l];
+    uint32_t y0, y1;
+    rows_for(L->h, tid, s->nthreads, &y0, &y1);
+    for (uint32_t i = y0 * L->w; i < y1 * L->w; i++) {
+        double dg = level_diag(s, op->l, i);
+        if (dg != 0.0) op->x[i] += HT_JACOBI_OMEGA * op->r[i] / dg;
+    }
+}
+
+/** Restriction of r to the coarse right-hand side (sum over each 2x2 aggregate). */
+static void k_restrict(ht_solver_t *s, int tid, const void *arg) {
+    const ht_level_op_t *op = (const ht_level_op_t *)arg;
+    const ht_level_t *L = &s->lv[op->l];
+    ht_level_t *C = &s->lv[op->l + 1];
+    uint32_t Y0, Y1;
+    rows_for(C->h, tid, s->nthreads, &Y0, &Y1);
+    for (uint32_t Y = Y0; Y < Y1; Y++) {
+        for (uint32_t X = 0; X < C->w; X++) {
+            double acc = 0.0;
+            for (uint32_t y = 2u * Y; y < 2u * Y + 2u && y < L->h; y++) {
+                for (uint32_t xx = 2u * X; xx < 2u * X + 2u && xx < L->w; xx++) {
+                    acc += op->r[y * L->w + xx];
+                }
+            }
+            C->b[Y * C->w + X] = acc;
+        }
+    }
+}
+
+/** Prolongation of the coarse correction (piecewise constant). */
+static void k_prolong(ht_solver_t *s, int tid, const void *arg) {
+    const ht_level_op_t *op = (const ht_level_op_t *)arg;
+    const ht_level_t *L = &s->lv[op->l];
+    const ht_level_t *C = &s->lv[op->l + 1];
+    uint32_t y0, y1;
+    rows_for(L->h, tid, s->nthreads, &y0, &y1);
+    for (uint32_t y = y0; y < y1; y++) {
+        for (uint32_t xx = 0; xx < L->w; xx++) {
+            uint32_t i = y * L->w + xx;
+            if (level_diag(s, op->l, i) != 0.0) {
+                op->x[i] += HT_COARSE_SCALE * C->x[(y / 2u) * C->w + xx / 2u];
+            }
+        }
+    }
+}
+
+/**
+ * @brief One multigrid V-cycle: x ~= A_l^-1 b (x is overwritten, r is scratch).
+ */
+static void vcycle(ht_solver_t *s, int l, double *x, const double *b, double *r) {
+    if (l == s->nlevels - 1) {
+        coarsest_solve(s, b, x);
+        return;
+    }
+    const ht_level_op_t op = {l, x, b, r};
+
+    /* Pre-smoothing. */
+    run_phase(s, k_smooth_first, &op);
+    for (int k = 1; k < HT_SMOOTH_SWEEPS; k++) {
+        run_phase(s, k_residual, &op);
+        run_phase(s, k_jacobi, &op);
+    }
+
+    /* Residual, restriction, coarse correction. */
+    run_phase(s, k_residual, &op);
+    run_phase(s, k_restrict, &op);
+    ht_level_t *C = &s->lv[l + 1];
+    vcycle(s, l + 1, C->x, C->b, C->r);
+    run_phase(s, k_prolong, &op);
+
+    /* Post-smoothing. */
+    for (int k = 0; k < HT_SMOOTH_SWEEPS; k++) {
+        run_phase(s, k_residual, &op);
+        run_phase(s, k_jacobi, &op);
+    }
+}
+
+/*======== Krylov kernels (fine level) ========*/
+
+/** Arguments of k_dot(): slot 0 = a . b. */
+typedef struct {
+    const double *a;
+    const double *b;
+} ht_dot_op_t;
+
+/** Arguments of k_apply_dot(): out = A in, slot 0 = with . out. */
+typedef struct {
+    const double *in;
+    double *out;
+    const double *with;
+} ht_apply_op_t;
+
+/** Arguments of k_update(): x += alpha u, r -= alpha v, slot 0 = r . r. */
+typedef struct {
+    double alpha;
+    const double *u;
+    const double *v;
+} ht_update_op_t;
+
+/** Arguments of k_bicg_dir(). */
+typedef struct {
+    double beta;
+    double omega;
+} ht_dir_op_t;
+
+static void k_dot(ht_solver_t *s, int tid, const void *arg) {
+    const ht_dot_op_t *op = (const ht_dot_op_t *)arg;
+    uint32_t i0, i1;
+    fine_rows(s, tid, &i0, &i1);
+    s->partials[tid * HT_PAD] = dot_rows(op->a, op->b, i0, i1);
+}
+
+static void k_apply_dot(ht_solver_t *s, int tid, const void *arg) {
+    const ht_apply_op_t *op = (const ht_apply_op_t *)arg;
+    uint32_t y0, y1;
+    rows_for(s->lv[0].h, tid, s->nthreads, &y0, &y1);
+    level_apply(s, 0, op->in, op->out, y0, y1);
+    s->partials[tid * HT_PAD] = dot_rows(op->with, op->out, y0 * s->lv[0].w, y1 * s->lv[0].w);
+}
+
+static void k_update(ht_solver_t *s, int tid, const void *arg) {
+    const ht_update_op_t *op = (const ht_update_op_t *)arg;
+    uint32_t i0, i1;
+    fine_rows(s, tid, &i0, &i1);
+    double lr = 0.0;
+    for (uint32_t i = i0; i < i1; i++) {
+        s->x[i] += op->alpha * op->u[i];
+        s->r[i] -= op->alpha * op->v[i];
+        lr += s->r[i] * s->r[i];
+    }
+    s->partials[tid * HT_PAD] = lr;
+}
+
+/** PCG start: x = 0, r = b (1 on active cells), slot 0 = b . b. */
+static void k_pcg_init(ht_solver_t *s, int tid, const void *arg) {
+    (void)arg;
+    uint32_t i0, i1;
+    fine_rows(s, tid, &i0, &i1);
+    double lb = 0.0;
+    for (uint32_t i = i0; i < i1; i++) {
+        s->x[i] = 0.0;
+        s->r[i] = (s->code[i] != HT_CODE_INACTIVE) ? 1.0 : 0.0;
+        lb += s->r[i];
+    }
+    s->partials[tid * HT_PAD] = lb;
+}
+
+/** p = z + beta p (beta = 0 on the first direction). */
+static void k_pcg_dir(ht_solver_t *s, int tid, const void *arg) {
+    const double beta = *(const double *)arg;
+    uint32_t i0, i1;
+    fine_rows(s, tid, &i0, &i1);
+    for (uint32_t i = i0; i < i1; i++) {
+        s->pv[i] = s->z[i] + beta * s->pv[i];
+    }
+}
+
+/** BiCGSTAB start: x = p = v = 0, r = r0 = b, slot 0 = b . b. */
+static void k_bicg_init(ht_solver_t *s, int tid, const void *arg) {
+    (void)arg;
+    uint32_t i0, i1;
+    fine_rows(s, tid, &i0, &i1);
+    double lb = 0.0;
+    for (uint32_t i = i0; i < i1; i++) {
+        double bi = (s->code[i] != HT_CODE_INACTIVE) ? 1.0 : 0.0;
+        s->x[i] = 0.0;
+        s->r[i] = bi;
+        s->r0[i] = bi;
+        s->pv[i] = 0.0;
+        s->q[i] = 0.0;
+        lb += bi;
+    }
+    s->partials[tid * HT_PAD] = lb;
+}
+
+/** p = r + beta (p - omega v). */
+static void k_bicg_dir(ht_solver_t *s, int tid, const void *arg) {
+    const ht_dir_op_t *op = (const ht_dir_op_t *)arg;
+    uint32_t i0, i1;
+    fine_rows(s, tid, &i0, &i1);
+    for (uint32_t i = i0; i < i1; i++) {
+        s->pv[i] = s->r[i] + op->beta * (s->pv[i] - op->omega * s->q[i]);
+    }
+}
+
+/** t = A z, slot 0 = t . s, slot 1 = t . t. */
+static void k_bicg_omega(ht_solver_t *s, int tid, const void *arg) {
+    (void)arg;
+    uint32_t y0, y1;
+    rows_for(s->lv[0].h, tid, s->nthreads, &y0, &y1);
+    level_apply(s, 0, s->z, s->t, y0, y1);
+    double lts = 0.0, ltt = 0.0;
+    for (uint32_t i = y0 * s->lv[0].w; i < y1 * s->lv[0].w; i++) {
+        lts += s->t[i] * s->r[i];
+        ltt += s->t[i] * s->t[i];
+    }
+    s->partials[tid * HT_PAD] = lts;
+    s->partials[tid * HT_PAD + 1] = ltt;
+}
+
+/*======== Krylov drivers ========*/
+
+static void solver_finish(ht_solver_t *s, uint32_t it, double rel, int conv) {
+    s->iterations = it;
+    s->rel_residual = rel;
+    s->converged = conv;
+}
+
+/** Preconditioned conjugate gradients (symmetric walks). */
+static void run_pcg(ht_solver_t *s) {
+    run_phase(s, k_pcg_init, NULL);
+    double bnorm = sqrt(partial_sum(s, 0));
+
+    vcycle(s, 0, s->z, s->r, s->q);
+    const double zero = 0.0;
+    run_phase(s, k_pcg_dir, &zero);
+    const ht_dot_op_t rz_op = {s->r, s->z};
+    run_phase(s, k_dot, &rz_op);
+    double rz = partial_sum(s, 0);
+
+    double rel = 1.0;
+    for (uint32_t it = 1; it <= s->max_iters; it++) {
+        const ht_apply_op_t q_op = {s->pv, s->q, s->pv};
+        run_phase(s, k_apply_dot, &q_op);
+        double pq = partial_sum(s, 0);
+        if (pq == 0.0) {
+            solver_finish(s, it, rel, 0);
+            return;
+        }
+
+        const ht_update_op_t up = {rz / pq, s->pv, s->q};
+        run_phase(s, k_update, &up);
+        rel = sqrt(partial_sum(s, 0)) / bnorm;
+        if (rel <= s->tolerance) {
+            solver_finish(s, it, rel, 1);
+            return;
+        }
+        if (!(rel < HT_DIVERGENCE)) {
+            solver_finish(s, it, rel, 0);
+            return;
+        }
+
+        vcycle(s, 0, s->z, s->r, s->q);
+        run_phase(s, k_dot, &rz_op);
+        double rz_new = partial_sum(s, 0);
+        double beta = rz_new / rz;
+        rz = rz_new;
+        run_phase(s, k_pcg_dir, &beta);
+    }
+    solver_finish(s, s->max_iters, rel, 0);
+}
+
+/** Right-preconditioned BiCGSTAB (walks with drift). */
+static void run_bicgstab(ht_solver_t *s) {
+    /* Vector roles: pv=p, z=M^-1 p / M^-1 s, q=A M^-1 p (v), t=A M^-1 s, r doubles as s. */
+    run_phase(s, k_bicg_init, NULL);
+    double bnorm = sqrt(partial_sum(s, 0));
+
+    double rho = 1.0, alpha = 1.0, omega = 1.0;
+    double rel = 1.0;
+    const ht_dot_op_t rho_op = {s->r0, s->r};
+
+    for (uint32_t it = 1; it <= s->max_iters; it++) {
+        run_phase(s, k_dot, &rho_op);
+        double rho_new = partial_sum(s, 0);
+        if (rho_new == 0.0 || omega == 0.0) {
+            solver_finish(s, it, rel, 0);
+            return;
+        }
+        const ht_dir_op_t dir = {(rho_new / rho) * (alpha / omega), omega};
+        rho = rho_new;
+        run_phase(s, k_bicg_dir, &dir);
+
+        /* y = M^-1 p (kept in v until x is updated), q = A y. */
+        vcycle(s, 0, s->v, s->pv, s->t);
+        const ht_apply_op_t q_op = {s->v, s->q, s->r0};
+        run_phase(s, k_apply_dot, &q_op);
+        double r0q = partial_sum(s, 0);
+        if (r0q == 0.0) {
+            solver_finish(s, it, rel, 0);
+            return;
+        }
+        alpha = rho / r0q;
+
+        const ht_update_op_t up_alpha = {alpha, s->v, s->q};
+        run_phase(s, k_update, &up_alpha);
+        rel = sqrt(partial_sum(s, 0)) / bnorm;
+        if (rel <= s->tolerance) {
+            solver_finish(s, it, rel, 1);
+            return;
+        }
+        if (!(rel < HT_DIVERGENCE)) {
+            solver_finish(s, it, rel, 0);
+            return;
+        }
+
+        /* z = M^-1 s, t = A z. */
+        vcycle(s, 0, s->z, s->r, s->v);
+        run_phase(s, k_bicg_omega, NULL);
+        double ts = partial_sum(s, 0);
+        double tt = partial_sum(s, 1);
+        omega = (tt != 0.0) ? ts / tt : 0.0;
+
+        const ht_update_op_t up_omega = {omega, s->z, s->t};
+        run_phase(s, k_update, &up_omega);
+        rel = sqrt(partial_sum(s, 0)) / bnorm;
+        if (rel <= s->tolerance) {
+            solver_finish(s, it, rel, 1);
+            return;
+        }
+        if (!(rel < HT_DIVERGENCE)) {
+            solver_finish(s, it, rel, 0);
+            return;
+        }
+    }
+    solver_finish(s, s->max_iters, rel, 0);
+}
+
+static void solver_run(ht_solver_t *s) {
+    /* Coarse stencils, level by level (each level needs the finer one). */
+    for (int l = 0; l + 1 < s->nlevels; l++) {
+        run_phase(s, k_build_coarse, &l);
+    }
+    if (build_coarsest_lu(s) != 0) {
+        //no usable preconditioner: report failure instead of iterating with a partial LU
+        log_error("hitting_time: %s", (s->lu && s->piv) ? "singular coarsest level" : "out of memory (coarsest LU)");
+        solver_finish(s, 0, 1.0, 0);
+        return;
+    }
+
+    if (s->symmetric) {
+        run_pcg(s);
+    } else {
+        run_bicgstab(s);
+    }
+}
+
+/*======== public API ========*/
+
+static void solver_free(ht_solver_t *s) {
+    for (int l = 1; l < s->nlevels; l++) {
+        level_free(&s->lv[l]);
+    }
+    free(s->code);
+    free(s->partials);
+    free(s->parts);
+    free(s->lu);
+    free(s->piv);
+    free(s->x); free(s->r); free(s->z); free(s->pv);
+    free(s->q); free(s->r0); free(s->v); free(s->t);
+}
+
+int hitting_time_solve(const world_t *w,
+                       move_probs_t probs,
+                       const hitting_time_opts_t *opts,
+                       double *out,
+                       hitting_time_stats_t *out_stats) {
+    if (!w || !out) return -1;
+
+    /* Stencil and Krylov vectors are indexed with 32 bits (and the dense
+     * vectors would not fit in memory anyway for larger worlds). */
+    const uint64_t n64 = world_cell_count(w);
+    if (n64 == 0 || n64 > UINT32_MAX) return -1;
+    const uint32_t n = (uint32_t)n64;
+
+    ht_solver_t s;
+    memset(&s, 0, sizeof(s));
+    s.nthreads = (opts && opts->nthreads > 0) ? opts->nthreads : 1;
+    s.max_iters = (opts && opts->max_iters > 0) ? opts->max_iters : HT_DEFAULT_MAX_ITERS;
+    s.tolerance = (opts && opts->tolerance > 0.0) ? opts->tolerance : HT_DEFAULT_TOLERANCE;
+
+    double c = probs.p_up + probs.p_down + probs.p_left + probs.p_right;
+    if (c > 0.0) {
+        s.p[DIR_UP] = probs.p_up / c;
+        s.p[DIR_DOWN] = probs.p_down / c;
+        s.p[DIR_LEFT] = probs.p_left / c;
+        s.p[DIR_RIGHT] = probs.p_right / c;
+    }
+    s.symmetric = fabs(s.p[DIR_UP] - s.p[DIR_DOWN]) < 1e-12 &&
+                  fabs(s.p[DIR_LEFT] - s.p[DIR_RIGHT]) < 1e-12;
+
+    for (unsigned code = 0; code < 256u; code++) {
+        double dg = 1.0;
+        for (int d = 0; d < 4; d++) {
+            if (code & HT_STAY_BIT(d)) dg -= s.p[d];
+        }
+        s.dcode[code] = dg;
+    }
+
+    s.code = (uint8_t *)malloc((size_t)n);
+    if (!s.code) return -1;
+
+    uint32_t finite = 0, infinite = 0;
+    if (c <= 0.0) {
+        memset(s.code, HT_CODE_INACTIVE, (size_t)n);
+        for (uint32_t i = 1; i < n; i++) {
+            if (!world_is_obstacle_idx(w, i)) infinite++;
+        }
+    } else if (classify_cells(w, s.p, s.code, &finite, &infinite) != 0) {
+        free(s.code);
+        return -1;
+    }
+
+    /* Level hierarchy: halve each dimension until the grid is small. */
+    s.lv[0].w = (uint32_t)w->size.width;
+    s.lv[0].h = (uint32_t)w->size.height;
+    s.lv[0].n = n;
+    s.nlevels = 1;
+    while (s.nlevels < HT_MAX_LEVELS && s.lv[s.nlevels - 1].n > HT_COARSEST_CELLS) {
+        const ht_level_t *F = &s.lv[s.nlevels - 1];
+        uint32_t cw = (F->w + 1u) / 2u;
+        uint32_t ch = (F->h + 1u) / 2u;
+        if (level_alloc(&s.lv[s.nlevels], cw, ch) != 0) {
+            solver_free(&s);
+            return -1;
+        }
+        s.nlevels++;
+    }
+
+    size_t bytes = sizeof(double) * (size_t)n;
+    s.x = (double *)calloc(1, bytes);
+    s.r = (double *)calloc(1, bytes);
+    s.z = (double *)calloc(1, bytes);
+    s.pv = (double *)calloc(1, bytes);
+    s.q = (double *)calloc(1, bytes);
+    s.t = (double *)calloc(1, bytes);
+    s.v = (double *)calloc(1, bytes);
+    if (!s.symmetric) {
+        s.r0 = (double *)calloc(1, bytes);
+    }
+    s.partials = (double *)calloc((size_t)s.nthreads * HT_PAD, sizeof(double));
+    s.parts = (ht_part_t *)calloc((size_t)s.nthreads, sizeof(ht_part_t));
+    if (!s.x || !s.r || !s.z || !s.pv || !s.q || !s.t || !s.v ||
+        (!s.symmetric && !s.r0) || !s.partials || !s.parts) {
+        solver_free(&s);
+        return -1;
+    }
+
+    if (finite > 0) {
+        for (int t = 0; t < s.nthreads; t++) {
+            s.parts[t].s = &s;
+            s.parts[t].tid = t;
+        }
+        sched_group_init(&s.group);
+        solver_run(&s);
+        sched_group_destroy(&s.group);
+    } else {
+        s.converged = 1;
+        s.rel_residual = 0.0;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        if (world_is_obstacle_idx(w, i)) out[i] = NAN;
+        else if (i == 0) out[i] = 0.0;
+        else if (s.code[i] == HT_CODE_INACTIVE) out[i] = INFINITY;
+        else out[i] = s.x[i];
+    }
+
+    if (out_stats) {
+        memset(out_stats, 0, sizeof(*out_stats));
+        out_stats->iterations = s.iterations;
+        out_stats->rel_residual = s.rel_residual;
+        out_stats->converged = s.converged;
+        out_stats->symmetric = s.symmetric;
+        out_stats->levels = s.nlevels;
+        out_stats->finite_cells = finite;
+        out_stats->infinite_cells = infinite;
+    }
+
+    solver_free(&s);
+    return 0;
+}
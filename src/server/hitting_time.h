@@ -0,0 +1,115 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_HITTING_TIME_H
+#define SEMPRACA_HITTING_TIME_H
+
+/**
+ * @file hitting_time.h
+ * @brief Deterministic solver for the expected hitting time of the origin.
+ *
+ * Monte Carlo replications only estimate metrics truncated at K steps. This
+ * module computes the *unbounded* expected number of steps E[T](x,y) needed by
+ * a walker starting in (x,y) to reach the origin, by solving the linear system
+ *
+ * @code
+ * E[origin] = 0
+ * E[i]      = 1 + sum_d p_d * E[next_d(i)]     for every other free cell i
+ * @endcode
+ *
+ * where @c next_d(i) follows exactly the rules of @ref random_walk_run():
+ * positions wrap in @c WORLD_WRAP worlds, and a move out of bounds or into an
+ * obstacle keeps the walker in place. Probabilities are normalized by their sum.
+ *
+ * Cells from which the origin is not reached with probability 1 (origin not
+ * reachable at all, or a positive chance of getting trapped elsewhere) have an
+ * infinite expected hitting time and are excluded from the system.
+ *
+ * Method
+ * ------
+ * The system is solved matrix-free with a Krylov method preconditioned by an
+ * aggregation multigrid V-cycle (2x2 cell aggregates, Galerkin coarse stencils,
+ * damped Jacobi smoothing):
+ * - conjugate gradients when the walk is symmetric (p_up == p_down and
+ *   p_left == p_right), since the system matrix is then SPD,
+ * - BiCGSTAB otherwise (drift makes the matrix non-symmetric).
+ *
+ * All vector and stencil operations are split by rows into bands that run as
+ * background tasks of the scheduler (see scheduler.h). The fine level stores one byte per cell describing the stencil,
+ * so memory stays around 70-90 bytes per cell including all work vectors.
+ *
+ * Output encoding (one double per cell, row-major):
+ * - origin      : 0.0
+ * - free cell   : expected number of steps to reach the origin
+ * - unreachable : INFINITY
+ * - obstacle    : NAN
+ */
+
+#include "world.h"
+#include "../common/types.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Solver options. Zero-initialized options select sensible defaults.
+ */
+typedef struct {
+    /** Maximum Krylov iterations (0 = default 500). */
+    uint32_t max_iters;
+
+    /** Target relative residual ||b - Ax|| / ||b|| (<= 0 = default 1e-8). */
+    double tolerance;
+
+    /** Number of row bands run as background tasks (<= 0 = 1). */
+    int nthreads;
+} hitting_time_opts_t;
+
+/**
+ * @brief Solver outcome statistics.
+ */
+typedef struct {
+    /** Krylov iterations performed. */
+    uint32_t iterations;
+
+    /** Final relative residual. */
+    double rel_residual;
+
+    /** Non-zero if @ref hitting_time_opts_t::tolerance was reached. */
+    int converged;
+
+    /** Non-zero if conjugate gradients was used, 0 for BiCGSTAB. */
+    int symmetric;
+
+    /** Number of multigrid levels (including the fine grid). */
+    int levels;
+
+    /** Free cells (origin excluded) with a finite expected hitting time. */
+    uint32_t finite_cells;
+
+    /** Free cells with an infinite expected hitting time. */
+    uint32_t infinite_cells;
+} hitting_time_stats_t;
+
+/**
+ * @brief Solve for the expected hitting time of the origin for every cell.
+ *
+ * @param w         World (obstacles and topology).
+ * @param probs     Movement probabilities (normalized internally).
+ * @param opts      Options (may be NULL for defaults).
+ * @param out       Output array of length @ref world_cell_count(); see the
+ *                  file documentation for the encoding.
+ * @param out_stats Optional statistics.
+ *
+ * @retval 0  Success (also when the tolerance was not reached; check
+ *            @ref hitting_time_stats_t::converged).
+ * @retval -1 Invalid arguments (including worlds with more than 2^32 cells)
+ *            or allocation failure.
+ */
+int hitting_time_solve(const world_t *w,
+                       move_probs_t probs,
+                       const hitting_time_opts_t *opts,
+                       double *out,
+                       hitting_time_stats_t *out_stats);
+
+#endif //SEMPRACA_HITTING_TIME_H
@@ -0,0 +1,161 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "latency_stats.h"
+
+#include "../common/protocol.h"
+#include "../common/util.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @file latency_stats.c
+ * @brief Implementation of the log-bucketed latency histograms.
+ */
+
+#define LAT_SUB_BITS 3
+#define LAT_SUB (1u << LAT_SUB_BITS)
+/* highest tracked power of two (2^43 ns ~ 2.4 h); longer requests are clamped */
+#define LAT_MAX_EXP 43
+#define LAT_BUCKETS ((LAT_MAX_EXP - LAT_SUB_BITS + 2) * LAT_SUB)
+
+typedef struct {
+    _Atomic uint64_t bucket[LAT_BUCKETS];
+    _Atomic uint64_t max_ns;
+    _Atomic uint64_t interval_max_ns;  /* reset by latency_stats_log_interval() */
+} lat_hist_t;
+
+static lat_hist_t g_hist[LATENCY_MAX_TYPES];
+static uint64_t g_prev[LATENCY_MAX_TYPES][LAT_BUCKETS];  /* interval reporter only */
+static uint64_t g_prev_ns;                              /* interval reporter only */
+
+static unsigned bucket_of(uint64_t ns) {
+    if (ns < LAT_SUB) return (unsigned)ns;
+    unsigned e = 63u - (unsigned)__builtin_clzll(ns);
+    if (e > LAT_MAX_EXP) return LAT_BUCKETS - 1u;
+    unsigned sub = (unsigned)(ns >> (e - LAT_SUB_BITS)) & (LAT_SUB - 1u);
+    return (e - LAT_SUB_BITS + 1u) * LAT_SUB + sub;
+}
+
+/* Largest value that falls into bucket @p b. */
+static uint64_t bucket_upper(unsigned b) {
+    if (b < LAT_SUB) return b;
+    unsigned e = b / LAT_SUB + LAT_SUB_BITS - 1u;
+    uint64_t sub = b % LAT_SUB;
+    uint64_t width = 1ull << (e - LAT_SUB_BITS);
+    return ((LAT_SUB + sub) << (e - LAT_SUB_BITS)) + width - 1u;
+}
+
+static void atomic_max(_Atomic uint64_t *m, uint64_t v) {
+    uint64_t cur = atomic_load_explicit(m, memory_order_relaxed);
+    while (v > cur &&
+           !atomic_compare_exchange_weak_explicit(m, &cur, v, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+/* Quantiles of a bucket histogram; returns the count. */
+static uint64_t summarize(const uint64_t *h, uint64_t max_ns, latency_summary_t *s) {
+    uint64_t n = 0;
+    for (unsigned b = 0; b < LAT_BUCKETS; b++) n += h[b];
+    s->count = n;
+    s->max_ns = max_ns;
+    s->p50_ns = s->p99_ns = s->p999_ns = 0;
+    if (n == 0) return 0;
+
+    //rank (1-based) of each quantile: ceil(q * n)
+    uint64_t r50 = (n + 1u) / 2u;
+    uint64_t r99 = n - n / 100u;
+    uint64_t r999 = n - n / 1000u;
+    uint64_t seen = 0;
+    for (unsigned b = 0; b < LAT_BUCKETS; b++) {
+        if (h[b] == 0) continue;
+        uint64_t prev = seen;
+        seen += h[b];
+        uint64_t v = bucket_upper(b);
+        if (v > max_ns) v = max_ns;
+        if (prev < r50 && seen >= r50) s->p50_ns = v;
+        if (prev < r99 && seen >= r99) s->p99_ns = v;
+        if (prev < r999 && seen >= r999) {
+            s->p999_ns = v;
+            break;
+        }
+    }
+    return n;
+}
+
+static void fmt_ns(char *buf, size_t cap, uint64_t ns) {
+    if (ns < 1000u) {
+        snprintf(buf, cap, "%lluns", (unsigned long long)ns);
+    } else if (ns < 1000000u) {
+        snprintf(buf, cap, "%.1fus", (double)ns / 1e3);
+    } else if (ns < 1000000000u) {
+        snprintf(buf, cap, "%.2fms", (double)ns / 1e6);
+    } else {
+        snprintf(buf, cap, "%.2fs", (double)ns / 1e9);
+    }
+}
+
+uint64_t latency_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void latency_stats_record(uint16_t type, uint64_t ns) {
+    if (type >= LATENCY_MAX_TYPES) return;
+    lat_hist_t *h = &g_hist[type];
+    atomic_fetch_add_explicit(&h->bucket[bucket_of(ns)], 1u, memory_order_relaxed);
+    atomic_max(&h->max_ns, ns);
+    atomic_max(&h->interval_max_ns, ns);
+}
+
+size_t latency_stats_summary(latency_summary_t *out, size_t cap) {
+    if (!out) return 0;
+
+    uint64_t h[LAT_BUCKETS];
+    size_t n = 0;
+    for (unsigned t = 0; t < LATENCY_MAX_TYPES && n < cap; t++) {
+        for (unsigned b = 0; b < LAT_BUCKETS; b++) {
+            h[b] = atomic_load_explicit(&g_hist[t].bucket[b], memory_order_relaxed);
+        }
+        latency_summary_t s;
+        if (summarize(h, atomic_load_explicit(&g_hist[t].max_ns, memory_order_relaxed), &s) == 0) continue;
+        s.type = (uint16_t)t;
+        out[n++] = s;
+    }
+    return n;
+}
+
+void latency_stats_log_interval(void) {
+    uint64_t now = latency_now_ns();
+    double secs = g_prev_ns ? (double)(now - g_prev_ns) / 1e9 : 0.0;
+    g_prev_ns = now;
+
+    uint64_t h[LAT_BUCKETS];
+    for (unsigned t = 0; t < LATENCY_MAX_TYPES; t++) {
+        for (unsigned b = 0; b < LAT_BUCKETS; b++) {
+            uint64_t cur = atomic_load_explicit(&g_hist[t].bucket[b], memory_order_relaxed);
+            h[b] = cur - g_prev[t][b];
+            g_prev[t][b] = cur;
+        }
+        uint64_t max_ns = atomic_exchange_explicit(&g_hist[t].interval_max_ns, 0u, memory_order_relaxed);
+
+        latency_summary_t s;
+        if (summarize(h, max_ns, &s) == 0) continue;
+
+        char p50[16], p99[16], p999[16], mx[16];
+        fmt_ns(p50, sizeof(p50), s.p50_ns);
+        fmt_ns(p99, sizeof(p99), s.p99_ns);
+        fmt_ns(p999, sizeof(p999), s.p999_ns);
+        fmt_ns(mx, sizeof(mx), s.max_ns);
+        log_info("latency %-18s n=%llu (%.1f/s) p50=%s p99=%s p999=%s max=%s",
+                 rw_msg_type_name((uint16_t)t), (unsigned long long)s.count,
+                 secs > 0.0 ? (double)s.count / secs : 0.0, p50, p99, p999, mx);
+    }
+}
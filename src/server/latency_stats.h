@@ -0,0 +1,69 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_LATENCY_STATS_H
+#define SEMPRACA_LATENCY_STATS_H
+
+/**
+ * @file latency_stats.h
+ * @brief Per-message-type service latency histograms of the control plane.
+ *
+ * server_ipc.c records, for every request, the time from receiving its header
+ * to finishing the handler (payload read, work and reply). Latencies go into
+ * log-bucketed histograms: 8 buckets per power of two of nanoseconds, so every
+ * reported quantile is within 12.5 % of the true value. Recording is a few
+ * relaxed atomic increments; there are no locks.
+ *
+ * Two views are provided:
+ * - @ref latency_stats_summary(): since server start (QUERY_STATS request),
+ * - @ref latency_stats_log_interval(): since its previous call, as one log line
+ *   (called periodically by server_main).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Message types below this value are tracked (others are ignored). */
+#define LATENCY_MAX_TYPES 64
+
+/**
+ * @brief Latency summary of one message type (nanoseconds).
+ */
+typedef struct {
+    uint16_t type;
+    uint64_t count;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+} latency_summary_t;
+
+/**
+ * @brief Monotonic clock in nanoseconds (for request timestamps).
+ */
+uint64_t latency_now_ns(void);
+
+/**
+ * @brief Record one request of @p type that took @p ns nanoseconds.
+ */
+void latency_stats_record(uint16_t type, uint64_t ns);
+
+/**
+ * @brief Summaries of all message types seen since server start.
+ *
+ * @param out Output array (ordered by message type).
+ * @param cap Capacity of @p out.
+ * @return Number of entries written.
+ */
+size_t latency_stats_summary(latency_summary_t *out, size_t cap);
+
+/**
+ * @brief Log one line with the latencies since the previous call.
+ *
+ * Logs nothing if no request arrived in the interval. Must be called from one
+ * thread only.
+ */
+void latency_stats_log_interval(void);
+
+#endif //SEMPRACA_LATENCY_STATS_H
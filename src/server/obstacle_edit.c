@@ -0,0 +1,173 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#include "obstacle_edit.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file obstacle_edit.c
+ * @brief Implementation of obstacle edits and the K-bounded affected-set search.
+ */
+
+static const int kNeighborDirs[4][2] = {
+    {1, 0}, {-1, 0}, {0, 1}, {0, -1}
+};
+
+/* Growable FIFO of cell indices; the affected set is usually tiny compared to
+ * the world, so it is not sized for the whole grid. */
+typedef struct {
+    uint64_t *items;
+    uint64_t len;
+    uint64_t cap;
+} idx_queue_t;
+
+static int queue_push(idx_queue_t *q, uint64_t idx) {
+    if (q->len == q->cap) {
+        uint64_t cap = q->cap ? q->cap * 2u : 1024u;
+        uint64_t *items = (uint64_t *)realloc(q->items, sizeof(uint64_t) * (size_t)cap);
+        if (!items) return -1;
+        q->items = items;
+        q->cap = cap;
+    }
+    q->items[q->len++] = idx;
+    return 0;
+}
+
+/* Open-addressing set of marked cells (index + 1, 0 = empty slot), kept at
+ * most half full; memory follows the affected set, not the world. */
+typedef struct {
+    uint64_t *slots;
+    uint64_t cap;   /* power of two */
+    uint64_t len;
+} idx_set_t;
+
+static uint64_t set_hash(uint64_t idx) {
+    idx ^= idx >> 33;
+    idx *= 0xff51afd7ed558ccdULL;
+    idx ^= idx >> 33;
+    return idx;
+}
+
+static int set_contains(const idx_set_t *s, uint64_t idx) {
+    if (s->cap == 0) return 0;
+    for (uint64_t i = set_hash(idx) & (s->cap - 1u);; i = (i + 1u) & (s->cap - 1u)) {
+        if (s->slots[i] == 0) return 0;
+        if (s->slots[i] == idx + 1u) return 1;
+    }
+}
+
+static void set_put(uint64_t *slots, uint64_t cap, uint64_t key) {
+    uint64_t i = set_hash(key - 1u) & (cap - 1u);
+    while (slots[i] != 0) i = (i + 1u) & (cap - 1u);
+    slots[i] = key;
+}
+
+/* Insert @p idx (not yet contained). */
+static int set_add(idx_set_t *s, uint64_t idx) {
+    if (2u * (s->len + 1u) > s->cap) {
+        uint64_t cap = s->cap ? s->cap * 2u : 2048u;
+        uint64_t *slots = (uint64_t *)calloc((size_t)cap, sizeof(uint64_t));
+        if (!slots) return -1;
+        for (uint64_t i = 0; i < s->cap; i++) {
+            if (s->slots[i]) set_put(slots, cap, s->slots[i]);
+        }
+        free(s->slots);
+        s->slots = slots;
+        s->cap = cap;
+    }
+    set_put(s->slots, s->cap, idx + 1u);
+    s->len++;
+    return 0;
+}
+
+/* Mark @p idx: remember it and append it to the queue. */
+static int mark(idx_set_t *set, idx_queue_t *q, uint64_t idx) {
+    if (queue_push(q, idx) != 0) return -1;
+    if (set_add(set, idx) != 0) {
+        q->len--;
+        return -1;
+    }
+    return 0;
+}
+
+int obstacle_edit_apply(world_t *w,
+                        const obstacle_edit_t *edits,
+                        uint32_t count,
+                        uint32_t k_max_steps,
+                        uint64_t **out_cells,
+                        uint32_t *out_changed,
+                        uint64_t *out_affected) {
+    if (!w || !w->obstacle_bits || !out_cells || (count > 0 && !edits)) return -1;
+    *out_cells = NULL;
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (!world_in_bounds(w, edits[i].x, edits[i].y)) return -1;
+        if (edits[i].x == 0 && edits[i].y == 0 && edits[i].value) return -1;
+    }
+
+    idx_queue_t q;
+    idx_set_t set;
+    memset(&q, 0, sizeof(q));
+    memset(&set, 0, sizeof(set));
+    int oom = 0;
+
+    /* Depth 0: cells that actually change (the first @c changed queue entries). */
+    uint32_t changed = 0;
+    for (uint32_t i = 0; i < count && !oom; i++) {
+        uint64_t idx = world_index(w, edits[i].x, edits[i].y);
+        int value = edits[i].value ? 1 : 0;
+        if (world_is_obstacle_idx(w, idx) == value || set_contains(&set, idx)) continue;
+        if (mark(&set, &q, idx) != 0) {
+            oom = 1;
+            break;
+        }
+        world_set_obstacle_idx(w, idx, value);
+        changed++;
+    }
+
+    /* Level-synchronous BFS through cells free in both worlds, up to depth K.
+     * Changed cells are already marked, so "free now and unmarked" is exactly
+     * "unchanged free cell". */
+    uint64_t width = (uint64_t)w->size.width;
+    uint64_t level_start = 0;
+    for (uint32_t depth = 1; depth <= k_max_steps && level_start < q.len && !oom; depth++) {
+        uint64_t level_end = q.len;
+        for (uint64_t head = level_start; head < level_end && !oom; head++) {
+            uint64_t idx = q.items[head];
+            int32_t x = (int32_t)(idx % width);
+            int32_t y = (int32_t)(idx / width);
+
+            for (int d = 0; d < 4; d++) {
+                pos_t nb = {x + kNeighborDirs[d][0], y + kNeighborDirs[d][1]};
+                if (w->kind == WORLD_WRAP) {
+                    nb = world_wrap_pos(w, nb);
+                }
+                if (!world_in_bounds(w, nb.x, nb.y)) continue;
+                uint64_t nidx = world_index(w, nb.x, nb.y);
+                if (world_is_obstacle_idx(w, nidx) || set_contains(&set, nidx)) continue;
+                if (mark(&set, &q, nidx) != 0) {
+                    oom = 1;
+                    break;
+                }
+            }
+        }
+        level_start = level_end;
+    }
+    free(set.slots);
+
+    if (oom) {
+        /* Roll back the cells changed so far; the world stays untouched. */
+        for (uint64_t j = 0; j < changed; j++) {
+            world_set_obstacle_idx(w, q.items[j], !world_is_obstacle_idx(w, q.items[j]));
+        }
+        free(q.items);
+        return -2;
+    }
+    if (out_changed) *out_changed = changed;
+    if (out_affected) *out_affected = q.len;
+    *out_cells = q.items;
+    return 0;
+}
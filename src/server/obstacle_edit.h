@@ -0,0 +1,72 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_OBSTACLE_EDIT_H
+#define SEMPRACA_OBSTACLE_EDIT_H
+
+/**
+ * @file obstacle_edit.h
+ * @brief Live obstacle edits with computation of the affected start cells.
+ *
+ * Every walk is truncated after K steps, so an edited cell e can only change
+ * the outcome of walks that can interact with e (step onto it, or be blocked by
+ * it) within K steps. Until that first interaction, a walk only visits cells
+ * that are free both before and after the edit. Therefore the affected start
+ * cells are exactly those within graph distance <= K of an edited cell, where
+ * the distance is measured through cells that are free in both worlds. Changes
+ * of connected components (cut-off regions) are covered by the same bound:
+ * beyond distance K they are invisible to K-truncated walks.
+ *
+ * Results of all other cells stay statistically valid and are kept.
+ *
+ * @note Edits are applied as given; unlike @ref world_generate_obstacles() no
+ *       corridors are carved, so a region may be cut off from the origin
+ *       (its cells then simply never succeed). The origin itself cannot be
+ *       turned into an obstacle.
+ */
+
+#include "world.h"
+
+#include <stdint.h>
+
+/**
+ * @brief One requested cell change.
+ */
+typedef struct {
+    int32_t x;
+    int32_t y;
+    int value; /**< 0 = free, non-zero = obstacle */
+} obstacle_edit_t;
+
+/**
+ * @brief Apply edits to @p w and mark the start cells whose results are affected.
+ *
+ * All edits are validated before anything is changed (in bounds, origin not
+ * blocked). Edits that do not change a cell are ignored.
+ *
+ * @param w            World to modify.
+ * @param edits        Requested changes.
+ * @param count        Number of entries in @p edits.
+ * @param k_max_steps  K (walk length bound).
+ * @param out_cells    Set to a heap array (free()) of the changed cells and
+ *                     affected start cells, @p out_affected entries, in BFS
+ *                     order; NULL if nothing changed. Its size follows the
+ *                     affected set, not the world.
+ * @param out_changed  Optional: number of cells that actually changed.
+ * @param out_affected Optional: number of entries in @p out_cells.
+ *
+ * @retval 0  Success.
+ * @retval -1 Invalid edit; nothing is changed.
+ * @retval -2 Allocation failure during the search; the edits are rolled back
+ *            and the world is unchanged.
+ */
+int obstacle_edit_apply(world_t *w,
+                        const obstacle_edit_t *edits,
+                        uint32_t count,
+                        uint32_t k_max_steps,
+                        uint64_t **out_cells,
+                        uint32_t *out_changed,
+                        uint64_t *out_affected);
+
+#endif //SEMPRACA_OBSTACLE_EDIT_H
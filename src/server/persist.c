@@ -2,17 +2,36 @@
 // Created by Jozef Jelšík on 27/12/2025.
 //
 
+#define _POSIX_C_SOURCE 200809L /* mmap() of result files */
+
 #include "persist.h"
 
 #include "../common/util.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define RWRES_MAGIC "RWRES\0\0\0"
 #define RWRES_MAGIC_LEN 8
-#define RWRES_VERSION 1u
+#define RWRES_VERSION 3u
+/* Version 1 files end after the success_leq_k array (no extra_fields word). */
+#define RWRES_VERSION_V1 1u
+/* Versions 1 and 2 store one byte per cell for obstacles instead of a bitmap. */
+#define RWRES_VERSION_V2 2u
+
+#define RWRES_VERSION_OK(v) ((v) == RWRES_VERSION || (v) == RWRES_VERSION_V2 || (v) == RWRES_VERSION_V1)
+
+/* Bits of the v2 extra_fields word: optional arrays following the v1 payload. */
+#define RWRES_EXTRA_HIT_TIME 0x1u
+
+/* Bytes of the fixed header (magic .. total_reps). */
+#define RWRES_HEADER_LEN (RWRES_MAGIC_LEN + 4u * 4u + 4u * sizeof(double) + 2u * 4u)
 
 static int write_exact(FILE *f, const void *p, size_t n) {
     return fwrite(p, 1, n, f) == n ? 0 : -1;
@@ -22,6 +41,50 @@ static int read_exact(FILE *f, void *p, size_t n) {
     return fread(p, 1, n, f) == n ? 0 : -1;
 }
 
+/* Read the obstacle map of a file with the given version into @p world. */
+static int read_obstacles(FILE *f, uint32_t version, world_t *world) {
+    if (version >= RWRES_VERSION) {
+        return read_exact(f, world->obstacle_bits, (size_t)world_obstacle_bytes(world));
+    }
+
+    /* v1/v2: byte per cell, converted in blocks. */
+    uint8_t buf[4096];
+    uint64_t n = world_cell_count(world);
+    for (uint64_t i = 0; i < n; ) {
+        size_t len = (n - i) < sizeof(buf) ? (size_t)(n - i) : sizeof(buf);
+        if (read_exact(f, buf, len) != 0) return -1;
+        for (size_t j = 0; j < len; j++) {
+            if (buf[j]) world_set_obstacle_idx(world, i + j, 1);
+        }
+        i += len;
+    }
+    return 0;
+}
+
+/* Write the obstacle map as the linear bitmap of the file format. */
+static int write_obstacles(FILE *f, const world_t *world) {
+    if (world->layout == WORLD_LAYOUT_LINEAR) {
+        return write_exact(f, world->obstacle_bits, (size_t)world_obstacle_bytes(world));
+    }
+
+    /* Tiled (mapped) world: repack in blocks of 8 * sizeof(buf) cells. */
+    uint8_t buf[4096];
+    uint64_t n = world_cell_count(world);
+    size_t len = 0;
+    for (uint64_t i = 0; i < n; i += 8u) {
+        uint8_t byte = 0;
+        for (uint64_t j = 0; j < 8u && i + j < n; j++) {
+            if (world_is_obstacle_idx(world, i + j)) byte |= (uint8_t)(1u << j);
+        }
+        buf[len++] = byte;
+        if (len == sizeof(buf)) {
+            if (write_exact(f, buf, len) != 0) return -1;
+            len = 0;
+        }
+    }
+    return len > 0 ? write_exact(f, buf, len) : 0;
+}
+
 int persist_save_results(const char *path,
                          const server_context_t *ctx,
                          const world_t *world,
@@ -43,7 +106,7 @@ int persist_save_results(const char *path,
     uint32_t k_max_steps = ctx->k_max_steps;
     uint32_t total_reps = ctx->total_reps;
 
-    uint32_t cell_count = (uint32_t)(width * height);
+    uint64_t cell_count = world_cell_count(world);
 
     int ok = 0;
     ok |= write_exact(f, magic, sizeof(magic));
@@ -55,11 +118,19 @@ int persist_save_results(const char *path,
     ok |= write_exact(f, &k_max_steps, sizeof(k_max_steps));
     ok |= write_exact(f, &total_reps, sizeof(total_reps));
 
-    ok |= write_exact(f, world->obstacles, (size_t)cell_count * sizeof(uint8_t));
+    ok |= write_obstacles(f, world);
     ok |= write_exact(f, results_trials(results), (size_t)cell_count * sizeof(uint32_t));
     ok |= write_exact(f, results_sum_steps(results), (size_t)cell_count * sizeof(uint64_t));
     ok |= write_exact(f, results_success_leq_k(results), (size_t)cell_count * sizeof(uint32_t));
 
+    const results_hit_time_t *hit_time = results_hit_time_acquire(results);
+    uint32_t extra_fields = hit_time ? RWRES_EXTRA_HIT_TIME : 0u;
+    ok |= write_exact(f, &extra_fields, sizeof(extra_fields));
+    if (hit_time) {
+        ok |= write_exact(f, hit_time->values, (size_t)cell_count * sizeof(double));
+    }
+    results_hit_time_release(hit_time);
+
     if (fclose(f) != 0) {
         ok = -1;
     }
@@ -101,7 +172,8 @@ int persist_load_results(const char *path,
     ok |= read_exact(f, &k_max_steps, sizeof(k_max_steps));
     ok |= read_exact(f, &total_reps, sizeof(total_reps));
 
-    if (ok != 0 || memcmp(magic, RWRES_MAGIC, RWRES_MAGIC_LEN) != 0 || version != RWRES_VERSION) {
+    if (ok != 0 || memcmp(magic, RWRES_MAGIC, RWRES_MAGIC_LEN) != 0 || !RWRES_VERSION_OK(version) ||
+        width == 0 || height == 0 || width > INT32_MAX || height > INT32_MAX) {
         fclose(f);
         log_error("persist_load_results: invalid header in '%s'", path);
         return -1;
@@ -121,18 +193,35 @@ int persist_load_results(const char *path,
         return -1;
     }
 
-    uint32_t cell_count = (uint32_t)(width * height);
+    uint64_t cell_count = world_cell_count(world);
 
     ok = 0;
-    ok |= read_exact(f, world->obstacles, (size_t)cell_count * sizeof(uint8_t));
+    ok |= read_obstacles(f, version, world);
 
     /* results arrays are internal; load into them directly */
     ok |= read_exact(f, (void *)results->trials, (size_t)cell_count * sizeof(uint32_t));
     ok |= read_exact(f, (void *)results->sum_steps, (size_t)cell_count * sizeof(uint64_t));
     ok |= read_exact(f, (void *)results->success_leq_k, (size_t)cell_count * sizeof(uint32_t));
 
+    uint32_t extra_fields = 0;
+    if (ok == 0 && version >= RWRES_VERSION_V2) {
+        ok |= read_exact(f, &extra_fields, sizeof(extra_fields));
+    }
+    if (ok == 0 && (extra_fields & RWRES_EXTRA_HIT_TIME)) {
+        double *hit_time = (double *)malloc((size_t)cell_count * sizeof(double));
+        if (!hit_time || read_exact(f, hit_time, (size_t)cell_count * sizeof(double)) != 0) {
+            free(hit_time);
+            ok = -1;
+        } else {
+            results_set_hit_time(results, hit_time);
+        }
+    }
+
     fclose(f);
 
+    //arrays were filled behind the results API: invalidate cached views
+    results_mark_all(results);
+
     if (ok != 0) {
         log_error("persist_load_results: read failed for '%s'", path);
         return -1;
@@ -181,7 +270,8 @@ int persist_load_world(const char *path,
     ok |= read_exact(f, &k_max_steps, sizeof(k_max_steps));
     ok |= read_exact(f, &total_reps, sizeof(total_reps));
 
-    if (ok != 0 || memcmp(magic, RWRES_MAGIC, RWRES_MAGIC_LEN) != 0 || version != RWRES_VERSION) {
+    if (ok != 0 || memcmp(magic, RWRES_MAGIC, RWRES_MAGIC_LEN) != 0 || !RWRES_VERSION_OK(version) ||
+        width == 0 || height == 0 || width > INT32_MAX || height > INT32_MAX) {
         fclose(f);
         log_error("persist_load_world: invalid header in '%s'", path);
         return -1;
@@ -189,20 +279,25 @@ int persist_load_world(const char *path,
 
     world_kind_t wk = (world_kind == (uint32_t)WORLD_OBSTACLES) ? WORLD_OBSTACLES : WORLD_WRAP;
 
-    world_destroy(world);
-    if (world_init(world, wk, (world_size_t){(int32_t)width, (int32_t)height}) != 0) {
+    /* Read aside: on failure @p world and the context stay as they were. */
+    world_t tmp;
+    memset(&tmp, 0, sizeof(tmp));
+    if (world_init(&tmp, wk, (world_size_t){(int32_t)width, (int32_t)height}) != 0) {
         fclose(f);
         return -1;
     }
 
-    uint32_t cell_count = (uint32_t)(width * height);
-    if (read_exact(f, world->obstacles, (size_t)cell_count * sizeof(uint8_t)) != 0) {
+    if (read_obstacles(f, version, &tmp) != 0) {
         fclose(f);
+        world_destroy(&tmp);
         return -1;
     }
 
     fclose(f);
 
+    world_destroy(world);
+    *world = tmp;
+
     if (ctx_optional) {
         ctx_optional->world_kind = wk;
         ctx_optional->world_size.width = (int32_t)width;
@@ -218,3 +313,72 @@ int persist_load_world(const char *path,
     return 0;
 }
 
+
+int persist_map_results(const char *path, persist_results_map_t *out) {
+    if (!path || !out) return -1;
+    memset(out, 0, sizeof(*out));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        log_error("persist_map_results: open('%s') failed: %s", path, strerror(errno));
+        return -1;
+    }
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || (uint64_t)sb.st_size < RWRES_HEADER_LEN) {
+        log_error("persist_map_results: '%s' is too short", path);
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        log_error("persist_map_results: mmap('%s') failed: %s", path, strerror(errno));
+        return -1;
+    }
+    /* one sequential pass over the arrays */
+    (void)posix_madvise(map, (size_t)sb.st_size, POSIX_MADV_SEQUENTIAL);
+
+    const uint8_t *p = (const uint8_t *)map;
+    uint32_t version = 0, width = 0, height = 0;
+    memcpy(&version, p + RWRES_MAGIC_LEN, sizeof(version));
+    memcpy(&width, p + RWRES_MAGIC_LEN + 8u, sizeof(width));
+    memcpy(&height, p + RWRES_MAGIC_LEN + 12u, sizeof(height));
+    memcpy(&out->k_max_steps, p + RWRES_HEADER_LEN - 8u, sizeof(out->k_max_steps));
+    memcpy(&out->total_reps, p + RWRES_HEADER_LEN - 4u, sizeof(out->total_reps));
+
+    const uint64_t cells = (uint64_t)width * (uint64_t)height;
+    const uint64_t obst_len = version >= RWRES_VERSION ? (cells + 7u) / 8u : cells;
+    const uint64_t need = RWRES_HEADER_LEN + obst_len + cells * (sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint32_t));
+    if (memcmp(p, RWRES_MAGIC, RWRES_MAGIC_LEN) != 0 || !RWRES_VERSION_OK(version) ||
+        width == 0 || height == 0 || width > INT32_MAX || height > INT32_MAX || (uint64_t)sb.st_size < need) {
+        log_error("persist_map_results: invalid header in '%s'", path);
+        munmap(map, (size_t)sb.st_size);
+        return -1;
+    }
+
+    out->size.width = (int32_t)width;
+    out->size.height = (int32_t)height;
+    p += RWRES_HEADER_LEN;
+    if (version >= RWRES_VERSION) {
+        out->obstacle_bits = p;
+    } else {
+        out->obstacle_bytes = p;
+    }
+    p += obst_len;
+    out->trials = p;
+    p += cells * sizeof(uint32_t);
+    out->sum_steps = p;
+    p += cells * sizeof(uint64_t);
+    out->success_leq_k = p;
+    out->map = map;
+    out->map_len = (size_t)sb.st_size;
+    return 0;
+}
+
+void persist_unmap_results(persist_results_map_t *m) {
+    if (!m) return;
+    if (m->map) {
+        munmap(m->map, m->map_len);
+    }
+    memset(m, 0, sizeof(*m));
+}
@@ -15,17 +15,22 @@
  *
  * File format (little-endian, versioned):
  *  - magic[8] = "RWRES\0\0\0"
- *  - uint32_t version (1)
+ *  - uint32_t version (3; versions 1 and 2 are still accepted)
  *  - uint32_t world_kind
  *  - uint32_t width
  *  - uint32_t height
  *  - double probs[4] {up,down,left,right}
  *  - uint32_t k_max_steps
  *  - uint32_t total_reps
- *  - uint8_t obstacles[cell_count]
+ *  - obstacles: version 3 stores the world bitmap, uint8_t[(cell_count + 7) / 8]
+ *    (see world.h); versions 1 and 2 store uint8_t[cell_count] (1 = obstacle)
  *  - uint32_t trials[cell_count]
  *  - uint64_t sum_steps[cell_count]
  *  - uint32_t success_leq_k[cell_count]
+ *  - uint32_t extra_fields (version >= 2): bitmask of optional arrays below
+ *  - double hit_time[cell_count] (only if extra_fields & 0x1)
+ *
+ * cell_count = width * height is computed in 64 bits.
  */
 
 int persist_save_results(const char *path,
@@ -42,5 +47,37 @@ int persist_load_world(const char *path,
                        world_t *world,
                        server_context_t *ctx_optional);
 
+/**
+ * @brief Read-only mapping of a result file (no copy of the arrays).
+ *
+ * The arrays follow the header and the obstacle map without padding, so they
+ * may be unaligned: read elements with memcpy(). Exactly one of obstacle_bits
+ * (version 3, linear bitmap) and obstacle_bytes (versions 1 and 2) is set.
+ */
+typedef struct {
+    world_size_t size;
+    uint32_t k_max_steps;
+    uint32_t total_reps;
+    const uint8_t *obstacle_bits;
+    const uint8_t *obstacle_bytes;
+    const void *trials;          /**< uint32_t[cell_count] */
+    const void *sum_steps;       /**< uint64_t[cell_count] */
+    const void *success_leq_k;   /**< uint32_t[cell_count] */
+    void *map;
+    size_t map_len;
+} persist_results_map_t;
+
+/**
+ * @brief Map a result file for reading (offline tools over files larger than RAM).
+ *
+ * @return 0 on success, -1 if the file cannot be mapped or is not a valid RWRES file.
+ */
+int persist_map_results(const char *path, persist_results_map_t *out);
+
+/**
+ * @brief Release a mapping of @ref persist_map_results() (safe on a zeroed structure).
+ */
+void persist_unmap_results(persist_results_map_t *m);
+
 #endif //SEMPRACA_PERSIST_H
 
@@ -62,6 +62,24 @@ void rw_rng_init_time_seed(rw_rng_t *rng) {
     rng->initialized = 1;
 }
 
+void rw_rng_seed_stream(rw_rng_t *rng, uint64_t base_seed, uint64_t cell_idx, uint32_t rep) {
+    if (!rng) return;
+    memset(rng, 0, sizeof(*rng));
+
+    /* Two splitmix64 rounds decorrelate neighbouring (cell, rep) pairs. */
+    uint64_t s = base_seed ^ (((uint64_t)rep << 32) | (cell_idx & 0xFFFFFFFFu));
+    s ^= (cell_idx >> 32) * 0x9E3779B97F4A7C15ULL; /* zero for indices < 2^32 */
+    uint64_t seed = splitmix64_next(&s);
+    seed ^= splitmix64_next(&s);
+
+    if (seed == 0) {
+        seed = 0xD1B54A32D192ED03ULL;
+    }
+
+    rng->state = seed;
+    rng->initialized = 1;
+}
+
 double rw_rng_next01(rw_rng_t *rng) {
     if (!rng || !rng->initialized) {
         die("rw_rng_next01: RNG not initialized");
@@ -74,6 +92,23 @@ double rw_rng_next01(rw_rng_t *rng) {
     return (double)top53 * (1.0 / 9007199254740992.0); /* 2^53 */
 }
 
+void rw_rng_fork(rw_rng_t *rng, rw_rng_t *out) {
+    if (!rng || !rng->initialized) {
+        die("rw_rng_fork: RNG not initialized");
+    }
+    if (!out) return;
+
+    uint64_t s = splitmix64_next(&rng->state);
+    uint64_t seed = splitmix64_next(&s);
+    if (seed == 0) {
+        seed = 0xD1B54A32D192ED03ULL;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->state = seed;
+    out->initialized = 1;
+}
+
 void random_walk_run(const world_t *w,
                      pos_t start,
                      move_probs_t probs,
@@ -173,3 +208,155 @@ void random_walk_run(const world_t *w,
     *out_reached_origin = 0;
     *out_success_leq_k = 0;
 }
+
+
+/* One walker of the interleaved kernel. */
+typedef struct {
+    rw_walk_t *walk;
+    pos_t p;
+    pos_t next;      /* candidate cell, drawn one step ahead */
+    uint64_t bit;    /* bitmap position of next (if next_in) */
+    int next_in;     /* next lies inside the world */
+    uint32_t step;   /* steps taken so far */
+} rw_lane_t;
+
+typedef struct {
+    const world_t *w;
+    double c1, c2, c3, c4;
+    uint32_t max_steps;
+    uint32_t width;
+    uint32_t height;
+    int wrap;
+    int linear;
+} rw_batch_t;
+
+/* Direction offsets in the order up, down, left, right. */
+static const int32_t kStepDx[4] = {0, 0, -1, 1};
+static const int32_t kStepDy[4] = {-1, 1, 0, 0};
+
+static void walk_finish(rw_walk_t *walk, uint32_t steps, int reached) {
+    walk->steps = steps;
+    walk->reached_origin = reached;
+    walk->success_leq_k = reached;
+}
+
+/* Draw the next step of the lane and prefetch the obstacle byte it will test.
+ * Same decision as the if-chain of random_walk_run() without its hard to
+ * predict branches (the thresholds are tested in order, so the result does
+ * not depend on the probabilities being non-negative). */
+static void lane_draw(const rw_batch_t *b, rw_lane_t *l) {
+    double r = rw_rng_next01(&l->walk->rng);
+
+    r *= b->c4;
+
+    unsigned past1 = r >= b->c1;
+    unsigned past2 = past1 & (r >= b->c2);
+    unsigned past3 = past2 & (r >= b->c3);
+    unsigned dir = past1 + past2 + past3;
+
+    pos_t next = {l->p.x + kStepDx[dir], l->p.y + kStepDy[dir]};
+
+    //a single step leaves the world by at most one cell
+    if (b->wrap) {
+        if (next.x < 0) next.x += (int32_t)b->width;
+        else if ((uint32_t)next.x >= b->width) next.x = 0;
+        if (next.y < 0) next.y += (int32_t)b->height;
+        else if ((uint32_t)next.y >= b->height) next.y = 0;
+    }
+
+    l->next = next;
+    l->next_in = (uint32_t)next.x < b->width && (uint32_t)next.y < b->height;
+    if (l->next_in) {
+        l->bit = b->linear ? (uint64_t)(uint32_t)next.y * b->width + (uint32_t)next.x
+                           : world_obstacle_bit(b->w, next.x, next.y);
+        __builtin_prefetch(&b->w->obstacle_bits[l->bit >> 3]);
+    }
+}
+
+/* Start @p walk in lane @p l. Returns 0 if the walk finished without a step. */
+static int lane_start(const rw_batch_t *b, rw_lane_t *l, rw_walk_t *walk) {
+    pos_t p = walk->start;
+
+    //same early exits as random_walk_run()
+    if (world_is_obstacle_xy(b->w, p.x, p.y)) {
+        walk_finish(walk, 0, 0);
+        return 0;
+    }
+    if (p.x == 0 && p.y == 0) {
+        walk_finish(walk, 0, 1);
+        return 0;
+    }
+    if (b->c4 <= 0.0 || b->max_steps == 0) {
+        walk_finish(walk, b->max_steps, 0);
+        return 0;
+    }
+
+    l->walk = walk;
+    l->p = p;
+    l->step = 0;
+    lane_draw(b, l);
+    return 1;
+}
+
+void random_walk_run_batch(const world_t *w,
+                           move_probs_t probs,
+                           uint32_t max_steps,
+                           rw_walk_t *walks,
+                           size_t n) {
+    if (!w || !walks) {
+        return;
+    }
+
+    rw_batch_t b;
+    b.w = w;
+    b.c1 = probs.p_up;
+    b.c2 = b.c1 + probs.p_down;
+    b.c3 = b.c2 + probs.p_left;
+    b.c4 = b.c3 + probs.p_right;
+    b.max_steps = max_steps;
+    b.width = (uint32_t)w->size.width;
+    b.height = (uint32_t)w->size.height;
+    b.wrap = w->kind == WORLD_WRAP;
+    b.linear = w->layout == WORLD_LAYOUT_LINEAR;
+
+    rw_lane_t lanes[RW_WALK_INTERLEAVE];
+    int active = 0;
+    size_t next_walk = 0;
+
+    while (active < RW_WALK_INTERLEAVE && next_walk < n) {
+        if (lane_start(&b, &lanes[active], &walks[next_walk++])) {
+            active++;
+        }
+    }
+
+    while (active > 0) {
+        for (int i = 0; i < active; ) {
+            rw_lane_t *l = &lanes[i];
+
+            //obstacle or edge -> stay in place
+            int free_cell = l->next_in && !((w->obstacle_bits[l->bit >> 3] >> (l->bit & 7u)) & 1u);
+            l->p.x = free_cell ? l->next.x : l->p.x;
+            l->p.y = free_cell ? l->next.y : l->p.y;
+            l->step++;
+
+            int reached = l->p.x == 0 && l->p.y == 0;
+            if (!reached && l->step < max_steps) {
+                lane_draw(&b, l);
+                i++;
+                continue;
+            }
+            walk_finish(l->walk, l->step, reached);
+
+            //refill the lane, or drop it and run the last lane in its place
+            int refilled = 0;
+            while (!refilled && next_walk < n) {
+                refilled = lane_start(&b, l, &walks[next_walk++]);
+            }
+            if (refilled) {
+                i++;
+            } else {
+                lanes[i] = lanes[--active];
+            }
+        }
+    }
+}
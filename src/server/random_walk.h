@@ -13,13 +13,31 @@
  * - a small per-instance RNG type (@ref rw_rng_t) intended to be owned by a worker thread
  * - @ref random_walk_run(), which simulates one trajectory until the origin is reached
  *   or a maximum number of steps is exceeded
+ * - @ref random_walk_run_batch(), which simulates many trajectories with the same
+ *   rules, interleaving several of them to overlap obstacle-map cache misses
+ *
+ * Interleaving
+ * ------------
+ * A single walker cannot hide memory latency: every step depends on the
+ * obstacle bit of the cell drawn in that step. The batch kernel keeps
+ * @ref RW_WALK_INTERLEAVE walkers in flight and advances them round-robin. Each
+ * walker draws its next direction one step ahead and prefetches the obstacle
+ * byte of that candidate cell, so by the time its turn comes again the line is
+ * (ideally) already in cache and several misses are outstanding at once.
+ *
+ * Every walk consumes its own RNG in the same order as @ref random_walk_run(),
+ * so both kernels give identical results for the same streams.
  */
 
 #include  "../common/types.h"
 #include "world.h"
 
+#include  <stddef.h>
 #include  <stdint.h>
 
+/** Walks advanced round-robin by @ref random_walk_run_batch(). */
+#define RW_WALK_INTERLEAVE 8
+
 /**
  * @brief Per-thread random number generator state.
  *
@@ -39,6 +57,23 @@ typedef struct {
  */
 void rw_rng_init_time_seed(rw_rng_t *rng);
 
+/**
+ * @brief Initialize RNG state for a deterministic per-(cell, replication) stream.
+ *
+ * Used for common random numbers (CRN): the stream depends only on
+ * (@p base_seed, @p cell_idx, @p rep), so runs that differ only in K or
+ * move probabilities consume identical random sequences for the same walk.
+ *
+ * Streams of cells below index 2^32 are the same as in earlier versions, so
+ * CRN results of existing worlds stay reproducible.
+ *
+ * @param rng       RNG instance to initialize.
+ * @param base_seed Seed shared by all configurations that should be compared.
+ * @param cell_idx  Start cell index (row-major, 64-bit).
+ * @param rep       Replication number.
+ */
+void rw_rng_seed_stream(rw_rng_t *rng, uint64_t base_seed, uint64_t cell_idx, uint32_t rep);
+
 /**
  * @brief Generate a pseudo-random floating-point value in [0, 1).
  *
@@ -47,6 +82,27 @@ void rw_rng_init_time_seed(rw_rng_t *rng);
  */
 double rw_rng_next01(rw_rng_t *rng);
 
+/**
+ * @brief Seed @p out from the next output of @p rng.
+ *
+ * Used to give each walk of a batch its own stream when CRN is off.
+ *
+ * @param rng Initialized parent RNG (advanced by one draw).
+ * @param out RNG to initialize.
+ */
+void rw_rng_fork(rw_rng_t *rng, rw_rng_t *out);
+
+/**
+ * @brief One walk of a batch (see @ref random_walk_run_batch()).
+ */
+typedef struct {
+    pos_t start;         /**< Starting position. */
+    rw_rng_t rng;        /**< Stream of this walk, seeded by the caller. */
+    uint32_t steps;      /**< Output: steps taken. */
+    int reached_origin;  /**< Output: reached origin flag. */
+    int success_leq_k;   /**< Output: success-within-K flag. */
+} rw_walk_t;
+
 /**
  * @brief Simulate one random-walk trajectory.
  *
@@ -83,5 +139,23 @@ void random_walk_run(const world_t *w,
                     int *out_reached_origin,
                     int *out_success_leq_k);
 
+/**
+ * @brief Simulate a batch of independent trajectories (see "Interleaving").
+ *
+ * Each element of @p walks gets exactly the outputs @ref random_walk_run()
+ * would produce for its start and RNG.
+ *
+ * @param w         World.
+ * @param probs     Movement probabilities.
+ * @param max_steps Maximum number of steps per walk.
+ * @param walks     Walks to run; outputs are written in place.
+ * @param n         Number of walks.
+ */
+void random_walk_run_batch(const world_t *w,
+                           move_probs_t probs,
+                           uint32_t max_steps,
+                           rw_walk_t *walks,
+                           size_t n);
+
 #endif //SEMPRACA_RANDOM_WALK_H
 
@@ -0,0 +1,194 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#include "region_stats.h"
+#include "scheduler.h"
+
+#include "../common/util.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file region_stats.c
+ * @brief Implementation of the summed-area tables.
+ */
+
+/* Sums over [0, x) x [0, y) of the three counters. */
+typedef struct {
+    uint64_t trials;
+    uint64_t successes;
+    uint64_t sum_steps;
+} sat_entry_t;
+
+/* The tables of one results version, (W + 1) x (H + 1) entries; row and column 0 are zero. */
+typedef struct {
+    const results_t *results;
+    uint64_t version;
+    world_size_t size;
+    sat_entry_t *tab;
+} sat_t;
+
+/* One table at a time; queries hold the mutex (a rebuild makes the others wait). */
+static sat_t g_sat;
+static pthread_mutex_t g_sat_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct {
+    const results_t *r;
+    sat_t *sat;
+    uint64_t lo, hi;      /* pass 1: rows [lo, hi); pass 2: columns [lo, hi) */
+    int pass;
+    sched_task_t task;
+} sat_task_t;
+
+static void sat_task_main(void *arg) {
+    sat_task_t *t = (sat_task_t *)arg;
+    const uint64_t w = (uint64_t)t->sat->size.width, h = (uint64_t)t->sat->size.height;
+    const uint64_t stride = w + 1u;
+    sat_entry_t *tab = t->sat->tab;
+
+    if (t->pass == 1) {
+        /* prefix sums along each row */
+        const uint32_t *trials = results_trials(t->r);
+        const uint32_t *succ = results_success_leq_k(t->r);
+        const uint64_t *steps = results_sum_steps(t->r);
+        for (uint64_t y = t->lo; y < t->hi; y++) {
+            sat_entry_t acc = {0, 0, 0};
+            sat_entry_t *row = tab + (y + 1u) * stride;
+            const uint64_t base = y * w;
+            row[0] = acc;
+            for (uint64_t x = 0; x < w; x++) {
+                acc.trials += trials[base + x];
+                acc.successes += succ[base + x];
+                acc.sum_steps += steps[base + x];
+                row[x + 1u] = acc;
+            }
+        }
+        return;
+    }
+
+    /* add the row above, top to bottom, within a stripe of columns */
+    for (uint64_t y = 2; y <= h; y++) {
+        const sat_entry_t *above = tab + (y - 1u) * stride;
+        sat_entry_t *row = tab + y * stride;
+        for (uint64_t x = t->lo; x < t->hi; x++) {
+            row[x].trials += above[x].trials;
+            row[x].successes += above[x].successes;
+            row[x].sum_steps += above[x].sum_steps;
+        }
+    }
+}
+
+/* Split [0, n) into nthreads ranges and run one pass (CONTROL class); the calling thread takes range 0. */
+static void run_pass(sat_task_t *tasks, int nthreads, int pass, uint64_t n) {
+    sched_group_t g;
+    sched_group_init(&g);
+    for (int i = 0; i < nthreads; i++) {
+        tasks[i].pass = pass;
+        tasks[i].lo = n * (uint64_t)i / (uint64_t)nthreads;
+        tasks[i].hi = n * (uint64_t)(i + 1) / (uint64_t)nthreads;
+    }
+    for (int i = 1; i < nthreads; i++) {
+        scheduler_submit(SCHED_CONTROL, &tasks[i].task, sat_task_main, &tasks[i], &g);
+    }
+    sat_task_main(&tasks[0]);
+    sched_group_wait(&g);
+    sched_group_destroy(&g);
+}
+
+/* Build the tables of @p r (called with g_sat_mtx held). */
+static int sat_build_locked(const results_t *r, uint64_t version, int nthreads) {
+    const world_size_t size = results_size(r);
+    const uint64_t w = (uint64_t)size.width, h = (uint64_t)size.height;
+    const uint64_t entries = (w + 1u) * (h + 1u);
+
+    if (!g_sat.tab || g_sat.size.width != size.width || g_sat.size.height != size.height) {
+        free(g_sat.tab);
+        memset(&g_sat, 0, sizeof(g_sat));
+        g_sat.tab = (sat_entry_t *)malloc(sizeof(sat_entry_t) * (size_t)entries);
+        if (!g_sat.tab) {
+            log_error("region_stats: cannot allocate %llu table entries", (unsigned long long)entries);
+            return -1;
+        }
+        g_sat.size = size;
+    }
+    g_sat.results = NULL; /* invalid until complete */
+    memset(g_sat.tab, 0, sizeof(sat_entry_t) * (size_t)(w + 1u));
+
+    if (nthreads <= 0) nthreads = 1;
+    if ((uint64_t)nthreads > h) nthreads = (int)h;
+    sat_task_t *tasks = (sat_task_t *)calloc((size_t)nthreads, sizeof(*tasks));
+    if (!tasks) {
+        return -1;
+    }
+    for (int i = 0; i < nthreads; i++) {
+        tasks[i].r = r;
+        tasks[i].sat = &g_sat;
+    }
+    run_pass(tasks, nthreads, 1, h);
+    run_pass(tasks, nthreads, 2, w + 1u);
+    free(tasks);
+
+    g_sat.results = r;
+    g_sat.version = version;
+    log_debug("region_stats: tables rebuilt for %dx%d (version %llu)", size.width, size.height,
+              (unsigned long long)version);
+    return 0;
+}
+
+static const sat_entry_t *sat_at(uint64_t x, uint64_t y) {
+    return &g_sat.tab[y * ((uint64_t)g_sat.size.width + 1u) + x];
+}
+
+int region_stats_query(const results_t *results,
+                       const world_region_t *rects,
+                       uint32_t count,
+                       int nthreads,
+                       region_stat_t *out,
+                       uint64_t *out_version) {
+    if (!results || (count > 0 && (!rects || !out))) return -1;
+    const world_size_t size = results_size(results);
+    if (size.width <= 0 || size.height <= 0) return -1;
+    if ((uint64_t)size.width * (uint64_t)size.height > REGION_STATS_MAX_CELLS) {
+        log_error("region_stats: %dx%d world exceeds %llu cells", size.width, size.height,
+                  (unsigned long long)REGION_STATS_MAX_CELLS);
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_sat_mtx);
+    /* version first: changes made during the build show up as a newer version */
+    const uint64_t version = results_version(results);
+    if (g_sat.results != results || g_sat.version != version ||
+        g_sat.size.width != size.width || g_sat.size.height != size.height) {
+        if (sat_build_locked(results, version, nthreads) != 0) {
+            pthread_mutex_unlock(&g_sat_mtx);
+            return -1;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        memset(&out[i], 0, sizeof(out[i]));
+        int64_t x0 = rects[i].x, y0 = rects[i].y;
+        int64_t x1 = x0 + rects[i].size.width, y1 = y0 + rects[i].size.height;
+        if (x0 < 0) x0 = 0;
+        if (y0 < 0) y0 = 0;
+        if (x1 > size.width) x1 = size.width;
+        if (y1 > size.height) y1 = size.height;
+        if (x0 >= x1 || y0 >= y1) continue;
+
+        const sat_entry_t *a = sat_at((uint64_t)x0, (uint64_t)y0);
+        const sat_entry_t *b = sat_at((uint64_t)x1, (uint64_t)y0);
+        const sat_entry_t *c = sat_at((uint64_t)x0, (uint64_t)y1);
+        const sat_entry_t *d = sat_at((uint64_t)x1, (uint64_t)y1);
+        out[i].cells = (uint64_t)(x1 - x0) * (uint64_t)(y1 - y0);
+        out[i].trials = d->trials - b->trials - c->trials + a->trials;
+        out[i].successes = d->successes - b->successes - c->successes + a->successes;
+        out[i].sum_steps = d->sum_steps - b->sum_steps - c->sum_steps + a->sum_steps;
+    }
+    pthread_mutex_unlock(&g_sat_mtx);
+
+    if (out_version) *out_version = version;
+    return 0;
+}
@@ -0,0 +1,70 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_REGION_STATS_H
+#define SEMPRACA_REGION_STATS_H
+
+/**
+ * @file region_stats.h
+ * @brief Pooled statistics of rectangles in O(1) each (summed-area tables).
+ *
+ * For trials, success_leq_k and sum_steps the server keeps a summed-area
+ * table: entry (x, y) holds the sum over all cells left of and above it, so
+ * the sum over any rectangle is
+ * @code
+ * S(x1, y1) - S(x0, y1) - S(x1, y0) + S(x0, y0)
+ * @endcode
+ * four lookups, independent of the rectangle size.
+ *
+ * The tables are built on demand: a query against a results version the
+ * tables were not built from rebuilds them first (O(cells), in parallel: rows
+ * are prefix-summed by row bands, then columns by column stripes). While
+ * nothing changes, any number of queries reuse them. Sums are unsigned 64-bit
+ * and wrap around; a rectangle sum is exact as long as it fits 64 bits itself.
+ *
+ * Memory: 24 bytes per cell (one entry of three sums), so the tables are only
+ * built for worlds up to @ref REGION_STATS_MAX_CELLS cells.
+ */
+
+#include "world.h"
+#include "results.h"
+
+#include <stdint.h>
+
+/** Largest world (cells) the tables are built for (~1.6 GB of tables). */
+#define REGION_STATS_MAX_CELLS (1ull << 26)
+
+/**
+ * @brief Pooled counters of one rectangle (clipped to the world).
+ */
+typedef struct {
+    uint64_t cells;
+    uint64_t trials;
+    uint64_t successes;
+    uint64_t sum_steps;
+} region_stat_t;
+
+/**
+ * @brief Answer a batch of rectangle queries.
+ *
+ * Rectangles are clipped to the world; one outside it has zero cells.
+ *
+ * @param results     Results to aggregate.
+ * @param rects       Rectangles (width/height 0 = empty).
+ * @param count       Number of rectangles.
+ * @param nthreads    Parallel parts of a rebuild (<= 0 means 1); all but one
+ *                    run as @ref SCHED_CONTROL tasks.
+ * @param out         count results.
+ * @param out_version Optional: results version the answers come from.
+ * @return 0 on success, -1 on invalid arguments, a world larger than
+ *         @ref REGION_STATS_MAX_CELLS or allocation failure.
+ */
+int region_stats_query(const results_t *results,
+                       const world_region_t *rects,
+                       uint32_t count,
+                       int nthreads,
+                       region_stat_t *out,
+                       uint64_t *out_version);
+
+#endif //SEMPRACA_REGION_STATS_H
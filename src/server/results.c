@@ -7,15 +7,61 @@
  * @brief Implementation of per-tile statistics storage.
  */
 
+#define _DEFAULT_SOURCE /* MAP_ANONYMOUS, MAP_NORESERVE, madvise() */
+
 #include "results.h"
 
 #include "../common/util.h"
 
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+
+/* Source of results versions; shared by all instances so values never repeat. */
+static _Atomic uint64_t g_version_seq;
+
+/* Version of the next change (taken with r->mtx held, or before r is shared). */
+static uint64_t next_version(void) {
+    return atomic_fetch_add_explicit(&g_version_seq, 1u, memory_order_relaxed) + 1u;
+}
+
+/* Make change @p v visible; block marks stored before are visible with it. */
+static void publish_version(results_t *r, uint64_t v) {
+    atomic_store_explicit(&r->version, v, memory_order_release);
+}
 
-static uint32_t cell_count_from_size(world_size_t s) {
-    return s.width * s.height;
+static void mark_range(results_t *r, uint64_t offset, uint64_t count, uint64_t v) {
+    if (count == 0) return;
+    uint64_t b1 = (offset + count - 1u) / RESULTS_BLOCK_CELLS;
+    for (uint64_t b = offset / RESULTS_BLOCK_CELLS; b <= b1; b++) {
+        atomic_store_explicit(&r->block_version[b], v, memory_order_relaxed);
+    }
+}
+
+static void mark_all(results_t *r, uint64_t v) {
+    atomic_store_explicit(&r->reset_version, v, memory_order_relaxed);
+}
+
+static uint64_t cell_count_from_size(world_size_t s) {
+    return (uint64_t)(uint32_t)s.width * (uint64_t)(uint32_t)s.height;
+}
+
+/* Zero-filled array whose pages are committed lazily on first write. */
+static void *lazy_alloc(uint64_t bytes) {
+    void *p = mmap(NULL, (size_t)bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+static void lazy_free(void *p, uint64_t bytes) {
+    if (p) munmap(p, (size_t)bytes);
+}
+
+/* Reset to zero and give the pages back (private anonymous mapping). */
+static void lazy_zero(void *p, uint64_t bytes) {
+    if (p && madvise(p, (size_t)bytes, MADV_DONTNEED) != 0) {
+        memset(p, 0, (size_t)bytes);
+    }
 }
 
 int results_init(results_t *r, world_size_t size) {
@@ -26,23 +72,24 @@ int results_init(results_t *r, world_size_t size) {
     r->size = size;
     r->cell_count = cell_count_from_size(size);
 
-    r->trials = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)r->cell_count);
-    r->sum_steps = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)r->cell_count);
-    r->success_leq_k = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)r->cell_count);
+    r->trials = (uint32_t*)lazy_alloc(sizeof(uint32_t) * r->cell_count);
+    r->sum_steps = (uint64_t*)lazy_alloc(sizeof(uint64_t) * r->cell_count);
+    r->success_leq_k = (uint32_t*)lazy_alloc(sizeof(uint32_t) * r->cell_count);
+    r->block_count = (r->cell_count + RESULTS_BLOCK_CELLS - 1u) / RESULTS_BLOCK_CELLS;
+    r->block_version = (_Atomic uint64_t *)lazy_alloc(sizeof(uint64_t) * r->block_count);
 
-    if (!r->trials || !r->sum_steps || !r->success_leq_k) {
+    if (!r->trials || !r->sum_steps || !r->success_leq_k || !r->block_version) {
         results_destroy(r);
         return -1;
     }
 
-    memset(r->trials, 0, sizeof(uint32_t) * (size_t)r->cell_count);
-    memset(r->sum_steps, 0, sizeof(uint64_t) * (size_t)r->cell_count);
-    memset(r->success_leq_k, 0, sizeof(uint32_t) * (size_t)r->cell_count);
-
     if (pthread_mutex_init(&r->mtx, NULL) != 0) {
         results_destroy(r);
         return -1;
     }
+    uint64_t v = next_version();
+    mark_all(r, v);
+    publish_version(r, v);
     return 0;
 }
 
@@ -56,13 +103,18 @@ void results_destroy(results_t *r) {
      */
     (void)pthread_mutex_destroy(&r->mtx);
 
-    free(r->trials);
-    free(r->sum_steps);
-    free(r->success_leq_k);
+    lazy_free(r->trials, sizeof(uint32_t) * r->cell_count);
+    lazy_free(r->sum_steps, sizeof(uint64_t) * r->cell_count);
+    lazy_free(r->success_leq_k, sizeof(uint32_t) * r->cell_count);
+    lazy_free((void *)r->block_version, sizeof(uint64_t) * r->block_count);
+    results_hit_time_release(r->hit_time);
 
+    r->block_version = NULL;
+    r->block_count = 0;
     r->trials = NULL;
     r->sum_steps = NULL;
     r->success_leq_k = NULL;
+    r->hit_time = NULL;
 
     r->cell_count = 0;
     r->size.width = 0;
@@ -73,32 +125,168 @@ void results_clear(results_t *r) {
     if (!r) return;
 
     pthread_mutex_lock(&r->mtx);
-    memset(r->trials, 0, sizeof(uint32_t) * (size_t)r->cell_count);
-    memset(r->sum_steps, 0, sizeof(uint64_t) * (size_t)r->cell_count);
-    memset(r->success_leq_k, 0, sizeof(uint32_t) * (size_t)r->cell_count);
+    lazy_zero(r->trials, sizeof(uint32_t) * r->cell_count);
+    lazy_zero(r->sum_steps, sizeof(uint64_t) * r->cell_count);
+    lazy_zero(r->success_leq_k, sizeof(uint32_t) * r->cell_count);
+    uint64_t v = next_version();
+    mark_all(r, v);
+    publish_version(r, v);
+    pthread_mutex_unlock(&r->mtx);
+}
+
+void results_mark_all(results_t *r) {
+    if (!r) return;
+
+    pthread_mutex_lock(&r->mtx);
+    uint64_t v = next_version();
+    mark_all(r, v);
+    publish_version(r, v);
+    pthread_mutex_unlock(&r->mtx);
+}
+
+int results_clear_cells(results_t *r, const uint64_t *cells, uint64_t count) {
+    if (!r || (count > 0 && !cells)) return -1;
+    for (uint64_t i = 0; i < count; i++) {
+        if (cells[i] >= r->cell_count) return -1;
+    }
+
+    pthread_mutex_lock(&r->mtx);
+    uint64_t v = next_version();
+    for (uint64_t i = 0; i < count; i++) {
+        const uint64_t c = cells[i];
+        r->trials[c] = 0;
+        r->sum_steps[c] = 0;
+        r->success_leq_k[c] = 0;
+        mark_range(r, c, 1, v);
+    }
+    publish_version(r, v);
+    pthread_mutex_unlock(&r->mtx);
+    return 0;
+}
+
+void results_clear_range(results_t *r, uint64_t offset, uint64_t count) {
+    if (!r || offset >= r->cell_count) return;
+    if (count > r->cell_count - offset) count = r->cell_count - offset;
+
+    pthread_mutex_lock(&r->mtx);
+    memset(r->trials + offset, 0, sizeof(uint32_t) * (size_t)count);
+    memset(r->sum_steps + offset, 0, sizeof(uint64_t) * (size_t)count);
+    memset(r->success_leq_k + offset, 0, sizeof(uint32_t) * (size_t)count);
+    uint64_t v = next_version();
+    mark_range(r, offset, count, v);
+    publish_version(r, v);
+    pthread_mutex_unlock(&r->mtx);
+}
+
+int results_merge_range(results_t *r,
+                        uint64_t offset,
+                        uint64_t count,
+                        const uint32_t *trials,
+                        const uint64_t *sum_steps,
+                        const uint32_t *success_leq_k) {
+    if (!r || !trials || !sum_steps || !success_leq_k) return -1;
+    if (offset > r->cell_count || count > r->cell_count - offset) return -1;
+
+    pthread_mutex_lock(&r->mtx);
+    for (uint64_t i = 0; i < count; i++) {
+        r->trials[offset + i] += trials[i];
+        r->sum_steps[offset + i] += sum_steps[i];
+        r->success_leq_k[offset + i] += success_leq_k[i];
+    }
+    uint64_t v = next_version();
+    mark_range(r, offset, count, v);
+    publish_version(r, v);
     pthread_mutex_unlock(&r->mtx);
+    return 0;
+}
+
+void results_set_hit_time(results_t *r, double *hit_time) {
+    if (!r) {
+        free(hit_time);
+        return;
+    }
+
+    results_hit_time_t *h = NULL;
+    if (hit_time) {
+        h = (results_hit_time_t *)malloc(sizeof(*h));
+        if (!h) {
+            //dropping the new array is still consistent: the old one is invalidated below
+            log_error("results_set_hit_time: out of memory");
+            free(hit_time);
+        } else {
+            atomic_init(&h->refs, 1u);
+            h->values = hit_time;
+        }
+    }
+
+    pthread_mutex_lock(&r->mtx);
+    results_hit_time_t *old = r->hit_time;
+    r->hit_time = h;
+    uint64_t v = next_version();
+    if (old || h) mark_all(r, v);
+    publish_version(r, v);
+    pthread_mutex_unlock(&r->mtx);
+
+    results_hit_time_release(old);
+}
+
+const results_hit_time_t *results_hit_time_acquire(const results_t *r) {
+    if (!r) return NULL;
+
+    //the mutex is not part of the logical state: locking it through a const view is fine
+    pthread_mutex_t *mtx = (pthread_mutex_t *)&r->mtx;
+    pthread_mutex_lock(mtx);
+    results_hit_time_t *h = r->hit_time;
+    if (h) atomic_fetch_add_explicit(&h->refs, 1u, memory_order_relaxed);
+    pthread_mutex_unlock(mtx);
+    return h;
+}
+
+void results_hit_time_release(const results_hit_time_t *h) {
+    if (!h) return;
+
+    results_hit_time_t *m = (results_hit_time_t *)h;
+    if (atomic_fetch_sub_explicit(&m->refs, 1u, memory_order_acq_rel) == 1u) {
+        free(m->values);
+        free(m);
+    }
 }
 
 void results_update(
     results_t *r,
-    uint32_t idx,
+    uint64_t idx,
     uint32_t steps,
     int reached_origin,
     int success_leq_k) {
-    if (!r) return;
-    if (idx >= r->cell_count) return;
-
-    pthread_mutex_lock(&r->mtx);
+    results_trial_t t = {idx, steps, (uint8_t)(reached_origin != 0), (uint8_t)(success_leq_k != 0)};
+    results_update_batch(r, &t, 1);
+}
 
-    r->trials[idx] += 1;
+void results_update_batch(results_t *r, const results_trial_t *trials, uint32_t n) {
+    if (!r || !trials || n == 0) return;
 
-    if (reached_origin) {
-        r->sum_steps[idx] += (uint64_t)steps;
-    }
+    pthread_mutex_lock(&r->mtx);
+    //one version per batch: a global counter bump per walk made the merge contend
+    uint64_t v = next_version();
+    uint64_t last_block = UINT64_MAX;
+    for (uint32_t i = 0; i < n; i++) {
+        const uint64_t idx = trials[i].idx;
+        if (idx >= r->cell_count) continue;
 
-    if (success_leq_k) {
-        r->success_leq_k[idx] += 1;
+        r->trials[idx] += 1;
+        if (trials[i].reached_origin) {
+            r->sum_steps[idx] += (uint64_t)trials[i].steps;
+        }
+        if (trials[i].success_leq_k) {
+            r->success_leq_k[idx] += 1;
+        }
+        const uint64_t b = idx / RESULTS_BLOCK_CELLS;
+        if (b != last_block) {
+            atomic_store_explicit(&r->block_version[b], v, memory_order_relaxed);
+            last_block = b;
+        }
     }
+    publish_version(r, v);
     pthread_mutex_unlock(&r->mtx);
 }
 
@@ -113,7 +301,24 @@ const uint32_t *results_success_leq_k(const results_t *r) {
     return r ? r->success_leq_k : NULL;
 }
 
-uint32_t results_cell_count(const results_t *r) {
+uint64_t results_version(const results_t *r) {
+    return r ? atomic_load_explicit(&r->version, memory_order_acquire) : 0;
+}
+
+int results_changed_since(const results_t *r, uint64_t since, uint64_t offset, uint64_t count) {
+    if (!r || !r->block_version) return 1;
+    if (atomic_load_explicit(&r->reset_version, memory_order_relaxed) > since) return 1;
+    if (count == 0 || offset >= r->cell_count) return 0;
+    if (count > r->cell_count - offset) count = r->cell_count - offset;
+
+    uint64_t b1 = (offset + count - 1u) / RESULTS_BLOCK_CELLS;
+    for (uint64_t b = offset / RESULTS_BLOCK_CELLS; b <= b1; b++) {
+        if (atomic_load_explicit(&r->block_version[b], memory_order_relaxed) > since) return 1;
+    }
+    return 0;
+}
+
+uint64_t results_cell_count(const results_t *r) {
     return r ? r->cell_count : 0;
 }
 
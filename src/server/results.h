@@ -23,11 +23,28 @@
  * @note Results are stored on the server; the client retrieves them via IPC
  *       when needed.
  *
+ * Memory
+ * ------
+ * The counter arrays are reserved as anonymous mappings without swap
+ * reservation (MAP_NORESERVE): pages are only committed when a cell in them is
+ * first updated, and @ref results_clear() returns them to the kernel. A world
+ * with billions of cells whose simulation is restricted to a small region
+ * therefore only uses memory proportional to that region.
+ *
  * Threading
  * ---------
  * Updates are protected by an internal mutex so that multiple worker threads can
  * call @ref results_update() concurrently.
  *
+ * Every change of the contents (update, clear, merge, hit times, re-init) gives
+ * the results a new @ref results_version(). Versions are unique within the
+ * process, so a cache keyed by the version never mistakes re-initialized
+ * results for the old ones.
+ *
+ * Besides the global version, every block of @ref RESULTS_BLOCK_CELLS cells
+ * remembers the version of its last change, so @ref results_changed_since()
+ * can tell which cells differ from an earlier version (delta snapshots).
+ *
  * The pointer-returning getters (e.g. @ref results_trials()) expose the internal
  * arrays. They do not take the mutex and do not provide a consistent snapshot.
  * If you need a consistent view, synchronize externally with the same lifetime
@@ -36,14 +53,42 @@
 
 #include "../common/types.h"
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 
+/**
+ * @brief Reference-counted expected hitting time array.
+ *
+ * Replacing the array (@ref results_set_hit_time()) only drops the reference
+ * of the results structure; the values are freed by the last reader.
+ */
+typedef struct {
+    /** One reference held by @ref results_t, one per reader. */
+    _Atomic uint32_t refs;
+
+    /** Length: @ref results_t::cell_count. */
+    double *values;
+} results_hit_time_t;
+
+/**
+ * @brief Outcome of one trial, see @ref results_update_batch().
+ */
+typedef struct {
+    uint64_t idx;            /**< Tile index in row-major order. */
+    uint32_t steps;          /**< Steps of the trial. */
+    uint8_t reached_origin;  /**< Non-zero: add @ref steps to @c sum_steps. */
+    uint8_t success_leq_k;   /**< Non-zero: count a success within K. */
+} results_trial_t;
+
+/** Cells per change-tracking block (see @ref results_changed_since()). */
+#define RESULTS_BLOCK_CELLS 4096u
+
 typedef struct {
     /** World dimensions for which these results were allocated. */
     world_size_t size;
 
-    /** Total number of cells (size.width * size.height). */
-    uint32_t cell_count;
+    /** Total number of cells (size.width * size.height, 64-bit). */
+    uint64_t cell_count;
 
     /**
      * Number of trials that ended in each cell.
@@ -69,8 +114,24 @@ typedef struct {
      */
     uint32_t *success_leq_k;
 
+    /**
+     * Expected hitting time of the origin per cell (see hitting_time.h), or NULL
+     * if it has not been computed for the current world/probabilities.
+     * Readers hold a reference (@ref results_hit_time_acquire()).
+     */
+    results_hit_time_t *hit_time;
+
     /** Mutex protecting updates/clears of the arrays above. */
     pthread_mutex_t mtx;
+
+    /** Content version, see @ref results_version(). */
+    _Atomic uint64_t version;
+
+    /** Version of the last change of each block of @ref RESULTS_BLOCK_CELLS cells. */
+    _Atomic uint64_t *block_version;
+    uint64_t block_count;
+    /** Version of the last change of all cells at once (init, clear, hit times). */
+    _Atomic uint64_t reset_version;
 } results_t;
 
 /**
@@ -102,6 +163,87 @@ void results_destroy(results_t *r);
  */
 void results_clear(results_t *r);
 
+/**
+ * @brief Publish a new version covering every tile.
+ *
+ * For code that fills the arrays directly (e.g. loading a results file);
+ * cached snapshots and region statistics are rebuilt afterwards.
+ *
+ * @param r Results structure (may be NULL).
+ */
+void results_mark_all(results_t *r);
+
+/**
+ * @brief Reset the counters of selected tiles to 0.
+ *
+ * Work is proportional to @p count, not to the world size.
+ *
+ * @param r     Results structure.
+ * @param cells Linear indices of the tiles to clear; all others are kept.
+ * @param count Number of entries in @p cells.
+ * @return 0 on success, -1 on invalid arguments (an index out of range; nothing is cleared).
+ */
+int results_clear_cells(results_t *r, const uint64_t *cells, uint64_t count);
+
+/**
+ * @brief Reset the counters of tiles [offset, offset + count) to 0.
+ *
+ * @param r      Results structure (may be NULL).
+ * @param offset First tile.
+ * @param count  Number of tiles (clamped to the cell count).
+ */
+void results_clear_range(results_t *r, uint64_t offset, uint64_t count);
+
+/**
+ * @brief Add per-tile counters of tiles [offset, offset + count).
+ *
+ * Used to merge partial results computed elsewhere (e.g. by a worker process).
+ *
+ * @param r             Results structure.
+ * @param offset        First tile.
+ * @param count         Number of tiles.
+ * @param trials        Trials to add (length @p count).
+ * @param sum_steps     Step sums to add (length @p count).
+ * @param success_leq_k Successes to add (length @p count).
+ * @return 0 on success, -1 if the range is out of bounds.
+ */
+int results_merge_range(results_t *r,
+                        uint64_t offset,
+                        uint64_t count,
+                        const uint32_t *trials,
+                        const uint64_t *sum_steps,
+                        const uint32_t *success_leq_k);
+
+/**
+ * @brief Install a new expected hitting time array (takes ownership).
+ *
+ * Replaces the previous array (freed once no reader holds it). Pass NULL to
+ * invalidate it, e.g. after the world or the movement probabilities changed.
+ *
+ * @param r        Results structure.
+ * @param hit_time Heap array of length @ref results_cell_count(), or NULL.
+ */
+void results_set_hit_time(results_t *r, double *hit_time);
+
+/**
+ * @brief Take a reference to the current expected hitting time array.
+ *
+ * The array stays valid until @ref results_hit_time_release(), even if it is
+ * replaced or invalidated in the meantime.
+ *
+ * @param r Results structure.
+ * @return Reference (values of length @ref results_cell_count()), or NULL if
+ *         not computed.
+ */
+const results_hit_time_t *results_hit_time_acquire(const results_t *r);
+
+/**
+ * @brief Drop a reference taken by @ref results_hit_time_acquire().
+ *
+ * @param h Reference (may be NULL).
+ */
+void results_hit_time_release(const results_hit_time_t *h);
+
 /**
  * @brief Update statistics for one tile.
  *
@@ -118,11 +260,24 @@ void results_clear(results_t *r);
  */
 void results_update(
     results_t *r,
-    uint32_t idx,
+    uint64_t idx,
     uint32_t steps,
     int reached_origin,
     int success_leq_k);
 
+/**
+ * @brief Add the outcomes of @p n trials as one change.
+ *
+ * Same as @ref results_update() per trial, but the mutex is taken once and the
+ * whole batch gets a single version; trials with an index outside the results
+ * are skipped.
+ *
+ * @param r      Results structure.
+ * @param trials Outcomes (any order, indices may repeat).
+ * @param n      Number of outcomes.
+ */
+void results_update_batch(results_t *r, const results_trial_t *trials, uint32_t n);
+
 /**
  * @brief Get the trials array (internal storage).
  * @param r Results structure.
@@ -147,12 +302,39 @@ const uint64_t *results_sum_steps(const results_t *r);
  */
 const uint32_t *results_success_leq_k(const results_t *r);
 
+/**
+ * @brief Get the content version of the results.
+ *
+ * The value changes (to a process-wide unique number) whenever the arrays or
+ * the hit times change, and stays the same while nothing touches them.
+ *
+ * @param r Results structure.
+ * @return Version, or 0 if @p r is NULL.
+ */
+uint64_t results_version(const results_t *r);
+
+/**
+ * @brief Check whether cells [offset, offset + count) may have changed after
+ *        version @p since.
+ *
+ * Block granular: a change of any cell in a block reports the whole block.
+ * Every change up to the value @ref results_version() returned before this
+ * call is seen.
+ *
+ * @param r      Results structure.
+ * @param since  Earlier @ref results_version() value.
+ * @param offset First cell.
+ * @param count  Number of cells.
+ * @return 1 if changed (or unknown), 0 if all cells are unchanged.
+ */
+int results_changed_since(const results_t *r, uint64_t since, uint64_t offset, uint64_t count);
+
 /**
  * @brief Get the number of cells tracked by these results.
  * @param r Results structure.
  * @return cell count, or 0 if @p r is NULL.
  */
-uint32_t results_cell_count(const results_t *r);
+uint64_t results_cell_count(const results_t *r);
 
 /**
  * @brief Get the world size associated with these results.
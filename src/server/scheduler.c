@@ -0,0 +1,301 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
+#include "scheduler.h"
+
+#include "trace.h"
+
+#include "../common/util.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @file scheduler.c
+ * @brief Implementation of the priority task scheduler.
+ */
+
+/* FIFO of one class plus its counters. */
+typedef struct {
+    sched_task_t *head, *tail;
+    uint32_t running;
+    uint64_t done;
+    uint64_t wait_ns;      /* total time tasks spent queued */
+    uint64_t max_wait_ns;
+} sched_queue_t;
+
+static struct {
+    pthread_mutex_t mtx;
+    pthread_cond_t cv;
+    pthread_t *threads;
+    int nthreads;
+    int stop;
+    sched_queue_t q[SCHED_NCLASSES];
+} g_sched = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, 0, 0, {{0}} };
+
+/* Set on scheduler threads: a wait there runs the group's queued tasks itself. */
+static _Thread_local int t_sched_thread;
+
+static const char *const kClassNames[SCHED_NCLASSES] = {"control", "snapshot", "sim", "background"};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Background tasks leave one thread to the shorter classes. */
+static uint32_t background_cap(void) {
+    return g_sched.nthreads > 1 ? (uint32_t)g_sched.nthreads - 1u : 1u;
+}
+
+static int queues_empty_locked(void) {
+    for (int c = 0; c < SCHED_NCLASSES; c++) {
+        if (g_sched.q[c].head) return 0;
+    }
+    return 1;
+}
+
+/* Oldest task of the highest class allowed to run now, or NULL. */
+static sched_task_t *pick_locked(void) {
+    for (int c = 0; c < SCHED_NCLASSES; c++) {
+        sched_queue_t *q = &g_sched.q[c];
+        if (!q->head) continue;
+        if (c == SCHED_BACKGROUND && q->running >= background_cap()) continue;
+
+        sched_task_t *t = q->head;
+        q->head = t->next;
+        if (!q->head) q->tail = NULL;
+        t->next = NULL;
+        return t;
+    }
+    return NULL;
+}
+
+static void group_done(sched_group_t *g) {
+    pthread_mutex_lock(&g->mtx);
+    if (--g->pending == 0) {
+        pthread_cond_broadcast(&g->cv);
+    }
+    pthread_mutex_unlock(&g->mtx);
+}
+
+/* Oldest queued task of group @p g in any class, unlinked, or NULL. */
+static sched_task_t *take_group_task_locked(const sched_group_t *g) {
+    for (int c = 0; c < SCHED_NCLASSES; c++) {
+        sched_queue_t *q = &g_sched.q[c];
+        sched_task_t *prev = NULL;
+        for (sched_task_t *t = q->head; t; prev = t, t = t->next) {
+            if (t->group != g) continue;
+            if (prev) prev->next = t->next;
+            else q->head = t->next;
+            if (q->tail == t) q->tail = prev;
+            t->next = NULL;
+            return t;
+        }
+    }
+    return NULL;
+}
+
+/* Run @p t (already unlinked); called and returns with the scheduler mutex held. */
+static void run_task_locked(sched_task_t *t) {
+    /* the node may be resubmitted by fn: read it first */
+    const sched_class_t cls = t->cls;
+    sched_fn_t fn = t->fn;
+    void *fn_arg = t->arg;
+    sched_group_t *group = t->group;
+
+    sched_queue_t *q = &g_sched.q[cls];
+    uint64_t waited = now_ns() - t->enqueued_ns;
+    q->wait_ns += waited;
+    if (waited > q->max_wait_ns) q->max_wait_ns = waited;
+    q->running++;
+    pthread_mutex_unlock(&g_sched.mtx);
+
+    fn(fn_arg);
+    if (group) group_done(group);
+
+    pthread_mutex_lock(&g_sched.mtx);
+    q->running--;
+    q->done++;
+    //a capped background task may run now
+    if (cls == SCHED_BACKGROUND && q->head) {
+        pthread_cond_signal(&g_sched.cv);
+    }
+}
+
+static void *sched_thread_main(void *arg) {
+    (void)arg;
+    trace_thread_name("sched");
+    t_sched_thread = 1;
+
+    pthread_mutex_lock(&g_sched.mtx);
+    while (1) {
+        sched_task_t *t = pick_locked();
+        if (!t) {
+            if (g_sched.stop && queues_empty_locked()) break;
+            pthread_cond_wait(&g_sched.cv, &g_sched.mtx);
+            continue;
+        }
+        run_task_locked(t);
+    }
+    //let the others see the empty queues too
+    pthread_cond_broadcast(&g_sched.cv);
+    pthread_mutex_unlock(&g_sched.mtx);
+    return NULL;
+}
+
+int scheduler_start(int nthreads) {
+    if (nthreads <= 0) nthreads = 1;
+
+    pthread_mutex_lock(&g_sched.mtx);
+    if (g_sched.threads) {
+        pthread_mutex_unlock(&g_sched.mtx);
+        return -1;
+    }
+    g_sched.threads = (pthread_t *)malloc(sizeof(pthread_t) * (size_t)nthreads);
+    if (!g_sched.threads) {
+        pthread_mutex_unlock(&g_sched.mtx);
+        return -1;
+    }
+    g_sched.nthreads = nthreads;
+    g_sched.stop = 0;
+    memset(g_sched.q, 0, sizeof(g_sched.q));
+    pthread_mutex_unlock(&g_sched.mtx);
+
+    for (int i = 0; i < nthreads; i++) {
+        if (pthread_create(&g_sched.threads[i], NULL, sched_thread_main, NULL) != 0) {
+            die("pthread_create(scheduler) failed");
+        }
+    }
+    return 0;
+}
+
+void scheduler_stop(void) {
+    pthread_mutex_lock(&g_sched.mtx);
+    if (!g_sched.threads) {
+        pthread_mutex_unlock(&g_sched.mtx);
+        return;
+    }
+    g_sched.stop = 1;
+    pthread_cond_broadcast(&g_sched.cv);
+    pthread_mutex_unlock(&g_sched.mtx);
+
+    for (int i = 0; i < g_sched.nthreads; i++) {
+        pthread_join(g_sched.threads[i], NULL);
+    }
+
+    for (int c = 0; c < SCHED_NCLASSES; c++) {
+        const sched_queue_t *q = &g_sched.q[c];
+        if (q->done == 0) continue;
+        log_debug("Scheduler %s: %llu tasks, queue wait mean %.1f us, max %.1f us", kClassNames[c],
+                  (unsigned long long)q->done, (double)q->wait_ns / (double)q->done / 1e3,
+                  (double)q->max_wait_ns / 1e3);
+    }
+
+    pthread_mutex_lock(&g_sched.mtx);
+    free(g_sched.threads);
+    g_sched.threads = NULL;
+    g_sched.nthreads = 0;
+    g_sched.stop = 0;
+    pthread_mutex_unlock(&g_sched.mtx);
+}
+
+int scheduler_nthreads(void) {
+    pthread_mutex_lock(&g_sched.mtx);
+    int n = g_sched.threads ? g_sched.nthreads : 0;
+    pthread_mutex_unlock(&g_sched.mtx);
+    return n;
+}
+
+void scheduler_submit(sched_class_t cls, sched_task_t *task, sched_fn_t fn, void *arg, sched_group_t *group) {
+    if (!task || !fn || (int)cls < 0 || cls >= SCHED_NCLASSES) return;
+
+    pthread_mutex_lock(&g_sched.mtx);
+    if (!g_sched.threads) {
+        //not started (offline tools): run inline
+        pthread_mutex_unlock(&g_sched.mtx);
+        fn(arg);
+        return;
+    }
+    if (group) {
+        pthread_mutex_lock(&group->mtx);
+        group->pending++;
+        pthread_mutex_unlock(&group->mtx);
+    }
+
+    task->fn = fn;
+    task->arg = arg;
+    task->group = group;
+    task->cls = cls;
+    task->enqueued_ns = now_ns();
+    task->next = NULL;
+
+    sched_queue_t *q = &g_sched.q[cls];
+    if (q->tail) {
+        q->tail->next = task;
+    } else {
+        q->head = task;
+    }
+    q->tail = task;
+
+    pthread_cond_signal(&g_sched.cv);
+    pthread_mutex_unlock(&g_sched.mtx);
+}
+
+typedef struct {
+    int (*fn)(void *arg);
+    void *arg;
+    int rc;
+} sched_call_t;
+
+static void call_main(void *arg) {
+    sched_call_t *c = (sched_call_t *)arg;
+    c->rc = c->fn(c->arg);
+}
+
+int scheduler_call(sched_class_t cls, int (*fn)(void *arg), void *arg) {
+    sched_call_t c = {fn, arg, -1};
+    sched_task_t task;
+    sched_group_t g;
+
+    sched_group_init(&g);
+    scheduler_submit(cls, &task, call_main, &c, &g);
+    sched_group_wait(&g);
+    sched_group_destroy(&g);
+    return c.rc;
+}
+
+void sched_group_init(sched_group_t *g) {
+    pthread_mutex_init(&g->mtx, NULL);
+    pthread_cond_init(&g->cv, NULL);
+    g->pending = 0;
+}
+
+void sched_group_destroy(sched_group_t *g) {
+    pthread_cond_destroy(&g->cv);
+    pthread_mutex_destroy(&g->mtx);
+}
+
+void sched_group_wait(sched_group_t *g) {
+    if (t_sched_thread) {
+        //inside a task: do the group's queued work here instead of holding a thread idle
+        pthread_mutex_lock(&g_sched.mtx);
+        sched_task_t *t;
+        while ((t = take_group_task_locked(g)) != NULL) {
+            run_task_locked(t);
+        }
+        pthread_mutex_unlock(&g_sched.mtx);
+    }
+
+    //the rest is running on other threads
+    pthread_mutex_lock(&g->mtx);
+    while (g->pending > 0) {
+        pthread_cond_wait(&g->cv, &g->mtx);
+    }
+    pthread_mutex_unlock(&g->mtx);
+}
@@ -0,0 +1,143 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_SCHEDULER_H
+#define SEMPRACA_SCHEDULER_H
+
+/**
+ * @file scheduler.h
+ * @brief Process-wide task scheduler with priority classes.
+ *
+ * All CPU work of the server runs as tasks on one fixed set of threads
+ * instead of ad-hoc threads per request. Every task belongs to a class; an
+ * idle thread always takes the oldest task of the highest non-empty class:
+ *
+ * | class                  | work                                            |
+ * |------------------------|-------------------------------------------------|
+ * | @ref SCHED_CONTROL     | interactive queries (region statistics),        |
+ * |                        | obstacle edits                                  |
+ * | @ref SCHED_SNAPSHOT    | snapshot encoding (frames, derived fields)      |
+ * | @ref SCHED_SIM         | random-walk batches (@ref worker_pool_t)        |
+ * | @ref SCHED_BACKGROUND  | world generation, save/load, image export,      |
+ * |                        | hitting-time solver, CRN diff, cluster scaling  |
+ *
+ * Tasks are not preempted, so the classes are only as responsive as the
+ * tasks below them are short: simulation batches are at most
+ * @ref WORKER_POOL_BATCH walks and then requeue themselves, so a control or
+ * snapshot task waits for at most one batch per thread. Background tasks are
+ * long (a save writes the whole results file); they may occupy at most
+ * nthreads - 1 threads, so one thread always keeps cycling through the
+ * shorter classes. The simulation uses all capacity the other classes leave.
+ *
+ * What stays a thread
+ * -------------------
+ * Client threads block on their sockets and answer status queries inline;
+ * they never compute, they submit a task and wait for it. A snapshot is
+ * encoded by a task and the client thread only writes the frames; only a
+ * RAW view too large to buffer (@ref SNAPSHOT_CACHE_MAX_BYTES) is gathered
+ * while streaming on the client thread. The simulation
+ * thread only feeds jobs to the pool and waits for the replications, which
+ * are not a group it could help with, so it stays a thread too.
+ *
+ * Waiting inside a task
+ * ---------------------
+ * A task may split its work into a group of tasks and wait for them
+ * (@ref sched_group_wait(), @ref scheduler_call()): on a scheduler thread the
+ * wait first runs the still-queued tasks of that group itself, ignoring the
+ * background cap, and only then blocks for the ones already running
+ * elsewhere. A wait therefore never needs a free thread and cannot deadlock.
+ * Tasks that meet at a barrier would need all of them running at once, so
+ * parallel kernels are written fork-join instead.
+ *
+ * Tasks are caller-owned (@ref sched_task_t), so submitting never allocates.
+ * Before @ref scheduler_start() (offline tools) a submitted task runs inline
+ * in the caller.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+
+/**
+ * @brief Priority classes, highest first.
+ */
+typedef enum {
+    SCHED_CONTROL = 0,
+    SCHED_SNAPSHOT = 1,
+    SCHED_SIM = 2,
+    SCHED_BACKGROUND = 3
+} sched_class_t;
+
+/** Number of priority classes. */
+#define SCHED_NCLASSES 4
+
+typedef void (*sched_fn_t)(void *arg);
+
+/**
+ * @brief Completion counter of a set of tasks.
+ */
+typedef struct {
+    pthread_mutex_t mtx;
+    pthread_cond_t cv;
+    uint32_t pending;   /**< Submitted tasks that have not finished. */
+} sched_group_t;
+
+/**
+ * @brief One queued task; must stay valid until it has run.
+ *
+ * The node may be submitted again from inside its own function (the
+ * scheduler does not touch it after calling @ref fn).
+ */
+typedef struct sched_task {
+    sched_fn_t fn;
+    void *arg;
+    sched_group_t *group;
+    sched_class_t cls;
+    uint64_t enqueued_ns;
+    struct sched_task *next;
+} sched_task_t;
+
+/**
+ * @brief Start the scheduler threads.
+ *
+ * @param nthreads Number of threads (<= 0 means 1).
+ * @return 0 on success, -1 if already running.
+ */
+int scheduler_start(int nthreads);
+
+/**
+ * @brief Run all queued tasks, stop the threads and log per-class statistics.
+ */
+void scheduler_stop(void);
+
+/**
+ * @brief Number of scheduler threads, 0 if the scheduler is not running.
+ */
+int scheduler_nthreads(void);
+
+/**
+ * @brief Queue @p fn(@p arg) in class @p cls.
+ *
+ * @param task  Caller-owned node, valid until the task has run.
+ * @param group Optional: counted as pending until the task has run.
+ */
+void scheduler_submit(sched_class_t cls, sched_task_t *task, sched_fn_t fn, void *arg, sched_group_t *group);
+
+/**
+ * @brief Run @p fn(@p arg) as a task of class @p cls and wait for it.
+ *
+ * @return The return value of @p fn.
+ */
+int scheduler_call(sched_class_t cls, int (*fn)(void *arg), void *arg);
+
+void sched_group_init(sched_group_t *g);
+void sched_group_destroy(sched_group_t *g);
+
+/**
+ * @brief Block until every task submitted with @p g has run.
+ *
+ * Called from a task, the queued tasks of @p g run in the caller first.
+ */
+void sched_group_wait(sched_group_t *g);
+
+#endif //SEMPRACA_SCHEDULER_H
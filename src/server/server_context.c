@@ -2,11 +2,17 @@
 // Created by Jozef Jelšík on 26/12/2025.
 //
 
+#define _POSIX_C_SOURCE 200809L /* clock_gettime() */
+
 #include "server_context.h"
 
 #include "../common/util.h"
 
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 /**
@@ -14,6 +20,74 @@
  * @brief Implementation of server context initialization and synchronized accessors.
  */
 
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/* Random non-zero session token. */
+static uint64_t new_session_token(void) {
+    uint64_t t = 0;
+    int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        if (read(fd, &t, sizeof(t)) != (ssize_t)sizeof(t)) t = 0;
+        close(fd);
+    }
+    if (t == 0) {
+        /* fallback: clock, pid and a counter through the splitmix64 finalizer */
+        static _Atomic uint64_t ctr;
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        uint64_t z = ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)ts.tv_nsec ^ ((uint64_t)getpid() << 16) ^
+                     (atomic_fetch_add(&ctr, 1u) * 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        t = z ^ (z >> 31);
+    }
+    return t ? t : 1u;
+}
+
+/* Control of a dropped owner is still reserved for its session; caller holds state_mtx. */
+static int owner_reserved_locked(const server_context_t *ctx, uint64_t now) {
+    return ctx->owner_fd < 0 && ctx->owner_reserved_until_ms != 0 && now < ctx->owner_reserved_until_ms;
+}
+
+/* Store the status block; caller holds state_mtx (serializes writers). */
+static void status_publish_locked(server_context_t *ctx) {
+    server_status_t st;
+    uint64_t words[SERVER_STATUS_WORDS];
+
+    memset(&st, 0, sizeof(st));
+    st.wire.state = ctx->sim_state;
+    st.wire.multi_user = ctx->multi_user;
+    st.wire.world_kind = (ctx->world_kind == WORLD_OBSTACLES) ? RW_WIRE_WORLD_OBSTACLES : RW_WIRE_WORLD_WRAP;
+    st.wire.size.width = (uint32_t)ctx->world_size.width;
+    st.wire.size.height = (uint32_t)ctx->world_size.height;
+    st.wire.probs.p_up = ctx->probs.p_up;
+    st.wire.probs.p_down = ctx->probs.p_down;
+    st.wire.probs.p_left = ctx->probs.p_left;
+    st.wire.probs.p_right = ctx->probs.p_right;
+    st.wire.k_max_steps = ctx->k_max_steps;
+    st.wire.total_reps = ctx->total_reps;
+    st.wire.current_rep = ctx->current_rep;
+    st.wire.global_mode = (rw_wire_global_mode_t)ctx->global_mode;
+    st.owner_fd = ctx->owner_fd;
+    st.owner_reserved_until_ms = ctx->owner_fd < 0 ? ctx->owner_reserved_until_ms : 0;
+    st.version = ++ctx->status_version;
+
+    memset(words, 0, sizeof(words));
+    memcpy(words, &st, sizeof(st));
+
+    unsigned seq = atomic_load_explicit(&ctx->status_seq, memory_order_relaxed);
+    atomic_store_explicit(&ctx->status_seq, seq + 1u, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (size_t i = 0; i < SERVER_STATUS_WORDS; i++) {
+        atomic_store_explicit(&ctx->status_words[i], words[i], memory_order_relaxed);
+    }
+    atomic_store_explicit(&ctx->status_seq, seq + 2u, memory_order_release);
+}
+
 /**
  * @brief Initialize a server context with defaults.
  *
@@ -42,11 +116,14 @@ void server_context_init(server_context_t *ctx) {
     ctx->sim_state = RW_WIRE_SIM_LOBBY;
     ctx->multi_user = 0;
     ctx->owner_fd = -1;
+    ctx->session_prefix = new_session_token() << 32;
+    if (ctx->session_prefix == 0) ctx->session_prefix = 1ull << 32;
 
-    ctx->clients.count = 0;
-    for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
-        ctx->clients.fds[i] = -1;
+    ctx->clients = (client_list_t *)calloc(1, sizeof(client_list_t));
+    if (!ctx->clients) {
+        die("server_context_init: out of memory");
     }
+    atomic_init(&ctx->clients->refs, 1u);
 
     if (pthread_mutex_init(&ctx->clients_mtx, NULL) != 0) {
         die("pthread_mutex_init(client_mtx) failed");
@@ -54,6 +131,53 @@ void server_context_init(server_context_t *ctx) {
     if (pthread_mutex_init(&ctx->state_mtx, NULL) != 0) {
         die("pthread_mutex_init(state_mtx) failed");
     }
+
+    atomic_init(&ctx->status_seq, 0u);
+    for (size_t i = 0; i < SERVER_STATUS_WORDS; i++) {
+        atomic_init(&ctx->status_words[i], 0u);
+    }
+    status_publish_locked(ctx);
+}
+
+static void client_release(server_client_t *c) {
+    if (atomic_fetch_sub(&c->refs, 1u) == 1u) {
+        close(c->fd);
+        free(c);
+    }
+}
+
+static void client_list_release(client_list_t *list) {
+    if (atomic_fetch_sub(&list->refs, 1u) == 1u) {
+        for (int i = 0; i < list->count; i++) {
+            client_release(list->clients[i]);
+        }
+        free(list);
+    }
+}
+
+/* Take a reference to the current list; the lock only covers the pointer read
+ * and the increment, so the list cannot be freed in between. */
+static client_list_t *client_list_acquire(server_context_t *ctx) {
+    pthread_mutex_lock(&ctx->clients_mtx);
+    client_list_t *list = ctx->clients;
+    atomic_fetch_add(&list->refs, 1u);
+    pthread_mutex_unlock(&ctx->clients_mtx);
+    return list;
+}
+
+/* Copy of @p list without client @p skip_fd (-1 = keep all); NULL if out of memory. */
+static client_list_t *client_list_copy(const client_list_t *list, int skip_fd) {
+    client_list_t *copy = (client_list_t *)calloc(1, sizeof(*copy));
+    if (!copy) return NULL;
+    atomic_init(&copy->refs, 1u);
+
+    for (int i = 0; i < list->count; i++) {
+        server_client_t *c = list->clients[i];
+        if (c->fd == skip_fd) continue;
+        atomic_fetch_add(&c->refs, 1u);
+        copy->clients[copy->count++] = c;
+    }
+    return copy;
 }
 
 /**
@@ -62,6 +186,10 @@ void server_context_init(server_context_t *ctx) {
  * @param ctx Context to destroy.
  */
 void server_context_destroy(server_context_t *ctx) {
+    if (ctx->clients) {
+        client_list_release(ctx->clients);
+        ctx->clients = NULL;
+    }
     pthread_mutex_destroy(&ctx->clients_mtx);
     pthread_mutex_destroy(&ctx->state_mtx);
 }
@@ -69,37 +197,41 @@ void server_context_destroy(server_context_t *ctx) {
 /**
  * @brief Add a client socket FD to the context.
  *
- * Thread-safe.
+ * Thread-safe. Publishes a new client list.
  *
  * @param ctx Server context.
  * @param client_fd Client socket.
- * @return 0 on success, -1 if the client list is full or no free slot exists.
+ * @return 0 on success, -1 if the client list is full or out of memory.
  */
 int server_context_add_client(server_context_t *ctx, int client_fd) {
+    server_client_t *c = (server_client_t *)malloc(sizeof(*c));
+    if (!c) return -1;
+    c->fd = client_fd;
+    atomic_init(&c->refs, 1u);
+
     pthread_mutex_lock(&ctx->clients_mtx);
 
-    if (ctx->clients.count >= SERVER_MAX_CLIENTS) {
+    client_list_t *old = ctx->clients;
+    client_list_t *list = old->count < SERVER_MAX_CLIENTS ? client_list_copy(old, -1) : NULL;
+    if (!list) {
         pthread_mutex_unlock(&ctx->clients_mtx);
+        free(c);
         return -1;
     }
+    list->clients[list->count++] = c;
+    ctx->clients = list;
 
-    //find empty slot*/
-    for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
-        if (ctx->clients.fds[i] == -1) {
-            ctx->clients.fds[i] = client_fd;
-            ctx->clients.count++;
-            pthread_mutex_unlock(&ctx->clients_mtx);
-            return 0;
-        }
-    }
     pthread_mutex_unlock(&ctx->clients_mtx);
-    return -1;
+
+    client_list_release(old);
+    return 0;
 }
 
 /**
  * @brief Remove a client socket FD from the context.
  *
- * Thread-safe.
+ * Thread-safe. Publishes a new client list; the socket is closed with the last
+ * reference to it.
  *
  * @param ctx Server context.
  * @param client_fd Client socket to remove.
@@ -107,37 +239,38 @@ int server_context_add_client(server_context_t *ctx, int client_fd) {
 void server_context_remove_client(server_context_t *ctx, int client_fd) {
     pthread_mutex_lock(&ctx->clients_mtx);
 
-    for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
-        if (ctx->clients.fds[i] == client_fd) {
-            ctx->clients.fds[i] = -1;
-            if (ctx->clients.count > 0) {
-                ctx->clients.count--;
-            }
-            break;
-        }
+    client_list_t *old = ctx->clients;
+    client_list_t *list = client_list_copy(old, client_fd);
+    if (!list) {
+        //keep the client registered rather than closing a socket in use
+        pthread_mutex_unlock(&ctx->clients_mtx);
+        log_error("server_context_remove_client: out of memory (fd=%d)", client_fd);
+        return;
     }
+    ctx->clients = list;
+
     pthread_mutex_unlock(&ctx->clients_mtx);
+
+    client_list_release(old);
 }
 
 /**
  * @brief Invoke a callback for each connected client.
  *
- * Thread-safe.
+ * Thread-safe; @p fn runs without any lock held.
  *
  * @param ctx Server context.
  * @param fn Callback invoked for each client.
  * @param user User pointer passed through to the callback.
  */
 void server_context_for_each_client(server_context_t *ctx, client_fd_fn fn, void *user) {
-    pthread_mutex_lock(&ctx->clients_mtx);
+    client_list_t *list = client_list_acquire(ctx);
 
-    for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
-        int fd = ctx->clients.fds[i];
-        if (fd != -1) {
-            fn(fd, user);
-        }
+    for (int i = 0; i < list->count; i++) {
+        fn(list->clients[i]->fd, user);
     }
-    pthread_mutex_unlock(&ctx->clients_mtx);
+
+    client_list_release(list);
 }
 
 /**
@@ -151,6 +284,7 @@ void server_context_for_each_client(server_context_t *ctx, client_fd_fn fn, void
 void server_context_set_mode(server_context_t *ctx, global_mode_t mode) {
     pthread_mutex_lock(&ctx->state_mtx);
     ctx->global_mode = mode;
+    status_publish_locked(ctx);
     pthread_mutex_unlock(&ctx->state_mtx);
 }
 
@@ -181,6 +315,7 @@ global_mode_t server_context_get_mode(server_context_t *ctx) {
 void server_context_set_progress(struct server_context *ctx, uint32_t current_rep) {
     pthread_mutex_lock(&ctx->state_mtx);
     ctx->current_rep = current_rep;
+    status_publish_locked(ctx);
     pthread_mutex_unlock(&ctx->state_mtx);
 }
 
@@ -209,12 +344,14 @@ rw_wire_sim_state_t server_context_get_sim_state(server_context_t *ctx) {
 void server_context_set_sim_state(server_context_t *ctx, rw_wire_sim_state_t state) {
     pthread_mutex_lock(&ctx->state_mtx);
     ctx->sim_state = state;
+    status_publish_locked(ctx);
     pthread_mutex_unlock(&ctx->state_mtx);
 }
 
 void server_context_set_multi_user(server_context_t *ctx, uint8_t multi_user) {
     pthread_mutex_lock(&ctx->state_mtx);
     ctx->multi_user = multi_user ? 1 : 0;
+    status_publish_locked(ctx);
     pthread_mutex_unlock(&ctx->state_mtx);
 }
 
@@ -228,6 +365,7 @@ uint8_t server_context_get_multi_user(server_context_t *ctx) {
 void server_context_set_owner_fd(server_context_t *ctx, int owner_fd) {
     pthread_mutex_lock(&ctx->state_mtx);
     ctx->owner_fd = owner_fd;
+    status_publish_locked(ctx);
     pthread_mutex_unlock(&ctx->state_mtx);
 }
 
@@ -238,15 +376,63 @@ int server_context_get_owner_fd(server_context_t *ctx) {
     return v;
 }
 
+int server_context_open_session(server_context_t *ctx, int client_fd, uint64_t resume_token,
+                                uint64_t *out_token, uint8_t *out_is_owner) {
+    uint64_t token = ctx->session_prefix | (new_session_token() & 0xFFFFFFFFull);
+    uint64_t now = now_ms();
+    int resumed = 0;
+
+    if (resume_token != 0 && (resume_token & ~0xFFFFFFFFull) == ctx->session_prefix) {
+        token = resume_token;
+        resumed = 1;
+    }
+
+    pthread_mutex_lock(&ctx->state_mtx);
+    if (resumed && resume_token == ctx->owner_token) {
+        /* owner reconnected (its old connection may not be noticed as dead yet) */
+        ctx->owner_fd = client_fd;
+        ctx->owner_reserved_until_ms = 0;
+    } else if (ctx->owner_fd < 0 && !owner_reserved_locked(ctx, now)) {
+        /* First client becomes owner (if not set). */
+        ctx->owner_fd = client_fd;
+        ctx->owner_token = token;
+        ctx->owner_reserved_until_ms = 0;
+    }
+    *out_is_owner = ctx->owner_fd == client_fd ? 1 : 0;
+    status_publish_locked(ctx);
+    pthread_mutex_unlock(&ctx->state_mtx);
+
+    *out_token = token;
+    return resumed;
+}
+
+void server_context_close_session(server_context_t *ctx, int client_fd, int reserve) {
+    pthread_mutex_lock(&ctx->state_mtx);
+    if (ctx->owner_fd == client_fd) {
+        /* If owner left, clear owner (next client may become owner). */
+        ctx->owner_fd = -1;
+        if (reserve) {
+            ctx->owner_reserved_until_ms = now_ms() + SERVER_OWNER_GRACE_MS;
+        } else {
+            ctx->owner_token = 0;
+            ctx->owner_reserved_until_ms = 0;
+        }
+        status_publish_locked(ctx);
+    }
+    pthread_mutex_unlock(&ctx->state_mtx);
+}
+
 int server_context_client_can_control(server_context_t *ctx, int client_fd) {
     pthread_mutex_lock(&ctx->state_mtx);
     int owner = ctx->owner_fd;
     uint8_t mu = ctx->multi_user;
+    int reserved = owner_reserved_locked(ctx, now_ms());
     pthread_mutex_unlock(&ctx->state_mtx);
 
     if (owner < 0) {
-        /* If not set yet, allow first client to become owner logically. */
-        return 1;
+        /* If not set yet, allow first client to become owner logically
+         * (unless a dropped owner may still resume). */
+        return !reserved;
     }
 
     if (!mu) {
@@ -256,3 +442,40 @@ int server_context_client_can_control(server_context_t *ctx, int client_fd) {
     /* In multi-user, still limit control to owner for simplicity/determinism. */
     return client_fd == owner;
 }
+
+void server_context_publish_status(server_context_t *ctx) {
+    pthread_mutex_lock(&ctx->state_mtx);
+    status_publish_locked(ctx);
+    pthread_mutex_unlock(&ctx->state_mtx);
+}
+
+void server_context_read_status(server_context_t *ctx, server_status_t *out) {
+    uint64_t words[SERVER_STATUS_WORDS];
+    unsigned seq0, seq1;
+
+    do {
+        seq0 = atomic_load_explicit(&ctx->status_seq, memory_order_acquire);
+        if (seq0 & 1u) {
+            sched_yield();
+            seq1 = seq0 + 1u;
+            continue;
+        }
+        for (size_t i = 0; i < SERVER_STATUS_WORDS; i++) {
+            words[i] = atomic_load_explicit(&ctx->status_words[i], memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        seq1 = atomic_load_explicit(&ctx->status_seq, memory_order_relaxed);
+    } while (seq0 != seq1);
+
+    memcpy(out, words, sizeof(*out));
+}
+
+void server_context_status_for(server_context_t *ctx, int client_fd, rw_status_t *out) {
+    server_status_t st;
+    server_context_read_status(ctx, &st);
+
+    *out = st.wire;
+    /* Same rule as server_context_client_can_control(), on the snapshot. */
+    int reserved = st.owner_reserved_until_ms != 0 && now_ms() < st.owner_reserved_until_ms;
+    out->can_control = ((st.owner_fd < 0 && !reserved) || client_fd == st.owner_fd) ? 1 : 0;
+}
@@ -6,9 +6,11 @@
 #define SEMPRACA_SERVER_CONTEXT_H
 
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include "../common/types.h"
 #include "../common/protocol.h"
+#include "world.h"
 
 /**
  * @file server_context.h
@@ -19,9 +21,46 @@
  * current progress).
  *
  * Thread safety:
- * - Client list operations are protected by `clients_mtx`.
+ * - The client list is read-mostly and published copy-on-write (see below);
+ *   `clients_mtx` only serializes joins/leaves and taking a reference.
  * - Mode/progress are protected by `state_mtx`.
  * - Public APIs in this file acquire the necessary mutex internally.
+ * - Configuration fields (world kind/size, probabilities, K, replications) are
+ *   written directly by the controlling client thread while no simulation
+ *   runs; such writers call @ref server_context_publish_status() afterwards.
+ *
+ * Status block
+ * ------------
+ * Everything a STATUS reply contains is published as one versioned
+ * @ref server_status_t under a sequence lock. Writers (all under `state_mtx`)
+ * bump the sequence to odd, store the block and bump it to even again; readers
+ * copy the block without any lock and retry if the sequence was odd or changed.
+ * Status queries therefore never block the simulation or each other and always
+ * see one consistent configuration.
+ *
+ * Client registry
+ * ---------------
+ * The connected clients are published as an immutable, reference-counted
+ * @ref client_list_t. A join or leave builds a new list and swaps the pointer;
+ * @ref server_context_for_each_client() takes a reference to the current list
+ * and calls back without any lock, so a slow socket in one broadcast never
+ * delays joins, leaves or other broadcasts.
+ *
+ * Each client is a reference-counted @ref server_client_t held by every list
+ * that contains it. Its socket is closed when the last list drops it, so a
+ * broadcast still iterating an old list never writes to a closed (or reused)
+ * descriptor.
+ *
+ * Sessions
+ * --------
+ * Every JOIN opens a session identified by a random 64-bit token sent in
+ * WELCOME. The high 32 bits are fixed per server instance, so a JOIN can
+ * resume any session of this instance (its snapshot ids are still valid)
+ * without a session table. Only the owner's session has state: when the owner's connection
+ * drops without QUIT, control stays reserved for its token for
+ * @ref SERVER_OWNER_GRACE_MS, and a JOIN presenting that token becomes the owner
+ * again. Other clients cannot take control meanwhile; after the grace period
+ * the usual rule applies (the next joiner becomes owner).
  */
 
 /**
@@ -30,13 +69,42 @@
 #define SERVER_MAX_CLIENTS 32
 
 /**
- * @brief Set of connected client file descriptors.
+ * @brief How long a dropped owner's control stays reserved for its session (ms).
+ */
+#define SERVER_OWNER_GRACE_MS 60000u
+
+/**
+ * @brief One registered client (see "Client registry").
+ */
+typedef struct {
+    int fd;            /**< Client socket, closed with the last reference. */
+    atomic_uint refs;  /**< Number of client lists containing this client. */
+} server_client_t;
+
+/**
+ * @brief Immutable snapshot of the connected clients.
  */
 typedef struct {
-    int fds[SERVER_MAX_CLIENTS]; /**< Client socket file descriptors. */
-    int count;                   /**< Number of active clients. */
+    atomic_uint refs;                              /**< Registry + active iterations. */
+    int count;                                     /**< Number of clients. */
+    server_client_t *clients[SERVER_MAX_CLIENTS]; /**< Clients, in join order. */
 } client_list_t;
 
+/**
+ * @brief Published status block (see "Status block").
+ */
+typedef struct {
+    /** STATUS payload, ready to send except the per-client can_control flag. */
+    rw_status_t wire;
+    int32_t owner_fd;  /**< Controlling client (-1 = none yet). */
+    uint32_t version;  /**< Incremented by every publish. */
+    /** While no owner is connected: control reserved for its session until then (monotonic ms). */
+    uint64_t owner_reserved_until_ms;
+} server_status_t;
+
+/** 64-bit words backing the status block. */
+#define SERVER_STATUS_WORDS ((sizeof(server_status_t) + 7u) / 8u)
+
 /**
  * @brief Server runtime context.
  *
@@ -55,6 +123,19 @@ typedef struct server_context{
 
     global_mode_t global_mode; /**< Current server mode (interactive/summary). */
 
+    /** Non-zero: replications use common random numbers (see @ref rw_rng_seed_stream()). */
+    uint8_t crn_enabled;
+    uint64_t crn_seed;         /**< Base seed for common random numbers. */
+
+    /**
+     * Simulated region (start cells) and snapshot view; empty = whole world.
+     * Reset whenever a new world is created or loaded.
+     */
+    world_region_t region;
+
+    /** RWTILE file backing the world (empty for an in-memory world). */
+    char world_file[RW_PATH_MAX];
+
     /** Simulation lifecycle state. */
     rw_wire_sim_state_t sim_state;
 
@@ -63,14 +144,25 @@ typedef struct server_context{
 
     /** Client fd that currently owns control (in single-user always the first joiner). */
     int owner_fd;
+    /** High 32 bits of every session token of this server instance, see "Sessions". */
+    uint64_t session_prefix;
+    /** Session token of the owner (0 = none), see "Sessions". */
+    uint64_t owner_token;
+    /** Owner lost its connection: ownership reserved for its session until then (monotonic ms, 0 = not reserved). */
+    uint64_t owner_reserved_until_ms;
 
     /* Clients */
-    client_list_t clients;     /**< Connected client sockets. */
+    client_list_t *clients;    /**< Current published client list (never NULL). */
 
     /* Synchronization */
-    pthread_mutex_t clients_mtx; /**< Protects @ref server_context_t::clients. */
+    pthread_mutex_t clients_mtx; /**< Serializes swaps of @ref server_context_t::clients. */
     pthread_mutex_t state_mtx;   /**< Protects mutable state and lifecycle fields. */
 
+    /* Status block (sequence lock, written under state_mtx) */
+    atomic_uint status_seq;                              /**< Odd while a publish is in progress. */
+    _Atomic uint64_t status_words[SERVER_STATUS_WORDS];  /**< Stored @ref server_status_t. */
+    uint32_t status_version;                             /**< Version of the last publish. */
+
 } server_context_t;
 
 /**
@@ -81,9 +173,9 @@ typedef struct server_context{
 void server_context_init(server_context_t *ctx);
 
 /**
- * @brief Destroy a server context (releases mutexes).
+ * @brief Destroy a server context (releases mutexes and the client list).
  *
- * Does not close any client sockets.
+ * Sockets of clients still registered are closed.
  *
  * @param ctx Context to destroy.
  */
@@ -101,6 +193,9 @@ int server_context_add_client(server_context_t *ctx, int client_fd);
 /**
  * @brief Remove a client file descriptor from the context.
  *
+ * The context takes over @p client_fd: it is closed as soon as no broadcast
+ * still uses it, so the caller must not close it.
+ *
  * @param ctx Server context.
  * @param client_fd Client socket to remove.
  */
@@ -117,9 +212,10 @@ typedef void(*client_fd_fn)(int fd, void *user);
 /**
  * @brief Invoke @p fn for each currently connected client.
  *
- * Note: this holds `clients_mtx` while iterating and calling @p fn.
- * Keep callbacks short and avoid calling back into functions that might
- * try to acquire `clients_mtx` again.
+ * Iterates a stable snapshot of the client list without holding any lock, so
+ * callbacks may block on sends. Clients that join during the iteration are
+ * not visited; clients that leave may still be visited (their socket stays
+ * open until the iteration ends).
  *
  * @param ctx Server context.
  * @param fn Callback invoked for each client.
@@ -166,10 +262,69 @@ rw_wire_sim_state_t server_context_get_sim_state(server_context_t *ctx);
 void server_context_set_multi_user(server_context_t *ctx, uint8_t multi_user);
 uint8_t server_context_get_multi_user(server_context_t *ctx);
 
+/**
+ * @brief Open the session of a joining client (see "Sessions").
+ *
+ * A JOIN carrying a token of this server instance keeps that token; the
+ * owner's token makes the client the owner again, also when the old connection
+ * has not been noticed as dead yet. Otherwise a new token is issued. A client
+ * becomes owner if nobody owns control and no dropped owner's reservation is
+ * pending.
+ *
+ * @param ctx          Server context.
+ * @param client_fd    Joining client.
+ * @param resume_token Token from the client's JOIN (0 = none).
+ * @param out_token    Session token to send in WELCOME.
+ * @param out_is_owner Set to 1 if the client owns control.
+ * @return 1 if a session was resumed, 0 for a new session.
+ */
+int server_context_open_session(server_context_t *ctx, int client_fd, uint64_t resume_token,
+                                uint64_t *out_token, uint8_t *out_is_owner);
+
+/**
+ * @brief Close the session of a leaving client.
+ *
+ * If the client was the owner, ownership is released. With @p reserve (lost
+ * connection, no QUIT) it stays reserved for the owner's session for
+ * @ref SERVER_OWNER_GRACE_MS, so a reconnect can resume it.
+ *
+ * @param ctx       Server context.
+ * @param client_fd Leaving client.
+ * @param reserve   Non-zero to keep ownership for a resume.
+ */
+void server_context_close_session(server_context_t *ctx, int client_fd, int reserve);
+
 void server_context_set_owner_fd(server_context_t *ctx, int owner_fd);
 int server_context_get_owner_fd(server_context_t *ctx);
 
 int server_context_client_can_control(server_context_t *ctx, int client_fd);
 
+/**
+ * @brief Republish the status block from the current context fields.
+ *
+ * State setters above do this themselves; call it after changing
+ * configuration fields directly.
+ *
+ * @param ctx Server context.
+ */
+void server_context_publish_status(server_context_t *ctx);
+
+/**
+ * @brief Read a consistent copy of the status block without locking.
+ *
+ * @param ctx Server context.
+ * @param out Output block.
+ */
+void server_context_read_status(server_context_t *ctx, server_status_t *out);
+
+/**
+ * @brief Build the STATUS reply for one client from the status block.
+ *
+ * @param ctx       Server context.
+ * @param client_fd Client asking (decides @c can_control).
+ * @param out       Output payload.
+ */
+void server_context_status_for(server_context_t *ctx, int client_fd, rw_status_t *out);
+
 #endif //SEMPRACA_SERVER_CONTEXT_H
 
@@ -12,6 +12,16 @@
 #include "results.h"
 #include "world.h"
 #include "persist.h"
+#include "hitting_time.h"
+#include "crn_diff.h"
+#include "obstacle_edit.h"
+#include "world_tiles.h"
+#include "world_import.h"
+#include "trace.h"
+#include "latency_stats.h"
+#include "heatmap_export.h"
+#include "region_stats.h"
+#include "scheduler.h"
 
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -78,15 +88,103 @@ static void *client_thread(void *arg);
  * @brief Handle initial JOIN request and send WELCOME.
  *
  * @param client_fd Client socket fd.
+ * @param rx        Receiver of the connection.
  * @return 0 on success, -1 on protocol/IO error.
  */
-static int handle_join(int client_fd);
+static int handle_join(int client_fd, rw_rx_buf_t *rx);
 
 // Control-plane helpers used in client_thread (defined at end of file)
 static void send_error(int fd, uint32_t code, const char *msg);
 static void send_ack(int fd, uint16_t req_type, uint16_t status);
 static void on_sim_end_cb(void *user, int stopped);
 
+// Request work, run as scheduler tasks while the client thread waits (defined at end of file);
+// SCHED_CONTROL for interactive queries and edits, SCHED_BACKGROUND for the rest
+static int create_world_task(void *arg);
+static int reset_results_task(void *arg);
+static int load_world_task(void *arg);
+static int map_world_task(void *arg);
+static int save_results_task(void *arg);
+static int load_results_task(void *arg);
+static int export_image_task(void *arg);
+static int write_world_file_task(void *arg);
+static int import_image_task(void *arg);
+static int clear_results_cells_task(void *arg);
+static int solve_hit_time_task(void *arg);
+static int crn_diff_task(void *arg);
+static int cluster_scaling_task(void *arg);
+static int obstacle_edit_task(void *arg);
+static int region_stats_task(void *arg);
+
+/**
+ * @brief Arguments of @ref export_image_task().
+ */
+typedef struct {
+    const char *path;
+    heatmap_source_t src;
+    heatmap_options_t opts;
+    uint32_t width, height;
+} export_image_job_t;
+
+/**
+ * @brief Arguments and outcome of @ref solve_hit_time_task().
+ */
+typedef struct {
+    hitting_time_opts_t opts;
+    double *hit_time;
+    hitting_time_stats_t st;
+} solve_hit_time_job_t;
+
+/**
+ * @brief Arguments and outcome of @ref crn_diff_task().
+ */
+typedef struct {
+    crn_config_t a;
+    crn_config_t b;
+    uint32_t reps;
+    uint64_t seed;
+    int nthreads;
+    const char *path;
+    crn_diff_summary_t st;
+} crn_diff_job_t;
+
+/**
+ * @brief Arguments of @ref clear_results_cells_task().
+ */
+typedef struct {
+    const uint64_t *cells;
+    uint64_t count;
+} clear_cells_job_t;
+
+/**
+ * @brief Arguments of @ref cluster_scaling_task().
+ */
+typedef struct {
+    cluster_job_t job;
+    const char *path;
+} cluster_scaling_job_t;
+
+/**
+ * @brief Arguments and outcome of @ref obstacle_edit_task().
+ */
+typedef struct {
+    const obstacle_edit_t *edits;
+    uint32_t count;
+    uint64_t *cells;
+    uint32_t changed;
+    uint64_t affected;
+} obstacle_edit_job_t;
+
+/**
+ * @brief Arguments and outcome of @ref region_stats_task().
+ */
+typedef struct {
+    const world_region_t *rects;
+    uint32_t count;
+    region_stat_t *stats;
+    uint64_t version;
+} region_stats_job_t;
+
 /**
  * @brief Broadcast a global-mode-changed notification to all clients.
  *
@@ -222,8 +320,18 @@ static void *accept_loop(void *arg) {
 static void *client_thread(void *arg) {
     int client_fd = *(int *)arg;
     free(arg);
+    trace_thread_name("client");
+
+    //all reads of this connection go through one buffered receiver
+    rw_rx_buf_t rx;
+    if (rw_rx_init(&rx, client_fd) != 0) {
+        log_error("Cannot allocate receive buffer (fd=%d)", client_fd);
+        close(client_fd);
+        return NULL;
+    }
     //join + WELCOME
-    if (handle_join(client_fd) != 0) {
+    if (handle_join(client_fd, &rx) != 0) {
+        rw_rx_free(&rx);
         close(client_fd);
         log_info("Client rejected (fd=%d)", client_fd);
         return NULL;
@@ -231,29 +339,40 @@ static void *client_thread(void *arg) {
     //Active client
     if (server_context_add_client(g_ctx,client_fd) != 0) {
         log_error("Cannot register client (fd=%d)", client_fd);
+        server_context_close_session(g_ctx, client_fd, 1);
+        rw_rx_free(&rx);
         close(client_fd);
         return NULL;
     }
 
-    /* First client becomes owner (if not set). */
-    if (server_context_get_owner_fd(g_ctx) < 0) {
-        server_context_set_owner_fd(g_ctx, client_fd);
-    }
-
     log_info("Client connected (fd=%d)", client_fd);
 
+    //QUIT releases ownership; a lost connection keeps it for a resume
+    int quit = 0;
+
+
+    //service latency of the previous request (every handler ends with continue)
+    uint64_t req_t0 = 0;
+    uint16_t req_type = 0;
 
     while (1) {
+        if (req_t0 != 0) {
+            latency_stats_record(req_type, latency_now_ns() - req_t0);
+            req_t0 = 0;
+        }
+
         rw_msg_hdr_t hdr;
-        if (rw_recv_hdr(client_fd, &hdr) != 0) {
+        if (rw_rx_next(&rx, &hdr) != 0) {
             break;
         }
+        req_t0 = latency_now_ns();
+        req_type = hdr.type;
 
         if (hdr.type == RW_MSG_SET_GLOBAL_MODE &&
             hdr.payload_len == sizeof(rw_set_global_mode_t)) {
 
             rw_set_global_mode_t req;
-            if (rw_recv_payload(client_fd, &req, sizeof(req)) != 0) {
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
                 break;
             }
 
@@ -273,32 +392,41 @@ static void *client_thread(void *arg) {
 
         if (hdr.type == RW_MSG_QUERY_STATUS && hdr.payload_len == sizeof(rw_query_status_t)) {
             rw_query_status_t q;
-            if (rw_recv_payload(client_fd, &q, sizeof(q)) != 0) {
+            if (rw_rx_payload(&rx, &q, sizeof(q)) != 0) {
                 break;
             }
             rw_status_t st;
-            memset(&st, 0, sizeof(st));
-            st.state = server_context_get_sim_state(g_ctx);
-            st.multi_user = server_context_get_multi_user(g_ctx);
-            st.can_control = server_context_client_can_control(g_ctx, client_fd) ? 1 : 0;
-            st.world_kind = (g_ctx->world_kind == WORLD_OBSTACLES) ? RW_WIRE_WORLD_OBSTACLES : RW_WIRE_WORLD_WRAP;
-            st.size.width = (uint32_t)g_ctx->world_size.width;
-            st.size.height = (uint32_t)g_ctx->world_size.height;
-            st.probs.p_up = g_ctx->probs.p_up;
-            st.probs.p_down = g_ctx->probs.p_down;
-            st.probs.p_left = g_ctx->probs.p_left;
-            st.probs.p_right = g_ctx->probs.p_right;
-            st.k_max_steps = g_ctx->k_max_steps;
-            st.total_reps = g_ctx->total_reps;
-            st.current_rep = server_context_get_progress(g_ctx);
-            st.global_mode = (rw_wire_global_mode_t)server_context_get_mode(g_ctx);
+            server_context_status_for(g_ctx, client_fd, &st);
             rw_send_msg(client_fd, RW_MSG_STATUS, &st, sizeof(st));
             continue;
         }
 
+        if (hdr.type == RW_MSG_QUERY_STATS && hdr.payload_len == sizeof(rw_query_stats_t)) {
+            rw_query_stats_t q;
+            if (rw_rx_payload(&rx, &q, sizeof(q)) != 0) {
+                break;
+            }
+            latency_summary_t sum[RW_STATS_MAX_ENTRIES];
+            size_t n = latency_stats_summary(sum, RW_STATS_MAX_ENTRIES);
+
+            rw_stats_t st;
+            memset(&st, 0, sizeof(st));
+            st.count = (uint32_t)n;
+            for (size_t i = 0; i < n; i++) {
+                st.entries[i].type = sum[i].type;
+                st.entries[i].count = sum[i].count;
+                st.entries[i].p50_ns = sum[i].p50_ns;
+                st.entries[i].p99_ns = sum[i].p99_ns;
+                st.entries[i].p999_ns = sum[i].p999_ns;
+                st.entries[i].max_ns = sum[i].max_ns;
+            }
+            rw_send_msg(client_fd, RW_MSG_STATS, &st, sizeof(st));
+            continue;
+        }
+
         if (hdr.type == RW_MSG_CREATE_SIM && hdr.payload_len == sizeof(rw_create_sim_t)) {
             rw_create_sim_t req;
-            if (rw_recv_payload(client_fd, &req, sizeof(req)) != 0) {
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
                 break;
             }
             if (!server_context_client_can_control(g_ctx, client_fd)) {
@@ -309,7 +437,8 @@ static void *client_thread(void *arg) {
                 send_error(client_fd, 2, "Simulation already running");
                 continue;
             }
-            if (req.size.width == 0 || req.size.height == 0 || req.total_reps == 0 || req.k_max_steps == 0) {
+            if (req.size.width == 0 || req.size.height == 0 || req.total_reps == 0 || req.k_max_steps == 0 ||
+                req.size.width > INT32_MAX || req.size.height > INT32_MAX) {
                 send_error(client_fd, 3, "Invalid parameters");
                 continue;
             }
@@ -330,24 +459,18 @@ static void *client_thread(void *arg) {
             g_ctx->probs.p_right = req.probs.p_right;
             g_ctx->k_max_steps = req.k_max_steps;
             g_ctx->total_reps = req.total_reps;
+            server_context_publish_status(g_ctx);
+            memset(&g_ctx->region, 0, sizeof(g_ctx->region));
+            g_ctx->world_file[0] = '\0';
             server_context_set_progress(g_ctx, 0);
 
-            if (g_world) {
-                world_destroy(g_world);
-                if (world_init(g_world, g_ctx->world_kind, g_ctx->world_size) != 0) {
-                    send_error(client_fd, 5, "world_init failed");
-                    continue;
-                }
-                if (g_ctx->world_kind == WORLD_OBSTACLES) {
-                    world_generate_obstacles(g_world, 10, 12345);
-                }
+            if (g_world && scheduler_call(SCHED_BACKGROUND, create_world_task, NULL) != 0) {
+                send_error(client_fd, 5, "world_init failed");
+                continue;
             }
-            if (g_results) {
-                results_destroy(g_results);
-                if (results_init(g_results, g_ctx->world_size) != 0) {
-                    send_error(client_fd, 6, "results_init failed");
-                    continue;
-                }
+            if (g_results && scheduler_call(SCHED_BACKGROUND, reset_results_task, NULL) != 0) {
+                send_error(client_fd, 6, "results_init failed");
+                continue;
             }
 
             server_context_set_sim_state(g_ctx, RW_WIRE_SIM_LOBBY);
@@ -357,7 +480,7 @@ static void *client_thread(void *arg) {
 
         if (hdr.type == RW_MSG_LOAD_WORLD && hdr.payload_len == sizeof(rw_load_world_t)) {
             rw_load_world_t req;
-            if (rw_recv_payload(client_fd, &req, sizeof(req)) != 0) {
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
                 break;
             }
             if (!server_context_client_can_control(g_ctx, client_fd)) {
@@ -371,21 +494,25 @@ static void *client_thread(void *arg) {
             req.path[RW_PATH_MAX - 1] = '\0';
             server_context_set_multi_user(g_ctx, req.multi_user);
 
-            if (!g_world) {
+            if (!g_world || !g_results) {
                 send_error(client_fd, 7, "Server world handle not set");
                 continue;
             }
-            if (persist_load_world(req.path, g_world, g_ctx) != 0) {
-                send_error(client_fd, 8, "Failed to load world file");
-                continue;
-            }
-            if (g_results) {
-                results_destroy(g_results);
-                if (results_init(g_results, g_ctx->world_size) != 0) {
+            trace_span_t span;
+            trace_begin(&span, "load world", NULL, 0);
+            int rc = scheduler_call(SCHED_BACKGROUND, load_world_task, req.path);
+            trace_end(&span);
+            if (rc != 0) {
+                if (rc == -2) {
                     send_error(client_fd, 6, "results_init failed");
-                    continue;
+                } else {
+                    send_error(client_fd, 8, "Failed to load world file");
                 }
+                continue;
             }
+            server_context_publish_status(g_ctx);
+            memset(&g_ctx->region, 0, sizeof(g_ctx->region));
+            g_ctx->world_file[0] = '\0';
 
             server_context_set_sim_state(g_ctx, RW_WIRE_SIM_LOBBY);
             send_ack(client_fd, RW_MSG_LOAD_WORLD, 0);
@@ -418,7 +545,7 @@ static void *client_thread(void *arg) {
 
         if (hdr.type == RW_MSG_RESTART_SIM && hdr.payload_len == sizeof(rw_restart_sim_t)) {
             rw_restart_sim_t req;
-            if (rw_recv_payload(client_fd, &req, sizeof(req)) != 0) {
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
                 break;
             }
             if (!server_context_client_can_control(g_ctx, client_fd)) {
@@ -449,7 +576,7 @@ static void *client_thread(void *arg) {
 
         if (hdr.type == RW_MSG_STOP_SIM && hdr.payload_len == sizeof(rw_stop_sim_t)) {
             rw_stop_sim_t req;
-            if (rw_recv_payload(client_fd, &req, sizeof(req)) != 0) {
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
                 break;
             }
             if (!server_context_client_can_control(g_ctx, client_fd)) {
@@ -465,15 +592,33 @@ static void *client_thread(void *arg) {
 
         if (hdr.type == RW_MSG_REQUEST_SNAPSHOT && hdr.payload_len == sizeof(rw_request_snapshot_t)) {
             rw_request_snapshot_t req;
-            if (rw_recv_payload(client_fd, &req, sizeof(req)) != 0) {
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
                 break;
             }
             if (!g_world || !g_results) {
                 send_error(client_fd, 11, "Snapshot unavailable");
                 continue;
             }
-            uint32_t snapshot_id = snapshot_next_id();
-            if (snapshot_send_to_client(client_fd, g_world, g_results, snapshot_id) != 0) {
+            if (!snapshot_view_ok(g_world, &g_ctx->region)) {
+                send_error(client_fd, 12, "Snapshot too large; set a region");
+                continue;
+            }
+            if (req.format > RW_SNAP_FORMAT_DERIVED16) {
+                send_error(client_fd, 25, "Invalid snapshot format");
+                continue;
+            }
+            snapshot_opts_t opts;
+            opts.format = (rw_wire_snapshot_format_t)req.format;
+            opts.nthreads = g_sm ? g_sm->nthreads : 1;
+            opts.base_snapshot_id = req.base_snapshot_id;
+            int rc;
+            if (server_context_get_sim_state(g_ctx) == RW_WIRE_SIM_RUNNING) {
+                rc = snapshot_send_to_client(client_fd, g_world, g_results, &g_ctx->region,
+                                             snapshot_next_id(), &opts);
+            } else {
+                rc = snapshot_send_cached(client_fd, g_world, g_results, &g_ctx->region, &opts);
+            }
+            if (rc != 0) {
                 send_error(client_fd, 12, "Snapshot send failed");
                 continue;
             }
@@ -483,7 +628,7 @@ static void *client_thread(void *arg) {
 
         if (hdr.type == RW_MSG_SAVE_RESULTS && hdr.payload_len == sizeof(rw_save_results_t)) {
             rw_save_results_t req;
-            if (rw_recv_payload(client_fd, &req, sizeof(req)) != 0) {
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
                 break;
             }
             if (!server_context_client_can_control(g_ctx, client_fd)) {
@@ -495,7 +640,11 @@ static void *client_thread(void *arg) {
                 send_error(client_fd, 13, "Nothing to save");
                 continue;
             }
-            if (persist_save_results(req.path, g_ctx, g_world, g_results) != 0) {
+            trace_span_t span;
+            trace_begin(&span, "save results", NULL, 0);
+            int rc = scheduler_call(SCHED_BACKGROUND, save_results_task, req.path);
+            trace_end(&span);
+            if (rc != 0) {
                 send_error(client_fd, 14, "Save failed");
                 continue;
             }
@@ -503,9 +652,126 @@ static void *client_thread(void *arg) {
             continue;
         }
 
+        if (hdr.type == RW_MSG_QUERY_REGIONS) {
+            //bad lengths get an answer too; rw_rx_next() skips the unread payload
+            if (hdr.payload_len < sizeof(rw_query_regions_hdr_t) ||
+                hdr.payload_len > sizeof(rw_query_regions_hdr_t) + RW_REGION_QUERY_MAX * sizeof(rw_wire_rect_t)) {
+                send_error(client_fd, 3, "Invalid parameters");
+                continue;
+            }
+            const uint8_t *buf = rx.payload;
+
+            rw_query_regions_hdr_t req;
+            memcpy(&req, buf, sizeof(req));
+            if (req.count == 0 ||
+                hdr.payload_len != sizeof(req) + req.count * sizeof(rw_wire_rect_t)) {
+                send_error(client_fd, 3, "Invalid parameters");
+                continue;
+            }
+            if (!g_results) {
+                send_error(client_fd, 7, "Server handles not set");
+                continue;
+            }
+
+            const size_t reply_len = sizeof(rw_region_stats_hdr_t) + req.count * sizeof(rw_region_stat_t);
+            world_region_t *rects = (world_region_t *)malloc(sizeof(world_region_t) * req.count);
+            region_stat_t *stats = (region_stat_t *)malloc(sizeof(region_stat_t) * req.count);
+            uint8_t *reply = (uint8_t *)malloc(reply_len);
+            if (!rects || !stats || !reply) {
+                free(rects);
+                free(stats);
+                free(reply);
+                send_error(client_fd, 5, "Out of memory");
+                continue;
+            }
+            for (uint32_t i = 0; i < req.count; i++) {
+                rw_wire_rect_t r;
+                memcpy(&r, buf + sizeof(req) + i * sizeof(r), sizeof(r));
+                rects[i].x = r.x > INT32_MAX ? INT32_MAX : (int32_t)r.x;
+                rects[i].y = r.y > INT32_MAX ? INT32_MAX : (int32_t)r.y;
+                rects[i].size.width = r.width > INT32_MAX ? INT32_MAX : (int32_t)r.width;
+                rects[i].size.height = r.height > INT32_MAX ? INT32_MAX : (int32_t)r.height;
+            }
+
+            region_stats_job_t job = {rects, req.count, stats, 0};
+            trace_span_t span;
+            trace_begin(&span, "region stats", NULL, 0);
+            int rc = scheduler_call(SCHED_CONTROL, region_stats_task, &job);
+            trace_end(&span);
+            if (rc != 0) {
+                free(rects);
+                free(stats);
+                free(reply);
+                send_error(client_fd, 27, "Region statistics unavailable (world too large?)");
+                continue;
+            }
+
+            rw_region_stats_hdr_t rh;
+            memset(&rh, 0, sizeof(rh));
+            rh.count = req.count;
+            rh.results_version = job.version;
+            memcpy(reply, &rh, sizeof(rh));
+            for (uint32_t i = 0; i < req.count; i++) {
+                rw_region_stat_t e;
+                e.cells = stats[i].cells;
+                e.trials = stats[i].trials;
+                e.successes = stats[i].successes;
+                e.sum_steps = stats[i].sum_steps;
+                memcpy(reply + sizeof(rh) + i * sizeof(e), &e, sizeof(e));
+            }
+            rw_send_msg(client_fd, RW_MSG_REGION_STATS, reply, (uint32_t)reply_len);
+            free(rects);
+            free(stats);
+            free(reply);
+            continue;
+        }
+
+        if (hdr.type == RW_MSG_EXPORT_IMAGE && hdr.payload_len == sizeof(rw_export_image_t)) {
+            rw_export_image_t req;
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
+                break;
+            }
+            if (!server_context_client_can_control(g_ctx, client_fd)) {
+                send_error(client_fd, 1, "Permission denied");
+                continue;
+            }
+            req.path[RW_PATH_MAX - 1] = '\0';
+            if (!g_world || !g_results) {
+                send_error(client_fd, 13, "Nothing to save");
+                continue;
+            }
+            if (req.field > RW_WIRE_IMAGE_AVG_STEPS || req.colormap > RW_WIRE_CMAP_GRAY ||
+                req.format > RW_WIRE_IMAGE_PNG || !(req.max_value >= 0.0)) {
+                send_error(client_fd, 3, "Invalid parameters");
+                continue;
+            }
+            export_image_job_t job;
+            memset(&job, 0, sizeof(job));
+            job.path = req.path;
+            heatmap_source_from_results(&job.src, g_world, g_results);
+            job.opts.field = (heatmap_field_t)req.field;
+            job.opts.colormap = (heatmap_colormap_t)req.colormap;
+            job.opts.format = (heatmap_format_t)req.format;
+            job.opts.downsample = req.downsample;
+            job.opts.max_value = req.max_value;
+            job.opts.nthreads = g_sm ? g_sm->nthreads : 1;
+
+            trace_span_t span;
+            trace_begin(&span, "export image", NULL, 0);
+            int rc = scheduler_call(SCHED_BACKGROUND, export_image_task, &job);
+            trace_end(&span);
+            if (rc != 0) {
+                send_error(client_fd, 26, "Image export failed");
+                continue;
+            }
+            log_info("EXPORT_IMAGE: %ux%u pixels written to %s", job.width, job.height, req.path);
+            send_ack(client_fd, RW_MSG_EXPORT_IMAGE, 0);
+            continue;
+        }
+
         if (hdr.type == RW_MSG_LOAD_RESULTS && hdr.payload_len == sizeof(rw_load_results_t)) {
             rw_load_results_t req;
-            if (rw_recv_payload(client_fd, &req, sizeof(req)) != 0) {
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
                 break;
             }
             if (!server_context_client_can_control(g_ctx, client_fd)) {
@@ -517,18 +783,474 @@ static void *client_thread(void *arg) {
                 send_error(client_fd, 7, "Server handles not set");
                 continue;
             }
-            if (persist_load_results(req.path, g_ctx, g_world, g_results) != 0) {
+            trace_span_t span;
+            trace_begin(&span, "load results", NULL, 0);
+            int rc = scheduler_call(SCHED_BACKGROUND, load_results_task, req.path);
+            trace_end(&span);
+            if (rc != 0) {
+                server_context_publish_status(g_ctx);
                 send_error(client_fd, 15, "Load failed");
                 continue;
             }
+            server_context_publish_status(g_ctx);
+            memset(&g_ctx->region, 0, sizeof(g_ctx->region));
+            g_ctx->world_file[0] = '\0';
             server_context_set_sim_state(g_ctx, RW_WIRE_SIM_FINISHED);
             send_ack(client_fd, RW_MSG_LOAD_RESULTS, 0);
             continue;
         }
 
+        if (hdr.type == RW_MSG_SOLVE_HIT_TIME && hdr.payload_len == sizeof(rw_solve_hit_time_t)) {
+            rw_solve_hit_time_t req;
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
+                break;
+            }
+            if (!server_context_client_can_control(g_ctx, client_fd)) {
+                send_error(client_fd, 1, "Permission denied");
+                continue;
+            }
+            if (server_context_get_sim_state(g_ctx) == RW_WIRE_SIM_RUNNING) {
+                send_error(client_fd, 2, "Simulation running; stop first");
+                continue;
+            }
+            if (!g_world || !g_results) {
+                send_error(client_fd, 7, "Server handles not set");
+                continue;
+            }
+
+            if (world_cell_count(g_world) > UINT32_MAX) {
+                send_error(client_fd, 16, "World too large for the solver");
+                continue;
+            }
+            double *hit_time = (double *)malloc(sizeof(double) * (size_t)world_cell_count(g_world));
+            if (!hit_time) {
+                send_error(client_fd, 16, "Solver failed");
+                continue;
+            }
+
+            solve_hit_time_job_t job;
+            memset(&job, 0, sizeof(job));
+            job.opts.max_iters = req.max_iters;
+            job.opts.tolerance = req.tolerance;
+            job.opts.nthreads = g_sm ? g_sm->nthreads : 1;
+            job.hit_time = hit_time;
+
+            if (scheduler_call(SCHED_BACKGROUND, solve_hit_time_task, &job) != 0) {
+                free(hit_time);
+                send_error(client_fd, 16, "Solver failed");
+                continue;
+            }
+            const hitting_time_stats_t st = job.st;
+            log_info("SOLVE_HIT_TIME: %s, %d levels, %u iterations, rel_residual=%.3e, finite=%u, infinite=%u",
+                     st.symmetric ? "CG" : "BiCGSTAB", st.levels, st.iterations, st.rel_residual,
+                     st.finite_cells, st.infinite_cells);
+            if (!st.converged) {
+                free(hit_time);
+                send_error(client_fd, 17, "Solver did not converge");
+                continue;
+            }
+
+            results_set_hit_time(g_results, hit_time);
+            send_ack(client_fd, RW_MSG_SOLVE_HIT_TIME, 0);
+            continue;
+        }
+
+        if (hdr.type == RW_MSG_SET_RNG_MODE && hdr.payload_len == sizeof(rw_set_rng_mode_t)) {
+            rw_set_rng_mode_t req;
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
+                break;
+            }
+            if (!server_context_client_can_control(g_ctx, client_fd)) {
+                send_error(client_fd, 1, "Permission denied");
+                continue;
+            }
+            if (server_context_get_sim_state(g_ctx) == RW_WIRE_SIM_RUNNING) {
+                send_error(client_fd, 2, "Simulation running; stop first");
+                continue;
+            }
+            g_ctx->crn_enabled = req.crn_enabled ? 1 : 0;
+            g_ctx->crn_seed = req.seed;
+            log_info("RNG mode: %s (seed=%llu)", g_ctx->crn_enabled ? "CRN" : "independent",
+                     (unsigned long long)g_ctx->crn_seed);
+            send_ack(client_fd, RW_MSG_SET_RNG_MODE, 0);
+            continue;
+        }
+
+        if (hdr.type == RW_MSG_CRN_DIFF && hdr.payload_len == sizeof(rw_crn_diff_t)) {
+            rw_crn_diff_t req;
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
+                break;
+            }
+            if (!server_context_client_can_control(g_ctx, client_fd)) {
+                send_error(client_fd, 1, "Permission denied");
+                continue;
+            }
+            if (server_context_get_sim_state(g_ctx) == RW_WIRE_SIM_RUNNING) {
+                send_error(client_fd, 2, "Simulation running; stop first");
+                continue;
+            }
+            if (!g_world) {
+                send_error(client_fd, 7, "Server handles not set");
+                continue;
+            }
+            if (req.reps < 2 || req.k_b == 0) {
+                send_error(client_fd, 3, "Invalid parameters");
+                continue;
+            }
+            double sum = req.probs_b.p_up + req.probs_b.p_down + req.probs_b.p_left + req.probs_b.p_right;
+            if (sum < 0.999 || sum > 1.001) {
+                send_error(client_fd, 4, "Probabilities must sum to 1");
+                continue;
+            }
+            req.path[RW_PATH_MAX - 1] = '\0';
+
+            crn_diff_job_t job;
+            memset(&job, 0, sizeof(job));
+            job.a.probs = g_ctx->probs;
+            job.a.k_max_steps = g_ctx->k_max_steps;
+            job.b.probs.p_up = req.probs_b.p_up;
+            job.b.probs.p_down = req.probs_b.p_down;
+            job.b.probs.p_left = req.probs_b.p_left;
+            job.b.probs.p_right = req.probs_b.p_right;
+            job.b.k_max_steps = req.k_b;
+            job.reps = req.reps;
+            job.seed = req.seed;
+            job.nthreads = g_sm ? g_sm->nthreads : 1;
+            job.path = req.path;
+
+            if (scheduler_call(SCHED_BACKGROUND, crn_diff_task, &job) != 0) {
+                send_error(client_fd, 18, "CRN diff failed");
+                continue;
+            }
+            const crn_diff_summary_t st = job.st;
+            log_info("CRN_DIFF: %u cells, significant succ=%u steps=%u, mean CI95 succ=%.4f steps=%.2f -> %s",
+                     st.cells, st.succ_significant, st.steps_significant,
+                     st.mean_succ_ci95, st.mean_steps_ci95, req.path);
+            send_ack(client_fd, RW_MSG_CRN_DIFF, 0);
+            continue;
+        }
+
+        if (hdr.type == RW_MSG_EDIT_OBSTACLES) {
+            //bad lengths get an answer too; rw_rx_next() skips the unread payload
+            if (hdr.payload_len < sizeof(rw_obstacle_edit_hdr_t) ||
+                hdr.payload_len > sizeof(rw_obstacle_edit_hdr_t) + RW_OBSTACLE_EDIT_MAX * sizeof(rw_obstacle_edit_t)) {
+                send_error(client_fd, 3, "Invalid parameters");
+                continue;
+            }
+            const uint8_t *buf = rx.payload;
+
+            rw_obstacle_edit_hdr_t req;
+            memcpy(&req, buf, sizeof(req));
+            const rw_obstacle_edit_t *wire = (const rw_obstacle_edit_t *)(buf + sizeof(req));
+
+            if (!server_context_client_can_control(g_ctx, client_fd)) {
+                send_error(client_fd, 1, "Permission denied");
+                continue;
+            }
+            if (server_context_get_sim_state(g_ctx) == RW_WIRE_SIM_RUNNING) {
+                send_error(client_fd, 2, "Simulation running; stop first");
+                continue;
+            }
+            if (!g_world || !g_results || !g_sm) {
+                send_error(client_fd, 7, "Server handles not set");
+                continue;
+            }
+            if (req.count == 0 ||
+                hdr.payload_len != sizeof(req) + req.count * sizeof(rw_obstacle_edit_t)) {
+                send_error(client_fd, 3, "Invalid parameters");
+                continue;
+            }
+            if (world_is_readonly(g_world)) {
+                send_error(client_fd, 19, "World is read-only (mapped file)");
+                continue;
+            }
+
+            obstacle_edit_t *edits = (obstacle_edit_t *)malloc(sizeof(obstacle_edit_t) * req.count);
+            if (!edits) {
+                send_error(client_fd, 5, "Out of memory");
+                continue;
+            }
+            for (uint32_t i = 0; i < req.count; i++) {
+                edits[i].x = (int32_t)wire[i].x;
+                edits[i].y = (int32_t)wire[i].y;
+                edits[i].value = wire[i].value;
+            }
+
+            obstacle_edit_job_t job = {edits, req.count, NULL, 0, 0};
+            int rc = scheduler_call(SCHED_CONTROL, obstacle_edit_task, &job);
+            free(edits);
+            uint64_t *cells = job.cells;
+            const uint32_t changed = job.changed;
+            const uint64_t affected = job.affected;
+            if (rc == -2) {
+                //edits were rolled back, world and results still agree
+                send_error(client_fd, 5, "Out of memory");
+                continue;
+            }
+            if (rc != 0) {
+                send_error(client_fd, 19, "Invalid obstacle edit");
+                continue;
+            }
+
+            //stale results of affected cells are dropped, the rest stays valid
+            results_set_hit_time(g_results, NULL);
+            clear_cells_job_t clear = {cells, affected};
+            if (affected > 0 && scheduler_call(SCHED_BACKGROUND, clear_results_cells_task, &clear) != 0) {
+                //cannot tell which results are stale any more: drop them all
+                free(cells);
+                if (scheduler_call(SCHED_BACKGROUND, reset_results_task, NULL) != 0) {
+                    send_error(client_fd, 6, "results_init failed");
+                } else {
+                    send_error(client_fd, 6, "Failed to clear affected results; all results reset");
+                }
+                continue;
+            }
+
+            uint32_t reps = server_context_get_progress(g_ctx);
+            log_info("EDIT_OBSTACLES: %u cells changed, %llu cells affected (K=%u)%s",
+                     changed, (unsigned long long)affected, g_ctx->k_max_steps,
+                     (req.resimulate && reps > 0 && affected > 0) ? ", re-simulating" : "");
+
+            if (req.resimulate && reps > 0 && affected > 0) {
+                sim_manager_set_on_end(g_sm, on_sim_end_cb, g_ctx);
+                if (sim_manager_start_incremental(g_sm, cells, affected, reps) != 0) {
+                    send_error(client_fd, 10, "Failed to start simulation");
+                    continue;
+                }
+            } else {
+                free(cells);
+            }
+            send_ack(client_fd, RW_MSG_EDIT_OBSTACLES, 0);
+            continue;
+        }
+
+        if (hdr.type == RW_MSG_CLUSTER_SCALING && hdr.payload_len == sizeof(rw_cluster_scaling_t)) {
+            rw_cluster_scaling_t req;
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
+                break;
+            }
+            if (!server_context_client_can_control(g_ctx, client_fd)) {
+                send_error(client_fd, 1, "Permission denied");
+                continue;
+            }
+            if (server_context_get_sim_state(g_ctx) == RW_WIRE_SIM_RUNNING) {
+                send_error(client_fd, 2, "Simulation running; stop first");
+                continue;
+            }
+            if (!g_world || !g_sm) {
+                send_error(client_fd, 7, "Server handles not set");
+                continue;
+            }
+            if (!g_sm->cluster) {
+                send_error(client_fd, 20, "Not in cluster mode");
+                continue;
+            }
+            if (req.reps == 0) {
+                send_error(client_fd, 3, "Invalid parameters");
+                continue;
+            }
+            req.path[RW_PATH_MAX - 1] = '\0';
+
+            cluster_scaling_job_t job;
+            memset(&job, 0, sizeof(job));
+            job.job.world = g_world;
+            job.job.world_file = g_ctx->world_file[0] ? g_ctx->world_file : NULL;
+            job.job.region = g_ctx->region;
+            job.job.probs = g_ctx->probs;
+            job.job.k_max_steps = g_ctx->k_max_steps;
+            job.job.reps = req.reps;
+            job.job.crn = g_ctx->crn_enabled;
+            job.job.crn_seed = g_ctx->crn_seed;
+            job.path = req.path;
+
+            if (scheduler_call(SCHED_BACKGROUND, cluster_scaling_task, &job) != 0) {
+                send_error(client_fd, 21, "Scaling report failed");
+                continue;
+            }
+            log_info("CLUSTER_SCALING: report written to %s", req.path);
+            send_ack(client_fd, RW_MSG_CLUSTER_SCALING, 0);
+            continue;
+        }
+
+        if (hdr.type == RW_MSG_SET_REGION && hdr.payload_len == sizeof(rw_set_region_t)) {
+            rw_set_region_t req;
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
+                break;
+            }
+            if (!server_context_client_can_control(g_ctx, client_fd)) {
+                send_error(client_fd, 1, "Permission denied");
+                continue;
+            }
+            if (server_context_get_sim_state(g_ctx) == RW_WIRE_SIM_RUNNING) {
+                send_error(client_fd, 2, "Simulation running; stop first");
+                continue;
+            }
+            if (!g_world) {
+                send_error(client_fd, 7, "Server handles not set");
+                continue;
+            }
+
+            world_region_t reg;
+            memset(&reg, 0, sizeof(reg));
+            if (req.width != 0 && req.height != 0) {
+                if (req.x > INT32_MAX || req.y > INT32_MAX ||
+                    req.width > INT32_MAX || req.height > INT32_MAX) {
+                    send_error(client_fd, 22, "Region outside the world");
+                    continue;
+                }
+                reg.x = (int32_t)req.x;
+                reg.y = (int32_t)req.y;
+                reg.size.width = (int32_t)req.width;
+                reg.size.height = (int32_t)req.height;
+            }
+            world_region_t resolved;
+            if (world_region_resolve(g_world, &reg, &resolved) != 0) {
+                send_error(client_fd, 22, "Region outside the world");
+                continue;
+            }
+            g_ctx->region = reg;
+            log_info("Region: x=%d y=%d %dx%d (%llu cells)",
+                     resolved.x, resolved.y, resolved.size.width, resolved.size.height,
+                     (unsigned long long)resolved.size.width * (unsigned long long)resolved.size.height);
+            send_ack(client_fd, RW_MSG_SET_REGION, 0);
+            continue;
+        }
+
+        if (hdr.type == RW_MSG_MAP_WORLD && hdr.payload_len == sizeof(rw_map_world_t)) {
+            rw_map_world_t req;
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
+                break;
+            }
+            if (!server_context_client_can_control(g_ctx, client_fd)) {
+                send_error(client_fd, 1, "Permission denied");
+                continue;
+            }
+            if (server_context_get_sim_state(g_ctx) == RW_WIRE_SIM_RUNNING) {
+                send_error(client_fd, 2, "Simulation running; stop first");
+                continue;
+            }
+            if (!g_world || !g_results) {
+                send_error(client_fd, 7, "Server handles not set");
+                continue;
+            }
+            req.path[RW_PATH_MAX - 1] = '\0';
+
+            if (req.mode == RW_WIRE_MAP_GENERATE) {
+                if (req.size.width == 0 || req.size.height == 0 ||
+                    req.size.width > INT32_MAX || req.size.height > INT32_MAX || req.obstacle_percent > 100) {
+                    send_error(client_fd, 3, "Invalid parameters");
+                    continue;
+                }
+                log_info("MAP_WORLD: generating %ux%u (%u%% obstacles) into %s",
+                         req.size.width, req.size.height, req.obstacle_percent, req.path);
+            } else if (req.mode != RW_WIRE_MAP_CONVERT && req.mode != RW_WIRE_MAP_OPEN) {
+                send_error(client_fd, 3, "Invalid parameters");
+                continue;
+            }
+            if (scheduler_call(SCHED_BACKGROUND, write_world_file_task, &req) != 0) {
+                send_error(client_fd, 23, "Failed to write world file");
+                continue;
+            }
+
+            int rc = scheduler_call(SCHED_BACKGROUND, map_world_task, req.path);
+            if (rc != 0) {
+                if (rc == -2) {
+                    send_error(client_fd, 6, "results_init failed");
+                } else {
+                    send_error(client_fd, 8, "Failed to load world file");
+                }
+                continue;
+            }
+            server_context_set_multi_user(g_ctx, req.multi_user);
+            server_context_publish_status(g_ctx);
+            memset(&g_ctx->region, 0, sizeof(g_ctx->region));
+            snprintf(g_ctx->world_file, sizeof(g_ctx->world_file), "%s", req.path);
+            server_context_set_progress(g_ctx, 0);
+
+            log_info("MAP_WORLD: mapped %s (%dx%d, %llu MB of tiles)",
+                     req.path, g_world->size.width, g_world->size.height,
+                     (unsigned long long)(world_obstacle_bytes(g_world) >> 20));
+            server_context_set_sim_state(g_ctx, RW_WIRE_SIM_LOBBY);
+            send_ack(client_fd, RW_MSG_MAP_WORLD, 0);
+            continue;
+        }
+
+        if (hdr.type == RW_MSG_IMPORT_IMAGE && hdr.payload_len == sizeof(rw_import_image_t)) {
+            rw_import_image_t req;
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
+                break;
+            }
+            if (!server_context_client_can_control(g_ctx, client_fd)) {
+                send_error(client_fd, 1, "Permission denied");
+                continue;
+            }
+            if (server_context_get_sim_state(g_ctx) == RW_WIRE_SIM_RUNNING) {
+                send_error(client_fd, 2, "Simulation already running");
+                continue;
+            }
+            if (!g_world || !g_results) {
+                send_error(client_fd, 7, "Server handles not set");
+                continue;
+            }
+            req.path[RW_PATH_MAX - 1] = '\0';
+            server_context_set_multi_user(g_ctx, req.multi_user);
+
+            //world, results and ctx change together or not at all
+            int rc = scheduler_call(SCHED_BACKGROUND, import_image_task, &req);
+            if (rc != 0) {
+                if (rc == -2) {
+                    send_error(client_fd, 6, "results_init failed");
+                } else {
+                    send_error(client_fd, 8, "Failed to load world file");
+                }
+                continue;
+            }
+            server_context_publish_status(g_ctx);
+            memset(&g_ctx->region, 0, sizeof(g_ctx->region));
+            g_ctx->world_file[0] = '\0';
+            server_context_set_progress(g_ctx, 0);
+
+            server_context_set_sim_state(g_ctx, RW_WIRE_SIM_LOBBY);
+            send_ack(client_fd, RW_MSG_IMPORT_IMAGE, 0);
+            continue;
+        }
+
+        if (hdr.type == RW_MSG_TRACE && hdr.payload_len == sizeof(rw_trace_t)) {
+            rw_trace_t req;
+            if (rw_rx_payload(&rx, &req, sizeof(req)) != 0) {
+                break;
+            }
+            if (!server_context_client_can_control(g_ctx, client_fd)) {
+                send_error(client_fd, 1, "Permission denied");
+                continue;
+            }
+            req.path[RW_PATH_MAX - 1] = '\0';
+
+            if (req.action == RW_WIRE_TRACE_START) {
+                if (trace_start() != 0) {
+                    send_error(client_fd, 6, "trace_start failed");
+                    continue;
+                }
+                log_info("TRACE: recording started");
+            } else if (req.action == RW_WIRE_TRACE_STOP) {
+                trace_stop();
+                log_info("TRACE: recording stopped");
+            } else if (req.action == RW_WIRE_TRACE_DUMP) {
+                if (trace_dump(req.path, NULL) != 0) {
+                    send_error(client_fd, 24, "Failed to write trace file");
+                    continue;
+                }
+            } else {
+                send_error(client_fd, 3, "Invalid parameters");
+                continue;
+            }
+            send_ack(client_fd, RW_MSG_TRACE, 0);
+            continue;
+        }
+
         if (hdr.type == RW_MSG_QUIT && hdr.payload_len == sizeof(rw_quit_t)) {
             rw_quit_t q;
-            if (rw_recv_payload(client_fd, &q, sizeof(q)) != 0) {
+            if (rw_rx_payload(&rx, &q, sizeof(q)) != 0) {
                 break;
             }
             if (q.stop_if_owner && server_context_client_can_control(g_ctx, client_fd)) {
@@ -537,33 +1259,20 @@ static void *client_thread(void *arg) {
                 }
             }
             send_ack(client_fd, RW_MSG_QUIT, 0);
+            quit = 1;
             break;
         }
 
-        //unknown message type
-        if (hdr.payload_len > 0) {
-            char buf[256];
-            uint32_t left = hdr.payload_len;
-
-            while (left > 0) {
-                uint32_t chunk = left > sizeof(buf) ? sizeof(buf) : left;
-                if (rw_recv_payload(client_fd, buf, chunk) != 0) {
-                    left = 0;
-                    break;
-                }
-                left -= chunk;
-            }
-        }
+        //unknown message type: rw_rx_next() skips its payload
     }
+    log_debug("Client fd=%d: %llu messages in %llu reads", client_fd,
+              (unsigned long long)rx.frames, (unsigned long long)rx.reads);
+    rw_rx_free(&rx);
     //cleanup
-    server_context_remove_client(g_ctx, client_fd);
-
-    /* If owner left, clear owner (next client may become owner). */
-    if (server_context_get_owner_fd(g_ctx) == client_fd) {
-        server_context_set_owner_fd(g_ctx, -1);
-    }
+    server_context_close_session(g_ctx, client_fd, !quit);
 
-    close(client_fd);
+    //closes the socket once no broadcast uses it any more
+    server_context_remove_client(g_ctx, client_fd);
 
     log_info("Client disconnected (fd=%d)", client_fd);
     return NULL;
@@ -575,13 +1284,14 @@ static void *client_thread(void *arg) {
  * @brief Process a client's JOIN request and send WELCOME.
  *
  * @param client_fd Client socket.
+ * @param rx        Receiver of the connection.
  * @return 0 on success, -1 on error.
  */
-static int handle_join(int client_fd) {
+static int handle_join(int client_fd, rw_rx_buf_t *rx) {
     rw_msg_hdr_t hdr;
 
     /*expect JOIN message*/
-    if (rw_recv_hdr(client_fd, &hdr) != 0) {
+    if (rw_rx_next(rx, &hdr) != 0) {
         log_error("Failed to receive message header from client (fd=%d)", client_fd);
         return -1;
     }
@@ -594,17 +1304,25 @@ static int handle_join(int client_fd) {
         return -1;
     }
     rw_join_t join_msg;
-    if (rw_recv_payload(client_fd, &join_msg, sizeof(join_msg)) != 0) {
+    if (rw_rx_payload(rx, &join_msg, sizeof(join_msg)) != 0) {
         log_error("Failed to receive JOIN message payload from client (fd=%d)", client_fd);
         return -1;
     }
 
-    log_info("Client (pid=%d) joined (fd=%d)", join_msg.pid, client_fd);
-
     /*send WELCOME message*/
     rw_welcome_t welcome_msg;
     memset(&welcome_msg, 0, sizeof(welcome_msg));
 
+    uint64_t token = 0;
+    uint8_t is_owner = 0;
+    int resumed = server_context_open_session(g_ctx, client_fd, join_msg.resume_token, &token, &is_owner);
+    welcome_msg.session_token = token;
+    welcome_msg.is_owner = is_owner;
+    welcome_msg.resumed = (uint8_t)resumed;
+    welcome_msg.server_instance = g_ctx->session_prefix >> 32;
+    log_info("Client (pid=%d) %s (fd=%d)%s", join_msg.pid, resumed ? "resumed its session" : "joined",
+             client_fd, welcome_msg.is_owner ? ", owner" : "");
+
     welcome_msg.world_kind = (rw_wire_world_kinds_t)g_ctx->world_kind;
     welcome_msg.size.width = (uint32_t)g_ctx->world_size.width;
     welcome_msg.size.height = (uint32_t)g_ctx->world_size.height;
@@ -625,6 +1343,8 @@ static int handle_join(int client_fd) {
     if (rw_send_msg(client_fd, RW_MSG_WELCOME,
                     &welcome_msg, sizeof(welcome_msg)) != 0) {
         log_error("Failed to send WELCOME message to client (fd=%d)", client_fd);
+        //a new token never reached the client, a resumed one may be retried
+        server_context_close_session(g_ctx, client_fd, resumed);
         return -1;
     }
     log_info("WELCOME (pid=%d)", join_msg.pid);
@@ -703,3 +1423,161 @@ static void on_sim_end_cb(void *user, int stopped) {
     server_context_t *ctx = (server_context_t *)user;
     broadcast_end_msg(ctx, stopped ? 1u : 0u);
 }
+
+/*======================================================================
+ *Background tasks
+ *======================================================================*/
+
+/* New world of the configured kind and size (CREATE_SIM). */
+static int create_world_task(void *arg) {
+    (void)arg;
+    world_destroy(g_world);
+    if (world_init(g_world, g_ctx->world_kind, g_ctx->world_size) != 0) {
+        return -1;
+    }
+    if (g_ctx->world_kind == WORLD_OBSTACLES) {
+        world_generate_obstacles(g_world, 10, 12345);
+    }
+    return 0;
+}
+
+/* Empty results for the current world size. */
+static int reset_results_task(void *arg) {
+    (void)arg;
+    results_destroy(g_results);
+    return results_init(g_results, g_ctx->world_size);
+}
+
+/*
+ * Swap @p w in as the server world together with results of its size.
+ * Returns -2 if the results cannot be allocated; @p w is then destroyed and
+ * world, results and ctx keep the previous size.
+ */
+static int install_world(world_t *w) {
+    results_destroy(g_results);
+    if (results_init(g_results, w->size) != 0) {
+        world_destroy(w);
+        if (results_init(g_results, g_ctx->world_size) != 0) {
+            log_error("Cannot restore results of the previous world");
+        }
+        return -2;
+    }
+
+    world_destroy(g_world);
+    *g_world = *w;
+    g_ctx->world_kind = w->kind;
+    g_ctx->world_size = w->size;
+    return 0;
+}
+
+/* LOAD_WORLD: -1 if the file cannot be read, -2 if the results cannot be allocated. */
+static int load_world_task(void *arg) {
+    world_t w;
+    memset(&w, 0, sizeof(w));
+
+    //the file's configuration only applies together with its world
+    const move_probs_t probs = g_ctx->probs;
+    const uint32_t k_max_steps = g_ctx->k_max_steps;
+    const uint32_t total_reps = g_ctx->total_reps;
+    const world_kind_t kind = g_ctx->world_kind;
+    const world_size_t size = g_ctx->world_size;
+
+    if (persist_load_world((const char *)arg, &w, g_ctx) != 0) {
+        return -1;
+    }
+    g_ctx->world_kind = kind;
+    g_ctx->world_size = size;
+    if (install_world(&w) != 0) {
+        g_ctx->probs = probs;
+        g_ctx->k_max_steps = k_max_steps;
+        g_ctx->total_reps = total_reps;
+        return -2;
+    }
+    return 0;
+}
+
+/* MAP_WORLD: -1 if the tile file cannot be mapped, -2 if the results cannot be allocated. */
+static int map_world_task(void *arg) {
+    world_t w;
+    if (world_tiles_map(&w, (const char *)arg) != 0) {
+        return -1;
+    }
+    return install_world(&w);
+}
+
+static int save_results_task(void *arg) {
+    return persist_save_results((const char *)arg, g_ctx, g_world, g_results);
+}
+
+static int load_results_task(void *arg) {
+    return persist_load_results((const char *)arg, g_ctx, g_world, g_results);
+}
+
+static int export_image_task(void *arg) {
+    export_image_job_t *job = (export_image_job_t *)arg;
+    return heatmap_export(job->path, &job->src, &job->opts, &job->width, &job->height);
+}
+
+/* Tile file of MAP_WORLD: generated, converted from the current world, or existing (OPEN). */
+static int write_world_file_task(void *arg) {
+    const rw_map_world_t *req = (const rw_map_world_t *)arg;
+    if (req->mode == RW_WIRE_MAP_GENERATE) {
+        world_kind_t kind = (req->world_kind == RW_WIRE_WORLD_OBSTACLES) ? WORLD_OBSTACLES : WORLD_WRAP;
+        world_size_t size = {(int32_t)req->size.width, (int32_t)req->size.height};
+        return world_tiles_generate(req->path, kind, size, req->obstacle_percent, req->seed);
+    }
+    if (req->mode == RW_WIRE_MAP_CONVERT) {
+        return world_tiles_save(req->path, g_world);
+    }
+    return 0;
+}
+
+/*
+ * IMPORT_IMAGE: the world is imported aside and swapped in together with
+ * results of its size. Returns -1 if the image cannot be imported, -2 if the
+ * results cannot be allocated; either way world, results and ctx keep the
+ * previous size.
+ */
+static int import_image_task(void *arg) {
+    const rw_import_image_t *req = (const rw_import_image_t *)arg;
+    world_kind_t kind = (req->world_kind == RW_WIRE_WORLD_OBSTACLES) ? WORLD_OBSTACLES : WORLD_WRAP;
+
+    world_t w;
+    memset(&w, 0, sizeof(w));
+    if (world_import_pnm(req->path, kind, req->threshold, &w, NULL) != 0) {
+        return -1;
+    }
+    return install_world(&w);
+}
+
+static int clear_results_cells_task(void *arg) {
+    const clear_cells_job_t *job = (const clear_cells_job_t *)arg;
+    return results_clear_cells(g_results, job->cells, job->count);
+}
+
+static int solve_hit_time_task(void *arg) {
+    solve_hit_time_job_t *job = (solve_hit_time_job_t *)arg;
+    return hitting_time_solve(g_world, g_ctx->probs, &job->opts, job->hit_time, &job->st);
+}
+
+static int crn_diff_task(void *arg) {
+    crn_diff_job_t *job = (crn_diff_job_t *)arg;
+    return crn_diff_run(g_world, job->a, job->b, job->reps, job->seed, job->nthreads, job->path, &job->st);
+}
+
+static int cluster_scaling_task(void *arg) {
+    const cluster_scaling_job_t *job = (const cluster_scaling_job_t *)arg;
+    return cluster_scaling_report(g_sm->cluster, &job->job, job->path);
+}
+
+static int obstacle_edit_task(void *arg) {
+    obstacle_edit_job_t *job = (obstacle_edit_job_t *)arg;
+    return obstacle_edit_apply(g_world, job->edits, job->count, g_ctx->k_max_steps,
+                               &job->cells, &job->changed, &job->affected);
+}
+
+static int region_stats_task(void *arg) {
+    region_stats_job_t *job = (region_stats_job_t *)arg;
+    return region_stats_query(g_results, job->rects, job->count, g_sm ? g_sm->nthreads : 1,
+                              job->stats, &job->version);
+}
@@ -5,10 +5,17 @@
 #include "world.h"
 #include "results.h"
 #include "sim_manager.h"
+#include "cluster.h"
+#include "latency_stats.h"
+#include "scheduler.h"
 
 #include "../common/util.h"
+#include "../common/log_ring.h"
 
 #include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 /* jednoduché ukončenie cez Ctrl+C */
@@ -19,7 +26,66 @@ static void on_sigint(int sig) {
     g_stop = 1;
 }
 
-int main(void) {
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [--threads N] [--workers N] [--worker-threads T] [--log-level L] [--stats-interval S]\n", argv0);
+    fprintf(stderr, "  --threads N         scheduler threads: simulation, snapshots, saves (default 4)\n");
+    fprintf(stderr, "  --workers N         cluster mode: run simulations in N worker processes\n");
+    fprintf(stderr, "  --worker-threads T  simulation threads per worker process (default 1)\n");
+    fprintf(stderr, "  --log-level L       debug, info (default) or error\n");
+    fprintf(stderr, "  --stats-interval S  log request latencies every S seconds (default 60, 0 = off)\n");
+}
+
+int main(int argc, char **argv) {
+    int threads = 4;
+    int workers = 0;
+    int worker_threads = 1;
+    int stats_interval = 60;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--worker-threads") == 0 && i + 1 < argc) {
+            worker_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--stats-interval") == 0 && i + 1 < argc) {
+            stats_interval = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            const char *l = argv[++i];
+            if (strcmp(l, "debug") == 0) {
+                rw_log_set_level(RW_LOG_DEBUG);
+            } else if (strcmp(l, "info") == 0) {
+                rw_log_set_level(RW_LOG_INFO);
+            } else if (strcmp(l, "error") == 0) {
+                rw_log_set_level(RW_LOG_ERROR);
+            } else {
+                usage(argv[0]);
+                return 1;
+            }
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (threads <= 0 || workers < 0 || worker_threads <= 0 || stats_interval < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    /* a dead worker process must not kill the coordinator on write */
+    signal(SIGPIPE, SIG_IGN);
+
+    /* ===== 0) cluster workers (fork before any thread exists) ===== */
+    cluster_t cluster;
+    if (workers > 0 && cluster_spawn(&cluster, workers, worker_threads) != 0) {
+        die("cluster_spawn failed");
+    }
+
+    /* logging off the hot paths (after fork: workers keep synchronous logging) */
+    if (log_ring_start() != 0) {
+        log_error("log_ring_start failed, logging synchronously");
+    }
+
     signal(SIGINT, on_sigint);
 
     /* ===== 1) server context ===== */
@@ -41,6 +107,7 @@ int main(void) {
     ctx.current_rep = 0;
 
     ctx.global_mode = MODE_SUMMARY;
+    server_context_publish_status(&ctx);
 
     const char *socket_path = "/tmp/rw_test.sock";
 
@@ -64,7 +131,12 @@ int main(void) {
         die("results_init failed");
     }
 
-    /* ===== 4) IPC server ===== */
+    /* ===== 4) scheduler + IPC server ===== */
+    if (scheduler_start(threads) != 0) {
+        die("scheduler_start failed");
+    }
+    log_info("Scheduler running with %d threads", threads);
+
     if (server_ipc_start(socket_path, &ctx) != 0) {
         die("server_ipc_start failed");
     }
@@ -72,12 +144,16 @@ int main(void) {
     /* ===== 5) sim manager ===== */
     sim_manager_t sm;
     if (sim_manager_init(&sm, &ctx, &world, &results,
-                         4,        /* nthreads */
+                         threads,  /* parallel walk batches */
                          8192      /* queue capacity */
                          ) != 0) {
         die("sim_manager_init failed");
     }
 
+    if (workers > 0) {
+        sim_manager_set_cluster(&sm, &cluster);
+    }
+
     /* Provide handles for menu control-plane. */
     server_ipc_set_sim_handles(&ctx, &world, &results, &sm);
 
@@ -85,9 +161,19 @@ int main(void) {
 
     log_info("Server running (lobby). Ctrl+C to stop.");
 
-    /* ===== 6) main loop ===== */
+    /* ===== 6) main loop (periodic latency report) ===== */
+    latency_stats_log_interval();
+    int ticks = 0;
     while (!g_stop) {
-        pause();
+        if (stats_interval == 0) {
+            pause();
+            continue;
+        }
+        sleep(1);
+        if (++ticks >= stats_interval) {
+            latency_stats_log_interval();
+            ticks = 0;
+        }
     }
 
     log_info("Stopping...");
@@ -97,10 +183,16 @@ int main(void) {
     sim_manager_destroy(&sm);
 
     server_ipc_stop();
+    scheduler_stop();
+
+    if (workers > 0) {
+        cluster_shutdown(&cluster);
+    }
 
     results_destroy(&results);
     world_destroy(&world);
     server_context_destroy(&ctx);
 
+    log_ring_stop();
     return 0;
 }
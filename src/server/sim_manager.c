@@ -2,13 +2,18 @@
 // Created by Jozef Jelšík on 26/12/2025.
 //
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "sim_manager.h"
+#include "trace.h"
 
 #include  "../common/protocol.h"
 #include  "../common/util.h"
 
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
+#include <time.h>
 #include <unistd.h>
 
 /*======== broadcast PROGRESS =====*/
@@ -35,15 +40,49 @@ static void broadcast_progress(server_context_t *ctx,
 
 /*======== sim thread ========*/
 
-static void *sim_thread_main(void *arg) {
-    sim_manager_t *sm = (sim_manager_t*)arg;
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
 
-    sm->running = 1;
-    sm->stop_requested = 0;
+/* Major page faults of the process so far (tiles paged in from a mapped world). */
+static long major_faults(void) {
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+    return ru.ru_majflt;
+}
 
-    server_context_set_sim_state(sm->ctx, RW_WIRE_SIM_RUNNING);
-    server_context_set_progress(sm->ctx, 0);
+static int region_contains(const world_region_t *reg, int32_t x, int32_t y) {
+    return x >= reg->x && y >= reg->y &&
+           (int64_t)x < (int64_t)reg->x + reg->size.width &&
+           (int64_t)y < (int64_t)reg->y + reg->size.height;
+}
+
+/* Submit one replication of the listed cells (incremental run); returns the walks submitted. */
+static uint64_t submit_cells(sim_manager_t *sm, const world_region_t *reg, uint32_t rep) {
+    const uint64_t width = (uint64_t)sm->world->size.width;
+    uint64_t walks = 0;
+    for (uint64_t i = 0; i < sm->cell_count && !sm->stop_requested; i++) {
+        const uint64_t idx = sm->cells[i];
+        pos_t p = {(int32_t)(idx % width), (int32_t)(idx / width)};
+        if (!region_contains(reg, p.x, p.y) || world_is_obstacle_idx(sm->world, idx)) {
+            continue;
+        }
 
+        rw_job_t job;
+        job.cell_idx = idx;
+        job.start = p;
+        job.rep = rep;
+
+        worker_pool_submit(&sm->pool, job);
+        walks++;
+    }
+    return walks;
+}
+
+/* Run replications of the start cells in @p reg (or of the listed cells) on the in-process worker pool. */
+static void run_local(sim_manager_t *sm, const world_region_t *reg, uint32_t total_reps) {
     if (worker_pool_init(&sm->pool,
                          sm->nthreads,
                          sm->queue_capacity,
@@ -53,53 +92,144 @@ static void *sim_thread_main(void *arg) {
                          sm->ctx->k_max_steps) != 0) {
         die("sim_manager: worker_pool_init() failed");
                          }
+    worker_pool_set_crn(&sm->pool, sm->ctx->crn_enabled, sm->ctx->crn_seed);
 
-    //results are acumulated over all reps -> clear at start
-
-    results_clear(sm->results);
+    uint64_t walks = 0;
+    double t0 = now_s();
+    long faults0 = major_faults();
 
-    uint32_t W = sm->world->size.width;
-    uint32_t H = sm->world->size.height;
-
-    for (uint32_t rep = 1; rep <= sm->ctx->total_reps; rep++) {
+    for (uint32_t rep = 1; rep <= total_reps; rep++) {
         if (sm->stop_requested) {
             break;
         }
 
-        for (uint32_t y = 0; y < H; y++) {
-            for (uint32_t x = 0; x < W; x++) {
-                if (sm->stop_requested) break;
+        trace_span_t rep_span, span;
+        trace_begin(&rep_span, "replication", "rep", rep);
 
-                if (world_is_obstacle_xy(sm->world, (int32_t)x, (int32_t)y)) {
-                    continue;
-                }
+        //tile order for mapped worlds: walks in flight start close to each other
+        world_scan_t scan;
+        pos_t p;
+        world_scan_begin(&scan, sm->world, reg);
+        while (!sm->cells && !sm->stop_requested && world_scan_next(&scan, &p)) {
+            if (world_is_obstacle_xy(sm->world, p.x, p.y)) {
+                continue;
+            }
 
-                uint32_t idx = world_index(sm->world, (int32_t)x, (int32_t)y);
+            uint64_t idx = world_index(sm->world, p.x, p.y);
 
-                rw_job_t job;
-                job.cell_idx = idx;
-                job.start.x = (int32_t)x;
-                job.start.y = (int32_t)y;
+            rw_job_t job;
+            job.cell_idx = idx;
+            job.start = p;
+            job.rep = rep;
 
-                worker_pool_submit(&sm->pool, job);
-            }
-            if (sm->stop_requested) break;
+            worker_pool_submit(&sm->pool, job);
+            walks++;
+        }
+        if (sm->cells) {
+            walks += submit_cells(sm, reg, rep);
         }
         //wait for all jobs to finish
+        trace_begin(&span, "wait workers", "rep", rep);
         worker_pool_wait_all(&sm->pool);
+        trace_end(&span);
 
         //update progress
         server_context_set_progress(sm->ctx, rep);
 
         //broadcast progress
-        broadcast_progress(sm->ctx, rep, sm->ctx->total_reps);
+        trace_begin(&span, "progress broadcast", "rep", rep);
+        broadcast_progress(sm->ctx, rep, total_reps);
+        trace_end(&span);
+        trace_end(&rep_span);
 
-        log_info("Replication %u/%u completed", rep, sm->ctx->total_reps);
+        log_info("Replication %u/%u completed%s", rep, total_reps, sm->cells ? " (incremental)" : "");
     }
 
     worker_pool_stop(&sm->pool);
     worker_pool_destroy(&sm->pool);
 
+    double wall = now_s() - t0;
+    log_info("Local run: %llu walks in %.3f s (%.0f walks/s, %ld major page faults%s)",
+             (unsigned long long)walks, wall, wall > 0.0 ? (double)walks / wall : 0.0,
+             major_faults() - faults0, world_is_readonly(sm->world) ? ", mapped world" : "");
+}
+
+static void on_cluster_rep(void *user, uint32_t rep, uint32_t total) {
+    sim_manager_t *sm = (sim_manager_t*)user;
+
+    server_context_set_progress(sm->ctx, rep);
+    broadcast_progress(sm->ctx, rep, total);
+
+    log_info("Replication %u/%u completed (cluster)", rep, total);
+}
+
+/* Run replications on the cluster worker processes. */
+static void run_cluster(sim_manager_t *sm, const world_region_t *reg, uint32_t total_reps) {
+    cluster_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.world = sm->world;
+    job.world_file = sm->ctx->world_file[0] ? sm->ctx->world_file : NULL;
+    job.region = *reg;
+    job.probs = sm->ctx->probs;
+    job.k_max_steps = sm->ctx->k_max_steps;
+    job.reps = total_reps;
+    job.crn = sm->ctx->crn_enabled;
+    job.crn_seed = sm->ctx->crn_seed;
+
+    cluster_run_stats_t st;
+    trace_span_t span;
+    trace_begin(&span, "cluster run", "reps", total_reps);
+    int rc = cluster_run(sm->cluster, &job, sm->results, &sm->stop_requested,
+                         on_cluster_rep, sm, &st);
+    trace_end(&span);
+    if (rc != 0) {
+        log_error("sim_manager: cluster run failed; results are incomplete");
+        return;
+    }
+
+    double x = st.wall_s > 0.0 ? (double)st.walks / st.wall_s : 0.0;
+    double util = st.wall_s > 0.0 ? st.busy_s / (st.wall_s * (double)st.nworkers) : 0.0;
+    log_info("Cluster run: %d workers, %u reps, %llu walks in %.3f s (%.0f walks/s, worker utilization %.1f%%)",
+             st.nworkers, st.reps_done, (unsigned long long)st.walks, st.wall_s, x, 100.0 * util);
+}
+
+static void *sim_thread_main(void *arg) {
+    sim_manager_t *sm = (sim_manager_t*)arg;
+
+    trace_thread_name("sim");
+
+    sm->running = 1;
+    sm->stop_requested = 0;
+
+    server_context_set_sim_state(sm->ctx, RW_WIRE_SIM_RUNNING);
+    server_context_set_progress(sm->ctx, 0);
+
+    //results are acumulated over all reps -> clear at start (full run only)
+    const int incremental = sm->cells != NULL;
+    uint32_t total_reps = incremental ? sm->cells_reps : sm->ctx->total_reps;
+
+    if (!incremental) {
+        results_clear(sm->results);
+    }
+
+    //start cells: the configured region (validated by SET_REGION), else the whole world
+    world_region_t reg;
+    if (world_region_resolve(sm->world, &sm->ctx->region, &reg) != 0) {
+        (void)world_region_resolve(sm->world, NULL, &reg);
+    }
+
+    //incremental runs touch few cells -> always in-process
+    if (sm->cluster && !incremental) {
+        run_cluster(sm, &reg, total_reps);
+    } else {
+        run_local(sm, &reg, total_reps);
+    }
+
+    free(sm->cells);
+    sm->cells = NULL;
+    sm->cell_count = 0;
+    sm->cells_reps = 0;
+
     sm->running = 0;
 
     server_context_set_sim_state(sm->ctx, RW_WIRE_SIM_FINISHED);
@@ -160,6 +290,23 @@ int sim_manager_start(sim_manager_t *sm) {
     return 0;
 }
 
+void sim_manager_set_cluster(sim_manager_t *sm, cluster_t *cluster) {
+    if (!sm) return;
+    sm->cluster = cluster;
+}
+
+int sim_manager_start_incremental(sim_manager_t *sm, uint64_t *cells, uint64_t count, uint32_t reps) {
+    if (!sm || !cells || count == 0 || reps == 0 || sm->running) {
+        free(cells);
+        return -1;
+    }
+
+    sm->cells = cells;
+    sm->cell_count = count;
+    sm->cells_reps = reps;
+    return sim_manager_start(sm);
+}
+
 void sim_manager_join(sim_manager_t *sm) {
     if (!sm) return;
     if (sm->running) {
@@ -180,6 +327,7 @@ int sim_manager_restart(sim_manager_t *sm, uint32_t total_reps) {
     if (total_reps == 0) return -1;
 
     sm->ctx->total_reps = total_reps;
+    server_context_publish_status(sm->ctx);
     server_context_set_progress(sm->ctx, 0);
     server_context_set_sim_state(sm->ctx, RW_WIRE_SIM_LOBBY);
 
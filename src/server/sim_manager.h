@@ -14,6 +14,13 @@
  * - submits per-cell random-walk jobs to the worker pool
  * - updates progress in @ref server_context_t
  *
+ * In cluster mode (@ref sim_manager_set_cluster()) full runs are executed by
+ * worker processes instead of the local pool; see cluster.h.
+ *
+ * Only start cells inside @ref server_context_t::region are simulated (all
+ * cells when the region is empty), so a small region of a huge world only
+ * touches the result pages of that region.
+ *
  * It does not handle client IO directly; IPC is handled by the server IPC layer.
  */
 
@@ -21,6 +28,7 @@
 #include  "world.h"
 #include  "results.h"
 #include  "worker_pool.h"
+#include  "cluster.h"
 
 #include <pthread.h>
 #include <stdint.h>
@@ -55,6 +63,22 @@ typedef struct {
     /** Non-zero when a stop was requested. */
     int stop_requested;
 
+    /**
+     * Incremental run (see @ref sim_manager_start_incremental()): only these
+     * cells are simulated and results are not cleared. NULL for a full run.
+     * Owned by the manager while set.
+     */
+    uint64_t *cells;
+
+    /** Number of entries in @ref cells. */
+    uint64_t cell_count;
+
+    /** Number of replications of the incremental run. */
+    uint32_t cells_reps;
+
+    /** Worker processes for full runs, or NULL to simulate in-process. */
+    cluster_t *cluster;
+
     /** Optional callback invoked when the simulation thread finishes. */
     sim_manager_on_end_fn on_end;
     void *on_end_user;
@@ -99,6 +123,30 @@ void sim_manager_destroy(sim_manager_t *sm);
  */
 int sim_manager_start(sim_manager_t *sm);
 
+/**
+ * @brief Use worker processes for subsequent full runs.
+ *
+ * @param sm      Manager.
+ * @param cluster Spawned cluster (see @ref cluster_spawn()), or NULL for
+ *                in-process simulation.
+ */
+void sim_manager_set_cluster(sim_manager_t *sm, cluster_t *cluster);
+
+/**
+ * @brief Start an incremental run that re-simulates only selected cells.
+ *
+ * Runs @p reps replications over the listed cells that lie in the region,
+ * without clearing results first (the caller clears the selected cells, see
+ * @ref results_clear_cells()). Progress and END are reported as for a full run.
+ *
+ * @param sm    Manager.
+ * @param cells Heap array of linear cell indices; ownership is taken (also on failure).
+ * @param count Number of entries in @p cells.
+ * @param reps  Replications to run.
+ * @return 0 on success, -1 on failure.
+ */
+int sim_manager_start_incremental(sim_manager_t *sm, uint64_t *cells, uint64_t count, uint32_t reps);
+
 /**
  * @brief Join (wait for) the simulation thread if running.
  */
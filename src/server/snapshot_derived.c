@@ -0,0 +1,154 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#include "snapshot_derived.h"
+#include "scheduler.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file snapshot_derived.c
+ * @brief Implementation of the quantized snapshot fields.
+ */
+
+typedef struct {
+    const world_t *w;
+    const results_t *r;
+    world_region_t view;
+    snapshot_derived_t *d;
+    uint64_t i0, i1;      /* view cells [i0, i1), i0 a multiple of 64 */
+    double max_avg;       /* pass 1 output */
+    int pass;
+    sched_task_t task;
+} derived_task_t;
+
+/* World index of view cell @p i. */
+static uint64_t world_idx_of(const derived_task_t *t, uint64_t i) {
+    uint64_t vw = (uint64_t)t->view.size.width;
+    return world_index(t->w, t->view.x + (int32_t)(i % vw), t->view.y + (int32_t)(i / vw));
+}
+
+static void put_code(snapshot_derived_t *d, void *arr, uint64_t i, uint32_t code) {
+    if (d->bits == 8) {
+        ((uint8_t *)arr)[i] = (uint8_t)code;
+    } else {
+        ((uint16_t *)arr)[i] = (uint16_t)code;
+    }
+}
+
+static void derived_task_main(void *arg) {
+    derived_task_t *t = (derived_task_t *)arg;
+    snapshot_derived_t *d = t->d;
+    const uint32_t *trials = results_trials(t->r);
+    const uint64_t *sum_steps = results_sum_steps(t->r);
+    const uint32_t *succ = results_success_leq_k(t->r);
+    const uint32_t m = (1u << d->bits) - 1u;
+
+    for (uint64_t i = t->i0; i < t->i1; i++) {
+        uint64_t wi = world_idx_of(t, i);
+        if (t->pass == 1) {
+            if (succ[wi] > 0) {
+                double avg = (double)sum_steps[wi] / (double)succ[wi];
+                if (avg > t->max_avg) t->max_avg = avg;
+            }
+            continue;
+        }
+
+        uint8_t bit = (uint8_t)(1u << (i & 7u));
+        if (world_is_obstacle_idx(t->w, wi)) d->obstacles[i >> 3] |= bit;
+        if (trials[wi] > 0) d->valid[i >> 3] |= bit;
+
+        uint32_t avg_code = m;
+        if (succ[wi] > 0) {
+            long q = lrint((double)sum_steps[wi] / (double)succ[wi] / d->avg_steps_scale);
+            avg_code = q < (long)(m - 1u) ? (uint32_t)q : m - 1u;
+        }
+        put_code(d, d->avg_steps, i, avg_code);
+
+        uint32_t p_code = 0;
+        if (trials[wi] > 0) {
+            p_code = (uint32_t)lrint((double)succ[wi] / (double)trials[wi] * (double)m);
+            if (p_code > m) p_code = m;
+        }
+        put_code(d, d->p_leq_k, i, p_code);
+    }
+}
+
+/* Run one pass over all tasks (SNAPSHOT class); the calling thread takes task 0. */
+static void run_pass(derived_task_t *tasks, int nthreads, int pass) {
+    sched_group_t g;
+    sched_group_init(&g);
+    for (int i = 0; i < nthreads; i++) tasks[i].pass = pass;
+    for (int i = 1; i < nthreads; i++) {
+        scheduler_submit(SCHED_SNAPSHOT, &tasks[i].task, derived_task_main, &tasks[i], &g);
+    }
+    derived_task_main(&tasks[0]);
+    sched_group_wait(&g);
+    sched_group_destroy(&g);
+}
+
+int snapshot_derived_compute(const world_t *world,
+                             const results_t *results,
+                             const world_region_t *view,
+                             int bits,
+                             int nthreads,
+                             snapshot_derived_t *out) {
+    if (!world || !results || !view || !out || (bits != 8 && bits != 16)) return -1;
+    if (view->size.width <= 0 || view->size.height <= 0) return -1;
+    memset(out, 0, sizeof(*out));
+
+    const uint64_t n = (uint64_t)view->size.width * (uint64_t)view->size.height;
+    const uint64_t words = (n + 63u) / 64u;
+    if (nthreads <= 0) nthreads = 1;
+    if ((uint64_t)nthreads > words) nthreads = (int)words;
+
+    out->cell_count = n;
+    out->bits = (uint8_t)bits;
+    out->avg_steps = malloc((size_t)n * (size_t)(bits / 8));
+    out->p_leq_k = malloc((size_t)n * (size_t)(bits / 8));
+    out->valid = (uint8_t *)calloc((size_t)words, 8u);
+    out->obstacles = (uint8_t *)calloc((size_t)words, 8u);
+    derived_task_t *tasks = (derived_task_t *)calloc((size_t)nthreads, sizeof(*tasks));
+    if (!out->avg_steps || !out->p_leq_k || !out->valid || !out->obstacles || !tasks) {
+        snapshot_derived_free(out);
+        free(tasks);
+        return -1;
+    }
+
+    /* Split on 64-cell boundaries so no two threads write the same mask byte. */
+    for (int i = 0; i < nthreads; i++) {
+        tasks[i].w = world;
+        tasks[i].r = results;
+        tasks[i].view = *view;
+        tasks[i].d = out;
+        tasks[i].i0 = words * (uint64_t)i / (uint64_t)nthreads * 64u;
+        tasks[i].i1 = words * (uint64_t)(i + 1) / (uint64_t)nthreads * 64u;
+        if (tasks[i].i1 > n) tasks[i].i1 = n;
+    }
+
+    run_pass(tasks, nthreads, 1);
+    double max_avg = 0.0;
+    for (int i = 0; i < nthreads; i++) {
+        if (tasks[i].max_avg > max_avg) max_avg = tasks[i].max_avg;
+    }
+    const uint32_t m = (1u << bits) - 1u;
+    out->avg_steps_scale = max_avg > 0.0 ? max_avg / (double)(m - 1u) : 1.0;
+    out->p_leq_k_scale = 1.0 / (double)m;
+
+    run_pass(tasks, nthreads, 2);
+
+    free(tasks);
+    return 0;
+}
+
+void snapshot_derived_free(snapshot_derived_t *d) {
+    if (!d) return;
+    free(d->avg_steps);
+    free(d->p_leq_k);
+    free(d->valid);
+    free(d->obstacles);
+    memset(d, 0, sizeof(*d));
+}
@@ -0,0 +1,75 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_SNAPSHOT_DERIVED_H
+#define SEMPRACA_SNAPSHOT_DERIVED_H
+
+/**
+ * @file snapshot_derived.h
+ * @brief Display-oriented (quantized) snapshot fields computed by the server.
+ *
+ * Instead of the raw counters a client can ask for the two values it shows per
+ * cell, already divided and quantized (see @ref rw_wire_snapshot_format_t):
+ * - avg steps = sum_steps / success_leq_k (cells without a success are n/a),
+ * - p<=K      = success_leq_k / trials.
+ *
+ * Quantization
+ * ------------
+ * With B bits per code (8 or 16) and M = 2^B - 1:
+ * - p<=K uses the fixed scale 1 / M, code = round(p * M);
+ * - avg steps uses scale = max_avg / (M - 1) over the view, code =
+ *   round(avg / scale) in [0, M - 1]; code M marks n/a.
+ * The absolute error is at most scale / 2.
+ *
+ * The valid mask (cell has trials) and the obstacle mask are bitmaps, cell i is
+ * bit (i & 7) of byte i / 8.
+ *
+ * Threads split the view into ranges of whole bitmap words; a first pass finds
+ * the largest average, a second one quantizes with the resulting scale.
+ */
+
+#include "world.h"
+#include "results.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Derived fields of one snapshot view.
+ */
+typedef struct {
+    uint64_t cell_count;      /**< Cells of the view. */
+    uint8_t bits;             /**< 8 or 16 bits per code. */
+    double avg_steps_scale;   /**< Value of one avg steps code step. */
+    double p_leq_k_scale;     /**< Value of one p<=K code step. */
+    void *avg_steps;          /**< cell_count codes (uint8_t or uint16_t). */
+    void *p_leq_k;            /**< cell_count codes (uint8_t or uint16_t). */
+    uint8_t *valid;           /**< Bitmap, (cell_count + 7) / 8 bytes. */
+    uint8_t *obstacles;       /**< Bitmap, (cell_count + 7) / 8 bytes. */
+} snapshot_derived_t;
+
+/**
+ * @brief Compute the derived fields of a view.
+ *
+ * @param world    World.
+ * @param results  Results of @p world.
+ * @param view     Resolved, non-empty rectangle of the world.
+ * @param bits     8 or 16.
+ * @param nthreads Number of parts computed in parallel (<= 0 means 1); the
+ *                 caller computes one, the rest are @ref SCHED_SNAPSHOT tasks.
+ * @param out      Output; release with @ref snapshot_derived_free().
+ * @return 0 on success, -1 on invalid arguments or allocation failure.
+ */
+int snapshot_derived_compute(const world_t *world,
+                             const results_t *results,
+                             const world_region_t *view,
+                             int bits,
+                             int nthreads,
+                             snapshot_derived_t *out);
+
+/**
+ * @brief Free the arrays of @p d (safe on a zeroed or NULL structure).
+ */
+void snapshot_derived_free(snapshot_derived_t *d);
+
+#endif //SEMPRACA_SNAPSHOT_DERIVED_H
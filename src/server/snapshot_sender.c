@@ -3,50 +3,166 @@
 #include "server_context.h"
 #include "world.h"
 #include "results.h"
+#include "scheduler.h"
+#include "snapshot_derived.h"
+#include "trace.h"
 #include "../common/protocol.h"
 #include "../common/util.h"
 
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 static uint32_t next_snapshot_id(void) {
-    static uint32_t counter = 1;
-    return counter++;
+    /* client threads send concurrently; ids are delta bases, so never reuse one */
+    static _Atomic uint32_t counter = 1;
+    return atomic_fetch_add_explicit(&counter, 1u, memory_order_relaxed);
 }
 
 uint32_t snapshot_next_id(void) {
     return next_snapshot_id();
 }
 
-/* Send one field sliced into RW_SNAPSHOT_CHUNK_MAX-sized pieces. */
-static int send_field_chunks(int fd,
-                             uint32_t snapshot_id,
-                             rw_snapshot_field_t field,
-                             const uint8_t *data,
-                             uint32_t total_bytes) {
+/* Destination of the snapshot messages: a socket, or (fd < 0) a growing byte
+ * buffer of encoded frames for the snapshot cache. */
+typedef struct {
+    int fd;
+    uint8_t *buf;
+    size_t len;
+    size_t cap;
+} snap_out_t;
+
+static int snap_emit(snap_out_t *out, rw_msg_type_t type, const void *payload, uint32_t payload_len) {
+    if (out->fd >= 0) {
+        return rw_send_msg(out->fd, type, payload, payload_len);
+    }
+
+    rw_msg_hdr_t hdr;
+    hdr.type = (uint16_t)type;
+    hdr.reserved = 0;
+    hdr.payload_len = payload_len;
+    size_t need = out->len + sizeof(hdr) + payload_len;
+    if (need > SNAPSHOT_CACHE_MAX_BYTES) return -1;
+    if (need > out->cap) {
+        size_t cap = out->cap ? out->cap : 65536u;
+        while (cap < need) cap *= 2u;
+        uint8_t *nb = (uint8_t *)realloc(out->buf, cap);
+        if (!nb) return -1;
+        out->buf = nb;
+        out->cap = cap;
+    }
+    memcpy(out->buf + out->len, &hdr, sizeof(hdr));
+    if (payload_len > 0) memcpy(out->buf + out->len + sizeof(hdr), payload, payload_len);
+    out->len = need;
+    return 0;
+}
+
+/* Gathers rows of the view into RW_SNAPSHOT_CHUNK_MAX-sized chunks. */
+typedef struct {
+    snap_out_t *out;
     rw_snapshot_chunk_t chunk;
-    chunk.snapshot_id = snapshot_id;
-    chunk.field = (uint16_t)field;
-    chunk.reserved = 0;
-
-    uint32_t offset = 0;
-    while (offset < total_bytes) {
-        uint32_t remaining = total_bytes - offset;
-        uint32_t to_copy = remaining < RW_SNAPSHOT_CHUNK_MAX ? remaining : RW_SNAPSHOT_CHUNK_MAX;
-
-        chunk.offset_bytes = offset;
-        chunk.data_len = to_copy;
-        memcpy(chunk.data, data + offset, to_copy);
-
-        if (rw_send_msg(fd, RW_MSG_SNAPSHOT_CHUNK, &chunk,
-                        sizeof(chunk.snapshot_id) + sizeof(chunk.field) + sizeof(chunk.reserved) +
-                        sizeof(chunk.offset_bytes) + sizeof(chunk.data_len) + to_copy) != 0) {
+    uint64_t offset;    /* field bytes already sent */
+} chunk_writer_t;
+
+static int chunk_flush(chunk_writer_t *cw) {
+    if (cw->chunk.data_len == 0) return 0;
+
+    cw->chunk.offset_bytes = cw->offset;
+    if (snap_emit(cw->out, RW_MSG_SNAPSHOT_CHUNK, &cw->chunk,
+                  (uint32_t)(offsetof(rw_snapshot_chunk_t, data) + cw->chunk.data_len)) != 0) {
+        return -1;
+    }
+    cw->offset += cw->chunk.data_len;
+    cw->chunk.data_len = 0;
+    return 0;
+}
+
+static int chunk_append(chunk_writer_t *cw, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        size_t room = RW_SNAPSHOT_CHUNK_MAX - cw->chunk.data_len;
+        size_t n = len < room ? len : room;
+        memcpy(cw->chunk.data + cw->chunk.data_len, data, n);
+        cw->chunk.data_len += (uint32_t)n;
+        data += n;
+        len -= n;
+        if (cw->chunk.data_len == RW_SNAPSHOT_CHUNK_MAX && chunk_flush(cw) != 0) {
             return -1;
         }
-        offset += to_copy;
     }
     return 0;
 }
 
+/* Cells [start, start + len) of the view (row-major view indices). */
+typedef struct {
+    uint64_t start;
+    uint64_t len;
+} cell_run_t;
+
+/* Send the cells of @p runs of one field of the view; @p base is the per-cell
+ * array of the whole world with @p elem_size bytes per cell, or NULL for the
+ * obstacle bitmap. A full snapshot is the single run covering the view. */
+static int send_field_view(snap_out_t *out,
+                           uint32_t snapshot_id,
+                           rw_snapshot_field_t field,
+                           const world_t *world,
+                           const world_region_t *view,
+                           const uint8_t *base,
+                           size_t elem_size,
+                           const cell_run_t *runs,
+                           size_t nruns) {
+    chunk_writer_t cw;
+    memset(&cw, 0, sizeof(cw));
+    cw.out = out;
+    cw.chunk.snapshot_id = snapshot_id;
+    cw.chunk.field = (uint16_t)field;
+
+    const uint64_t vw = (uint64_t)view->size.width;
+    uint8_t row_bytes[256];
+    for (size_t r = 0; r < nruns; r++) {
+        if (chunk_flush(&cw) != 0) return -1;
+        cw.offset = runs[r].start * elem_size;
+
+        const uint64_t end = runs[r].start + runs[r].len;
+        for (uint64_t i = runs[r].start; i < end;) {
+            uint64_t col = i % vw;
+            uint64_t n = vw - col < end - i ? vw - col : end - i;
+            uint64_t row = world_index(world, view->x + (int32_t)col, view->y + (int32_t)(i / vw));
+            i += n;
+
+            if (base) {
+                if (chunk_append(&cw, base + row * elem_size, (size_t)n * elem_size) != 0) return -1;
+                continue;
+            }
+            for (uint64_t x = 0; x < n;) {
+                size_t k = 0;
+                for (; k < sizeof(row_bytes) && x + k < n; k++) {
+                    row_bytes[k] = (uint8_t)world_is_obstacle_idx(world, row + x + k);
+                }
+                if (chunk_append(&cw, row_bytes, k) != 0) return -1;
+                x += k;
+            }
+        }
+    }
+    return chunk_flush(&cw);
+}
+
+/* Send one field from a contiguous buffer of the view. */
+static int send_field_buf(snap_out_t *out,
+                          uint32_t snapshot_id,
+                          rw_snapshot_field_t field,
+                          const void *data,
+                          size_t len) {
+    chunk_writer_t cw;
+    memset(&cw, 0, sizeof(cw));
+    cw.out = out;
+    cw.chunk.snapshot_id = snapshot_id;
+    cw.chunk.field = (uint16_t)field;
+    if (chunk_append(&cw, (const uint8_t *)data, len) != 0) return -1;
+    return chunk_flush(&cw);
+}
+
 static uint32_t field_bit(rw_snapshot_field_t field) {
     /* Protocol enum starts at 1, so shift by (field-1) to build a bitmask. */
     if (field == 0) {
@@ -55,66 +171,465 @@ static uint32_t field_bit(rw_snapshot_field_t field) {
     return 1u << (field - 1);
 }
 
-int snapshot_send_to_client(int fd,
-                            const world_t *world,
-                            const results_t *results,
-                            uint32_t snapshot_id) {
-    if (!world || !results) {
+int snapshot_view_ok(const world_t *world, const world_region_t *view) {
+    world_region_t v;
+    if (!world || world_region_resolve(world, view, &v) != 0) return 0;
+    return (uint64_t)v.size.width * (uint64_t)v.size.height <= RW_SNAPSHOT_MAX_CELLS;
+}
+
+/* Fields of a RAW snapshot. */
+static uint32_t raw_fields(const double *hit_time) {
+    uint32_t f = field_bit(RW_SNAP_FIELD_OBSTACLES) |
+                 field_bit(RW_SNAP_FIELD_TRIALS) |
+                 field_bit(RW_SNAP_FIELD_SUM_STEPS) |
+                 field_bit(RW_SNAP_FIELD_SUCC_LEQ_K);
+    if (hit_time) {
+        f |= field_bit(RW_SNAP_FIELD_HIT_TIME);
+    }
+    return f;
+}
+
+/* Recently sent snapshots, the possible bases of a delta. */
+typedef struct {
+    uint32_t snapshot_id;
+    const world_t *world;
+    const results_t *results;
+    uint64_t version;          /* results version read before encoding */
+    world_region_t view;
+    world_size_t size;
+    world_kind_t kind;
+    uint32_t included_fields;
+} snap_history_t;
+
+static pthread_mutex_t g_history_mtx = PTHREAD_MUTEX_INITIALIZER;
+static snap_history_t g_history[SNAPSHOT_HISTORY_LEN];
+static unsigned g_history_next;
+
+static void history_record(const snap_history_t *h) {
+    pthread_mutex_lock(&g_history_mtx);
+    int known = 0;
+    for (unsigned i = 0; i < SNAPSHOT_HISTORY_LEN; i++) {
+        if (g_history[i].snapshot_id == h->snapshot_id) known = 1;
+    }
+    if (!known) {
+        g_history[g_history_next] = *h;
+        g_history_next = (g_history_next + 1u) % SNAPSHOT_HISTORY_LEN;
+    }
+    pthread_mutex_unlock(&g_history_mtx);
+}
+
+/* Find snapshot @p id if a delta against it can be applied to the current contents. */
+static int history_find(uint32_t id,
+                        const world_t *world,
+                        const results_t *results,
+                        const world_region_t *v,
+                        uint32_t included_fields,
+                        snap_history_t *out) {
+    int rc = -1;
+    pthread_mutex_lock(&g_history_mtx);
+    for (unsigned i = 0; i < SNAPSHOT_HISTORY_LEN; i++) {
+        const snap_history_t *h = &g_history[i];
+        if (h->snapshot_id != id || h->world != world || h->results != results) continue;
+        if (h->size.width != world->size.width || h->size.height != world->size.height ||
+            h->kind != world->kind || h->included_fields != included_fields ||
+            memcmp(&h->view, v, sizeof(*v)) != 0) {
+            break;
+        }
+        *out = *h;
+        rc = 0;
+        break;
+    }
+    pthread_mutex_unlock(&g_history_mtx);
+    return rc;
+}
+
+/* View cells whose results changed after @p since, as merged runs (malloc'd). */
+static int delta_runs(const world_t *world,
+                      const results_t *results,
+                      const world_region_t *v,
+                      uint64_t since,
+                      cell_run_t **out,
+                      size_t *out_n) {
+    const uint64_t vw = (uint64_t)v->size.width;
+    cell_run_t *runs = NULL;
+    size_t n = 0, cap = 0;
+
+    for (int32_t y = 0; y < v->size.height; y++) {
+        uint64_t row = world_index(world, v->x, v->y + y);
+        for (uint64_t x = 0; x < vw;) {
+            /* segment up to the next block boundary of the world */
+            uint64_t seg = RESULTS_BLOCK_CELLS - (row + x) % RESULTS_BLOCK_CELLS;
+            if (seg > vw - x) seg = vw - x;
+            if (results_changed_since(results, since, row + x, seg)) {
+                uint64_t start = (uint64_t)y * vw + x;
+                if (n > 0 && runs[n - 1].start + runs[n - 1].len == start) {
+                    runs[n - 1].len += seg;
+                } else {
+                    if (n == cap) {
+                        size_t nc = cap ? cap * 2u : 64u;
+                        cell_run_t *nr = (cell_run_t *)realloc(runs, nc * sizeof(*nr));
+                        if (!nr) {
+                            free(runs);
+                            return -1;
+                        }
+                        runs = nr;
+                        cap = nc;
+                    }
+                    runs[n].start = start;
+                    runs[n].len = seg;
+                    n++;
+                }
+            }
+            x += seg;
+        }
+    }
+    *out = runs;
+    *out_n = n;
+    return 0;
+}
+
+/* Fields of a derived (quantized) snapshot, see snapshot_derived.h. */
+static int send_derived_fields(snap_out_t *out,
+                               uint32_t snapshot_id,
+                               rw_snapshot_begin_t *begin,
+                               const world_t *world,
+                               const results_t *results,
+                               const world_region_t *v,
+                               const snapshot_opts_t *opts) {
+    snapshot_derived_t d;
+    int bits = opts->format == RW_SNAP_FORMAT_DERIVED16 ? 16 : 8;
+    trace_span_t span;
+    trace_begin(&span, "snapshot derive", "bits", bits);
+    int rc = snapshot_derived_compute(world, results, v, bits, opts->nthreads, &d);
+    trace_end(&span);
+    if (rc != 0) return -1;
+
+    begin->included_fields = field_bit(RW_SNAP_FIELD_VALID_MASK) |
+                             field_bit(RW_SNAP_FIELD_OBSTACLE_MASK) |
+                             field_bit(RW_SNAP_FIELD_AVG_STEPS_Q) |
+                             field_bit(RW_SNAP_FIELD_P_LEQ_K_Q);
+    begin->quant_bits = d.bits;
+    begin->avg_steps_scale = d.avg_steps_scale;
+    begin->p_leq_k_scale = d.p_leq_k_scale;
+
+    size_t mask_len = (size_t)((d.cell_count + 7u) / 8u);
+    size_t code_len = (size_t)d.cell_count * (size_t)(d.bits / 8u);
+    rc = -1;
+    if (snap_emit(out, RW_MSG_SNAPSHOT_BEGIN, begin, sizeof(*begin)) == 0 &&
+        send_field_buf(out, snapshot_id, RW_SNAP_FIELD_VALID_MASK, d.valid, mask_len) == 0 &&
+        send_field_buf(out, snapshot_id, RW_SNAP_FIELD_OBSTACLE_MASK, d.obstacles, mask_len) == 0 &&
+        send_field_buf(out, snapshot_id, RW_SNAP_FIELD_AVG_STEPS_Q, d.avg_steps, code_len) == 0 &&
+        send_field_buf(out, snapshot_id, RW_SNAP_FIELD_P_LEQ_K_Q, d.p_leq_k, code_len) == 0) {
+        rc = 0;
+    }
+    snapshot_derived_free(&d);
+    return rc;
+}
+
+static int send_snapshot(snap_out_t *out,
+                         const world_t *world,
+                         const results_t *results,
+                         const world_region_t *view,
+                         uint32_t snapshot_id,
+                         const snapshot_opts_t *opts) {
+    if (!world || !results || !snapshot_view_ok(world, view)) {
         return -1;
     }
-    uint32_t cell_count = (uint32_t)(world->size.width * world->size.height);
+    world_region_t v;
+    (void)world_region_resolve(world, view, &v);
+    /* every change after this version is resent by a delta against this snapshot */
+    const uint64_t version = results_version(results);
 
     rw_snapshot_begin_t begin;
+    memset(&begin, 0, sizeof(begin));
     begin.snapshot_id = snapshot_id;
     begin.size.width = (uint32_t)world->size.width;
     begin.size.height = (uint32_t)world->size.height;
     begin.world_kind = (world->kind == WORLD_OBSTACLES) ? RW_WIRE_WORLD_OBSTACLES : RW_WIRE_WORLD_WRAP;
-    begin.cell_count = cell_count;
-    begin.included_fields = field_bit(RW_SNAP_FIELD_OBSTACLES) |
-                            field_bit(RW_SNAP_FIELD_TRIALS) |
-                            field_bit(RW_SNAP_FIELD_SUM_STEPS) |
-                            field_bit(RW_SNAP_FIELD_SUCC_LEQ_K);
+    begin.view.x = v.x;
+    begin.view.y = v.y;
+    begin.view_size.width = (uint32_t)v.size.width;
+    begin.view_size.height = (uint32_t)v.size.height;
+    begin.cell_count = (uint64_t)v.size.width * (uint64_t)v.size.height;
 
-    if (rw_send_msg(fd, RW_MSG_SNAPSHOT_BEGIN, &begin, sizeof(begin)) != 0) {
-        return -1;
+    if (opts && opts->format != RW_SNAP_FORMAT_RAW) {
+        if (send_derived_fields(out, snapshot_id, &begin, world, results, &v, opts) != 0) {
+            return -1;
+        }
+        return snap_emit(out, RW_MSG_SNAPSHOT_END, NULL, 0);
     }
 
-    /* Obstacles */
-    if (send_field_chunks(fd, snapshot_id, RW_SNAP_FIELD_OBSTACLES,
-                          world->obstacles, cell_count * sizeof(uint8_t)) != 0) {
-        return -1;
+    //held until the fields are sent: a concurrent SOLVE or edit may replace it
+    const results_hit_time_t *hit_time = results_hit_time_acquire(results);
+    begin.included_fields = raw_fields(hit_time ? hit_time->values : NULL);
+
+    /* Delta: only the cells changed since the base snapshot. */
+    cell_run_t full = {0, begin.cell_count};
+    const cell_run_t *runs = &full;
+    size_t nruns = 1;
+    cell_run_t *delta = NULL;
+    snap_history_t base;
+    if (opts && opts->base_snapshot_id != 0 &&
+        history_find(opts->base_snapshot_id, world, results, &v, begin.included_fields, &base) == 0 &&
+        delta_runs(world, results, &v, base.version, &delta, &nruns) == 0 &&
+        !(nruns == 1 && delta[0].len == begin.cell_count)) { /* all changed: full */
+        runs = delta;
+        begin.base_snapshot_id = base.snapshot_id;
+    } else {
+        nruns = 1;
     }
-    /* Trials */
-    if (send_field_chunks(fd, snapshot_id, RW_SNAP_FIELD_TRIALS,
-                          (const uint8_t *)results_trials(results), cell_count * sizeof(uint32_t)) != 0) {
-        return -1;
+    if (begin.base_snapshot_id != 0) {
+        uint64_t cells = 0;
+        for (size_t i = 0; i < nruns; i++) cells += runs[i].len;
+        log_debug("Snapshot %u: delta against %u, %llu of %llu cells", snapshot_id,
+                  begin.base_snapshot_id, (unsigned long long)cells,
+                  (unsigned long long)begin.cell_count);
     }
-    /* Sum steps */
-    if (send_field_chunks(fd, snapshot_id, RW_SNAP_FIELD_SUM_STEPS,
-                          (const uint8_t *)results_sum_steps(results), cell_count * sizeof(uint64_t)) != 0) {
-        return -1;
+
+    int rc = -1;
+    if (snap_emit(out, RW_MSG_SNAPSHOT_BEGIN, &begin, sizeof(begin)) == 0 &&
+        send_field_view(out, snapshot_id, RW_SNAP_FIELD_OBSTACLES, world, &v,
+                        NULL, sizeof(uint8_t), runs, nruns) == 0 &&
+        send_field_view(out, snapshot_id, RW_SNAP_FIELD_TRIALS, world, &v,
+                        (const uint8_t *)results_trials(results), sizeof(uint32_t), runs, nruns) == 0 &&
+        send_field_view(out, snapshot_id, RW_SNAP_FIELD_SUM_STEPS, world, &v,
+                        (const uint8_t *)results_sum_steps(results), sizeof(uint64_t), runs, nruns) == 0 &&
+        send_field_view(out, snapshot_id, RW_SNAP_FIELD_SUCC_LEQ_K, world, &v,
+                        (const uint8_t *)results_success_leq_k(results), sizeof(uint32_t), runs, nruns) == 0 &&
+        /* Expected hitting time (optional) */
+        (!hit_time ||
+         send_field_view(out, snapshot_id, RW_SNAP_FIELD_HIT_TIME, world, &v,
+                         (const uint8_t *)hit_time->values, sizeof(double), runs, nruns) == 0) &&
+        snap_emit(out, RW_MSG_SNAPSHOT_END, NULL, 0) == 0) {
+        rc = 0;
     }
-    /* Success <= k */
-    if (send_field_chunks(fd, snapshot_id, RW_SNAP_FIELD_SUCC_LEQ_K,
-                          (const uint8_t *)results_success_leq_k(results), cell_count * sizeof(uint32_t)) != 0) {
+    results_hit_time_release(hit_time);
+    free(delta);
+    if (rc != 0) return -1;
+
+    snap_history_t h;
+    memset(&h, 0, sizeof(h));
+    h.snapshot_id = snapshot_id;
+    h.world = world;
+    h.results = results;
+    h.version = version;
+    h.view = v;
+    h.size = world->size;
+    h.kind = world->kind;
+    h.included_fields = begin.included_fields;
+    history_record(&h);
+    return 0;
+}
+
+/* Arguments of encode_task(). */
+typedef struct {
+    snap_out_t out;
+    const world_t *world;
+    const results_t *results;
+    const world_region_t *view;
+    uint32_t snapshot_id;
+    const snapshot_opts_t *opts;
+} encode_job_t;
+
+static int encode_task(void *arg) {
+    encode_job_t *j = (encode_job_t *)arg;
+    return send_snapshot(&j->out, j->world, j->results, j->view, j->snapshot_id, j->opts);
+}
+
+/* Encode the frames into @p out (malloc'd) as a SNAPSHOT task; the caller only writes them.
+ * Fails above SNAPSHOT_CACHE_MAX_BYTES. */
+static int encode_snapshot(snap_out_t *out,
+                           const world_t *world,
+                           const results_t *results,
+                           const world_region_t *view,
+                           uint32_t snapshot_id,
+                           const snapshot_opts_t *opts) {
+    world_region_t v;
+    if ((!opts || (opts->format == RW_SNAP_FORMAT_RAW && opts->base_snapshot_id == 0)) &&
+        world && world_region_resolve(world, view, &v) == 0) {
+        /* obstacles, trials, sum_steps, succ_leq_k and hit_time bytes per cell */
+        const uint64_t raw_bytes = (uint64_t)v.size.width * (uint64_t)v.size.height * 25u;
+        if (raw_bytes > SNAPSHOT_CACHE_MAX_BYTES) return -1;
+    }
+    encode_job_t job = {{.fd = -1}, world, results, view, snapshot_id, opts};
+    int rc = scheduler_call(SCHED_SNAPSHOT, encode_task, &job);
+    if (rc != 0) {
+        free(job.out.buf);
         return -1;
     }
+    *out = job.out;
+    return 0;
+}
+
+int snapshot_send_to_client(int fd,
+                            const world_t *world,
+                            const results_t *results,
+                            const world_region_t *view,
+                            uint32_t snapshot_id,
+                            const snapshot_opts_t *opts) {
+    trace_span_t span;
+    trace_begin(&span, "snapshot send", "fd", fd);
+    snap_out_t out;
+    int rc = encode_snapshot(&out, world, results, view, snapshot_id, opts);
+    if (rc == 0) {
+        rc = rw_send_frames(fd, out.buf, out.len);
+        free(out.buf);
+    } else {
+        /* too large to buffer (a RAW view near RW_SNAPSHOT_MAX_CELLS): gather while streaming */
+        snap_out_t stream = {.fd = fd};
+        rc = send_snapshot(&stream, world, results, view, snapshot_id, opts);
+    }
+    trace_end(&span);
+    return rc;
+}
+
+/* One encoded snapshot; freed by whoever drops the last reference. */
+typedef struct {
+    const world_t *world;
+    const results_t *results;
+    uint64_t version;
+    world_region_t view;
+    world_size_t size;
+    world_kind_t kind;
+    int format;
+    uint8_t *frames;
+    size_t len;
+    int refs;
+} snap_cache_entry_t;
+
+static pthread_mutex_t g_cache_mtx = PTHREAD_MUTEX_INITIALIZER;
+static snap_cache_entry_t *g_cache = NULL;
+
+static void cache_release_locked(snap_cache_entry_t *e) {
+    if (e && --e->refs == 0) {
+        free(e->frames);
+        free(e);
+    }
+}
+
+static int cache_matches(const snap_cache_entry_t *e,
+                         const world_t *world,
+                         const results_t *results,
+                         uint64_t version,
+                         const world_region_t *v,
+                         int format) {
+    return e && e->world == world && e->results == results && e->version == version &&
+           e->format == format &&
+           e->size.width == world->size.width && e->size.height == world->size.height &&
+           e->kind == world->kind && memcmp(&e->view, v, sizeof(*v)) == 0;
+}
+
+/* Cached entry for the current contents (reference taken), or NULL. */
+static snap_cache_entry_t *cache_lookup(const world_t *world,
+                                        const results_t *results,
+                                        uint64_t version,
+                                        const world_region_t *v,
+                                        int format) {
+    pthread_mutex_lock(&g_cache_mtx);
+    snap_cache_entry_t *e = g_cache;
+    if (cache_matches(e, world, results, version, v, format)) {
+        e->refs++;
+    } else {
+        e = NULL;
+    }
+    pthread_mutex_unlock(&g_cache_mtx);
+    return e;
+}
 
-    if (rw_send_msg(fd, RW_MSG_SNAPSHOT_END, NULL, 0) != 0) {
+/* Encode the snapshot into a new entry (reference taken) and publish it,
+ * unless the results changed while encoding. */
+static snap_cache_entry_t *cache_build(const world_t *world,
+                                       const results_t *results,
+                                       uint64_t version,
+                                       const world_region_t *v,
+                                       const snapshot_opts_t *opts) {
+    snap_cache_entry_t *e = (snap_cache_entry_t *)calloc(1, sizeof(*e));
+    if (!e) return NULL;
+
+    snap_out_t out;
+    if (encode_snapshot(&out, world, results, v, next_snapshot_id(), opts) != 0) {
+        free(e);
+        return NULL;
+    }
+    e->world = world;
+    e->results = results;
+    e->version = version;
+    e->view = *v;
+    e->size = world->size;
+    e->kind = world->kind;
+    e->format = opts ? (int)opts->format : RW_SNAP_FORMAT_RAW;
+    e->frames = out.buf;
+    e->len = out.len;
+    e->refs = 1;
+
+    if (results_version(results) != version) {
+        return e; /* stale already: send it once, do not cache */
+    }
+    pthread_mutex_lock(&g_cache_mtx);
+    cache_release_locked(g_cache);
+    g_cache = e;
+    e->refs++;
+    pthread_mutex_unlock(&g_cache_mtx);
+    return e;
+}
+
+int snapshot_send_cached(int fd,
+                         const world_t *world,
+                         const results_t *results,
+                         const world_region_t *view,
+                         const snapshot_opts_t *opts) {
+    if (!world || !results || !snapshot_view_ok(world, view)) {
         return -1;
     }
+    world_region_t v;
+    (void)world_region_resolve(world, view, &v);
 
-    return 0;
+    int format = opts ? (int)opts->format : RW_SNAP_FORMAT_RAW;
+    snap_history_t base;
+    const results_hit_time_t *hit_time = results_hit_time_acquire(results);
+    const uint32_t fields = raw_fields(hit_time ? hit_time->values : NULL);
+    results_hit_time_release(hit_time);
+    if (opts && opts->base_snapshot_id != 0 && format == RW_SNAP_FORMAT_RAW &&
+        history_find(opts->base_snapshot_id, world, results, &v, fields, &base) == 0) {
+        /* a delta is smaller than any full snapshot, cached or not */
+        return snapshot_send_to_client(fd, world, results, view, next_snapshot_id(), opts);
+    }
+    snapshot_opts_t full = {RW_SNAP_FORMAT_RAW, 1, 0};
+    if (opts) {
+        full = *opts;
+        full.base_snapshot_id = 0;
+    }
+    uint64_t version = results_version(results);
+    snap_cache_entry_t *e = cache_lookup(world, results, version, &v, format);
+    int hit = e != NULL;
+    if (!e) {
+        e = cache_build(world, results, version, &v, &full);
+    }
+    if (!e) {
+        /* too large for the cache (or out of memory): stream it */
+        return snapshot_send_to_client(fd, world, results, view, next_snapshot_id(), opts);
+    }
+
+    trace_span_t span;
+    trace_begin(&span, hit ? "snapshot send (cached)" : "snapshot send (encoded)", "fd", fd);
+    int rc = rw_send_frames(fd, e->frames, e->len);
+    trace_end(&span);
+
+    pthread_mutex_lock(&g_cache_mtx);
+    cache_release_locked(e);
+    pthread_mutex_unlock(&g_cache_mtx);
+    return rc;
 }
 
 struct broadcast_ctx {
     uint32_t snapshot_id;
+    world_region_t view;
     const world_t *world;
     const results_t *results;
 };
 
 static int send_snapshot_to_client(int fd, const struct broadcast_ctx *bctx) {
-    return snapshot_send_to_client(fd, bctx->world, bctx->results, bctx->snapshot_id);
+    return snapshot_send_to_client(fd, bctx->world, bctx->results, &bctx->view, bctx->snapshot_id, NULL);
 }
 
 static void broadcast_cb(int fd, void *user) {
@@ -132,9 +647,13 @@ int snapshot_broadcast(server_context_t *ctx,
     }
     struct broadcast_ctx bctx;
     bctx.snapshot_id = next_snapshot_id();
+    bctx.view = ctx->region;
     bctx.world = world;
     bctx.results = results;
 
+    trace_span_t span;
+    trace_begin(&span, "snapshot broadcast", "snapshot", bctx.snapshot_id);
     server_context_for_each_client(ctx, broadcast_cb, &bctx);
+    trace_end(&span);
     return 0;
 }
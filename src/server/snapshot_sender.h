@@ -19,15 +19,26 @@
  *
  * Wire format
  * ----------
- * Data is transferred as per-field, byte-addressed arrays in row-major order:
- *   idx = y * width + x
+ * A snapshot covers a rectangular view of the world: the configured region
+ * (@ref server_context_t::region) or the whole world. Data is transferred as
+ * per-field, byte-addressed arrays of the view in row-major order:
+ *   idx = (y - view.y) * view_width + (x - view.x)
+ *
+ * The frames are encoded into one buffer by a @ref SCHED_SNAPSHOT task and then
+ * written by the calling thread. A RAW view whose frames exceed
+ * @ref SNAPSHOT_CACHE_MAX_BYTES is instead gathered row by row while sending,
+ * without a copy; views larger than @ref RW_SNAPSHOT_MAX_CELLS are refused.
  *
  * Fields (when included):
- * - obstacles      : uint8_t[cell_count]  (1=obstacle, 0=free)
+ * - obstacles      : uint8_t[cell_count]  (1=obstacle, 0=free; expanded from
+ *                    the world bitmap)
  * - trials         : uint32_t[cell_count]
  * - sum_steps      : uint64_t[cell_count]
  * - success_leq_k  : uint32_t[cell_count]
  *
+ * A derived format (@ref snapshot_opts_t, snapshot_derived.h) replaces these by
+ * valid/obstacle bitmaps and quantized avg steps and p<=K codes.
+ *
  * Chunking and ordering
  * ---------------------
  * The server sends:
@@ -38,6 +49,17 @@
  * Chunks may arrive in any grouping, but the receiver should copy each field's
  * bytes into a buffer at @c offset_bytes.
  *
+ * Delta snapshots
+ * ---------------
+ * The last @ref SNAPSHOT_HISTORY_LEN sent snapshots are remembered with the
+ * @ref results_version() read before encoding them. A RAW request naming one of
+ * them as its base (same world, view and fields) is answered with only the
+ * cells whose results block changed since (@ref results_changed_since()), as
+ * chunks at their usual offsets; the receiver applies them onto the base.
+ * While a simulation runs, every replication touches every simulated cell, so
+ * deltas pay off between replications of large views, after the run, after
+ * obstacle edits and on reconnects.
+ *
  * Consistency
  * -----------
  * The snapshot is intended for visualization. The results arrays exposed by
@@ -45,13 +67,28 @@
  * while sending unless the caller arranges external synchronization.
  */
 
+/**
+ * @brief Encoding options of one snapshot (NULL = raw counters).
+ */
+typedef struct {
+    rw_wire_snapshot_format_t format;  /**< RAW or a derived (quantized) format. */
+    int nthreads;                      /**< Threads computing derived fields. */
+    uint32_t base_snapshot_id;         /**< RAW: send a delta against this snapshot if known (0 = full). */
+} snapshot_opts_t;
+
+/** Number of sent snapshots remembered as delta bases (clients keep a base across restarts). */
+#define SNAPSHOT_HISTORY_LEN 1024u
+
+/** Largest encoded snapshot kept by @ref snapshot_send_cached() (bytes). */
+#define SNAPSHOT_CACHE_MAX_BYTES (128u << 20)
+
 /**
  * @brief Broadcast a snapshot to all currently connected clients.
  *
  * The function iterates over the current client list in @p ctx and attempts to
  * stream the snapshot to each client.
  *
- * @param ctx     Shared server context (used for client list and metadata).
+ * @param ctx     Shared server context (used for client list and the view region).
  * @param world   World to snapshot.
  * @param results Results to snapshot.
  *
@@ -75,18 +112,60 @@ int snapshot_broadcast(server_context_t *ctx,
  * @param fd      File descriptor of the client socket.
  * @param world   World to snapshot.
  * @param results Results to snapshot.
+ * @param view    Rectangle to send (NULL or empty = whole world).
  * @param snapshot_id Identifier for the snapshot, used to match requests and
  *                    responses.
+ * @param opts    Encoding (NULL = raw counters).
  *
  * @retval 0  Success (best-effort).
- * @retval -1 Invalid arguments.
+ * @retval -1 Invalid arguments, view too large or send failure.
  *
  * @warning This function may perform blocking socket writes.
  */
 int snapshot_send_to_client(int fd,
                             const world_t *world,
                             const results_t *results,
-                            uint32_t snapshot_id);
+                            const world_region_t *view,
+                            uint32_t snapshot_id,
+                            const snapshot_opts_t *opts);
+
+/**
+ * @brief Send a snapshot to a client, reusing the encoded frames of the previous
+ *        request when the results have not changed since.
+ *
+ * The last encoded snapshot is kept together with the world, the view and the
+ * @ref results_version() it was encoded from. A request for the same contents
+ * is answered with one write of the cached frames (same snapshot_id as before);
+ * any result update, clear, load or world change produces a new version and
+ * the next request encodes a fresh snapshot. Snapshots larger than
+ * @ref SNAPSHOT_CACHE_MAX_BYTES are streamed as in @ref snapshot_send_to_client().
+ *
+ * Intended for results that are not being updated (LOBBY/FINISHED); while a
+ * simulation runs every request would just replace the cache. A request with a
+ * known delta base is answered with an (uncached) delta instead.
+ *
+ * @param fd      File descriptor of the client socket.
+ * @param world   World to snapshot.
+ * @param results Results to snapshot.
+ * @param view    Rectangle to send (NULL or empty = whole world).
+ * @param opts    Encoding (NULL = raw counters); part of the cache key.
+ *
+ * @retval 0  Success.
+ * @retval -1 Invalid arguments, view too large or send failure.
+ */
+int snapshot_send_cached(int fd,
+                         const world_t *world,
+                         const results_t *results,
+                         const world_region_t *view,
+                         const snapshot_opts_t *opts);
+
+/**
+ * @brief Check whether a view can be sent as a snapshot.
+ * @param world World.
+ * @param view  Rectangle (NULL or empty = whole world).
+ * @return 1 if the view is valid and at most @ref RW_SNAPSHOT_MAX_CELLS cells.
+ */
+int snapshot_view_ok(const world_t *world, const world_region_t *view);
 
 uint32_t snapshot_next_id(void);
 
@@ -0,0 +1,225 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "trace.h"
+
+#include "../common/util.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @file trace.c
+ * @brief Implementation of per-thread trace buffers and the JSON dump.
+ */
+
+typedef struct {
+    const char *name;
+    const char *arg_name;
+    int64_t arg;
+    uint64_t ts_us;
+    uint64_t dur_us;
+} trace_event_t;
+
+typedef struct {
+    atomic_uint gen;       /* session the events belong to */
+    atomic_uint count;     /* events published to the dumper */
+    atomic_uint dropped;
+    atomic_int alive;      /* cleared when the owner thread exits */
+    atomic_intptr_t name;  /* const char *, thread name */
+    int tid;
+    int in_use;            /* g_reg_mtx */
+    trace_event_t ev[TRACE_EVENTS_PER_THREAD];
+} trace_buf_t;
+
+static trace_buf_t *g_bufs[TRACE_MAX_THREADS];  /* g_reg_mtx */
+static pthread_mutex_t g_reg_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t g_buf_key;
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static _Thread_local trace_buf_t *t_buf;
+static _Thread_local const char *t_name;
+
+static atomic_int g_on;
+static atomic_uint g_gen;
+static int g_next_tid = 1;                      /* g_reg_mtx */
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static void buf_detach(void *p) {
+    atomic_store_explicit(&((trace_buf_t *)p)->alive, 0, memory_order_release);
+}
+
+static void key_init(void) {
+    (void)pthread_key_create(&g_buf_key, buf_detach);
+}
+
+static trace_buf_t *buf_attach(void) {
+    pthread_once(&g_key_once, key_init);
+
+    trace_buf_t *b = NULL;
+    pthread_mutex_lock(&g_reg_mtx);
+    for (int i = 0; i < TRACE_MAX_THREADS && !b; i++) {
+        if (!g_bufs[i]) {
+            g_bufs[i] = (trace_buf_t *)calloc(1, sizeof(trace_buf_t));
+            if (!g_bufs[i]) break;
+        }
+        if (!g_bufs[i]->in_use) {
+            b = g_bufs[i];
+        }
+    }
+    if (b) {
+        b->in_use = 1;
+        b->tid = g_next_tid++;
+        atomic_store_explicit(&b->alive, 1, memory_order_relaxed);
+        atomic_store_explicit(&b->count, 0u, memory_order_relaxed);
+        atomic_store_explicit(&b->dropped, 0u, memory_order_relaxed);
+        atomic_store_explicit(&b->name, (intptr_t)t_name, memory_order_relaxed);
+        atomic_store_explicit(&b->gen, atomic_load(&g_gen), memory_order_release);
+    }
+    pthread_mutex_unlock(&g_reg_mtx);
+
+    if (b) {
+        t_buf = b;
+        (void)pthread_setspecific(g_buf_key, b);
+    }
+    return b;
+}
+
+static void record(const trace_span_t *s, uint64_t t1) {
+    trace_buf_t *b = t_buf ? t_buf : buf_attach();
+    if (!b) return;
+
+    unsigned gen = atomic_load_explicit(&g_gen, memory_order_acquire);
+    if (atomic_load_explicit(&b->gen, memory_order_relaxed) != gen) {
+        //first event of a new session: forget the old one
+        atomic_store_explicit(&b->count, 0u, memory_order_relaxed);
+        atomic_store_explicit(&b->dropped, 0u, memory_order_relaxed);
+        atomic_store_explicit(&b->gen, gen, memory_order_release);
+    }
+
+    unsigned n = atomic_load_explicit(&b->count, memory_order_relaxed);
+    if (n >= TRACE_EVENTS_PER_THREAD) {
+        atomic_fetch_add_explicit(&b->dropped, 1u, memory_order_relaxed);
+        return;
+    }
+    trace_event_t *e = &b->ev[n];
+    e->name = s->name;
+    e->arg_name = s->arg_name;
+    e->arg = s->arg;
+    e->ts_us = s->t0_us;
+    e->dur_us = t1 - s->t0_us;
+    atomic_store_explicit(&b->count, n + 1u, memory_order_release);
+}
+
+int trace_start(void) {
+    pthread_mutex_lock(&g_reg_mtx);
+    //buffers of threads that exited during the last session are free again
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+        if (g_bufs[i] && g_bufs[i]->in_use && !atomic_load_explicit(&g_bufs[i]->alive, memory_order_acquire)) {
+            g_bufs[i]->in_use = 0;
+        }
+    }
+    atomic_fetch_add_explicit(&g_gen, 1u, memory_order_release);
+    pthread_mutex_unlock(&g_reg_mtx);
+
+    atomic_store_explicit(&g_on, 1, memory_order_release);
+    return 0;
+}
+
+void trace_stop(void) {
+    atomic_store_explicit(&g_on, 0, memory_order_release);
+}
+
+int trace_enabled(void) {
+    return atomic_load_explicit(&g_on, memory_order_relaxed);
+}
+
+void trace_thread_name(const char *name) {
+    t_name = name;
+    if (t_buf) {
+        atomic_store_explicit(&t_buf->name, (intptr_t)name, memory_order_relaxed);
+    }
+}
+
+void trace_begin(trace_span_t *s, const char *name, const char *arg_name, int64_t arg) {
+    s->name = name;
+    s->arg_name = arg_name;
+    s->arg = arg;
+    s->t0_us = atomic_load_explicit(&g_on, memory_order_relaxed) ? now_us() : 0u;
+}
+
+void trace_end(trace_span_t *s) {
+    if (s->t0_us == 0 || !atomic_load_explicit(&g_on, memory_order_relaxed)) {
+        return;
+    }
+    record(s, now_us());
+}
+
+int trace_dump(const char *path, uint64_t *out_count) {
+    if (!path) return -1;
+
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        log_error("trace: fopen('%s') failed: %s", path, strerror(errno));
+        return -1;
+    }
+
+    int pid = (int)getpid();
+    uint64_t written = 0, dropped = 0;
+    int first = 1;
+
+    fprintf(f, "{\"traceEvents\":[\n");
+
+    pthread_mutex_lock(&g_reg_mtx);
+    unsigned gen = atomic_load_explicit(&g_gen, memory_order_acquire);
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+        trace_buf_t *b = g_bufs[i];
+        if (!b || !b->in_use || atomic_load_explicit(&b->gen, memory_order_acquire) != gen) continue;
+
+        unsigned n = atomic_load_explicit(&b->count, memory_order_acquire);
+        if (n == 0) continue;
+        dropped += atomic_load_explicit(&b->dropped, memory_order_relaxed);
+
+        const char *tname = (const char *)atomic_load_explicit(&b->name, memory_order_relaxed);
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", pid, b->tid, tname ? tname : "thread");
+        first = 0;
+
+        for (unsigned k = 0; k < n; k++) {
+            const trace_event_t *e = &b->ev[k];
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%llu,\"dur\":%llu",
+                    e->name, pid, b->tid, (unsigned long long)e->ts_us, (unsigned long long)e->dur_us);
+            if (e->arg_name) {
+                fprintf(f, ",\"args\":{\"%s\":%lld}", e->arg_name, (long long)e->arg);
+            }
+            fputc('}', f);
+        }
+        written += n;
+    }
+    pthread_mutex_unlock(&g_reg_mtx);
+
+    fprintf(f, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":%llu}}\n",
+            (unsigned long long)dropped);
+
+    if (fclose(f) != 0) {
+        log_error("trace: write failed for '%s'", path);
+        return -1;
+    }
+    log_info("trace: %llu events written to %s (%llu dropped)",
+             (unsigned long long)written, path, (unsigned long long)dropped);
+    if (out_count) *out_count = written;
+    return 0;
+}
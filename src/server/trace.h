@@ -0,0 +1,100 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_TRACE_H
+#define SEMPRACA_TRACE_H
+
+/**
+ * @file trace.h
+ * @brief Optional span tracing of simulation and I/O phases (Chrome trace JSON).
+ *
+ * While tracing is on, instrumented code records spans (replications, walk
+ * batches, result merges, snapshot sends, save/load) into a
+ * buffer owned by the recording thread. @ref trace_dump() writes all buffers
+ * of the current session in the Chrome trace-event format (JSON object with a
+ * `traceEvents` array), which chrome://tracing and Perfetto open as a
+ * per-thread timeline.
+ *
+ * Cost
+ * ----
+ * With tracing off, @ref trace_begin() / @ref trace_end() are one relaxed
+ * atomic load each. With tracing on, a span costs two clock reads and one
+ * store into the thread's buffer (no locks after the thread's first event).
+ *
+ * Buffers
+ * -------
+ * Each thread gets up to @ref TRACE_EVENTS_PER_THREAD events per session;
+ * further events are dropped and counted (reported in the dump). Buffers of
+ * exited threads are kept until the next @ref trace_start(), so their spans
+ * still appear in the dump.
+ *
+ * Names passed to the functions below must be string literals (only the
+ * pointer is stored) and must not need JSON escaping.
+ */
+
+#include <stdint.h>
+
+/** Event capacity of one thread buffer per session. */
+#define TRACE_EVENTS_PER_THREAD 65536u
+/** Maximum number of thread buffers. */
+#define TRACE_MAX_THREADS 128
+
+/**
+ * @brief An open span (see @ref trace_begin()).
+ */
+typedef struct {
+    const char *name;
+    const char *arg_name; /**< NULL = no argument. */
+    int64_t arg;
+    uint64_t t0_us;       /**< 0 if tracing was off at @ref trace_begin(). */
+} trace_span_t;
+
+/**
+ * @brief Start a new tracing session (discards the previous one).
+ * @return 0 on success, -1 on failure.
+ */
+int trace_start(void);
+
+/**
+ * @brief Stop recording; the session stays available to @ref trace_dump().
+ */
+void trace_stop(void);
+
+/**
+ * @brief Non-zero while recording.
+ */
+int trace_enabled(void);
+
+/**
+ * @brief Write the current session as Chrome trace JSON.
+ *
+ * May be called while recording; spans that are still open are not included.
+ *
+ * @param path      Output file (overwritten).
+ * @param out_count Optional output: number of events written.
+ * @return 0 on success, -1 on failure.
+ */
+int trace_dump(const char *path, uint64_t *out_count);
+
+/**
+ * @brief Name the calling thread in the trace (string literal).
+ */
+void trace_thread_name(const char *name);
+
+/**
+ * @brief Open a span.
+ *
+ * @param s        Span state (on the caller's stack).
+ * @param name     Span name.
+ * @param arg_name Name of the numeric argument, or NULL.
+ * @param arg      Argument value.
+ */
+void trace_begin(trace_span_t *s, const char *name, const char *arg_name, int64_t arg);
+
+/**
+ * @brief Close a span opened by @ref trace_begin() and record it.
+ */
+void trace_end(trace_span_t *s);
+
+#endif //SEMPRACA_TRACE_H
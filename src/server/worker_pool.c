@@ -4,12 +4,14 @@
 
 #include "worker_pool.h"
 
+#include "trace.h"
+
 #include "../common/util.h"
 
 #include <stdlib.h>
 #include <string.h>
 
-static void *worker_main(void *arg);
+static void runner_main(void *arg);
 
 int worker_pool_init(worker_pool_t *p,
                      int nthreads,
@@ -21,6 +23,10 @@ int worker_pool_init(worker_pool_t *p,
     if (!p || !world || !results) return -1;
     if (nthreads <= 0) return -1;
     if (queue_capacity < 16) queue_capacity = 16;
+    if (scheduler_nthreads() <= 0) {
+        log_error("worker_pool: scheduler not running");
+        return -1;
+    }
 
     memset(p,0, sizeof(*p));
     p->nthreads = nthreads;
@@ -31,32 +37,44 @@ int worker_pool_init(worker_pool_t *p,
     p->max_steps = max_steps;
 
     p->q = (rw_job_t*)malloc(sizeof(rw_job_t) * (size_t)p->q_cap);
-    p->threads = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)p->nthreads);
+    p->runners = (worker_runner_t*)calloc((size_t)p->nthreads, sizeof(worker_runner_t));
 
-    if (!p->q || !p->threads) {
-        worker_pool_destroy(p);
+    if (!p->q || !p->runners) {
+        free(p->q);
+        free(p->runners);
+        memset(p,0,sizeof(*p));
         return -1;
     }
 
     if (pthread_mutex_init(&p->mtx, NULL) != 0) return -1;
-    if (pthread_cond_init(&p->cv_nonempty, NULL) != 0) return -1;
     if (pthread_cond_init(&p->cv_all_done, NULL) != 0) return -1;
 
+    //one time seed, forked per runner (they are all seeded from this thread)
+    rw_rng_t seed;
+    rw_rng_init_time_seed(&seed);
     for (int i = 0; i < p->nthreads; i++) {
-        if (pthread_create(&p->threads[i], NULL,worker_main,p) != 0) {
-            die("pthread_create(worker) failed");
-        }
+        p->runners[i].pool = p;
+        rw_rng_fork(&seed, &p->runners[i].rng);
     }
 
     return 0;
 }
 
+void worker_pool_set_crn(worker_pool_t *p, int enabled, uint64_t seed) {
+    if (!p) return;
+
+    pthread_mutex_lock(&p->mtx);
+    p->crn = enabled ? 1 : 0;
+    p->crn_seed = seed;
+    pthread_mutex_unlock(&p->mtx);
+}
+
 void worker_pool_stop(worker_pool_t *p) {
     if (!p) return;
 
     pthread_mutex_lock(&p->mtx);
     p->stop = 1;
-    pthread_cond_broadcast(&p->cv_nonempty);
+    pthread_cond_broadcast(&p->cv_all_done);
     pthread_mutex_unlock(&p->mtx);
 }
 
@@ -65,18 +83,18 @@ void worker_pool_destroy(worker_pool_t *p) {
 
     worker_pool_stop(p);
 
-    for (int i = 0; i < p->nthreads; i++) {
-        if (p->threads) {
-            pthread_join(p->threads[i], NULL);
-        }
+    //queued runners still point at the pool
+    pthread_mutex_lock(&p->mtx);
+    while (p->active > 0) {
+        pthread_cond_wait(&p->cv_all_done, &p->mtx);
     }
+    pthread_mutex_unlock(&p->mtx);
 
-    pthread_cond_destroy(&p->cv_nonempty);
     pthread_cond_destroy(&p->cv_all_done);
     pthread_mutex_destroy(&p->mtx);
 
     free(p->q);
-    free(p->threads);
+    free(p->runners);
 
     memset(p,0,sizeof(*p));
 }
@@ -90,13 +108,15 @@ static int queue_push(worker_pool_t *p, rw_job_t job) {
     return 0;
 }
 
-static int queue_pop(worker_pool_t *p, rw_job_t *out_job) {
-    if (p->q_count == 0) return -1;
-
-    *out_job = p->q[p->q_head];
-    p->q_head = (p->q_head + 1) % p->q_cap;
-    p->q_count--;
-    return 0;
+/* Pop up to @p max jobs; returns how many were popped. */
+static uint32_t queue_pop_batch(worker_pool_t *p, rw_job_t *out_jobs, uint32_t max) {
+    uint32_t n = 0;
+    while (n < max && p->q_count > 0) {
+        out_jobs[n++] = p->q[p->q_head];
+        p->q_head = (p->q_head + 1) % p->q_cap;
+        p->q_count--;
+    }
+    return n;
 }
 
 int worker_pool_submit(worker_pool_t *p, rw_job_t job) {
@@ -120,8 +140,23 @@ int worker_pool_submit(worker_pool_t *p, rw_job_t job) {
 
     p->in_flight++;
 
-    pthread_cond_signal(&p->cv_nonempty);
+    //start an idle runner while fewer than nthreads drain the queue
+    worker_runner_t *r = NULL;
+    if (p->active < p->nthreads) {
+        for (int i = 0; i < p->nthreads; i++) {
+            if (!p->runners[i].active) {
+                r = &p->runners[i];
+                r->active = 1;
+                p->active++;
+                break;
+            }
+        }
+    }
     pthread_mutex_unlock(&p->mtx);
+
+    if (r) {
+        scheduler_submit(SCHED_SIM, &r->task, runner_main, r, NULL);
+    }
     return 0;
 }
 
@@ -129,60 +164,90 @@ void worker_pool_wait_all(worker_pool_t *p) {
     if (!p) return;
 
     pthread_mutex_lock(&p->mtx);
-    while (p->in_flight > 0) {
+    while (p->in_flight > 0 && !p->stop) {
         pthread_cond_wait(&p->cv_all_done, &p->mtx);
     }
     pthread_mutex_unlock(&p->mtx);
 }
 
-static void job_done(worker_pool_t *p) {
+static void jobs_done(worker_pool_t *p, uint32_t n) {
     if (p->in_flight > 0) {
-        p->in_flight--;
+        p->in_flight = p->in_flight > n ? p->in_flight - n : 0;
         if (p->in_flight == 0) {
-            pthread_cond_signal(&p->cv_all_done);
+            pthread_cond_broadcast(&p->cv_all_done);
         }
     }
 }
 
-static void *worker_main(void *arg) {
-    worker_pool_t *p = (worker_pool_t *)arg;
+/* Called with the mutex held. */
+static void runner_idle(worker_pool_t *p, worker_runner_t *r) {
+    r->active = 0;
+    if (--p->active == 0) {
+        pthread_cond_broadcast(&p->cv_all_done);
+    }
+}
 
-    rw_rng_t rng;
-    rw_rng_init_time_seed(&rng);
+/* One batch; requeues itself while jobs are left. */
+static void runner_main(void *arg) {
+    worker_runner_t *r = (worker_runner_t *)arg;
+    worker_pool_t *p = r->pool;
 
-    while (1) {
-        rw_job_t job;
+    rw_job_t jobs[WORKER_POOL_BATCH];
+    rw_walk_t walks[WORKER_POOL_BATCH];
 
-        pthread_mutex_lock(&p->mtx);
+    pthread_mutex_lock(&p->mtx);
+    if (p->stop || p->q_count == 0) {
+        runner_idle(p, r);
+        pthread_mutex_unlock(&p->mtx);
+        return;
+    }
 
-        while (!p->stop && p->q_count == 0) {
-            pthread_cond_wait(&p->cv_nonempty, &p->mtx);
-        }
+    //share a short queue between the runners instead of draining it
+    uint32_t take = p->q_count / (uint32_t)p->nthreads;
+    if (take < 1) take = 1;
+    if (take > WORKER_POOL_BATCH) take = WORKER_POOL_BATCH;
 
-        if (p->stop) {
-            pthread_mutex_unlock(&p->mtx);
-            break;
-        }
+    uint32_t n = queue_pop_batch(p, jobs, take);
+    int crn = p->crn;
+    uint64_t crn_seed = p->crn_seed;
 
-        if (queue_pop(p, &job) != 0) {
-            pthread_mutex_unlock(&p->mtx);
-            continue;
-        }
+    pthread_mutex_unlock(&p->mtx);
 
-        pthread_mutex_unlock(&p->mtx);
+    for (uint32_t i = 0; i < n; i++) {
+        walks[i].start = jobs[i].start;
+        if (crn) {
+            rw_rng_seed_stream(&walks[i].rng, crn_seed, jobs[i].cell_idx, jobs[i].rep);
+        } else {
+            rw_rng_fork(&r->rng, &walks[i].rng);
+        }
+    }
 
-        uint32_t steps = 0;
-        int reached = 0;
-        int success = 0;
+    trace_span_t span;
+    trace_begin(&span, "walk batch", "walks", n);
+    random_walk_run_batch(p->world, p->probs, p->max_steps, walks, n);
+    trace_end(&span);
+
+    trace_begin(&span, "results merge", "walks", n);
+    results_trial_t out[WORKER_POOL_BATCH];
+    for (uint32_t i = 0; i < n; i++) {
+        out[i].idx = jobs[i].cell_idx;
+        out[i].steps = walks[i].steps;
+        out[i].reached_origin = (uint8_t)(walks[i].reached_origin != 0);
+        out[i].success_leq_k = (uint8_t)(walks[i].success_leq_k != 0);
+    }
+    results_update_batch(p->results, out, n);
+    trace_end(&span);
 
-        random_walk_run(p->world, job.start, p->probs, p->max_steps,
-                        &rng, &steps, &reached, &success);
-        results_update(p->results, job.cell_idx, steps, reached, success);
+    pthread_mutex_lock(&p->mtx);
+    jobs_done(p, n);
+    int again = !p->stop && p->q_count > 0;
+    if (!again) {
+        runner_idle(p, r);
+    }
+    pthread_mutex_unlock(&p->mtx);
 
-        pthread_mutex_lock(&p->mtx);
-        job_done(p);
-        pthread_mutex_unlock(&p->mtx);
+    //back to the end of the SIM queue: higher classes run first
+    if (again) {
+        scheduler_submit(SCHED_SIM, &r->task, runner_main, r, NULL);
     }
-    return NULL;
 }
-
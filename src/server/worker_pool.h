@@ -7,44 +7,69 @@
 
 /**
  * @file worker_pool.h
- * @brief Simple thread pool used by the server to execute random-walk jobs.
+ * @brief Job queue used by the server to execute random-walk jobs.
  *
- * The worker pool maintains a bounded FIFO queue of @ref rw_job_t items.
- * Each worker thread repeatedly:
- * - pops a job
- * - runs one random walk from the provided start position
+ * The worker pool maintains a bounded FIFO queue of @ref rw_job_t items,
+ * drained by up to nthreads runners. A runner is a @ref SCHED_SIM task of the
+ * scheduler (see scheduler.h), not a thread; each time it runs it:
+ * - pops a batch of up to @ref WORKER_POOL_BATCH jobs
+ * - runs their random walks with the interleaved kernel
+ *   (@ref random_walk_run_batch())
  * - updates shared @ref results_t
+ * - requeues itself while jobs are left, so higher classes get a thread
+ *   after every batch.
  *
  * Threading model:
- * - Queue operations and in-flight accounting are protected by an internal mutex.
+ * - Queue operations, in-flight and runner accounting are protected by an internal mutex.
  * - Results are updated via @ref results_update(), which is internally synchronized.
+ * - The scheduler must be running (@ref scheduler_start()).
  */
 
 #include "world.h"
 #include "random_walk.h"
 #include "results.h"
+#include "scheduler.h"
 #include "../common/types.h"
 
 #include <pthread.h>
 #include <stdint.h>
 
+/** Maximum jobs a worker takes from the queue at once. */
+#define WORKER_POOL_BATCH 32u
+
 /**
  * @brief Random-walk job type.
  */
 typedef struct {
-    /** Linear index into result arrays (row-major). */
-    uint32_t cell_idx;
+    /** Linear index into result arrays (row-major, 64-bit). */
+    uint64_t cell_idx;
 
     /** Starting position for this random-walk job. */
     pos_t start;
+
+    /** Replication number (selects the random stream in CRN mode). */
+    uint32_t rep;
 } rw_job_t;
 
+struct worker_pool;
+
 /**
- * @brief Worker pool state.
+ * @brief One runner: a re-submittable scheduler task with its own RNG.
  */
 typedef struct {
-    pthread_t *threads; /**< Array of worker threads. */
-    int nthreads;       /**< Number of worker threads. */
+    struct worker_pool *pool;
+    sched_task_t task;
+    rw_rng_t rng;       /**< Walk streams outside CRN mode. */
+    int active;         /**< Queued or running on the scheduler. */
+} worker_runner_t;
+
+/**
+ * @brief Worker pool state.
+ */
+typedef struct worker_pool {
+    worker_runner_t *runners; /**< Array of runners. */
+    int nthreads;             /**< Number of runners (maximum parallelism). */
+    int active;               /**< Runners queued or running. */
 
     rw_job_t *q;        /**< Job queue. */
     uint32_t q_cap;    /**< Capacity of the job queue. */
@@ -54,10 +79,9 @@ typedef struct {
 
     /* synchronization */
     pthread_mutex_t mtx;                /**< Mutex for protecting shared data. */
-    pthread_cond_t cv_nonempty;        /**< Condition variable for non-empty queue. */
-    pthread_cond_t cv_all_done;        /**< Condition variable for all jobs done. */
+    pthread_cond_t cv_all_done;        /**< Signalled when all jobs are done or all runners idle. */
 
-    /** When non-zero, workers should exit. */
+    /** When non-zero, runners drop the queue and go idle. */
     int stop;
 
     /** Number of submitted jobs not yet marked done. */
@@ -68,13 +92,17 @@ typedef struct {
     results_t *results;   /**< Results accumulator. */
     move_probs_t probs;  /**< Movement probabilities. */
     uint32_t max_steps;  /**< Maximum steps per random walk. */
+
+    /** Non-zero: seed each job from (crn_seed, cell_idx, rep) instead of the runner RNG. */
+    int crn;
+    uint64_t crn_seed;   /**< Base seed for common random numbers. */
 } worker_pool_t;
 
 /**
- * @brief Initialize a worker pool and start worker threads.
+ * @brief Initialize a worker pool.
  *
  * @param p              Pool to initialize.
- * @param nthreads       Number of worker threads.
+ * @param nthreads       Number of runners (batches in parallel).
  * @param queue_capacity Capacity of the internal job queue.
  * @param world          World definition used for random walks.
  * @param results        Results accumulator.
@@ -82,7 +110,7 @@ typedef struct {
  * @param max_steps      Maximum steps per random walk.
  *
  * @retval 0  Success.
- * @retval -1 Invalid arguments or initialization failure.
+ * @retval -1 Invalid arguments, scheduler not running or initialization failure.
  */
 int worker_pool_init(worker_pool_t *p,
                      int nthreads,
@@ -93,9 +121,21 @@ int worker_pool_init(worker_pool_t *p,
                      uint32_t max_steps);
 
 /**
- * @brief Stop workers (cooperative) and release all pool resources.
+ * @brief Enable or disable common random numbers (CRN) for subsequent jobs.
+ *
+ * Must be called before jobs are submitted (the value is published to the
+ * workers by the queue mutex in @ref worker_pool_submit()).
+ *
+ * @param p       Pool.
+ * @param enabled Non-zero to use per-(cell, rep) streams.
+ * @param seed    Base seed of the streams.
+ */
+void worker_pool_set_crn(worker_pool_t *p, int enabled, uint64_t seed);
+
+/**
+ * @brief Stop runners (cooperative) and release all pool resources.
  *
- * Joins worker threads and frees internal allocations.
+ * Waits until no runner is queued or running, then frees internal allocations.
  *
  * @param p Pool (may be NULL).
  */
@@ -120,7 +160,7 @@ void worker_pool_wait_all(worker_pool_t *p);
 /**
  * @brief Request the pool to stop.
  *
- * This wakes waiting workers and causes them to exit once they observe @ref worker_pool_t::stop.
+ * Runners go idle once they observe @ref worker_pool_t::stop; queued jobs are dropped.
  *
  * @param p Pool.
  */
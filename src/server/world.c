@@ -13,104 +13,215 @@
 
 #include <stdlib.h>
 #include <string.h>
-
-static const int kNeighborDirs[4][2] = {
-    {1, 0}, {-1, 0}, {0, 1}, {0, -1}
-};
-
-static void world_mark_reachable(const world_t *w,
-                                 uint8_t *reachable,
-                                 uint32_t *queue) {
-    if (!w || !reachable || !queue) return;
-
-    uint32_t n = world_cell_count(w);
-    if (n == 0) return;
-
-    memset(reachable, 0, n);
-
-    if (w->obstacles[0]) {
-        return; /* origin blocked – nothing reachable */
+#include <sys/mman.h>
+
+#define BIT_GET(bits, i) (((bits)[(i) >> 3] >> ((i) & 7u)) & 1u)
+#define BIT_SET(bits, i) ((bits)[(i) >> 3] |= (uint8_t)(1u << ((i) & 7u)))
+
+/*======== reachability fixup ========*/
+
+/* Scratch bitmap of "blocked" cells (obstacles and cells already reached),
+ * one bit per cell, each row padded to whole 64-bit words (padding blocked),
+ * so runs are found with aligned word loads. */
+typedef struct {
+    uint64_t *words;
+    uint64_t stride;    /* words per row */
+    uint32_t width;
+    uint32_t height;
+} fill_map_t;
+
+/* Growable stack of runs to expand: pairs (row, lo | hi << 32). */
+typedef struct {
+    uint64_t *items;
+    size_t len;
+    size_t cap;
+} run_stack_t;
+
+static int run_push(run_stack_t *st, uint64_t y, uint32_t lo, uint32_t hi) {
+    if (st->len + 2u > st->cap) {
+        size_t cap = st->cap ? st->cap * 2u : 4096u;
+        uint64_t *items = (uint64_t *)realloc(st->items, sizeof(uint64_t) * cap);
+        if (!items) return -1;
+        st->items = items;
+        st->cap = cap;
     }
+    st->items[st->len++] = y;
+    st->items[st->len++] = (uint64_t)lo | ((uint64_t)hi << 32);
+    return 0;
+}
 
-    uint32_t width = (uint32_t)w->size.width;
-    uint32_t head = 0;
-    uint32_t tail = 0;
-    queue[tail++] = 0;
-    reachable[0] = 1;
-
-    while (head < tail) {
-        uint32_t idx = queue[head++];
-        int32_t x = (int32_t)(idx % width);
-        int32_t y = (int32_t)(idx / width);
+static int fill_map_init(fill_map_t *m, const world_t *w) {
+    m->width = (uint32_t)w->size.width;
+    m->height = (uint32_t)w->size.height;
+    m->stride = ((uint64_t)m->width + 63u) / 64u;
+    m->words = (uint64_t *)malloc(sizeof(uint64_t) * (size_t)(m->stride * m->height));
+    if (!m->words) return -1;
+
+    const uint64_t nbytes = world_obstacle_bytes(w);
+    for (uint64_t y = 0; y < m->height; y++) {
+        uint64_t *row = m->words + y * m->stride;
+        uint64_t base = y * m->width;
+        for (uint64_t k = 0; k < m->stride; k++) {
+            /* 64 cells from bit base + 64k of the world bitmap (9 bytes). */
+            uint64_t bit = base + k * 64u;
+            uint64_t byte = bit >> 3;
+            unsigned shift = (unsigned)(bit & 7u);
+            uint64_t v = 0;
+            for (unsigned j = 0; j < 8u && byte + j < nbytes; j++) {
+                v |= (uint64_t)w->obstacle_bits[byte + j] << (8u * j);
+            }
+            v >>= shift;
+            if (shift && byte + 8u < nbytes) {
+                v |= (uint64_t)w->obstacle_bits[byte + 8u] << (64u - shift);
+            }
 
-        for (int i = 0; i < 4; i++) {
-            int32_t nx = x + kNeighborDirs[i][0];
-            int32_t ny = y + kNeighborDirs[i][1];
-            if (!world_in_bounds(w, nx, ny)) continue;
-            uint32_t nidx = world_index(w, nx, ny);
-            if (w->obstacles[nidx]) continue;
-            if (reachable[nidx]) continue;
-            reachable[nidx] = 1;
-            queue[tail++] = nidx;
+            uint64_t cells = m->width - k * 64u;
+            if (cells < 64u) v |= ~0ull << cells; /* padding is blocked */
+            row[k] = v;
         }
     }
+    return 0;
 }
 
-static void world_carve_path_to_origin(world_t *w, uint32_t idx) {
-    if (!w || !w->obstacles) return;
-
-    uint32_t width = (uint32_t)w->size.width;
-    if (width == 0) return;
+/* First x in [x, end) of @p row whose bit equals @p blocked, or end. */
+static uint32_t row_find(const uint64_t *row, uint32_t x, uint32_t end, int blocked) {
+    while (x < end) {
+        uint64_t v = row[x >> 6];
+        if (!blocked) v = ~v;
+        v >>= (x & 63u);
+        if (v) {
+            uint64_t r = (uint64_t)x + (uint64_t)__builtin_ctzll(v);
+            return r < end ? (uint32_t)r : end;
+        }
+        x = (x | 63u) + 1u;
+    }
+    return end;
+}
 
-    uint32_t height = (uint32_t)w->size.height;
-    if (height == 0) return;
+/* One past the last blocked x in [0, x) of @p row, or 0. */
+static uint32_t row_find_blocked_before(const uint64_t *row, uint32_t x) {
+    while (x > 0) {
+        uint32_t k = (x - 1u) >> 6;
+        uint64_t v = row[k];
+        uint32_t n = x - (k << 6); /* bits of word k below x: 1..64 */
+        if (n < 64u) v &= (1ull << n) - 1u;
+        if (v) return (k << 6) + 64u - (uint32_t)__builtin_clzll(v);
+        x = k << 6;
+    }
+    return 0;
+}
 
-    if (idx >= width * height) return;
+static void row_set(uint64_t *row, uint32_t lo, uint32_t hi) {
+    while (lo < hi) {
+        uint32_t k = lo >> 6;
+        uint32_t end = (k + 1u) << 6;
+        if (end > hi) end = hi;
+        uint32_t n = end - lo;
+        uint64_t mask = n == 64u ? ~0ull : ((1ull << n) - 1u) << (lo & 63u);
+        row[k] |= mask;
+        lo = end;
+    }
+}
 
-    int32_t x = (int32_t)(idx % width);
-    int32_t y = (int32_t)(idx / width);
+/* Mark the open run of row @p y containing @p x as reached and push it. */
+static int claim_run(fill_map_t *m, run_stack_t *st, uint64_t y, uint32_t x, uint32_t *out_hi) {
+    uint64_t *row = m->words + y * m->stride;
+    uint32_t lo = row_find_blocked_before(row, x);
+    uint32_t hi = row_find(row, x, m->width, 1);
+    row_set(row, lo, hi);
+    *out_hi = hi;
+    return run_push(st, y, lo, hi);
+}
 
-    /* Clear the starting cell and carve an axis-aligned corridor back to origin. */
-    w->obstacles[idx] = 0;
-    while (x > 0) {
-        x--;
-        w->obstacles[world_index(w, x, y)] = 0;
+/* Scanline flood fill from the open cell (x,y). Runs are marked when found and
+ * pushed once; the rows above and below a run are scanned a word at a time.
+ * Every cell is marked once over all calls and each run is scanned from its
+ * two neighbouring rows, so the total work is O(cells). */
+static int fill_from(fill_map_t *m, run_stack_t *st, uint64_t y, uint32_t x) {
+    uint32_t hi = 0;
+    st->len = 0;
+    if (claim_run(m, st, y, x, &hi) != 0) return -1;
+
+    while (st->len > 0) {
+        uint64_t span = st->items[--st->len];
+        uint64_t ry = st->items[--st->len];
+        uint32_t lo = (uint32_t)span;
+        hi = (uint32_t)(span >> 32);
+
+        for (int d = 0; d < 2; d++) {
+            if (d == 0 && ry == 0) continue;
+            if (d == 1 && ry + 1u >= m->height) continue;
+            uint64_t ny = d == 0 ? ry - 1u : ry + 1u;
+            const uint64_t *nrow = m->words + ny * m->stride;
+
+            uint32_t a = lo;
+            while (a < hi) {
+                a = row_find(nrow, a, hi, 0);
+                if (a >= hi) break;
+                if (claim_run(m, st, ny, a, &a) != 0) return -1;
+            }
+        }
     }
-    while (y > 0) {
-        y--;
-        w->obstacles[world_index(w, x, y)] = 0;
+    return 0;
+}
+
+/* Connect the unreached free cell (x,y) to the reached set: clear obstacles
+ * upwards (then leftwards along row 0) until a free cell is hit. Cells before
+ * (x,y) in row-major order are already reached or obstacles, so the first free
+ * cell on the way is reached and every cleared cell was an obstacle. */
+static uint64_t carve_to_reached(world_t *w, fill_map_t *m, uint32_t x, uint64_t y) {
+    uint64_t carved = 0;
+    while (x > 0 || y > 0) {
+        if (y > 0) {
+            y--;
+        } else {
+            x--;
+        }
+        uint64_t idx = y * m->width + x;
+        if (!BIT_GET(w->obstacle_bits, idx)) break;
+        world_set_obstacle_idx(w, idx, 0);
+        m->words[y * m->stride + (x >> 6)] &= ~(1ull << (x & 63u));
+        carved++;
     }
+    return carved;
 }
 
-static void world_enforce_origin_reachability(world_t *w) {
-    if (!w || !w->obstacles) return;
+int world_ensure_reachable(world_t *w, uint64_t *out_carved) {
+    if (!w || !w->obstacle_bits || world_is_readonly(w)) return -1;
 
-    uint32_t n = world_cell_count(w);
-    if (n == 0) return;
+    world_set_obstacle_idx(w, 0, 0); /* origin is always free */
 
-    uint8_t *reachable = (uint8_t*)malloc(n);
-    uint32_t *queue = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)n);
-    if (!reachable || !queue) {
-        free(reachable);
-        free(queue);
-        return;
+    fill_map_t m;
+    run_stack_t st;
+    memset(&st, 0, sizeof(st));
+    if (fill_map_init(&m, w) != 0) {
+        log_error("world: not enough memory to check reachability of %llu cells",
+                  (unsigned long long)world_cell_count(w));
+        return -1;
     }
 
-    int fixed_any;
-    do {
-        fixed_any = 0;
-        world_mark_reachable(w, reachable, queue);
-        for (uint32_t i = 0; i < n; i++) {
-            if (w->obstacles[i] == 0 && reachable[i] == 0) {
-                world_carve_path_to_origin(w, i);
-                fixed_any = 1;
-                break; /* re-run flood fill after each carve */
-            }
+    uint64_t carved = 0;
+    int rc = fill_from(&m, &st, 0, 0);
+
+    /* Row-major scan for open (free, unreached) cells, a word at a time. */
+    for (uint64_t y = 0; y < m.height && rc == 0; y++) {
+        uint64_t *row = m.words + y * m.stride;
+        uint32_t x = 0;
+        while (rc == 0 && (x = row_find(row, x, m.width, 0)) < m.width) {
+            carved += carve_to_reached(w, &m, x, y);
+            rc = fill_from(&m, &st, y, x);
         }
-    } while (fixed_any);
+    }
 
-    free(queue);
-    free(reachable);
+    free(st.items);
+    free(m.words);
+    if (rc != 0) {
+        log_error("world: not enough memory to check reachability of %llu cells",
+                  (unsigned long long)world_cell_count(w));
+        return -1;
+    }
+    if (out_carved) *out_carved = carved;
+    return 0;
 }
 
 /* Simple deterministic RNG (LCG) to generate obstacles.
@@ -122,8 +233,52 @@ static uint32_t lcg_next(uint32_t *state) {
     return *state;
 }
 
-uint32_t world_cell_count(const world_t *w) {
-    return w->size.width * w->size.height;
+uint64_t world_cell_count(const world_t *w) {
+    return (uint64_t)(uint32_t)w->size.width * (uint64_t)(uint32_t)w->size.height;
+}
+
+uint64_t world_obstacle_bytes(const world_t *w) {
+    if (w->layout == WORLD_LAYOUT_TILED) {
+        uint64_t tiles_y = ((uint64_t)(uint32_t)w->size.height + WORLD_TILE_SIZE - 1u) >> WORLD_TILE_SHIFT;
+        return (uint64_t)w->tiles_x * tiles_y * WORLD_TILE_BYTES;
+    }
+    return (world_cell_count(w) + 7u) / 8u;
+}
+
+/* Bit address of an in-bounds cell in the obstacle bitmap. */
+static inline uint64_t world_bit_xy(const world_t *w, uint32_t x, uint32_t y) {
+    if (w->layout == WORLD_LAYOUT_TILED) {
+        uint64_t tile = (uint64_t)(y >> WORLD_TILE_SHIFT) * w->tiles_x + (x >> WORLD_TILE_SHIFT);
+        uint32_t in_tile = ((y & (WORLD_TILE_SIZE - 1u)) << WORLD_TILE_SHIFT) | (x & (WORLD_TILE_SIZE - 1u));
+        return tile * (WORLD_TILE_BYTES * 8u) + in_tile;
+    }
+    return (uint64_t)y * (uint32_t)w->size.width + x;
+}
+
+static inline uint64_t world_bit_idx(const world_t *w, uint64_t idx) {
+    if (w->layout == WORLD_LAYOUT_TILED) {
+        uint64_t width = (uint64_t)(uint32_t)w->size.width;
+        return world_bit_xy(w, (uint32_t)(idx % width), (uint32_t)(idx / width));
+    }
+    return idx;
+}
+
+int world_region_resolve(const world_t *w, const world_region_t *r, world_region_t *out) {
+    if (!w || !out) return -1;
+
+    if (!r || r->size.width == 0 || r->size.height == 0) {
+        out->x = 0;
+        out->y = 0;
+        out->size = w->size;
+        return 0;
+    }
+    if (r->x < 0 || r->y < 0 || r->size.width < 0 || r->size.height < 0 ||
+        (int64_t)r->x + r->size.width > w->size.width ||
+        (int64_t)r->y + r->size.height > w->size.height) {
+        return -1;
+    }
+    *out = *r;
+    return 0;
 }
 
 int world_init(world_t *w, world_kind_t kind, world_size_t size) {
@@ -134,19 +289,71 @@ int world_init(world_t *w, world_kind_t kind, world_size_t size) {
     w->kind = kind;
     w->size = size;
 
-    uint32_t n = world_cell_count(w);
-    w->obstacles = (uint8_t*)malloc((size_t)n);
-    if (!w->obstacles) {
+    w->obstacle_bits = (uint8_t*)calloc((size_t)world_obstacle_bytes(w), 1);
+    if (!w->obstacle_bits) {
         return -1;
     }
-    memset(w->obstacles, 0, (size_t)n);
     return 0;
 }
 
 void world_destroy(world_t *w) {
     if (!w) return;
-    free(w->obstacles);
-    w->obstacles = NULL;
+    if (w->map) {
+        munmap(w->map, w->map_len);
+    } else {
+        free(w->obstacle_bits);
+    }
+    w->obstacle_bits = NULL;
+    w->map = NULL;
+    w->map_len = 0;
+}
+
+int world_is_readonly(const world_t *w) {
+    return w && w->map != NULL;
+}
+
+void world_scan_begin(world_scan_t *s, const world_t *w, const world_region_t *reg) {
+    memset(s, 0, sizeof(*s));
+    s->reg = *reg;
+    s->tile = w->layout == WORLD_LAYOUT_TILED ? WORLD_TILE_SIZE : 0;
+    s->bx = reg->x;
+    s->by = reg->y;
+    s->x = reg->x;
+    s->y = reg->y;
+}
+
+int world_scan_next(world_scan_t *s, pos_t *out) {
+    const int32_t x_end = s->reg.x + s->reg.size.width;
+    const int32_t y_end = s->reg.y + s->reg.size.height;
+    if (s->reg.size.width <= 0 || s->y >= y_end) return 0;
+
+    out->x = s->x;
+    out->y = s->y;
+
+    /* Current block: the rest of the tile at (bx,by), or one region row. */
+    int32_t bx_end = x_end;
+    int32_t by_end = s->by + 1;
+    if (s->tile > 0) {
+        bx_end = (s->bx / s->tile + 1) * s->tile;
+        by_end = (s->by / s->tile + 1) * s->tile;
+        if (bx_end > x_end) bx_end = x_end;
+        if (by_end > y_end) by_end = y_end;
+    }
+
+    if (++s->x < bx_end) return 1;
+    s->x = s->bx;
+    if (++s->y < by_end) return 1;
+
+    /* Next block in the same band, or the first block of the next band. */
+    if (bx_end < x_end) {
+        s->bx = bx_end;
+    } else {
+        s->bx = s->reg.x;
+        s->by = by_end;
+    }
+    s->x = s->bx;
+    s->y = s->by;
+    return 1;
 }
 
 int world_in_bounds(const world_t *w, int32_t x, int32_t y) {
@@ -173,45 +380,62 @@ pos_t world_wrap_pos(const world_t *w, pos_t p) {
     return out;
 }
 
-uint32_t world_index(const world_t *w, int32_t x, int32_t y) {
-    return (uint32_t)y * w->size.width + (uint32_t)x;
+uint64_t world_index(const world_t *w, int32_t x, int32_t y) {
+    return (uint64_t)(uint32_t)y * (uint64_t)(uint32_t)w->size.width + (uint64_t)(uint32_t)x;
 }
 
-int world_is_obstacle_idx(const world_t *w, uint32_t idx) {
-    uint32_t n = world_cell_count(w);
-    if (idx >= n) return 1;
-    return w->obstacles[idx] ? 1 : 0;
+int world_is_obstacle_idx(const world_t *w, uint64_t idx) {
+    if (idx >= world_cell_count(w)) return 1;
+    uint64_t bit = world_bit_idx(w, idx);
+    return (int)BIT_GET(w->obstacle_bits, bit);
 }
 
 int world_is_obstacle_xy(const world_t *w, int32_t x, int32_t y) {
     if (!world_in_bounds(w, x, y)) return 1;
-    uint32_t idx = world_index(w, x, y);
-    return world_is_obstacle_idx(w, idx);
+    uint64_t bit = world_bit_xy(w, (uint32_t)x, (uint32_t)y);
+    return (int)BIT_GET(w->obstacle_bits, bit);
+}
+
+uint64_t world_obstacle_bit(const world_t *w, int32_t x, int32_t y) {
+    return world_bit_xy(w, (uint32_t)x, (uint32_t)y);
+}
+
+void world_set_obstacle_idx(world_t *w, uint64_t idx, int value) {
+    if (idx >= world_cell_count(w) || world_is_readonly(w)) return;
+    uint64_t pos = world_bit_idx(w, idx);
+    uint8_t bit = (uint8_t)(1u << (pos & 7u));
+    if (value) {
+        w->obstacle_bits[pos >> 3] |= bit;
+    } else {
+        w->obstacle_bits[pos >> 3] &= (uint8_t)~bit;
+    }
 }
 
 void world_set_obstacle(world_t *w, int32_t x, int32_t y, int value) {
     if (!world_in_bounds(w, x, y)) return;
-    uint32_t idx = world_index(w, x, y);
-    w->obstacles[idx] = (uint8_t)value ? 1 : 0;
+    world_set_obstacle_idx(w, world_index(w, x, y), value);
 }
 
 void world_generate_obstacles(world_t *w, int percent, uint32_t seed) {
-    if (!w || !w->obstacles) return;
+    if (!w || !w->obstacle_bits || world_is_readonly(w)) return;
 
     if (percent < 0) percent = 0;
     if (percent > 100) percent = 100;
 
-    uint32_t n = world_cell_count(w);
+    uint64_t n = world_cell_count(w);
     uint32_t state = seed;
 
-    for (uint32_t i = 0; i < n; i++) {
-        uint32_t r = lcg_next(&state) % 100u;
-        w->obstacles[i] = (r < (uint32_t)percent) ? 1 : 0;
+    memset(w->obstacle_bits, 0, (size_t)world_obstacle_bytes(w));
+    if (percent == 0) {
+        return; /* empty map; nothing to make reachable */
     }
 
-    if (n > 0) {
-        w->obstacles[0] = 0; /* Ensure origin (0,0) is always free. */
+    for (uint64_t i = 0; i < n; i++) {
+        uint32_t r = lcg_next(&state) % 100u;
+        if (r < (uint32_t)percent) {
+            BIT_SET(w->obstacle_bits, i); /* heap worlds are always linear */
+        }
     }
 
-    world_enforce_origin_reachability(w);
+    (void)world_ensure_reachable(w, NULL);
 }
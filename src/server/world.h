@@ -15,13 +15,23 @@
  *
  * Storage
  * -------
- * Obstacles are stored in a flat array in row-major order:
+ * Cells are addressed by a 64-bit linear index in row-major order:
  * @code
- * idx = y * width + x
+ * idx = (uint64_t)y * width + x
  * @endcode
- * with values:
- * - 0 = free cell
- * - 1 = obstacle
+ * so worlds with more than 2^32 cells (e.g. 70000 x 70000) are supported.
+ *
+ * Obstacles are stored as a bitmap, one bit per cell (1 = obstacle, 0 = free),
+ * in one of two layouts:
+ * - @ref WORLD_LAYOUT_LINEAR: bit `idx & 7` of byte `idx >> 3`, heap-allocated
+ *   by @ref world_init(). A 70000 x 70000 world needs ~612 MB.
+ * - @ref WORLD_LAYOUT_TILED: 64 x 64 cell tiles of 512 bytes each, tiles in
+ *   row-major order, cells row-major inside a tile. Used for worlds backed by a
+ *   read-only memory-mapped RWTILE file (see world_tiles.h), so the obstacle
+ *   map may be larger than RAM and only the tiles around active walks are
+ *   resident. Such worlds cannot be modified.
+ *
+ * Always use the accessors below instead of touching the bitmap directly.
  *
  * Semantics
  * ---------
@@ -31,6 +41,13 @@
  * - Obstacle queries treat out-of-bounds coordinates/indices as blocked
  *   (they return 1).
  *
+ * Scan order
+ * ----------
+ * @ref world_scan_next() enumerates the cells of a region tile by tile for
+ * tiled worlds (row-major otherwise). Schedulers use it so that consecutive
+ * walks start close to each other and the working set of a mapped world stays
+ * bounded to a band of tiles.
+ *
  * Threading
  * ---------
  * This module does not synchronize access internally. If a world is shared
@@ -39,8 +56,23 @@
  */
 
 #include "../common/types.h"
+#include <stddef.h>
 #include <stdint.h>
 
+/** Tile edge of the tiled layout, in cells. */
+#define WORLD_TILE_SHIFT 6
+#define WORLD_TILE_SIZE (1 << WORLD_TILE_SHIFT)
+/** Bytes per tile (WORLD_TILE_SIZE^2 bits). */
+#define WORLD_TILE_BYTES ((WORLD_TILE_SIZE * WORLD_TILE_SIZE) / 8)
+
+/**
+ * @brief Obstacle bitmap layout (see file documentation).
+ */
+typedef enum {
+    WORLD_LAYOUT_LINEAR = 0,
+    WORLD_LAYOUT_TILED = 1
+} world_layout_t;
+
 typedef struct {
     /** World kind/topology (meaning defined elsewhere by world_kind_t). */
     world_kind_t kind;
@@ -49,20 +81,53 @@ typedef struct {
     world_size_t size;
 
     /**
-     * Obstacle bitmap for all cells.
+     * Obstacle bitmap for all cells (one bit per cell, see file documentation).
      *
-     * Length: width*height bytes.
-     * Values: 0 (free) or 1 (obstacle).
+     * Length: @ref world_obstacle_bytes() bytes.
      *
-     * Memory is owned by this structure and allocated in @ref world_init().
+     * Linear worlds own this memory (allocated in @ref world_init()); for mapped
+     * worlds it points into the read-only file mapping.
      */
-    uint8_t *obstacles;
+    uint8_t *obstacle_bits;
+
+    /** Layout of @ref obstacle_bits. */
+    world_layout_t layout;
+
+    /** Tiles per tile row (tiled layout only). */
+    uint32_t tiles_x;
+
+    /** File mapping backing a tiled world (NULL for heap worlds). */
+    void *map;
+    size_t map_len;
 } world_t;
 
+/**
+ * @brief Rectangle of cells (e.g. the simulated region of a large world).
+ *
+ * A region with zero width or height means "the whole world".
+ */
+typedef struct {
+    int32_t x;
+    int32_t y;
+    world_size_t size;
+} world_region_t;
+
+/**
+ * @brief Iterator over the cells of a region (see "Scan order").
+ */
+typedef struct {
+    world_region_t reg;
+    int32_t tile;     /**< Tile size, 0 = row-major. */
+    int32_t bx;       /**< Left column of the current block. */
+    int32_t by;       /**< Top row of the current block. */
+    int32_t x;
+    int32_t y;
+} world_scan_t;
+
 /**
  * @brief Initialize a world.
  *
- * Allocates a zeroed obstacle array of size width*height.
+ * Allocates a zeroed obstacle bitmap for width*height cells.
  *
  * @param w    World handle to initialize.
  * @param kind World kind/topology.
@@ -74,19 +139,43 @@ typedef struct {
 int world_init(world_t *w, world_kind_t kind, world_size_t size);
 
 /**
- * @brief Free resources associated with the world.
+ * @brief Free resources associated with the world (heap bitmap or file mapping).
  * @param w World to destroy (may be NULL).
  */
 void world_destroy(world_t *w);
 
+/**
+ * @brief Check whether the world is backed by a read-only mapping.
+ * @param w World.
+ * @return Non-zero for mapped worlds; obstacle setters ignore such worlds.
+ */
+int world_is_readonly(const world_t *w);
+
+/**
+ * @brief Start scanning the cells of @p reg (already resolved, inside the world).
+ * @param s   Iterator.
+ * @param w   World (selects the order).
+ * @param reg Region to scan.
+ */
+void world_scan_begin(world_scan_t *s, const world_t *w, const world_region_t *reg);
+
+/**
+ * @brief Next cell of the scan.
+ * @param s   Iterator.
+ * @param out Cell position.
+ * @return 1 if @p out was set, 0 when the scan is finished.
+ */
+int world_scan_next(world_scan_t *s, pos_t *out);
+
 /**
  * @brief Generate obstacles with a deterministic pseudo-random distribution.
  *
  * Each cell is set to obstacle with probability approximately @p percent/100.
  * Percent is clamped to [0,100]. The same @p seed yields the same obstacle map.
+ * Mapped (read-only) worlds are left unchanged.
  *
- * The origin cell (index 0, i.e. coordinate (0,0) in row-major order) is always
- * forced to be free.
+ * Afterwards @ref world_ensure_reachable() makes every free cell reachable
+ * from the origin.
  *
  * @param w       World.
  * @param percent Obstacle percentage in range [0,100] (values outside are clamped).
@@ -94,12 +183,46 @@ void world_destroy(world_t *w);
  */
 void world_generate_obstacles(world_t *w, int percent, uint32_t seed);
 
+/**
+ * @brief Make every free cell reachable from the origin (4-neighbourhood, no wrap).
+ *
+ * The origin is forced free and flood-filled. Cells are then scanned in
+ * row-major order; a free cell not reached yet gets a corridor carved straight
+ * up (then left along row 0) to the first free cell, which is already
+ * reachable, and its component is flooded. Every cell is flooded once and
+ * every carved cell was an obstacle, so the fixup runs in O(cells).
+ *
+ * Extra memory: a reachability bitmap (cells / 8 bytes) and the flood frontier.
+ *
+ * @param w          Heap (writable) world.
+ * @param out_carved Optional: number of obstacles removed.
+ * @return 0 on success, -1 on invalid world or allocation failure.
+ */
+int world_ensure_reachable(world_t *w, uint64_t *out_carved);
+
 /**
  * @brief Get total number of cells in the world.
  * @param w World.
- * @return width*height.
+ * @return width*height (computed in 64 bits).
+ */
+uint64_t world_cell_count(const world_t *w);
+
+/**
+ * @brief Size of the obstacle bitmap in bytes.
+ * @param w World.
+ * @return ceil(cell_count / 8) for the linear layout, whole tiles for the tiled one.
+ */
+uint64_t world_obstacle_bytes(const world_t *w);
+
+/**
+ * @brief Resolve a region against the world.
+ *
+ * @param w   World.
+ * @param r   Requested region, or NULL; an empty region selects the whole world.
+ * @param out Resolved region.
+ * @return 0 if the region lies inside the world, -1 otherwise.
  */
-uint32_t world_cell_count(const world_t *w);
+int world_region_resolve(const world_t *w, const world_region_t *r, world_region_t *out);
 
 /**
  * @brief Convert 2D coordinates to linear index (row-major).
@@ -107,11 +230,11 @@ uint32_t world_cell_count(const world_t *w);
  * @param w World.
  * @param x X coordinate (column).
  * @param y Y coordinate (row).
- * @return Linear index (@c y*width + x).
+ * @return Linear index (@c y*width + x, computed in 64 bits).
  *
  * @warning This function does not validate bounds; use @ref world_in_bounds().
  */
-uint32_t world_index(const world_t *w, int32_t x, int32_t y);
+uint64_t world_index(const world_t *w, int32_t x, int32_t y);
 
 /**
  * @brief Test whether a coordinate is within the world rectangle.
@@ -141,7 +264,16 @@ pos_t world_wrap_pos(const world_t *w, pos_t p);
  * @param idx Linear cell index.
  * @return 1 if the index is invalid or the cell is an obstacle; 0 otherwise.
  */
-int world_is_obstacle_idx(const world_t *w, uint32_t idx);
+int world_is_obstacle_idx(const world_t *w, uint64_t idx);
+
+/**
+ * @brief Set or clear an obstacle (`idx` version).
+ * Invalid indices and read-only worlds are ignored.
+ * @param w     World.
+ * @param idx   Linear cell index.
+ * @param value Non-zero sets obstacle, 0 clears it.
+ */
+void world_set_obstacle_idx(world_t *w, uint64_t idx, int value);
 
 /**
  * @brief Check whether a cell is an obstacle (`x,y` version).
@@ -153,10 +285,23 @@ int world_is_obstacle_idx(const world_t *w, uint32_t idx);
  */
 int world_is_obstacle_xy(const world_t *w, int32_t x, int32_t y);
 
+/**
+ * @brief Position of cell (x,y) in the obstacle bitmap (either layout).
+ *
+ * Bit @c b is bit `b & 7` of byte `obstacle_bits[b >> 3]`. Meant for kernels
+ * that compute the position once, prefetch the byte and test it later.
+ *
+ * @param w World.
+ * @param x X coordinate, must be in bounds.
+ * @param y Y coordinate, must be in bounds.
+ * @return Bit position.
+ */
+uint64_t world_obstacle_bit(const world_t *w, int32_t x, int32_t y);
+
 /**
  * @brief Set or clear an obstacle at (x,y).
  *
- * If (x,y) is out of bounds, the function does nothing.
+ * If (x,y) is out of bounds or the world is read-only, the function does nothing.
  *
  * @param w     World.
  * @param x     X coordinate.
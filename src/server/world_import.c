@@ -0,0 +1,225 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "world_import.h"
+
+#include "../common/util.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @file world_import.c
+ * @brief Implementation of the streaming PBM/PGM importer.
+ */
+
+#define PNM_BLOCK_BYTES 65536u
+
+/* Buffered reader over the raster (the header is parsed with getc()). */
+typedef struct {
+    FILE *f;
+    uint8_t buf[PNM_BLOCK_BYTES];
+    size_t pos;
+    size_t len;
+} pnm_reader_t;
+
+/* Next byte of the raster, or -1 at end of file. */
+static int reader_byte(pnm_reader_t *r) {
+    if (r->pos == r->len) {
+        r->len = fread(r->buf, 1, sizeof(r->buf), r->f);
+        r->pos = 0;
+        if (r->len == 0) return -1;
+    }
+    return r->buf[r->pos++];
+}
+
+/* Skip whitespace and comments, then parse an unsigned decimal header field. */
+static int read_header_u32(FILE *f, uint32_t *out) {
+    int c = getc(f);
+    while (c == '#' || c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+        if (c == '#') {
+            while (c != '\n' && c != EOF) c = getc(f);
+        }
+        c = getc(f);
+    }
+    if (c < '0' || c > '9') return -1;
+
+    uint64_t v = 0;
+    while (c >= '0' && c <= '9') {
+        v = v * 10u + (uint64_t)(c - '0');
+        if (v > UINT32_MAX) return -1;
+        c = getc(f);
+    }
+    /* Exactly one whitespace character ends the field. */
+    if (c != ' ' && c != '\t' && c != '\r' && c != '\n') return -1;
+    *out = (uint32_t)v;
+    return 0;
+}
+
+/* P4: rows of ceil(width / 8) bytes, most significant bit first. Rows do not
+ * start on byte boundaries of the world bitmap, so each input byte is
+ * bit-reversed and OR-ed across at most two output bytes. */
+static int import_pbm(pnm_reader_t *r, world_t *w) {
+    const uint32_t W = (uint32_t)w->size.width;
+    const uint32_t H = (uint32_t)w->size.height;
+    uint8_t *bits = w->obstacle_bits;
+    uint64_t idx = 0;
+
+    uint8_t rev[256];
+    for (unsigned b = 0; b < 256u; b++) {
+        unsigned v = 0;
+        for (unsigned j = 0; j < 8u; j++) {
+            if (b & (1u << j)) v |= 1u << (7u - j);
+        }
+        rev[b] = (uint8_t)v;
+    }
+
+    for (uint32_t y = 0; y < H; y++) {
+        for (uint32_t x = 0; x < W; x += 8u) {
+            int c = reader_byte(r);
+            if (c < 0) return -1;
+            uint32_t n = W - x < 8u ? W - x : 8u;
+            unsigned v = rev[c] & ((1u << n) - 1u);
+            unsigned shift = (unsigned)(idx & 7u);
+            if (v) {
+                bits[idx >> 3] |= (uint8_t)(v << shift);
+                if (shift && (v >> (8u - shift))) bits[(idx >> 3) + 1u] |= (uint8_t)(v >> (8u - shift));
+            }
+            idx += n;
+        }
+    }
+    return 0;
+}
+
+/* P5: one or two bytes (big-endian) per pixel. Output bytes are assembled in a
+ * register and stored once (the bitmap starts zeroed and is filled in order). */
+static int import_pgm(pnm_reader_t *r, world_t *w, uint32_t maxval, int threshold) {
+    const uint64_t n = world_cell_count(w);
+    uint8_t *bits = w->obstacle_bits;
+    unsigned acc = 0;
+    uint64_t idx = 0;
+
+    if (maxval == 255u) {
+        while (idx < n) {
+            if (r->pos == r->len) {
+                r->len = fread(r->buf, 1, sizeof(r->buf), r->f);
+                r->pos = 0;
+                if (r->len == 0) return -1;
+            }
+            /* Whole buffered block at once: the common 8-bit case. */
+            size_t avail = r->len - r->pos;
+            if ((uint64_t)avail > n - idx) avail = (size_t)(n - idx);
+            const uint8_t *p = r->buf + r->pos;
+            for (size_t i = 0; i < avail; i++, idx++) {
+                acc |= (unsigned)((int)p[i] < threshold) << (idx & 7u);
+                if ((idx & 7u) == 7u) {
+                    bits[idx >> 3] = (uint8_t)acc;
+                    acc = 0;
+                }
+            }
+            r->pos += avail;
+        }
+    } else {
+        for (; idx < n; idx++) {
+            int hi = reader_byte(r);
+            if (hi < 0) return -1;
+            uint32_t v = (uint32_t)hi;
+            if (maxval > 255u) {
+                int lo = reader_byte(r);
+                if (lo < 0) return -1;
+                v = (v << 8) | (uint32_t)lo;
+            }
+            uint32_t gray = (uint32_t)(((uint64_t)(v > maxval ? maxval : v) * 255u) / maxval);
+            acc |= (unsigned)((int)gray < threshold) << (idx & 7u);
+            if ((idx & 7u) == 7u) {
+                bits[idx >> 3] = (uint8_t)acc;
+                acc = 0;
+            }
+        }
+    }
+    if (n & 7u) {
+        bits[n >> 3] = (uint8_t)acc;
+    }
+    return 0;
+}
+
+int world_import_pnm(const char *path,
+                     world_kind_t kind,
+                     int threshold,
+                     world_t *world,
+                     server_context_t *ctx_optional) {
+    if (!path || !world) return -1;
+
+    pnm_reader_t *r = (pnm_reader_t *)malloc(sizeof(*r));
+    if (!r) return -1;
+    memset(r, 0, sizeof(*r));
+
+    r->f = fopen(path, "rb");
+    if (!r->f) {
+        log_error("world_import: fopen('%s') failed: %s", path, strerror(errno));
+        free(r);
+        return -1;
+    }
+
+    char magic[2];
+    uint32_t width = 0, height = 0, maxval = 1;
+    int ok = fread(magic, 1, 2, r->f) == 2 && magic[0] == 'P' && (magic[1] == '4' || magic[1] == '5');
+    ok = ok && read_header_u32(r->f, &width) == 0 && read_header_u32(r->f, &height) == 0;
+    if (ok && magic[1] == '5') {
+        ok = read_header_u32(r->f, &maxval) == 0 && maxval >= 1u && maxval <= 65535u;
+    }
+    if (!ok || width == 0 || height == 0 || width > INT32_MAX || height > INT32_MAX) {
+        log_error("world_import: '%s' is not a binary PBM/PGM image", path);
+        fclose(r->f);
+        free(r);
+        return -1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    //build aside: on any failure below @p world stays as it was
+    world_t tmp;
+    if (world_init(&tmp, kind, (world_size_t){(int32_t)width, (int32_t)height}) != 0) {
+        fclose(r->f);
+        free(r);
+        return -1;
+    }
+
+    int rc = magic[1] == '4' ? import_pbm(r, &tmp) : import_pgm(r, &tmp, maxval, threshold);
+    fclose(r->f);
+    free(r);
+    if (rc != 0) {
+        log_error("world_import: '%s' is truncated", path);
+        world_destroy(&tmp);
+        return -1;
+    }
+
+    uint64_t carved = 0;
+    if (world_ensure_reachable(&tmp, &carved) != 0) {
+        world_destroy(&tmp);
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    world_destroy(world);
+    *world = tmp;
+
+    log_info("world_import: %ux%u from '%s' in %.3f s (%llu obstacles carved for reachability)",
+             width, height, path,
+             (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) * 1e-9,
+             (unsigned long long)carved);
+
+    if (ctx_optional) {
+        ctx_optional->world_kind = kind;
+        ctx_optional->world_size.width = (int32_t)width;
+        ctx_optional->world_size.height = (int32_t)height;
+    }
+    return 0;
+}
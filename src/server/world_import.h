@@ -0,0 +1,54 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_WORLD_IMPORT_H
+#define SEMPRACA_WORLD_IMPORT_H
+
+/**
+ * @file world_import.h
+ * @brief Import of obstacle maps from binary PBM/PGM images.
+ *
+ * Supported formats (Netpbm, binary variants):
+ *  - `P4` (PBM): 1 bit per pixel, rows padded to whole bytes; black (1) = obstacle.
+ *  - `P5` (PGM): 1 byte per pixel (maxval <= 255) or 2 bytes big-endian
+ *    (maxval <= 65535); a pixel is an obstacle if its gray level scaled to
+ *    0..255 is below the threshold (dark = obstacle).
+ *
+ * Header comments (`#` to end of line) are accepted. Image pixel (x,y) is world
+ * cell (x,y), so the origin is the top-left corner.
+ *
+ * Memory
+ * ------
+ * The raster is streamed in fixed-size blocks straight into the world bitmap,
+ * so parsing needs constant extra memory. The reachability fixup afterwards
+ * (@ref world_ensure_reachable()) needs cells / 8 bytes plus its frontier.
+ */
+
+#include "world.h"
+#include "server_context.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Load a PBM/PGM image as the obstacle map of @p world.
+ *
+ * The new world is built aside and replaces @p world only on success; on
+ * failure @p world (and @p ctx_optional) are left unchanged. The new world has
+ * the image size; the origin is forced free and every free cell is made
+ * reachable from it.
+ *
+ * @param path         Image path.
+ * @param kind         World kind of the new world.
+ * @param threshold    PGM only: gray levels (0..255) below it are obstacles.
+ * @param world        World to replace (a valid world).
+ * @param ctx_optional If not NULL, world kind and size are stored there.
+ * @return 0 on success, -1 on failure (invalid or truncated image, no memory).
+ */
+int world_import_pnm(const char *path,
+                     world_kind_t kind,
+                     int threshold,
+                     world_t *world,
+                     server_context_t *ctx_optional);
+
+#endif //SEMPRACA_WORLD_IMPORT_H
@@ -0,0 +1,240 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#define _DEFAULT_SOURCE
+
+#include "world_tiles.h"
+
+#include "../common/util.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @file world_tiles.c
+ * @brief Implementation of RWTILE generation, conversion and mapping.
+ */
+
+#define RWTILE_MAGIC "RWTILE\0\0"
+#define RWTILE_MAGIC_LEN 8
+#define RWTILE_VERSION 1u
+
+/* Fills one tile row (tiles_x tiles) of the output. */
+typedef void (*tile_row_fn)(void *user, uint32_t ty, uint32_t tiles_x, uint8_t *row);
+
+typedef struct {
+    uint64_t state;
+    uint32_t threshold; /* byte < threshold => obstacle, out of 256 */
+    int32_t width;
+    int32_t height;
+} gen_state_t;
+
+static int write_exact(FILE *f, const void *p, size_t n) {
+    return fwrite(p, 1, n, f) == n ? 0 : -1;
+}
+
+/* splitmix64: fast, and every seed gives a full-period sequence. */
+static uint64_t gen_next(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static uint32_t tiles_along(int32_t cells) {
+    return (uint32_t)(((uint64_t)(uint32_t)cells + WORLD_TILE_SIZE - 1u) >> WORLD_TILE_SHIFT);
+}
+
+/* Mark cells outside the world as obstacles in the last tile column/row. */
+static void pad_tile_row(uint8_t *row, uint32_t ty, uint32_t tiles_x, int32_t width, int32_t height) {
+    for (uint32_t tx = 0; tx < tiles_x; tx++) {
+        uint64_t x0 = (uint64_t)tx << WORLD_TILE_SHIFT;
+        uint64_t y0 = (uint64_t)ty << WORLD_TILE_SHIFT;
+        int edge_x = x0 + WORLD_TILE_SIZE > (uint64_t)width;
+        int edge_y = y0 + WORLD_TILE_SIZE > (uint64_t)height;
+        if (!edge_x && !edge_y) continue;
+
+        uint8_t *tile = row + (size_t)tx * WORLD_TILE_BYTES;
+        for (uint32_t b = 0; b < WORLD_TILE_BYTES; b++) {
+            uint64_t gy = y0 + b / (WORLD_TILE_SIZE / 8u);
+            uint64_t gx = x0 + (b % (WORLD_TILE_SIZE / 8u)) * 8u;
+            if (gy >= (uint64_t)height) {
+                tile[b] = 0xFF;
+                continue;
+            }
+            for (uint32_t j = 0; j < 8u; j++) {
+                if (gx + j >= (uint64_t)width) tile[b] |= (uint8_t)(1u << j);
+            }
+        }
+    }
+}
+
+static void gen_tile_row(void *user, uint32_t ty, uint32_t tiles_x, uint8_t *row) {
+    gen_state_t *g = (gen_state_t *)user;
+    size_t len = (size_t)tiles_x * WORLD_TILE_BYTES;
+
+    if (g->threshold == 0) {
+        memset(row, 0, len);
+    } else {
+        /* One 64-bit draw decides eight neighbouring cells (one byte each). */
+        for (size_t i = 0; i < len; i++) {
+            uint64_t r = gen_next(&g->state);
+            uint8_t byte = 0;
+            for (uint32_t j = 0; j < 8u; j++) {
+                if ((uint32_t)((r >> (j * 8u)) & 0xFFu) < g->threshold) byte |= (uint8_t)(1u << j);
+            }
+            row[i] = byte;
+        }
+    }
+    if (ty == 0) {
+        row[0] &= (uint8_t)~1u; /* origin (0,0) is always free */
+    }
+    pad_tile_row(row, ty, tiles_x, g->width, g->height);
+}
+
+static void copy_tile_row(void *user, uint32_t ty, uint32_t tiles_x, uint8_t *row) {
+    const world_t *w = (const world_t *)user;
+    memset(row, 0, (size_t)tiles_x * WORLD_TILE_BYTES);
+
+    int32_t y0 = (int32_t)(ty << WORLD_TILE_SHIFT);
+    for (int32_t dy = 0; dy < WORLD_TILE_SIZE && y0 + dy < w->size.height; dy++) {
+        for (int32_t x = 0; x < w->size.width; x++) {
+            if (!world_is_obstacle_xy(w, x, y0 + dy)) continue;
+            uint32_t bit = ((uint32_t)dy << WORLD_TILE_SHIFT) | ((uint32_t)x & (WORLD_TILE_SIZE - 1u));
+            row[(size_t)((uint32_t)x >> WORLD_TILE_SHIFT) * WORLD_TILE_BYTES + bit / 8u] |=
+                (uint8_t)(1u << (bit & 7u));
+        }
+    }
+    pad_tile_row(row, ty, tiles_x, w->size.width, w->size.height);
+}
+
+static int write_tiles(const char *path, world_kind_t kind, world_size_t size,
+                       tile_row_fn fill, void *user) {
+    if (!path || size.width <= 0 || size.height <= 0) return -1;
+
+    uint32_t tiles_x = tiles_along(size.width);
+    uint32_t tiles_y = tiles_along(size.height);
+    uint8_t *row = (uint8_t *)malloc((size_t)tiles_x * WORLD_TILE_BYTES);
+    uint8_t *header = (uint8_t *)calloc(WORLD_TILES_DATA_OFFSET, 1);
+    if (!row || !header) {
+        free(row);
+        free(header);
+        return -1;
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        log_error("world_tiles: fopen('%s') failed: %s", path, strerror(errno));
+        free(row);
+        free(header);
+        return -1;
+    }
+
+    uint32_t fields[6] = {RWTILE_VERSION, (uint32_t)kind, (uint32_t)size.width,
+                          (uint32_t)size.height, WORLD_TILE_SIZE, 0u};
+    memcpy(header, RWTILE_MAGIC, RWTILE_MAGIC_LEN);
+    memcpy(header + RWTILE_MAGIC_LEN, fields, sizeof(fields));
+
+    int ok = write_exact(f, header, WORLD_TILES_DATA_OFFSET);
+    for (uint32_t ty = 0; ty < tiles_y && ok == 0; ty++) {
+        fill(user, ty, tiles_x, row);
+        ok = write_exact(f, row, (size_t)tiles_x * WORLD_TILE_BYTES);
+    }
+
+    if (fclose(f) != 0) {
+        ok = -1;
+    }
+    free(row);
+    free(header);
+
+    if (ok != 0) {
+        log_error("world_tiles: write failed for '%s'", path);
+        return -1;
+    }
+    return 0;
+}
+
+int world_tiles_generate(const char *path,
+                         world_kind_t kind,
+                         world_size_t size,
+                         int percent,
+                         uint32_t seed) {
+    if (percent < 0) percent = 0;
+    if (percent > 100) percent = 100;
+
+    gen_state_t g;
+    g.state = (uint64_t)seed;
+    g.threshold = (uint32_t)((percent * 256 + 50) / 100);
+    g.width = size.width;
+    g.height = size.height;
+    return write_tiles(path, kind, size, gen_tile_row, &g);
+}
+
+int world_tiles_save(const char *path, const world_t *w) {
+    if (!w || !w->obstacle_bits) return -1;
+    return write_tiles(path, w->kind, w->size, copy_tile_row, (void *)w);
+}
+
+int world_tiles_map(world_t *w, const char *path) {
+    if (!w || !path) return -1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        log_error("world_tiles: open('%s') failed: %s", path, strerror(errno));
+        return -1;
+    }
+
+    uint8_t header[RWTILE_MAGIC_LEN + 6 * sizeof(uint32_t)];
+    uint32_t fields[6];
+    struct stat st;
+    if (fstat(fd, &st) != 0 || pread(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+        log_error("world_tiles: cannot read header of '%s'", path);
+        close(fd);
+        return -1;
+    }
+    memcpy(fields, header + RWTILE_MAGIC_LEN, sizeof(fields));
+
+    if (memcmp(header, RWTILE_MAGIC, RWTILE_MAGIC_LEN) != 0 || fields[0] != RWTILE_VERSION ||
+        fields[2] == 0 || fields[3] == 0 || fields[2] > INT32_MAX || fields[3] > INT32_MAX ||
+        fields[4] != WORLD_TILE_SIZE) {
+        log_error("world_tiles: invalid header in '%s'", path);
+        close(fd);
+        return -1;
+    }
+
+    world_t tmp;
+    memset(&tmp, 0, sizeof(tmp));
+    tmp.kind = (fields[1] == (uint32_t)WORLD_OBSTACLES) ? WORLD_OBSTACLES : WORLD_WRAP;
+    tmp.size.width = (int32_t)fields[2];
+    tmp.size.height = (int32_t)fields[3];
+    tmp.layout = WORLD_LAYOUT_TILED;
+    tmp.tiles_x = tiles_along(tmp.size.width);
+
+    uint64_t need = (uint64_t)WORLD_TILES_DATA_OFFSET + world_obstacle_bytes(&tmp);
+    if ((uint64_t)st.st_size < need || need > (uint64_t)SIZE_MAX) {
+        log_error("world_tiles: '%s' is truncated (%lld of %llu bytes)",
+                  path, (long long)st.st_size, (unsigned long long)need);
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, (size_t)need, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        log_error("world_tiles: mmap('%s') failed: %s", path, strerror(errno));
+        return -1;
+    }
+
+    tmp.map = map;
+    tmp.map_len = (size_t)need;
+    tmp.obstacle_bits = (uint8_t *)map + WORLD_TILES_DATA_OFFSET;
+    *w = tmp;
+    return 0;
+}
@@ -0,0 +1,87 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+#ifndef SEMPRACA_WORLD_TILES_H
+#define SEMPRACA_WORLD_TILES_H
+
+/**
+ * @file world_tiles.h
+ * @brief Out-of-core obstacle worlds stored in memory-mapped tile files.
+ *
+ * A heap world needs its whole obstacle bitmap in RAM. For worlds larger than
+ * memory the bitmap is kept in an RWTILE file and mapped read-only; the kernel
+ * pages tiles in on demand and may drop clean pages at any time, so the
+ * resident set is bounded by the tiles the walks actually touch.
+ *
+ * File format (little-endian)
+ * ---------------------------
+ *  - magic[8] = "RWTILE\0\0"
+ *  - uint32_t version (1)
+ *  - uint32_t world_kind
+ *  - uint32_t width
+ *  - uint32_t height
+ *  - uint32_t tile_size (@ref WORLD_TILE_SIZE)
+ *  - uint32_t reserved
+ *  - zero padding up to @ref WORLD_TILES_DATA_OFFSET (one page, so the tile
+ *    data is page aligned)
+ *  - tiles_x * tiles_y tiles of @ref WORLD_TILE_BYTES each, in row-major tile
+ *    order; bit ((y % 64) * 64 + (x % 64)) of a tile is cell (x,y).
+ *    Padding cells of edge tiles are stored as obstacles.
+ *
+ * Memory
+ * ------
+ * Generation streams one tile row at a time, so it needs
+ * tiles_x * @ref WORLD_TILE_BYTES bytes of memory regardless of the height.
+ */
+
+#include "world.h"
+#include "../common/types.h"
+
+#include <stdint.h>
+
+/** Offset of the first tile in an RWTILE file. */
+#define WORLD_TILES_DATA_OFFSET 4096u
+
+/**
+ * @brief Generate a random obstacle world directly into an RWTILE file.
+ *
+ * Each cell is an obstacle with probability approximately @p percent/100; the
+ * origin is always free. Unlike @ref world_generate_obstacles() no corridors
+ * are carved (that needs the whole map in memory), so some free cells may be
+ * cut off from the origin; walks starting there simply never succeed.
+ *
+ * @param path    Output path (overwritten).
+ * @param kind    World kind stored in the header.
+ * @param size    World size (both dimensions >= 1).
+ * @param percent Obstacle percentage, clamped to [0,100].
+ * @param seed    Seed; the same seed yields the same file.
+ * @return 0 on success, -1 on failure.
+ */
+int world_tiles_generate(const char *path,
+                         world_kind_t kind,
+                         world_size_t size,
+                         int percent,
+                         uint32_t seed);
+
+/**
+ * @brief Write the obstacles of @p w to an RWTILE file.
+ * @param path Output path (overwritten).
+ * @param w    World (either layout).
+ * @return 0 on success, -1 on failure.
+ */
+int world_tiles_save(const char *path, const world_t *w);
+
+/**
+ * @brief Map an RWTILE file as a read-only tiled world.
+ *
+ * @p w is overwritten (it must not own resources); on success it has to be
+ * released with @ref world_destroy().
+ *
+ * @param w    World to initialize.
+ * @param path RWTILE file.
+ * @return 0 on success, -1 on failure (invalid or truncated file).
+ */
+int world_tiles_map(world_t *w, const char *path);
+
+#endif //SEMPRACA_WORLD_TILES_H
@@ -0,0 +1,416 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+/**
+ * @file loadgen.c
+ * @brief Synthetic client load for the IPC server.
+ *
+ * Opens N connections (JOIN + WELCOME each) and issues a weighted mix of
+ * QUERY_STATUS, REQUEST_SNAPSHOT and SET_GLOBAL_MODE requests at a target
+ * total rate for a fixed time. Requests are scheduled open-loop: latency is
+ * measured from the time a request was due, so a slow server shows up as
+ * latency instead of silently lowering the offered rate.
+ *
+ * Before the load phase a monitor connection samples the simulation progress
+ * for the same duration without load; if a simulation is running in both
+ * phases the report compares replications per second idle vs. under load.
+ *
+ * Usage: loadgen [--socket P] [--clients N] [--rate R] [--duration S]
+ *                [--mix STATUS,SNAPSHOT,MODE] [--snapshot-format F] [--no-idle]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../common/protocol.h"
+#include "../common/util.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LG_MAX_CLIENTS 256
+#define LG_REPLY_TIMEOUT_S 5
+
+enum { OP_STATUS, OP_SNAPSHOT, OP_MODE, OP_COUNT };
+static const char *const kOpName[OP_COUNT] = {"status", "snapshot", "mode"};
+
+static uint8_t g_snapshot_format = RW_SNAP_FORMAT_RAW;
+
+typedef struct {
+    uint64_t ok;
+    uint64_t err;      /* server answered with ERROR */
+    uint64_t fail;     /* timeout or disconnect */
+    uint32_t *lat_us;  /* latencies of ok requests */
+    size_t n_lat, cap_lat;
+} lg_op_stats_t;
+
+typedef struct {
+    int id;
+    const char *socket_path;
+    double interval_s;   /* 0 = closed loop */
+    double t_start, t_end;
+    unsigned weights[OP_COUNT];
+    unsigned weight_sum;
+    uint64_t rng;
+    uint64_t reconnects;
+    lg_op_stats_t op[OP_COUNT];
+} lg_client_t;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void sleep_until(double t) {
+    double d = t - now_s();
+    if (d <= 0.0) return;
+    struct timespec ts;
+    ts.tv_sec = (time_t)d;
+    ts.tv_nsec = (long)((d - (double)ts.tv_sec) * 1e9);
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+static uint64_t xorshift(uint64_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+/* Connect, JOIN and consume WELCOME; replies time out after LG_REPLY_TIMEOUT_S. */
+static int lg_connect(const char *path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (rw_copy_socket_path(addr.sun_path, sizeof(addr.sun_path), path) != 0 ||
+        connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    struct timeval tv = {LG_REPLY_TIMEOUT_S, 0};
+    (void)setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    rw_join_t join = {(uint32_t)getpid(), 0, 0};
+    rw_msg_hdr_t hdr;
+    rw_welcome_t welcome;
+    if (rw_send_msg(fd, RW_MSG_JOIN, &join, sizeof(join)) != 0 ||
+        rw_recv_hdr(fd, &hdr) != 0 || hdr.type != RW_MSG_WELCOME ||
+        hdr.payload_len != sizeof(welcome) ||
+        rw_recv_payload(fd, &welcome, sizeof(welcome)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void lg_quit(int fd) {
+    rw_quit_t q;
+    memset(&q, 0, sizeof(q));
+    q.pid = (uint32_t)getpid();
+    (void)rw_send_msg(fd, RW_MSG_QUIT, &q, sizeof(q));
+    close(fd);
+}
+
+/*
+ * Read messages until the reply that completes @p op. Broadcasts (PROGRESS,
+ * END, other clients' mode changes) are skipped.
+ * Returns 0 = ok, 1 = ERROR reply, -1 = connection failure.
+ */
+static int lg_wait_reply(int fd, int op, void *buf, size_t cap) {
+    for (;;) {
+        rw_msg_hdr_t hdr;
+        if (rw_recv_hdr(fd, &hdr) != 0 || hdr.payload_len > cap) return -1;
+        if (hdr.payload_len > 0 && rw_recv_payload(fd, buf, hdr.payload_len) != 0) return -1;
+
+        if (hdr.type == RW_MSG_ERROR) return 1;
+        if (op == OP_STATUS && hdr.type == RW_MSG_STATUS) return 0;
+        if (op == OP_MODE && hdr.type == RW_MSG_GLOBAL_MODE_CHANGED) return 0;
+        if (op == OP_SNAPSHOT && hdr.type == RW_MSG_ACK &&
+            hdr.payload_len == sizeof(rw_ack_t) &&
+            ((const rw_ack_t *)buf)->request_type == RW_MSG_REQUEST_SNAPSHOT) {
+            return 0;
+        }
+    }
+}
+
+static int lg_send(int fd, int op, uint32_t seq) {
+    uint32_t pid = (uint32_t)getpid();
+    if (op == OP_STATUS) {
+        rw_query_status_t q = {pid};
+        return rw_send_msg(fd, RW_MSG_QUERY_STATUS, &q, sizeof(q));
+    }
+    if (op == OP_SNAPSHOT) {
+        rw_request_snapshot_t q = {pid, g_snapshot_format, {0}, 0};
+        return rw_send_msg(fd, RW_MSG_REQUEST_SNAPSHOT, &q, sizeof(q));
+    }
+    rw_set_global_mode_t q;
+    q.new_mode = (seq & 1u) ? RW_WIRE_MODE_INTERACTIVE : RW_WIRE_MODE_SUMMARY;
+    return rw_send_msg(fd, RW_MSG_SET_GLOBAL_MODE, &q, sizeof(q));
+}
+
+static void lg_add_latency(lg_op_stats_t *s, double secs) {
+    if (s->n_lat == s->cap_lat) {
+        size_t cap = s->cap_lat ? s->cap_lat * 2u : 1024u;
+        uint32_t *p = (uint32_t *)realloc(s->lat_us, cap * sizeof(*p));
+        if (!p) return;
+        s->lat_us = p;
+        s->cap_lat = cap;
+    }
+    s->lat_us[s->n_lat++] = (uint32_t)(secs * 1e6 + 0.5);
+}
+
+static void *lg_client_main(void *arg) {
+    lg_client_t *c = (lg_client_t *)arg;
+
+    size_t cap = RW_SNAPSHOT_CHUNK_MAX + 4096u;
+    void *buf = malloc(cap);
+    int fd = buf ? lg_connect(c->socket_path) : -1;
+
+    //spread the clients over one interval
+    double due = c->t_start + c->interval_s * (double)c->id / (double)LG_MAX_CLIENTS;
+    uint32_t seq = 0;
+
+    while (buf && now_s() < c->t_end) {
+        if (c->interval_s > 0.0) {
+            sleep_until(due);
+        } else {
+            due = now_s();
+        }
+        if (now_s() >= c->t_end) break;
+
+        unsigned pick = (unsigned)(xorshift(&c->rng) % c->weight_sum);
+        int op = 0;
+        while (pick >= c->weights[op]) {
+            pick -= c->weights[op];
+            op++;
+        }
+        lg_op_stats_t *s = &c->op[op];
+
+        if (fd < 0) {
+            fd = lg_connect(c->socket_path);
+            c->reconnects++;
+        }
+        int rc = -1;
+        if (fd >= 0 && lg_send(fd, op, seq++) == 0) {
+            rc = lg_wait_reply(fd, op, buf, cap);
+        }
+        if (rc == 0) {
+            s->ok++;
+            lg_add_latency(s, now_s() - due);
+        } else if (rc == 1) {
+            s->err++;
+        } else {
+            s->fail++;
+            if (fd >= 0) close(fd);
+            fd = -1;
+        }
+        due += c->interval_s;
+    }
+
+    if (fd >= 0) lg_quit(fd);
+    free(buf);
+    return NULL;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t pct(const uint32_t *v, size_t n, double q) {
+    if (n == 0) return 0;
+    size_t i = (size_t)(q * (double)n);
+    return v[i < n ? i : n - 1];
+}
+
+/* Simulation progress as seen by a status query; -1 if not running. */
+static int lg_sample_progress(int fd, uint32_t *rep) {
+    rw_query_status_t q = {(uint32_t)getpid()};
+    rw_status_t st;
+    if (rw_send_msg(fd, RW_MSG_QUERY_STATUS, &q, sizeof(q)) != 0 ||
+        lg_wait_reply(fd, OP_STATUS, &st, sizeof(st)) != 0) {
+        return -1;
+    }
+    *rep = st.current_rep;
+    return st.state == RW_WIRE_SIM_RUNNING ? 0 : -1;
+}
+
+/* Replications per second over [now, now + secs]; < 0 if not measurable. */
+static double lg_measure_reps(int fd, double secs) {
+    uint32_t r0 = 0, r1 = 0;
+    double t0 = now_s();
+    if (lg_sample_progress(fd, &r0) != 0) return -1.0;
+    sleep_until(t0 + secs);
+    if (lg_sample_progress(fd, &r1) != 0 || r1 < r0) return -1.0;
+    return (double)(r1 - r0) / (now_s() - t0);
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [--socket P] [--clients N] [--rate R] [--duration S]\n"
+                    "          [--mix STATUS,SNAPSHOT,MODE] [--snapshot-format F] [--no-idle]\n", argv0);
+    fprintf(stderr, "  --socket P      server socket (default /tmp/rw_test.sock)\n");
+    fprintf(stderr, "  --clients N     connections (default 8)\n");
+    fprintf(stderr, "  --rate R        total requests per second, 0 = as fast as possible (default 1000)\n");
+    fprintf(stderr, "  --duration S    seconds of load (default 10)\n");
+    fprintf(stderr, "  --mix A,B,C     weights of status polls, snapshots, mode changes (default 90,9,1)\n");
+    fprintf(stderr, "  --snapshot-format F  0 = raw counters, 1/2 = derived 8/16-bit (default 0)\n");
+    fprintf(stderr, "  --no-idle       skip the idle phase (no simulation throughput comparison)\n");
+}
+
+int main(int argc, char **argv) {
+    const char *socket_path = "/tmp/rw_test.sock";
+    int nclients = 8;
+    double rate = 1000.0;
+    double duration = 10.0;
+    unsigned weights[OP_COUNT] = {90, 9, 1};
+    int idle_phase = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            nclients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            duration = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--mix") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%u,%u,%u", &weights[0], &weights[1], &weights[2]) != 3) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--snapshot-format") == 0 && i + 1 < argc) {
+            int f = atoi(argv[++i]);
+            if (f < RW_SNAP_FORMAT_RAW || f > RW_SNAP_FORMAT_DERIVED16) {
+                usage(argv[0]);
+                return 1;
+            }
+            g_snapshot_format = (uint8_t)f;
+        } else if (strcmp(argv[i], "--no-idle") == 0) {
+            idle_phase = 0;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    unsigned wsum = weights[0] + weights[1] + weights[2];
+    if (nclients <= 0 || nclients > LG_MAX_CLIENTS || rate < 0.0 || duration <= 0.0 || wsum == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int monitor = lg_connect(socket_path);
+    if (monitor < 0) {
+        fprintf(stderr, "cannot connect to %s\n", socket_path);
+        return 1;
+    }
+
+    printf("loadgen: %d clients, %s %.0f req/s, %.0f s, mix status %u / snapshot %u / mode %u\n",
+           nclients, rate > 0.0 ? "target" : "closed loop, max", rate, duration,
+           weights[0], weights[1], weights[2]);
+
+    double idle_reps = -1.0;
+    if (idle_phase) {
+        printf("idle phase (%.0f s)...\n", duration);
+        fflush(stdout);
+        idle_reps = lg_measure_reps(monitor, duration);
+    }
+
+    lg_client_t *clients = (lg_client_t *)calloc((size_t)nclients, sizeof(*clients));
+    pthread_t *tids = (pthread_t *)calloc((size_t)nclients, sizeof(*tids));
+    if (!clients || !tids) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printf("load phase (%.0f s)...\n", duration);
+    fflush(stdout);
+    double t_start = now_s() + 0.2;
+    for (int i = 0; i < nclients; i++) {
+        lg_client_t *c = &clients[i];
+        c->id = i * (LG_MAX_CLIENTS / nclients);
+        c->socket_path = socket_path;
+        c->interval_s = rate > 0.0 ? (double)nclients / rate : 0.0;
+        c->t_start = t_start;
+        c->t_end = t_start + duration;
+        memcpy(c->weights, weights, sizeof(weights));
+        c->weight_sum = wsum;
+        c->rng = 0x9E3779B97F4A7C15ULL * (uint64_t)(i + 1);
+        if (pthread_create(&tids[i], NULL, lg_client_main, c) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            return 1;
+        }
+    }
+    sleep_until(t_start);
+    double load_reps = lg_measure_reps(monitor, duration);
+    for (int i = 0; i < nclients; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    lg_quit(monitor);
+
+    //merge per-client results
+    printf("\n%-9s %9s %7s %7s %9s %9s %9s %9s\n",
+           "request", "ok", "error", "failed", "p50 us", "p99 us", "p999 us", "max us");
+    uint64_t total_ok = 0, total_bad = 0, reconnects = 0;
+    for (int op = 0; op < OP_COUNT; op++) {
+        lg_op_stats_t all = {0};
+        for (int i = 0; i < nclients; i++) {
+            const lg_op_stats_t *s = &clients[i].op[op];
+            all.ok += s->ok;
+            all.err += s->err;
+            all.fail += s->fail;
+            all.n_lat += s->n_lat;
+        }
+        all.lat_us = (uint32_t *)malloc((all.n_lat ? all.n_lat : 1u) * sizeof(uint32_t));
+        if (!all.lat_us) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+        size_t k = 0;
+        for (int i = 0; i < nclients; i++) {
+            const lg_op_stats_t *s = &clients[i].op[op];
+            if (s->n_lat) memcpy(all.lat_us + k, s->lat_us, s->n_lat * sizeof(uint32_t));
+            k += s->n_lat;
+        }
+        qsort(all.lat_us, all.n_lat, sizeof(uint32_t), cmp_u32);
+
+        printf("%-9s %9llu %7llu %7llu %9u %9u %9u %9u\n", kOpName[op],
+               (unsigned long long)all.ok, (unsigned long long)all.err, (unsigned long long)all.fail,
+               pct(all.lat_us, all.n_lat, 0.50), pct(all.lat_us, all.n_lat, 0.99),
+               pct(all.lat_us, all.n_lat, 0.999), all.n_lat ? all.lat_us[all.n_lat - 1] : 0u);
+        total_ok += all.ok;
+        total_bad += all.err + all.fail;
+        free(all.lat_us);
+    }
+    for (int i = 0; i < nclients; i++) {
+        reconnects += clients[i].reconnects;
+        for (int op = 0; op < OP_COUNT; op++) free(clients[i].op[op].lat_us);
+    }
+
+    printf("\nthroughput: %.0f req/s ok (%llu errors/failures, %llu reconnects)\n",
+           (double)total_ok / duration, (unsigned long long)total_bad, (unsigned long long)reconnects);
+    if (idle_reps > 0.0 && load_reps >= 0.0) {
+        printf("simulation: %.2f reps/s idle, %.2f reps/s under load (%+.1f %%)\n",
+               idle_reps, load_reps, (load_reps / idle_reps - 1.0) * 100.0);
+    } else if (idle_phase) {
+        printf("simulation: not running in both phases (or too slow to measure); comparison skipped\n");
+    }
+
+    free(clients);
+    free(tids);
+    return total_bad > 0 ? 2 : 0;
+}
@@ -0,0 +1,133 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+/**
+ * @file rwbench.c
+ * @brief Benchmark of the single-walker and the interleaved random-walk kernels.
+ *
+ * For square obstacle worlds from 64x64 to 16384x16384 it runs the same walks
+ * (CRN streams, random start cells) with @ref random_walk_run() and with
+ * @ref random_walk_run_batch() in batches of the worker pool size, prints
+ * steps per second of both and checks that their results are identical.
+ *
+ * Usage: rwbench [walks_per_size] [max_steps] [obstacle_percent]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../server/random_walk.h"
+#include "../server/worker_pool.h"
+#include "../server/world.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_SEED 0x5EEDu
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* Free start cells drawn uniformly (xorshift, independent of the walk streams). */
+static void pick_starts(const world_t *w, pos_t *starts, uint64_t *idx, size_t n) {
+    uint64_t s = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < n; ) {
+        s ^= s << 13;
+        s ^= s >> 7;
+        s ^= s << 17;
+        pos_t p = {(int32_t)(s % (uint64_t)w->size.width),
+                   (int32_t)((s >> 32) % (uint64_t)w->size.height)};
+        if (world_is_obstacle_xy(w, p.x, p.y)) continue;
+        starts[i] = p;
+        idx[i] = world_index(w, p.x, p.y);
+        i++;
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t nwalks = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 50000u;
+    uint32_t max_steps = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 1000u;
+    int percent = argc > 3 ? atoi(argv[3]) : 10;
+    if (nwalks == 0 || max_steps == 0) {
+        fprintf(stderr, "usage: %s [walks_per_size] [max_steps] [obstacle_percent]\n", argv[0]);
+        return 1;
+    }
+
+    const int32_t sizes[] = {64, 256, 1024, 4096, 16384};
+    move_probs_t probs = {0.25, 0.25, 0.25, 0.25};
+
+    pos_t *starts = (pos_t *)malloc(nwalks * sizeof(*starts));
+    uint64_t *idx = (uint64_t *)malloc(nwalks * sizeof(*idx));
+    rw_walk_t *walks = (rw_walk_t *)malloc(nwalks * sizeof(*walks));
+    rw_walk_t *ref = (rw_walk_t *)malloc(nwalks * sizeof(*ref));
+    if (!starts || !idx || !walks || !ref) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printf("%zu walks per size, K = %u, %d%% obstacles, %d walks interleaved\n",
+           nwalks, max_steps, percent, RW_WALK_INTERLEAVE);
+    printf("%12s %10s %14s %14s %8s %s\n",
+           "world", "bitmap", "single Msteps/s", "batch Msteps/s", "speedup", "results");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        world_t w;
+        if (world_init(&w, WORLD_OBSTACLES, (world_size_t){sizes[s], sizes[s]}) != 0) {
+            fprintf(stderr, "world_init(%d) failed\n", sizes[s]);
+            return 1;
+        }
+        world_generate_obstacles(&w, percent, BENCH_SEED);
+        pick_starts(&w, starts, idx, nwalks);
+
+        //single-walker kernel
+        uint64_t steps_total = 0;
+        double t0 = now_s();
+        for (size_t i = 0; i < nwalks; i++) {
+            rw_walk_t *r = &ref[i];
+            rw_rng_seed_stream(&r->rng, BENCH_SEED, idx[i], 1);
+            random_walk_run(&w, starts[i], probs, max_steps, &r->rng,
+                            &r->steps, &r->reached_origin, &r->success_leq_k);
+            steps_total += r->steps;
+        }
+        double t_single = now_s() - t0;
+
+        //interleaved kernel, batched like the worker pool
+        for (size_t i = 0; i < nwalks; i++) {
+            walks[i].start = starts[i];
+            rw_rng_seed_stream(&walks[i].rng, BENCH_SEED, idx[i], 1);
+        }
+        t0 = now_s();
+        for (size_t i = 0; i < nwalks; i += WORKER_POOL_BATCH) {
+            size_t n = nwalks - i < WORKER_POOL_BATCH ? nwalks - i : WORKER_POOL_BATCH;
+            random_walk_run_batch(&w, probs, max_steps, walks + i, n);
+        }
+        double t_batch = now_s() - t0;
+
+        int same = 1;
+        for (size_t i = 0; i < nwalks && same; i++) {
+            same = walks[i].steps == ref[i].steps &&
+                   walks[i].reached_origin == ref[i].reached_origin &&
+                   walks[i].success_leq_k == ref[i].success_leq_k;
+        }
+
+        char label[32];
+        snprintf(label, sizeof(label), "%dx%d", sizes[s], sizes[s]);
+        printf("%12s %8.1f MB %14.1f %14.1f %7.2fx %s\n",
+               label, (double)world_obstacle_bytes(&w) / (1024.0 * 1024.0),
+               (double)steps_total / t_single * 1e-6, (double)steps_total / t_batch * 1e-6,
+               t_single / t_batch, same ? "identical" : "MISMATCH");
+        fflush(stdout);
+
+        world_destroy(&w);
+    }
+
+    free(starts);
+    free(idx);
+    free(walks);
+    free(ref);
+    return 0;
+}
@@ -0,0 +1,114 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+/**
+ * @file rwheatmap.c
+ * @brief Render a saved RWRES file as a PPM/PNG heatmap without a server.
+ *
+ * The result file is memory-mapped (@ref persist_map_results()), so worlds
+ * larger than RAM are read once, sequentially, and only a band of output rows
+ * is held in memory (see heatmap_export.h).
+ *
+ * Usage: rwheatmap IN.rwres OUT.{ppm,png} [--field p|avg] [--colormap NAME]
+ *                  [--downsample D] [--max V] [--threads N]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../server/heatmap_export.h"
+#include "../server/persist.h"
+#include "../server/scheduler.h"
+#include "../common/util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s IN.rwres OUT.{ppm,png} [--field p|avg] [--colormap viridis|heat|gray]\n"
+                    "          [--downsample D] [--max V] [--threads N]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char *in = argv[1];
+    const char *out = argv[2];
+
+    heatmap_options_t opts;
+    memset(&opts, 0, sizeof(opts));
+    opts.field = HEATMAP_FIELD_P_LEQ_K;
+    opts.colormap = HEATMAP_CMAP_VIRIDIS;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    opts.nthreads = ncpu > 0 ? (int)ncpu : 1;
+    size_t len = strlen(out);
+    opts.format = (len >= 4 && strcmp(out + len - 4, ".png") == 0) ? HEATMAP_FORMAT_PNG : HEATMAP_FORMAT_PPM;
+
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--field") == 0 && i + 1 < argc) {
+            const char *f = argv[++i];
+            if (strcmp(f, "p") == 0) {
+                opts.field = HEATMAP_FIELD_P_LEQ_K;
+            } else if (strcmp(f, "avg") == 0) {
+                opts.field = HEATMAP_FIELD_AVG_STEPS;
+            } else {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--colormap") == 0 && i + 1 < argc) {
+            if (heatmap_colormap_parse(argv[++i], &opts.colormap) != 0) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--downsample") == 0 && i + 1 < argc) {
+            opts.downsample = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+            opts.max_value = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            opts.nthreads = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    persist_results_map_t map;
+    if (persist_map_results(in, &map) != 0) {
+        return 1;
+    }
+    heatmap_source_t src;
+    memset(&src, 0, sizeof(src));
+    src.size = map.size;
+    src.obstacle_bits = map.obstacle_bits;
+    src.obstacle_bytes = map.obstacle_bytes;
+    src.trials = map.trials;
+    src.sum_steps = map.sum_steps;
+    src.success_leq_k = map.success_leq_k;
+
+    //the export renders on scheduler tasks; without threads they would run inline
+    scheduler_start(opts.nthreads);
+    uint32_t w = 0, h = 0;
+    double t0 = now_s();
+    int rc = heatmap_export(out, &src, &opts, &w, &h);
+    double dt = now_s() - t0;
+    scheduler_stop();
+    persist_unmap_results(&map);
+    if (rc != 0) {
+        fprintf(stderr, "export failed\n");
+        return 1;
+    }
+    printf("%s: %dx%d cells -> %ux%u pixels in %.2f s (%d threads)\n", out, src.size.width, src.size.height,
+           w, h, dt, opts.nthreads);
+    return 0;
+}
@@ -0,0 +1,332 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+/**
+ * @file rwperf.c
+ * @brief Performance regression harness of the simulation path.
+ *
+ * Runs a fixed set of deterministic scenarios (world size, wrap/obstacles, K,
+ * worker threads) through the server's worker pool exactly like a local run
+ * of sim_manager with common random numbers, and measures:
+ * - `walks_per_s`: walks per second (median of the repeats, higher is better),
+ * - `rep_ms`:      wall time of the slowest replication (median of the repeats, lower is better),
+ * - `rss_kb`:      growth of the peak resident set size since program start
+ *                  (lower is better; differences under 1 MB are ignored),
+ * - `checksum`:    hash of the result arrays (must match exactly).
+ *
+ * The measurements are compared against a baseline file with one
+ * `scenario metric value tolerance_percent` line per check; the program exits
+ * with 1 if any metric is worse than its tolerance allows. With --update the
+ * baseline is rewritten from this run (existing tolerances are kept).
+ *
+ * Usage: rwperf [--baseline PATH] [--update] [--repeat N]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../server/results.h"
+#include "../server/scheduler.h"
+#include "../server/worker_pool.h"
+#include "../server/world.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#define PERF_SEED 0x5EEDu
+#define PERF_QUEUE 8192u
+#define PERF_MAX_CHECKS 64
+#define PERF_MAX_REPEAT 15
+#define PERF_RSS_SLACK_KB 1024.0
+
+typedef struct {
+    const char *name;
+    world_kind_t kind;
+    int32_t size;
+    int obstacle_percent;
+    uint32_t k;
+    uint32_t reps;
+    int threads;
+} perf_scenario_t;
+
+/* Ordered by memory (the RSS metric is the process peak). */
+static const perf_scenario_t kScenarios[] = {
+    {"small-wrap-k1000-t1",  WORLD_WRAP,      64,   0,  1000, 20, 1},
+    {"small-obst-k1000-t1",  WORLD_OBSTACLES, 64,   10, 1000, 20, 1},
+    {"small-obst-k1000-t4",  WORLD_OBSTACLES, 64,   10, 1000, 20, 4},
+    {"large-wrap-k100-t1",   WORLD_WRAP,      512,  0,  100,  2,  1},
+    {"large-obst-k100-t1",   WORLD_OBSTACLES, 512,  20, 100,  2,  1},
+    {"large-obst-k100-t4",   WORLD_OBSTACLES, 512,  20, 100,  2,  4},
+};
+#define PERF_NSCENARIOS (sizeof(kScenarios) / sizeof(kScenarios[0]))
+
+enum { M_WALKS, M_REP_MS, M_RSS, M_CHECKSUM, M_COUNT };
+static const char *const kMetric[M_COUNT] = {"walks_per_s", "rep_ms", "rss_kb", "checksum"};
+static const double kDefaultTolerance[M_COUNT] = {30.0, 40.0, 20.0, 0.0};
+static long g_rss0_kb;
+
+typedef struct {
+    char scenario[64];
+    int metric;
+    double value;
+    double tolerance;
+} perf_check_t;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001B3ULL;
+    }
+    return h;
+}
+
+/* One run of a scenario; fills the metrics, returns 0 on success. */
+static int run_scenario(const perf_scenario_t *sc, double m[M_COUNT]) {
+    world_t w;
+    results_t r;
+    worker_pool_t pool;
+    move_probs_t probs = {0.25, 0.25, 0.25, 0.25};
+
+    if (world_init(&w, sc->kind, (world_size_t){sc->size, sc->size}) != 0) return -1;
+    world_generate_obstacles(&w, sc->obstacle_percent, PERF_SEED);
+    if (results_init(&r, w.size) != 0) {
+        world_destroy(&w);
+        return -1;
+    }
+    //one scheduler thread per runner, like the server
+    if (scheduler_start(sc->threads) != 0) {
+        results_destroy(&r);
+        world_destroy(&w);
+        return -1;
+    }
+    if (worker_pool_init(&pool, sc->threads, PERF_QUEUE, &w, &r, probs, sc->k) != 0) {
+        scheduler_stop();
+        results_destroy(&r);
+        world_destroy(&w);
+        return -1;
+    }
+    worker_pool_set_crn(&pool, 1, PERF_SEED);
+
+    world_region_t reg;
+    (void)world_region_resolve(&w, NULL, &reg);
+
+    double rep_max = 0.0;
+    double t0 = now_s();
+    for (uint32_t rep = 1; rep <= sc->reps; rep++) {
+        double tr = now_s();
+        world_scan_t scan;
+        pos_t p;
+        world_scan_begin(&scan, &w, &reg);
+        while (world_scan_next(&scan, &p)) {
+            if (world_is_obstacle_xy(&w, p.x, p.y)) continue;
+            rw_job_t job = {world_index(&w, p.x, p.y), p, rep};
+            worker_pool_submit(&pool, job);
+        }
+        worker_pool_wait_all(&pool);
+        double dt = now_s() - tr;
+        if (dt > rep_max) rep_max = dt;
+    }
+    double wall = now_s() - t0;
+
+    worker_pool_stop(&pool);
+    worker_pool_destroy(&pool);
+    scheduler_stop();
+
+    uint64_t cells = results_cell_count(&r);
+    const uint32_t *trials = results_trials(&r);
+    uint64_t walks = 0;
+    for (uint64_t i = 0; i < cells; i++) walks += trials[i];
+
+    uint64_t h = 0xCBF29CE484222325ULL;
+    h = fnv1a(h, trials, cells * sizeof(uint32_t));
+    h = fnv1a(h, results_sum_steps(&r), cells * sizeof(uint64_t));
+    h = fnv1a(h, results_success_leq_k(&r), cells * sizeof(uint32_t));
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+
+    m[M_WALKS] = (double)walks / wall;
+    m[M_REP_MS] = rep_max * 1e3;
+    m[M_RSS] = (double)(ru.ru_maxrss - g_rss0_kb);
+    m[M_CHECKSUM] = (double)(h >> 12); /* 52 bits: exact in a double */
+
+    results_destroy(&r);
+    world_destroy(&w);
+    return 0;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double median(double *v, int n) {
+    qsort(v, (size_t)n, sizeof(*v), cmp_double);
+    return n % 2 ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+static int metric_of(const char *name) {
+    for (int i = 0; i < M_COUNT; i++) {
+        if (strcmp(name, kMetric[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static int load_baseline(const char *path, perf_check_t *checks, int cap) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+
+    char line[256];
+    int n = 0;
+    while (n < cap && fgets(line, sizeof(line), f)) {
+        char metric[32];
+        perf_check_t *c = &checks[n];
+        if (line[0] == '#' ||
+            sscanf(line, "%63s %31s %lf %lf", c->scenario, metric, &c->value, &c->tolerance) != 4) {
+            continue;
+        }
+        c->metric = metric_of(metric);
+        if (c->metric >= 0) n++;
+    }
+    fclose(f);
+    return n;
+}
+
+static const perf_check_t *find_check(const perf_check_t *checks, int n, const char *scenario, int metric) {
+    for (int i = 0; i < n; i++) {
+        if (checks[i].metric == metric && strcmp(checks[i].scenario, scenario) == 0) return &checks[i];
+    }
+    return NULL;
+}
+
+static int write_baseline(const char *path, const double m[][M_COUNT],
+                          const perf_check_t *old, int nold) {
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+
+    fprintf(f, "# rwperf baseline (make perf-baseline): scenario metric value tolerance_percent\n");
+    fprintf(f, "# walks_per_s: lower fails; rep_ms, rss_kb: higher fails; checksum: must match\n");
+    for (size_t s = 0; s < PERF_NSCENARIOS; s++) {
+        for (int k = 0; k < M_COUNT; k++) {
+            const perf_check_t *c = find_check(old, nold, kScenarios[s].name, k);
+            fprintf(f, "%-22s %-12s %.*f %g\n", kScenarios[s].name, kMetric[k],
+                    k == M_CHECKSUM || k == M_RSS ? 0 : 3, m[s][k],
+                    c ? c->tolerance : kDefaultTolerance[k]);
+        }
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+int main(int argc, char **argv) {
+    const char *baseline = "perf/baseline.txt";
+    int update = 0;
+    int repeat = 5;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline = argv[++i];
+        } else if (strcmp(argv[i], "--update") == 0) {
+            update = 1;
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--baseline PATH] [--update] [--repeat N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (repeat <= 0) repeat = 1;
+    if (repeat > PERF_MAX_REPEAT) repeat = PERF_MAX_REPEAT;
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    g_rss0_kb = ru.ru_maxrss;
+
+    perf_check_t checks[PERF_MAX_CHECKS];
+    int nchecks = load_baseline(baseline, checks, PERF_MAX_CHECKS);
+    if (nchecks < 0 && !update) {
+        fprintf(stderr, "cannot read baseline %s (create it with --update)\n", baseline);
+        return 2;
+    }
+    if (nchecks < 0) nchecks = 0;
+
+    double m[PERF_NSCENARIOS][M_COUNT];
+    int failed = 0;
+
+    printf("%-22s %12s %10s %10s %s\n", "scenario", "walks/s", "rep ms", "RSS MB", "vs. baseline");
+    for (size_t s = 0; s < PERF_NSCENARIOS; s++) {
+        const perf_scenario_t *sc = &kScenarios[s];
+
+        //median of the repeats for time metrics (single runs vary with CPU frequency)
+        double walks[PERF_MAX_REPEAT], rep_ms[PERF_MAX_REPEAT];
+        for (int r = 0; r < repeat; r++) {
+            double cur[M_COUNT];
+            if (run_scenario(sc, cur) != 0) {
+                fprintf(stderr, "%s: setup failed\n", sc->name);
+                return 2;
+            }
+            if (r > 0 && cur[M_CHECKSUM] != m[s][M_CHECKSUM]) {
+                fprintf(stderr, "%s: results differ between repeats (not deterministic)\n", sc->name);
+                failed = 1;
+            }
+            memcpy(m[s], cur, sizeof(cur));
+            walks[r] = cur[M_WALKS];
+            rep_ms[r] = cur[M_REP_MS];
+        }
+        m[s][M_WALKS] = median(walks, repeat);
+        m[s][M_REP_MS] = median(rep_ms, repeat);
+
+        printf("%-22s %12.0f %10.1f %10.1f ", sc->name, m[s][M_WALKS], m[s][M_REP_MS],
+               m[s][M_RSS] / 1024.0);
+        if (update) {
+            printf("(updating)\n");
+            continue;
+        }
+
+        char verdict[256] = "ok";
+        size_t vlen = 0;
+        for (int k = 0; k < M_COUNT; k++) {
+            const perf_check_t *c = find_check(checks, nchecks, sc->name, k);
+            if (!c) continue;
+
+            int bad;
+            double delta = c->value != 0.0 ? (m[s][k] / c->value - 1.0) * 100.0 : 0.0;
+            if (k == M_CHECKSUM) {
+                bad = m[s][k] != c->value;
+            } else if (k == M_WALKS) {
+                bad = delta < -c->tolerance;
+            } else if (k == M_RSS) {
+                bad = delta > c->tolerance && m[s][k] - c->value > PERF_RSS_SLACK_KB;
+            } else {
+                bad = delta > c->tolerance;
+            }
+            if (bad && vlen < sizeof(verdict)) {
+                vlen += (size_t)snprintf(verdict + vlen, sizeof(verdict) - vlen, "%sREGRESSION %s %+.1f%%",
+                                         vlen ? ", " : "", kMetric[k], delta);
+                failed = 1;
+            }
+        }
+        printf("%s\n", verdict);
+        fflush(stdout);
+    }
+
+    if (update) {
+        if (write_baseline(baseline, (const double (*)[M_COUNT])m, checks, nchecks) != 0) {
+            fprintf(stderr, "cannot write baseline %s\n", baseline);
+            return 2;
+        }
+        printf("baseline written to %s\n", baseline);
+        return failed;
+    }
+    printf(failed ? "FAILED: performance regression against %s\n" : "all within tolerance of %s\n", baseline);
+    return failed;
+}
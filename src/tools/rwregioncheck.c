@@ -0,0 +1,197 @@
+//
+// Created by Jozef Jelšík on 18/10/2026.
+//
+
+/**
+ * @file rwregioncheck.c
+ * @brief Check of 64-bit cell indexing and simulation regions on a huge world.
+ *
+ * Simulates a 64x32 region of a 70000x70000 obstacle world (4.9 G cells, all
+ * region cells above index 2^32) through the server's worker pool like a local
+ * run with common random numbers, then checks:
+ * - world_index() of the region is the 64-bit row-major index,
+ * - every free region cell got one trial per replication, obstacles none,
+ * - no cell outside the region changed (whole world, via the block versions),
+ *   in particular not the cells 2^32 below the region a 32-bit index would hit,
+ * - the result arrays stayed lazy (peak RSS growth far below the world size).
+ *
+ * Exits with 0 if all checks pass, 1 otherwise.
+ *
+ * Usage: rwregioncheck
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../server/results.h"
+#include "../server/scheduler.h"
+#include "../server/worker_pool.h"
+#include "../server/world.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#define CHECK_SIDE 70000
+#define CHECK_REGION_X (CHECK_SIDE - 64)  /* touches the right border */
+#define CHECK_REGION_Y 65000              /* 65000 * 70000 > 2^32 */
+#define CHECK_REGION_W 64
+#define CHECK_REGION_H 32
+#define CHECK_REPS 3u
+#define CHECK_K 200u
+#define CHECK_SEED 0x5EEDu
+#define CHECK_QUEUE 8192u
+#define CHECK_RSS_MAX_KB (64L * 1024L)
+
+static int g_failed = 0;
+
+static void fail(const char *what, uint64_t idx, uint64_t value) {
+    if (g_failed < 10) {
+        fprintf(stderr, "FAIL: %s (cell %llu, value %llu)\n", what,
+                (unsigned long long)idx, (unsigned long long)value);
+    }
+    g_failed++;
+}
+
+static int in_region(const world_region_t *reg, uint64_t idx) {
+    const uint64_t x = idx % CHECK_SIDE, y = idx / CHECK_SIDE;
+    return x >= (uint64_t)reg->x && x < (uint64_t)reg->x + (uint64_t)reg->size.width &&
+           y >= (uint64_t)reg->y && y < (uint64_t)reg->y + (uint64_t)reg->size.height;
+}
+
+/* Obstacles inside the region and around it, plus one at the 32-bit alias of a free region cell. */
+static void place_obstacles(world_t *w, const world_region_t *reg) {
+    for (int32_t i = 0; i < reg->size.height; i++) {
+        world_set_obstacle(w, reg->x + 2 * i, reg->y + i, 1);             /* diagonal */
+    }
+    for (int32_t x = reg->x - 8; x < reg->x + reg->size.width; x += 3) {
+        world_set_obstacle(w, x, reg->y - 1, 1);                           /* dotted wall above */
+    }
+    const uint64_t free_idx = world_index(w, reg->x + 1, reg->y);
+    world_set_obstacle_idx(w, free_idx - (1ull << 32), 1);
+}
+
+/* Region cells: exact trials per cell; returns the number of walks. */
+static uint64_t check_region(const world_t *w, const results_t *r, const world_region_t *reg) {
+    const uint32_t *trials = results_trials(r);
+    const uint32_t *succ = results_success_leq_k(r);
+    const uint64_t *steps = results_sum_steps(r);
+    uint64_t walks = 0;
+
+    for (int32_t y = reg->y; y < reg->y + reg->size.height; y++) {
+        for (int32_t x = reg->x; x < reg->x + reg->size.width; x++) {
+            const uint64_t idx = world_index(w, x, y);
+            if (idx != (uint64_t)y * CHECK_SIDE + (uint64_t)x) fail("world_index is not 64-bit", idx, 0);
+            if (idx <= UINT32_MAX) fail("region cell below 2^32", idx, 0);
+
+            if (world_is_obstacle_idx(w, idx)) {
+                if (trials[idx] != 0) fail("trials on an obstacle", idx, trials[idx]);
+                continue;
+            }
+            if (trials[idx] != CHECK_REPS) fail("free region cell without one trial per replication", idx, trials[idx]);
+            if (succ[idx] > trials[idx]) fail("more successes than trials", idx, succ[idx]);
+            if (steps[idx] > (uint64_t)trials[idx] * CHECK_K) fail("more steps than K per trial", idx, steps[idx]);
+            walks += trials[idx];
+        }
+    }
+    return walks;
+}
+
+/* Whole world: blocks changed since @p since must overlap the region, with trials only inside it. */
+static void check_outside(const results_t *r, const world_region_t *reg, uint64_t since) {
+    const uint32_t *trials = results_trials(r);
+    const uint64_t cells = results_cell_count(r);
+    uint64_t changed_blocks = 0;
+
+    for (uint64_t off = 0; off < cells; off += RESULTS_BLOCK_CELLS) {
+        const uint64_t n = cells - off < RESULTS_BLOCK_CELLS ? cells - off : RESULTS_BLOCK_CELLS;
+        if (!results_changed_since(r, since, off, n)) continue;
+        changed_blocks++;
+        int overlaps = 0;
+        for (uint64_t i = off; i < off + n; i++) {
+            if (in_region(reg, i)) {
+                overlaps = 1;
+            } else if (trials[i] != 0) {
+                fail("trials outside the region", i, trials[i]);
+            }
+        }
+        if (!overlaps) fail("block outside the region changed", off, 0);
+    }
+    if (changed_blocks == 0) fail("no block changed", 0, 0);
+}
+
+int main(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    const long rss0_kb = ru.ru_maxrss;
+
+    world_t w;
+    results_t r;
+    worker_pool_t pool;
+    move_probs_t probs = {0.25, 0.25, 0.25, 0.25};
+    const world_region_t reg = {CHECK_REGION_X, CHECK_REGION_Y, {CHECK_REGION_W, CHECK_REGION_H}};
+
+    if (world_init(&w, WORLD_OBSTACLES, (world_size_t){CHECK_SIDE, CHECK_SIDE}) != 0) {
+        fprintf(stderr, "cannot allocate the %dx%d world\n", CHECK_SIDE, CHECK_SIDE);
+        return 1;
+    }
+    if (world_cell_count(&w) != (uint64_t)CHECK_SIDE * CHECK_SIDE) fail("world_cell_count overflows", 0, world_cell_count(&w));
+    place_obstacles(&w, &reg);
+
+    world_region_t resolved;
+    if (world_region_resolve(&w, &reg, &resolved) != 0 || memcmp(&resolved, &reg, sizeof(reg)) != 0) {
+        fprintf(stderr, "region does not resolve to itself\n");
+        world_destroy(&w);
+        return 1;
+    }
+    if (results_init(&r, w.size) != 0) {
+        fprintf(stderr, "cannot map the result arrays\n");
+        world_destroy(&w);
+        return 1;
+    }
+    if (scheduler_start(1) != 0 || worker_pool_init(&pool, 1, CHECK_QUEUE, &w, &r, probs, CHECK_K) != 0) {
+        fprintf(stderr, "cannot start the worker pool\n");
+        results_destroy(&r);
+        world_destroy(&w);
+        return 1;
+    }
+    worker_pool_set_crn(&pool, 1, CHECK_SEED);
+
+    const uint64_t v0 = results_version(&r);
+    uint64_t submitted = 0;
+    for (uint32_t rep = 1; rep <= CHECK_REPS; rep++) {
+        world_scan_t scan;
+        pos_t p;
+        world_scan_begin(&scan, &w, &reg);
+        while (world_scan_next(&scan, &p)) {
+            if (world_is_obstacle_xy(&w, p.x, p.y)) continue;
+            rw_job_t job = {world_index(&w, p.x, p.y), p, rep};
+            worker_pool_submit(&pool, job);
+            submitted++;
+        }
+        worker_pool_wait_all(&pool);
+    }
+    worker_pool_stop(&pool);
+    worker_pool_destroy(&pool);
+    scheduler_stop();
+
+    const uint64_t walks = check_region(&w, &r, &reg);
+    if (walks != submitted) fail("walks in the region differ from the submitted jobs", submitted, walks);
+    check_outside(&r, &reg, v0);
+
+    getrusage(RUSAGE_SELF, &ru);
+    const long rss_kb = ru.ru_maxrss - rss0_kb;
+    if (rss_kb > CHECK_RSS_MAX_KB) fail("peak RSS growth (kB) above the limit", 0, (uint64_t)rss_kb);
+
+    results_destroy(&r);
+    world_destroy(&w);
+
+    if (g_failed) {
+        fprintf(stderr, "rwregioncheck: %d check(s) failed\n", g_failed);
+        return 1;
+    }
+    printf("rwregioncheck: OK (%dx%d region at %d,%d of a %dx%d world, %llu walks, RSS +%ld kB)\n",
+           CHECK_REGION_W, CHECK_REGION_H, CHECK_REGION_X, CHECK_REGION_Y, CHECK_SIDE, CHECK_SIDE,
+           (unsigned long long)walks, rss_kb);
+    return 0;
+}